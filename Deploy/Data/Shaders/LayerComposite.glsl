@@ -0,0 +1,30 @@
+#version 330
+
+#if defined(VERTEX_SHADER)
+    layout(location = 0) in vec2 vertexPosition;
+
+    out vec2 fragmentTexture;
+
+    uniform mat4 transform;
+
+    void main()
+    {
+        // Place unit quad over the area covered by the layer.
+        gl_Position     = transform * vec4(vertexPosition, 0.0f, 1.0f);
+        fragmentTexture = vertexPosition;
+    }
+#endif
+
+#if defined(FRAGMENT_SHADER)
+    in vec2 fragmentTexture;
+
+    out vec4 finalColor;
+
+    uniform sampler2D textureLayer;
+
+    void main()
+    {
+        // Output premultiplied layer color.
+        finalColor = texture(textureLayer, fragmentTexture);
+    }
+#endif
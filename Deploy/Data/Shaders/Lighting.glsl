@@ -0,0 +1,54 @@
+#version 330
+
+#if defined(VERTEX_SHADER)
+    layout(location = 0) in vec2 vertexPosition;
+
+    out vec2 fragmentGrid;
+
+    void main()
+    {
+        // Stretch unit quad over the whole viewport.
+        gl_Position  = vec4(vertexPosition * 2.0f - 1.0f, 0.0f, 1.0f);
+        fragmentGrid = vertexPosition;
+    }
+#endif
+
+#if defined(FRAGMENT_SHADER)
+    in vec2 fragmentGrid;
+
+    out vec4 finalColor;
+
+    uniform samplerBuffer  lightData;
+    uniform usamplerBuffer lightTiles;
+    uniform usamplerBuffer lightIndices;
+    uniform vec3  ambientColor;
+    uniform vec4  gridBounds;
+    uniform ivec2 tileCount;
+
+    void main()
+    {
+        // Calculate the world position of the pixel.
+        vec2 position = mix(gridBounds.xz, gridBounds.yw, fragmentGrid);
+
+        // Find the range of lights touching the tile.
+        ivec2 tile = min(ivec2(fragmentGrid * vec2(tileCount)), tileCount - 1);
+        uvec2 range = texelFetch(lightTiles, tile.y * tileCount.x + tile.x).xy;
+
+        // Accumulate light with quadratic falloff.
+        vec3 light = ambientColor;
+
+        for(uint i = 0u; i < range.y; ++i)
+        {
+            int index = int(texelFetch(lightIndices, int(range.x + i)).x);
+
+            vec4 lightPosition = texelFetch(lightData, index * 2);
+            vec4 lightColor = texelFetch(lightData, index * 2 + 1);
+
+            float attenuation = clamp(1.0f - distance(position, lightPosition.xy) / lightPosition.z, 0.0f, 1.0f);
+            light += lightColor.rgb * lightColor.a * attenuation * attenuation;
+        }
+
+        // Output the light color, which is multiplied with the framebuffer.
+        finalColor = vec4(light, 1.0f);
+    }
+#endif
@@ -6,6 +6,7 @@
     layout(location = 2) in mat4 instanceTransform;
     layout(location = 6) in vec4 instanceRectangle;
     layout(location = 7) in vec4 instanceColor;
+    layout(location = 8) in vec4 instanceAnimation;
 
     out vec2 fragmentTexture;
     out vec4 fragmentColor;
@@ -13,25 +14,52 @@
     uniform mat4 viewTransform;
     uniform vec2 textureSizeInv;
 
+    uniform samplerBuffer frameTable;
+    uniform float animationTime;
+
     void main()
     {
         vec4 position = vec4(vertexPosition, 0.0f, 1.0f);
         vec2 texture = vertexTexture;
 
+        vec4 rectangle = instanceRectangle;
+        vec2 offset = vec2(0.0f, 0.0f);
+
+        // Pick the current frame of a looping animation.
+        // Each frame has a rectangle and an offset with its end time.
+        if(instanceAnimation.y > 0.0f)
+        {
+            int first = int(instanceAnimation.x);
+            int count = int(instanceAnimation.y);
+            float duration = texelFetch(frameTable, (first + count - 1) * 2 + 1).z;
+            float time = mod((animationTime - instanceAnimation.z) * instanceAnimation.w, duration);
+
+            int frame = 0;
+
+            while(frame < count - 1 && texelFetch(frameTable, (first + frame) * 2 + 1).z <= time)
+            {
+                ++frame;
+            }
+
+            rectangle = texelFetch(frameTable, (first + frame) * 2);
+            offset = texelFetch(frameTable, (first + frame) * 2 + 1).xy;
+        }
+
         // Scale vertex position by sprite size.
         // Size can be negative for mirrored sprites.
-        position.xy *= abs(instanceRectangle.zw);
+        position.xy *= abs(rectangle.zw);
+        position.xy += offset;
 
         // Apply transformation.
         position = instanceTransform * position;
         position = viewTransform * position;
 
         // Normalize texture coordinate.
-        texture *= instanceRectangle.zw * textureSizeInv;
-        texture += instanceRectangle.xy * textureSizeInv;
+        texture *= rectangle.zw * textureSizeInv;
+        texture += rectangle.xy * textureSizeInv;
 
         // Move texture origin from top left corner to bottom left.
-        texture.y -= instanceRectangle.w * textureSizeInv.y;
+        texture.y -= rectangle.w * textureSizeInv.y;
 
         // Output vertex.
         gl_Position     = position;
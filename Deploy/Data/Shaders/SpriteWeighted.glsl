@@ -0,0 +1,94 @@
+#version 330
+
+#if defined(VERTEX_SHADER)
+    layout(location = 0) in vec2 vertexPosition;
+    layout(location = 1) in vec2 vertexTexture;
+    layout(location = 2) in mat4 instanceTransform;
+    layout(location = 6) in vec4 instanceRectangle;
+    layout(location = 7) in vec4 instanceColor;
+    layout(location = 8) in vec4 instanceAnimation;
+
+    out vec2 fragmentTexture;
+    out vec4 fragmentColor;
+
+    uniform mat4 viewTransform;
+    uniform vec2 textureSizeInv;
+
+    uniform samplerBuffer frameTable;
+    uniform float animationTime;
+
+    void main()
+    {
+        vec4 position = vec4(vertexPosition, 0.0f, 1.0f);
+        vec2 texture = vertexTexture;
+
+        vec4 rectangle = instanceRectangle;
+        vec2 offset = vec2(0.0f, 0.0f);
+
+        // Pick the current frame of a looping animation.
+        // Each frame has a rectangle and an offset with its end time.
+        if(instanceAnimation.y > 0.0f)
+        {
+            int first = int(instanceAnimation.x);
+            int count = int(instanceAnimation.y);
+            float duration = texelFetch(frameTable, (first + count - 1) * 2 + 1).z;
+            float time = mod((animationTime - instanceAnimation.z) * instanceAnimation.w, duration);
+
+            int frame = 0;
+
+            while(frame < count - 1 && texelFetch(frameTable, (first + frame) * 2 + 1).z <= time)
+            {
+                ++frame;
+            }
+
+            rectangle = texelFetch(frameTable, (first + frame) * 2);
+            offset = texelFetch(frameTable, (first + frame) * 2 + 1).xy;
+        }
+
+        // Scale vertex position by sprite size.
+        // Size can be negative for mirrored sprites.
+        position.xy *= abs(rectangle.zw);
+        position.xy += offset;
+
+        // Apply transformation.
+        position = instanceTransform * position;
+        position = viewTransform * position;
+
+        // Normalize texture coordinate.
+        texture *= rectangle.zw * textureSizeInv;
+        texture += rectangle.xy * textureSizeInv;
+
+        // Move texture origin from top left corner to bottom left.
+        texture.y -= rectangle.w * textureSizeInv.y;
+
+        // Output vertex.
+        gl_Position     = position;
+        fragmentTexture = texture;
+        fragmentColor   = instanceColor;
+    }
+#endif
+
+#if defined(FRAGMENT_SHADER)
+    in  vec2 fragmentTexture;
+    in  vec4 fragmentColor;
+
+    layout(location = 0) out vec4 finalAccumulation;
+    layout(location = 1) out vec4 finalWeight;
+
+    uniform sampler2D textureDiffuse;
+
+    void main()
+    {
+        vec4 color = texture(textureDiffuse, fragmentTexture) * fragmentColor;
+
+        // Calculate order independent weight.
+        // Sprites closer to the viewer contribute more to the final color.
+        float weight = pow(min(1.0f, color.a * 10.0f) + 0.01f, 3.0f) * 1e8f * pow(1.0f - gl_FragCoord.z * 0.9f, 3.0f);
+        weight = clamp(weight, 1e-2f, 3e3f);
+
+        // Output weighted premultiplied color.
+        // Blending accumulates color and multiplies revealage in alpha channel.
+        finalAccumulation = vec4(color.rgb * color.a * weight, color.a);
+        finalWeight       = vec4(color.a * weight, 0.0f, 0.0f, 0.0f);
+    }
+#endif
@@ -0,0 +1,42 @@
+#version 330
+
+#if defined(VERTEX_SHADER)
+    layout(location = 0) in vec2 vertexPosition;
+
+    out vec2 fragmentTexture;
+
+    void main()
+    {
+        // Stretch unit quad over the whole viewport.
+        gl_Position     = vec4(vertexPosition * 2.0f - 1.0f, 0.0f, 1.0f);
+        fragmentTexture = vertexPosition;
+    }
+#endif
+
+#if defined(FRAGMENT_SHADER)
+    in vec2 fragmentTexture;
+
+    out vec4 finalColor;
+
+    uniform sampler2D textureSource;
+    uniform vec2 sourceSize;
+    uniform vec2 targetSize;
+
+    void main()
+    {
+        // Find position within the source pixel.
+        vec2 texel = fragmentTexture * sourceSize;
+        vec2 texelFloor = floor(texel);
+        vec2 texelCenter = texel - texelFloor - 0.5f;
+
+        // Keep the pixel center flat and only interpolate across the
+        // edge region, which is about one target pixel wide.
+        // With nearest sampling and integer scale this has no effect.
+        vec2 scale = max(targetSize / sourceSize, vec2(1.0f));
+        vec2 region = 0.5f - 0.5f / scale;
+        vec2 offset = (texelCenter - clamp(texelCenter, -region, region)) * scale + 0.5f;
+
+        // Output the source color.
+        finalColor = texture(textureSource, (texelFloor + offset) / sourceSize);
+    }
+#endif
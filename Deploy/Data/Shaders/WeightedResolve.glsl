@@ -0,0 +1,39 @@
+#version 330
+
+#if defined(VERTEX_SHADER)
+    layout(location = 0) in vec2 vertexPosition;
+
+    void main()
+    {
+        // Stretch unit quad over the whole screen.
+        gl_Position = vec4(vertexPosition * 2.0f - 1.0f, 0.0f, 1.0f);
+    }
+#endif
+
+#if defined(FRAGMENT_SHADER)
+    out vec4 finalColor;
+
+    uniform sampler2D textureAccumulation;
+    uniform sampler2D textureWeight;
+    uniform ivec2 viewportOrigin;
+
+    void main()
+    {
+        // Targets are rendered at the origin, offset by the viewport position.
+        ivec2 coords = ivec2(gl_FragCoord.xy) - viewportOrigin;
+
+        // Read accumulated values.
+        vec4 accumulation = texelFetch(textureAccumulation, coords, 0);
+        float weight = texelFetch(textureWeight, coords, 0).r;
+
+        // Skip pixels that were not covered.
+        float revealage = accumulation.a;
+
+        if(revealage >= 1.0f)
+            discard;
+
+        // Output average color with coverage as alpha.
+        vec3 average = accumulation.rgb / max(weight, 1e-5f);
+        finalColor = vec4(average, 1.0f - revealage);
+    }
+#endif
@@ -1,17 +1,97 @@
 #include "Precompiled.hpp"
 #include "AnimationSystem.hpp"
 #include "ComponentSystem.hpp"
+#include "VisibilitySystem.hpp"
 #include "Components/Animation.hpp"
+#include "Components/Render.hpp"
+#include "Components/Transform.hpp"
 using namespace Game;
 
 namespace
 {
     // Log error messages.
     #define LogInitializeError() "Failed to initialize the animation system! "
+
+    // Duration used for animations without one, to avoid division by zero.
+    const float MinimumDuration = 0.0001f;
+}
+
+void AnimationSystem::PlaybackArrays::Clear()
+{
+    owners.clear();
+    lists.clear();
+    clips.clear();
+    startTimes.clear();
+    speeds.clear();
+    durations.clear();
+    flags.clear();
+    frames.clear();
+    localTimes.clear();
+}
+
+void AnimationSystem::PlaybackArrays::Remove(std::size_t index)
+{
+    assert(index < owners.size());
+
+    std::size_t last = owners.size() - 1;
+
+    owners[index] = owners[last];
+    lists[index] = lists[last];
+    clips[index] = clips[last];
+    startTimes[index] = startTimes[last];
+    speeds[index] = speeds[last];
+    durations[index] = durations[last];
+    flags[index] = flags[last];
+    frames[index] = frames[last];
+    localTimes[index] = localTimes[last];
+
+    owners.pop_back();
+    lists.pop_back();
+    clips.pop_back();
+    startTimes.pop_back();
+    speeds.pop_back();
+    durations.pop_back();
+    flags.pop_back();
+    frames.pop_back();
+    localTimes.pop_back();
+}
+
+bool AnimationSystem::SyncKey::operator==(const SyncKey& other) const
+{
+    return list == other.list && clip == other.clip && speed == other.speed && phase == other.phase;
+}
+
+std::size_t AnimationSystem::SyncKeyHash::operator()(const SyncKey& key) const
+{
+    std::size_t hash = std::hash<const void*>()(key.list);
+    hash = hash * 31 + std::hash<int>()(key.clip);
+    hash = hash * 31 + std::hash<float>()(key.speed);
+    hash = hash * 31 + std::hash<float>()(key.phase);
+
+    return hash;
+}
+
+AnimationSystem::Statistics::Statistics() :
+    updatedCount(0),
+    skippedCount(0)
+{
+}
+
+AnimationSystem::SyncGroup::SyncGroup() :
+    duration(MinimumDuration),
+    frame(-1),
+    staleCount(0)
+{
+    key.list = nullptr;
+    key.clip = Graphics::AnimationList::InvalidId;
+    key.speed = 1.0f;
+    key.phase = 0.0f;
 }
 
 AnimationSystem::AnimationSystem() :
     m_componentSystem(nullptr),
+    m_visibilitySystem(nullptr),
+    m_time(0.0),
     m_initialized(false)
 {
 }
@@ -26,6 +106,36 @@ void AnimationSystem::Cleanup()
 {
     // Reset context references.
     m_componentSystem = nullptr;
+    m_visibilitySystem = nullptr;
+
+    // Reset animation time.
+    m_time = 0.0;
+
+    // Release playbacks of animation components.
+    for(auto* animation : m_playbacks.owners)
+    {
+        animation->m_playback = -1;
+    }
+
+    m_playbacks.Clear();
+
+    for(auto& group : m_syncGroups)
+    {
+        for(auto* animation : group.members)
+        {
+            animation->m_syncGroup = -1;
+            animation->m_syncIndex = -1;
+            animation->m_syncStale = false;
+        }
+    }
+
+    Utility::ClearContainer(m_syncGroups);
+    Utility::ClearContainer(m_syncGroupMap);
+
+    m_frameChanges.clear();
+
+    // Reset update statistics.
+    m_statistics = Statistics();
 
     // Reset initialization state.
     m_initialized = false;
@@ -61,6 +171,15 @@ bool AnimationSystem::Initialize(Context& context)
         return false;
     }
 
+    // Get the visibility system.
+    m_visibilitySystem = context[ContextTypes::Game].Get<VisibilitySystem>();
+
+    if(m_visibilitySystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing VisibilitySystem instance.";
+        return false;
+    }
+
     // Success!
     return m_initialized = true;
 }
@@ -70,15 +189,365 @@ void AnimationSystem::Update(float timeDelta)
     if(!m_initialized)
         return;
 
-    // Iterate over all animation components.
-    auto componentsBegin = m_componentSystem->Begin<Components::Animation>();
-    auto componentsEnd = m_componentSystem->End<Components::Animation>();
+    // Advance the animation time.
+    m_time += timeDelta;
+
+    // Release frame changes of the previous update.
+    m_frameChanges.clear();
+
+    // Reset update statistics.
+    m_statistics = Statistics();
 
-    for(auto it = componentsBegin; it != componentsEnd; ++it)
+    // Evaluate sync groups once for all of their members.
+    for(std::size_t i = 0; i < m_syncGroups.size(); ++i)
     {
-        Components::Animation& animation = it->second;
+        SyncGroup& group = m_syncGroups[i];
+
+        if(group.members.empty())
+            continue;
+
+        const Graphics::AnimationList* list = group.key.list;
+        const Graphics::AnimationList::Animation* animation = list->GetAnimation(group.key.clip);
+        assert(animation != nullptr);
 
-        // Update animation component.
-        animation.Update(timeDelta);
+        float time = (float)std::fmod(m_time * group.key.speed + group.key.phase, (double)group.duration);
+        if(time < 0.0f) time += group.duration;
+
+        int frame = list->FindFrame(*animation, time);
+
+        bool changed = frame != group.frame;
+        group.frame = frame;
+
+        // Stale members are checked for visibility at a reduced rate.
+        bool checkStale = group.staleCount != 0;
+        checkStale = checkStale && m_visibilitySystem->ShouldUpdate(VisibilitySystem::DetailLevels::Near, (int)i);
+
+        if(!changed && !checkStale)
+            continue;
+
+        for(auto* member : group.members)
+        {
+            if(!changed && !member->m_syncStale)
+                continue;
+
+            // Mark members that can't be seen as stale.
+            if(!this->IsVisible(member))
+            {
+                if(!member->m_syncStale)
+                {
+                    member->m_syncStale = true;
+                    ++group.staleCount;
+                }
+
+                ++m_statistics.skippedCount;
+                continue;
+            }
+
+            if(member->m_syncStale)
+            {
+                member->m_syncStale = false;
+                --group.staleCount;
+            }
+
+            FrameChange change;
+            change.animation = member;
+            change.frame = frame;
+
+            m_frameChanges.push_back(change);
+
+            ++m_statistics.updatedCount;
+        }
+    }
+
+    // Calculate local times of all playbacks.
+    // Kept as plain loops over arrays, so they can be vectorized.
+    const double* startTimes = m_playbacks.startTimes.data();
+    const float* speeds = m_playbacks.speeds.data();
+    const float* durations = m_playbacks.durations.data();
+    const PlaybackFlags::Type* flags = m_playbacks.flags.data();
+    float* localTimes = m_playbacks.localTimes.data();
+
+    std::size_t count = m_playbacks.owners.size();
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        localTimes[i] = (float)(m_time - startTimes[i]) * speeds[i];
+    }
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        float time = localTimes[i];
+        float duration = durations[i];
+
+        // Wrap looped animations and clamp others at their end.
+        float wrapped = time - std::floor(time / duration) * duration;
+        float clamped = std::min(time, duration);
+
+        localTimes[i] = (flags[i] & PlaybackFlags::Loop) ? wrapped : clamped;
     }
+
+    // Find current frames and write frame changes.
+    bool finished = false;
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        bool ended = !(flags[i] & PlaybackFlags::Loop) && localTimes[i] >= durations[i];
+
+        // Skip animations that can't be seen.
+        // Frame is reset to have it sent once the entity is visible again.
+        // Ended animations still have to show their last frame.
+        if(!ended && !this->IsVisible(m_playbacks.owners[i]))
+        {
+            m_playbacks.frames[i] = -1;
+            ++m_statistics.skippedCount;
+            continue;
+        }
+
+        ++m_statistics.updatedCount;
+
+        const Graphics::AnimationList* list = m_playbacks.lists[i];
+        const Graphics::AnimationList::Animation* animation = list->GetAnimation(m_playbacks.clips[i]);
+        assert(animation != nullptr);
+
+        int frame = list->FindFrame(*animation, localTimes[i]);
+
+        if(frame != m_playbacks.frames[i])
+        {
+            m_playbacks.frames[i] = frame;
+
+            FrameChange change;
+            change.animation = m_playbacks.owners[i];
+            change.frame = frame;
+
+            m_frameChanges.push_back(change);
+        }
+
+        if(ended)
+        {
+            m_playbacks.flags[i] |= PlaybackFlags::Finished;
+            finished = true;
+        }
+    }
+
+    // Apply frame changes to animation components.
+    for(const auto& change : m_frameChanges)
+    {
+        change.animation->SetFrame(change.frame);
+    }
+
+    // Stop finished animations.
+    if(finished)
+    {
+        for(std::size_t i = count; i-- > 0;)
+        {
+            if(!(m_playbacks.flags[i] & PlaybackFlags::Finished))
+                continue;
+
+            Components::Animation* animation = m_playbacks.owners[i];
+            animation->m_playing = false;
+
+            this->StopPlayback(animation);
+        }
+    }
+}
+
+double AnimationSystem::GetTime() const
+{
+    return m_time;
+}
+
+const AnimationSystem::FrameChangeList& AnimationSystem::GetFrameChanges() const
+{
+    return m_frameChanges;
+}
+
+const AnimationSystem::Statistics& AnimationSystem::GetStatistics() const
+{
+    return m_statistics;
+}
+
+void AnimationSystem::StartPlayback(Components::Animation* animation)
+{
+    assert(animation != nullptr);
+    assert(animation->m_currentAnimation != nullptr);
+
+    // Synced animations are evaluated by their group.
+    if(animation->m_sync)
+    {
+        this->RemovePlayback(animation);
+        this->JoinSyncGroup(animation);
+        return;
+    }
+
+    this->LeaveSyncGroup(animation);
+
+    // Add a new playback if needed.
+    int index = animation->m_playback;
+
+    if(index < 0)
+    {
+        index = (int)m_playbacks.owners.size();
+
+        m_playbacks.owners.push_back(animation);
+        m_playbacks.lists.push_back(nullptr);
+        m_playbacks.clips.push_back(Graphics::AnimationList::InvalidId);
+        m_playbacks.startTimes.push_back(0.0);
+        m_playbacks.speeds.push_back(1.0f);
+        m_playbacks.durations.push_back(MinimumDuration);
+        m_playbacks.flags.push_back(PlaybackFlags::None);
+        m_playbacks.frames.push_back(-1);
+        m_playbacks.localTimes.push_back(0.0f);
+
+        animation->m_playback = index;
+    }
+
+    // Set playback state.
+    // Frame is reset to have it sent on the next update.
+    m_playbacks.lists[index] = animation->m_animationList.Get();
+    m_playbacks.clips[index] = animation->m_currentId;
+    m_playbacks.startTimes[index] = animation->m_startTime;
+    m_playbacks.speeds[index] = animation->m_speed;
+    m_playbacks.durations[index] = std::max(animation->m_currentAnimation->totalDuration, MinimumDuration);
+    m_playbacks.flags[index] = animation->m_loop ? PlaybackFlags::Loop : PlaybackFlags::None;
+    m_playbacks.frames[index] = -1;
+}
+
+void AnimationSystem::StopPlayback(Components::Animation* animation)
+{
+    this->RemovePlayback(animation);
+    this->LeaveSyncGroup(animation);
+}
+
+void AnimationSystem::RemovePlayback(Components::Animation* animation)
+{
+    assert(animation != nullptr);
+
+    int index = animation->m_playback;
+
+    if(index < 0)
+        return;
+
+    assert(m_playbacks.owners[index] == animation);
+
+    // Move the last playback in place of the removed one.
+    m_playbacks.Remove(index);
+
+    if(index < (int)m_playbacks.owners.size())
+    {
+        m_playbacks.owners[index]->m_playback = index;
+    }
+
+    animation->m_playback = -1;
+}
+
+void AnimationSystem::JoinSyncGroup(Components::Animation* animation)
+{
+    assert(animation != nullptr);
+    assert(animation->m_currentAnimation != nullptr);
+
+    // Find or create the sync group.
+    SyncKey key;
+    key.list = animation->m_animationList.Get();
+    key.clip = animation->m_currentId;
+    key.speed = animation->m_speed;
+    key.phase = animation->m_syncPhase;
+
+    // Leave the previous group first, as it's removed when left empty.
+    if(animation->m_syncGroup >= 0 && !(m_syncGroups[animation->m_syncGroup].key == key))
+    {
+        this->LeaveSyncGroup(animation);
+    }
+
+    auto result = m_syncGroupMap.emplace(key, (int)m_syncGroups.size());
+
+    if(result.second)
+    {
+        SyncGroup group;
+        group.key = key;
+        group.duration = std::max(animation->m_currentAnimation->totalDuration, MinimumDuration);
+
+        m_syncGroups.push_back(group);
+    }
+
+    int groupIndex = result.first->second;
+    SyncGroup& group = m_syncGroups[groupIndex];
+
+    // Add the member if not one already.
+    if(animation->m_syncGroup != groupIndex)
+    {
+        animation->m_syncGroup = groupIndex;
+        animation->m_syncIndex = (int)group.members.size();
+
+        group.members.push_back(animation);
+    }
+
+    // Read the shared frame if the group was already evaluated.
+    if(group.frame >= 0)
+    {
+        animation->SetFrame(group.frame);
+    }
+}
+
+void AnimationSystem::LeaveSyncGroup(Components::Animation* animation)
+{
+    assert(animation != nullptr);
+
+    if(animation->m_syncGroup < 0)
+        return;
+
+    SyncGroup& group = m_syncGroups[animation->m_syncGroup];
+
+    int index = animation->m_syncIndex;
+    assert(group.members[index] == animation);
+
+    if(animation->m_syncStale)
+    {
+        animation->m_syncStale = false;
+        --group.staleCount;
+    }
+
+    // Move the last member in place of the removed one.
+    group.members[index] = group.members.back();
+    group.members[index]->m_syncIndex = index;
+    group.members.pop_back();
+
+    // Remove an empty group by moving the last group in its place.
+    if(group.members.empty())
+    {
+        int groupIndex = animation->m_syncGroup;
+        int lastIndex = (int)m_syncGroups.size() - 1;
+
+        m_syncGroupMap.erase(group.key);
+
+        if(groupIndex != lastIndex)
+        {
+            m_syncGroups[groupIndex] = std::move(m_syncGroups[lastIndex]);
+            m_syncGroupMap[m_syncGroups[groupIndex].key] = groupIndex;
+
+            for(auto* member : m_syncGroups[groupIndex].members)
+            {
+                member->m_syncGroup = groupIndex;
+            }
+        }
+
+        m_syncGroups.pop_back();
+    }
+
+    animation->m_syncGroup = -1;
+    animation->m_syncIndex = -1;
+}
+
+bool AnimationSystem::IsVisible(Components::Animation* animation) const
+{
+    assert(animation != nullptr);
+    assert(animation->m_render != nullptr);
+
+    Components::Transform* transform = animation->m_render->GetTransform();
+
+    if(transform == nullptr)
+        return true;
+
+    auto level = m_visibilitySystem->CalculateDetailLevel(transform->GetPosition());
+
+    return level == VisibilitySystem::DetailLevels::Visible;
 }
@@ -1,19 +1,61 @@
 #pragma once
 
 #include "Precompiled.hpp"
+#include "Graphics/AnimationList.hpp"
 
 //
 // Animation System
 //
+//  Keeps playback state of all animations played on the CPU in flat
+//  arrays. Frames are evaluated in closed form from the animation time,
+//  a modulo by the animation duration and a binary search over cumulative
+//  frame end times, so long hitches cost no more than regular frames.
+//  Only frame changes are passed back to animation components.
+//
+//  Looped animations played in sync share a group keyed by their clip,
+//  speed and phase. Each group is evaluated once per update and all of
+//  its members read the shared frame, so ambient animations cost as much
+//  as the number of distinct clips they play.
+//
+//  Frames of animations that are not visible are not evaluated. As frames
+//  only depend on time, they catch up once the entity becomes visible.
+//
 
 namespace Game
 {
     // Forward declarations.
     class ComponentSystem;
+    class VisibilitySystem;
+
+    namespace Components
+    {
+        class Animation;
+    }
 
     // Animation system class.
     class AnimationSystem
     {
+    public:
+        // Update statistics.
+        struct Statistics
+        {
+            Statistics();
+
+            int updatedCount;
+            int skippedCount;
+        };
+
+        // Frame change.
+        struct FrameChange
+        {
+            Components::Animation* animation;
+            int                    frame;
+        };
+
+        // Type declarations.
+        typedef Graphics::AnimationList::AnimationId AnimationId;
+        typedef std::vector<FrameChange> FrameChangeList;
+
     public:
         AnimationSystem();
         ~AnimationSystem();
@@ -24,12 +66,131 @@ namespace Game
         // Initializes the animation system.
         bool Initialize(Context& context);
 
-        // Updates all animation components.
+        // Updates all playing animations.
         void Update(float timeDelta);
 
+        // Gets the animation time.
+        // Shared by all animations, including ones played on the GPU.
+        double GetTime() const;
+
+        // Gets frame changes written by the last update.
+        const FrameChangeList& GetFrameChanges() const;
+
+        // Gets statistics of the last update.
+        const Statistics& GetStatistics() const;
+
+    private:
+        // Starts or restarts a playback of an animation component.
+        void StartPlayback(Components::Animation* animation);
+
+        // Stops a playback of an animation component.
+        void StopPlayback(Components::Animation* animation);
+
+        // Removes an animation component from the playback arrays.
+        void RemovePlayback(Components::Animation* animation);
+
+        // Adds an animation component to a sync group.
+        void JoinSyncGroup(Components::Animation* animation);
+
+        // Removes an animation component from its sync group.
+        void LeaveSyncGroup(Components::Animation* animation);
+
+        // Checks if the entity of an animation component is visible.
+        bool IsVisible(Components::Animation* animation) const;
+
+        // Allows animation components to manage their playback.
+        friend class Components::Animation;
+
+    private:
+        // Playback flags.
+        struct PlaybackFlags
+        {
+            enum
+            {
+                None     = 0,
+                Loop     = 1 << 0,
+                Finished = 1 << 1,
+            };
+
+            typedef uint8_t Type;
+        };
+
+        // Playback arrays.
+        //  Every playback is stored at the same index of each array.
+        struct PlaybackArrays
+        {
+            // Clears all arrays.
+            void Clear();
+
+            // Removes a playback by moving the last one in its place.
+            void Remove(std::size_t index);
+
+            std::vector<Components::Animation*>         owners;
+            std::vector<const Graphics::AnimationList*> lists;
+            std::vector<AnimationId>                    clips;
+            std::vector<double>                         startTimes;
+            std::vector<float>                          speeds;
+            std::vector<float>                          durations;
+            std::vector<PlaybackFlags::Type>            flags;
+            std::vector<int>                            frames;
+            std::vector<float>                          localTimes;
+        };
+
+        // Sync group key.
+        struct SyncKey
+        {
+            bool operator==(const SyncKey& other) const;
+
+            const Graphics::AnimationList* list;
+            AnimationId                    clip;
+            float                          speed;
+            float                          phase;
+        };
+
+        struct SyncKeyHash
+        {
+            std::size_t operator()(const SyncKey& key) const;
+        };
+
+        // Sync group.
+        //  Members keep their index in the group for constant time removal.
+        //  Members that were not visible on a frame change are marked stale.
+        struct SyncGroup
+        {
+            SyncGroup();
+
+            SyncKey                             key;
+            float                               duration;
+            int                                 frame;
+            int                                 staleCount;
+            std::vector<Components::Animation*> members;
+        };
+
+        typedef std::vector<SyncGroup> SyncGroupList;
+        typedef std::unordered_map<SyncKey, int, SyncKeyHash> SyncGroupMap;
+
     private:
         // Context references.
-        ComponentSystem* m_componentSystem;
+        ComponentSystem*  m_componentSystem;
+        VisibilitySystem* m_visibilitySystem;
+
+        // Animation time.
+        double m_time;
+
+        // Playing animations.
+        PlaybackArrays m_playbacks;
+
+        // Sync groups.
+        //  Empty groups are removed, as reloaded animation lists
+        //  get new addresses and would add new groups forever.
+        SyncGroupList m_syncGroups;
+        SyncGroupMap  m_syncGroupMap;
+
+        // Frame changes of the last update.
+        FrameChangeList m_frameChanges;
+
+        // Update statistics.
+        Statistics m_statistics;
 
         // Initialization state.
         bool m_initialized;
@@ -2,23 +2,36 @@
 #include "Animation.hpp"
 #include "Render.hpp"
 #include "Game/ComponentSystem.hpp"
+#include "Game/AnimationSystem.hpp"
 using namespace Game;
 using namespace Components;
 
 Animation::Animation() :
+    m_animationSystem(nullptr),
     m_render(nullptr),
+    m_currentId(Graphics::AnimationList::InvalidId),
     m_currentAnimation(nullptr),
-    m_currentFrame(nullptr),
-    m_frameIndex(0),
-    m_frameTime(0.0f),
+    m_startTime(0.0),
+    m_speed(1.0f),
+    m_syncPhase(0.0f),
     m_playing(false),
     m_loop(false),
-    m_update(false)
+    m_gpu(false),
+    m_sync(false),
+    m_playback(-1),
+    m_syncGroup(-1),
+    m_syncIndex(-1),
+    m_syncStale(false)
 {
 }
 
 Animation::~Animation()
 {
+    // Remove playback from the animation system.
+    if(m_animationSystem != nullptr)
+    {
+        m_animationSystem->StopPlayback(this);
+    }
 }
 
 bool Animation::Finalize(EntityHandle self, const Context& context)
@@ -27,99 +40,53 @@ bool Animation::Finalize(EntityHandle self, const Context& context)
     ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
     if(componentSystem == nullptr) return false;
 
+    m_animationSystem = context[ContextTypes::Game].Get<AnimationSystem>();
+    if(m_animationSystem == nullptr) return false;
+
     // Get required components.
     m_render = componentSystem->Lookup<Render>(self);
     if(m_render == nullptr) return false;
 
+    // Start an animation played before finalization.
+    if(m_playing)
+    {
+        m_startTime = m_animationSystem->GetTime();
+        this->Start();
+    }
+
     return true;
 }
 
-void Animation::SetAnimationList(AnimationListPtr animationList)
+void Animation::SetAnimationList(const AnimationListHandle& animationList)
 {
     this->Stop();
 
     m_animationList = animationList;
+    m_currentId = Graphics::AnimationList::InvalidId;
     m_currentAnimation = nullptr;
-    m_currentFrame = nullptr;
 }
 
-const Animation::AnimationListPtr& Animation::GetAnimationList() const
+const Animation::AnimationListHandle& Animation::GetAnimationList() const
 {
     return m_animationList;
 }
 
-void Animation::Update(float timeDelta)
+void Animation::Play(const std::string& name, PlayFlags::Type flags)
 {
-    if(m_playing)
-    {
-        assert(m_currentAnimation != nullptr);
-        assert(m_currentFrame != nullptr);
-
-        // Update animation frame.
-        while(m_frameTime > m_currentFrame->duration)
-        {
-            // Substract time of already played frame.
-            m_frameTime -= m_currentFrame->duration;
-            
-            // Advance to the next frame.
-            ++m_frameIndex;
-
-            // Check if we are past the last frame.
-            if(m_frameIndex >= m_currentAnimation->frames.size())
-            {
-                if(m_loop)
-                {
-                    // Go back to the first frame if looped.
-                    m_currentFrame = &m_currentAnimation->frames[0];
-                    m_frameIndex = 0;
-                }
-                else
-                {
-                    // Stop playing the animation.
-                    m_playing = false;
-                    return;
-                }
-            }
-            else
-            {
-                // Set the next animation frame.
-                m_currentFrame = &m_currentAnimation->frames[m_frameIndex];
-            }
-
-            // Set frame change state.
-            m_update = true;
-        }
-
-        // Set the animation frame sprite.
-        if(m_update)
-        {
-            assert(m_render != nullptr);
-
-            m_render->SetTexture(m_animationList->GetTexture());
-            m_render->SetRectangle(m_currentFrame->rectangle);
-            m_render->SetOffset(m_currentFrame->offset);
-
-            m_update = false;
-        }
+    if(!m_animationList.IsValid())
+        return;
 
-        // Increment frame time.
-        m_frameTime += timeDelta;
-    }
+    // Resolve the animation name.
+    this->Play(m_animationList->GetAnimationId(name), flags);
 }
 
-void Animation::Play(std::string name, PlayFlags::Type flags)
+void Animation::Play(AnimationId id, PlayFlags::Type flags)
 {
-    if(m_animationList == nullptr)
-        return;
-
-    // Get the animation.
-    const auto* animation = m_animationList->GetAnimation(name);
-
-    if(animation == nullptr)
+    if(!m_animationList.IsValid())
         return;
 
     // Check if it's the current animation.
-    if(m_currentAnimation == animation)
+    if(m_currentId == id)
     {
         // Ignore the request to play the same animation again
         // if we didn't specify that we want to reset it.
@@ -127,34 +94,173 @@ void Animation::Play(std::string name, PlayFlags::Type flags)
             return;
     }
 
+    // Get the animation.
+    const auto* animation = m_animationList->GetAnimation(id);
+
+    if(animation == nullptr)
+        return;
+
     // Play the animation.
+    // Continued animation preserves its start time, and so its current frame.
     bool continueAnimation = (flags & PlayFlags::Continue) != 0;
-    continueAnimation = continueAnimation && m_currentAnimation == animation;
-    continueAnimation = continueAnimation && m_frameIndex < m_currentAnimation->frames.size();
+    continueAnimation = continueAnimation && m_currentId == id && m_playing;
 
-    if(continueAnimation)
+    if(!continueAnimation)
     {
-        // Change animation but preserve the frame index and time.
-        m_currentAnimation = animation;
-        m_currentFrame = &animation->frames[m_frameIndex];
+        m_startTime = m_animationSystem != nullptr ? m_animationSystem->GetTime() : 0.0;
     }
-    else
+
+    m_currentId = id;
+    m_currentAnimation = animation;
+    m_loop = (flags & PlayFlags::Loop) != 0;
+    m_playing = true;
+
+    // Check if the animation can be played on the GPU.
+    m_gpu = (flags & PlayFlags::Gpu) != 0;
+    m_gpu = m_gpu && m_loop && animation->totalDuration > 0.0f;
+    m_gpu = m_gpu && m_animationList->GetFrameTable() != nullptr;
+
+    // Check if the animation is synced with the global clock.
+    m_sync = (flags & PlayFlags::Sync) != 0 && m_loop;
+
+    // Start the animation.
+    // Components are started on finalization if not finalized yet.
+    if(m_animationSystem != nullptr)
+    {
+        this->Start();
+    }
+}
+
+void Animation::Start()
+{
+    assert(m_animationSystem != nullptr);
+    assert(m_render != nullptr);
+    assert(m_currentAnimation != nullptr);
+
+    m_render->SetTexture(m_animationList->GetTexture());
+
+    // Synced animations start at the beginning of the global clock.
+    if(m_sync)
     {
-        // Start new animation.
-        m_currentAnimation = animation;
-        m_currentFrame = &animation->frames[0];
-        m_frameIndex = 0;
-        m_frameTime = 0.0f;
+        m_startTime = -m_syncPhase / m_speed;
     }
 
-    m_loop = flags & PlayFlags::Loop;
-    m_playing = true;
-    m_update = true;
+    if(m_gpu)
+    {
+        // Hand the animation over to the shader.
+        m_animationSystem->StopPlayback(this);
+
+        glm::vec4 animation;
+        animation.x = (float)m_currentAnimation->firstFrame;
+        animation.y = (float)m_currentAnimation->frameCount;
+        animation.z = (float)m_startTime;
+        animation.w = m_speed;
+
+        this->SetFrame(m_animationList->FindFrame(*m_currentAnimation, this->CalculateLocalTime()));
+        m_render->SetOffset(glm::vec2(0.0f, 0.0f));
+        m_render->SetFrameAnimation(m_animationList->GetFrameTable(), animation);
+    }
+    else
+    {
+        // Hand the animation over to the animation system.
+        m_render->SetFrameAnimation(nullptr, glm::vec4(0.0f));
+
+        m_animationSystem->StartPlayback(this);
+    }
 }
 
 void Animation::Stop()
 {
+    if(m_playing && m_animationSystem != nullptr)
+    {
+        if(m_gpu)
+        {
+            // Freeze the sprite on the frame shown by the shader.
+            m_render->SetFrameAnimation(nullptr, glm::vec4(0.0f));
+            this->SetFrame(m_animationList->FindFrame(*m_currentAnimation, this->CalculateLocalTime()));
+        }
+        else
+        {
+            // Last frame set by the animation system stays.
+            m_animationSystem->StopPlayback(this);
+        }
+    }
+
     m_playing = false;
+    m_gpu = false;
+    m_sync = false;
+}
+
+void Animation::SetSpeed(float speed)
+{
+    if(speed <= 0.0f || speed == m_speed)
+        return;
+
+    // Adjust the start time to preserve the current frame.
+    if(m_animationSystem != nullptr)
+    {
+        double time = m_animationSystem->GetTime();
+        m_startTime = time - (time - m_startTime) * m_speed / speed;
+    }
+
+    m_speed = speed;
+
+    // Restart with the new speed.
+    if(m_playing && m_animationSystem != nullptr)
+    {
+        this->Start();
+    }
+}
+
+float Animation::GetSpeed() const
+{
+    return m_speed;
+}
+
+void Animation::SetSyncPhase(float phase)
+{
+    if(phase == m_syncPhase)
+        return;
+
+    m_syncPhase = phase;
+
+    // Restart with the new phase.
+    if(m_playing && m_sync && m_animationSystem != nullptr)
+    {
+        this->Start();
+    }
+}
+
+float Animation::GetSyncPhase() const
+{
+    return m_syncPhase;
+}
+
+void Animation::SetFrame(int frame)
+{
+    assert(m_render != nullptr);
+
+    const Graphics::AnimationList::Frame& entry = m_animationList->GetFrame(frame);
+
+    m_render->SetRectangle(entry.rectangle);
+    m_render->SetOffset(entry.offset);
+}
+
+float Animation::CalculateLocalTime() const
+{
+    assert(m_currentAnimation != nullptr);
+    assert(m_animationSystem != nullptr);
+
+    double duration = m_currentAnimation->totalDuration;
+    double time = (m_animationSystem->GetTime() - m_startTime) * m_speed;
+
+    if(m_loop && duration > 0.0)
+    {
+        time = std::fmod(time, duration);
+        if(time < 0.0) time += duration;
+    }
+
+    return (float)time;
 }
 
 bool Animation::IsPlaying() const
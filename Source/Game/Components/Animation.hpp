@@ -7,9 +7,25 @@
 //
 // Animation Component
 //
+//  Playback state of animations is kept by the animation system, which
+//  evaluates all playing animations at once and only informs components
+//  of frame changes.
+//
+//  Looped animations can be played on the GPU with the Gpu flag. Frames
+//  are then picked by the sprite shader from the frame table of the
+//  animation list, and the component does no work until the animation
+//  is changed or stopped.
+//
+//  Looped animations played with the Sync flag run on the global clock,
+//  offset by the sync phase. Animations of the same clip, speed and phase
+//  share their evaluation, which makes crowds of ambient animations cheap.
+//
 
 namespace Game
 {
+    // Forward declarations.
+    class AnimationSystem;
+
     namespace Components
     {
         // Forward declarations.
@@ -28,33 +44,49 @@ namespace Game
                     Continue = 1 << 0,
                     Loop     = 1 << 1,
                     Reset    = 1 << 2,
+                    Gpu      = 1 << 3,
+                    Sync     = 1 << 4,
                 };
 
                 typedef unsigned int Type;
             };
 
             // Type declarations.
-            typedef std::shared_ptr<const Graphics::AnimationList> AnimationListPtr;
+            typedef System::ResourceHandle<Graphics::AnimationList> AnimationListHandle;
+            typedef Graphics::AnimationList::AnimationId AnimationId;
 
         public:
             Animation();
             ~Animation();
 
             // Sets the animation list.
-            void SetAnimationList(AnimationListPtr animationList);
+            void SetAnimationList(const AnimationListHandle& animationList);
 
             // Gets the animation list.
-            const AnimationListPtr& GetAnimationList() const;
-
-            // Updates the component.
-            void Update(float timeDelta);
+            const AnimationListHandle& GetAnimationList() const;
 
             // Plays an animation from the list.
-            void Play(std::string name, PlayFlags::Type flags);
+            // Names should be resolved into ids beforehand in frequently
+            // called code, as playing by id does no string lookups.
+            void Play(AnimationId id, PlayFlags::Type flags);
+            void Play(const std::string& name, PlayFlags::Type flags);
 
             // Stops the current animation.
             void Stop();
 
+            // Sets the playback speed.
+            // Speed has to be positive, current frame is preserved.
+            void SetSpeed(float speed);
+
+            // Gets the playback speed.
+            float GetSpeed() const;
+
+            // Sets the phase of synced animations (in seconds).
+            void SetSyncPhase(float phase);
+
+            // Gets the phase of synced animations.
+            float GetSyncPhase() const;
+
             // Checks if an animation is playing.
             bool IsPlaying() const;
 
@@ -63,21 +95,47 @@ namespace Game
             bool Finalize(EntityHandle self, const Context& context) override;
 
         private:
+            // Hands the current animation over to the animation system or the shader.
+            void Start();
+
+            // Sets the sprite of a frame from the frame array.
+            void SetFrame(int frame);
+
+            // Calculates the time within the current animation.
+            float CalculateLocalTime() const;
+
+            // Allows the animation system to manage playback.
+            friend class Game::AnimationSystem;
+
+        private:
+            // Animation system reference.
+            AnimationSystem* m_animationSystem;
+
             // Entity render component.
             Render* m_render;
 
             // Animation list resource.
-            AnimationListPtr m_animationList;
+            AnimationListHandle m_animationList;
 
             // Animation state.
+            AnimationId                               m_currentId;
             const Graphics::AnimationList::Animation* m_currentAnimation;
-            const Graphics::AnimationList::Frame*     m_currentFrame;
 
-            std::size_t m_frameIndex;
-            float       m_frameTime;
-            bool        m_playing;
-            bool        m_loop;
-            bool        m_update;
+            double m_startTime;
+            float  m_speed;
+            float  m_syncPhase;
+            bool   m_playing;
+            bool   m_loop;
+            bool   m_gpu;
+            bool   m_sync;
+
+            // Index of the playback in the animation system.
+            int m_playback;
+
+            // Sync group and index within it.
+            int  m_syncGroup;
+            int  m_syncIndex;
+            bool m_syncStale;
         };
     }
 }
@@ -0,0 +1,176 @@
+#include "Precompiled.hpp"
+#include "Camera.hpp"
+#include "Transform.hpp"
+#include "Game/ComponentSystem.hpp"
+#include "System/Window.hpp"
+using namespace Game;
+using namespace Components;
+
+Camera::Camera() :
+    m_viewSize(10.0f, 10.0f),
+    m_viewport(0.0f, 0.0f, 1.0f, 1.0f),
+    m_order(0),
+    m_clearColor(1.0f, 1.0f, 1.0f, 1.0f),
+    m_pixelsPerUnit(0.0f),
+    m_windowSize(0, 0),
+    m_position(0.0f, 0.0f),
+    m_pixelViewport(0, 0, 0, 0),
+    m_viewTransform(1.0f),
+    m_visibleBounds(0.0f, 0.0f, 0.0f, 0.0f),
+    m_rebuild(true),
+    m_transform(nullptr)
+{
+    m_screenSpace.SetTargetSize(m_viewSize.x, m_viewSize.y);
+}
+
+Camera::~Camera()
+{
+}
+
+bool Camera::Finalize(EntityHandle self, const Context& context)
+{
+    // Get required systems.
+    ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+    if(componentSystem == nullptr) return false;
+
+    System::Window* window = context[ContextTypes::Main].Get<System::Window>();
+    if(window == nullptr) return false;
+
+    // Get required components.
+    m_transform = componentSystem->Lookup<Transform>(self);
+    if(m_transform == nullptr) return false;
+
+    // Get the initial window size.
+    // Following changes are passed by the render system.
+    this->SetWindowSize(window->GetWidth(), window->GetHeight());
+
+    return true;
+}
+
+void Camera::SetViewSize(const glm::vec2& size)
+{
+    m_viewSize = size;
+    m_screenSpace.SetTargetSize(size.x, size.y);
+
+    m_rebuild = true;
+}
+
+void Camera::SetViewport(const glm::vec4& viewport)
+{
+    m_viewport = viewport;
+
+    m_rebuild = true;
+}
+
+void Camera::SetOrder(int order)
+{
+    m_order = order;
+}
+
+void Camera::SetClearColor(const glm::vec4& color)
+{
+    m_clearColor = color;
+}
+
+void Camera::SetWindowSize(int width, int height)
+{
+    if(m_windowSize.x == width && m_windowSize.y == height)
+        return;
+
+    m_windowSize = glm::ivec2(width, height);
+
+    m_rebuild = true;
+}
+
+void Camera::SetPixelsPerUnit(float pixels)
+{
+    if(m_pixelsPerUnit == pixels)
+        return;
+
+    m_pixelsPerUnit = pixels;
+    m_screenSpace.SetPixelsPerUnit(pixels);
+
+    m_rebuild = true;
+}
+
+bool Camera::Update()
+{
+    if(m_transform == nullptr)
+        return false;
+
+    // Check if the view has changed.
+    const glm::vec2& position = m_transform->GetPosition();
+
+    if(!m_rebuild && position == m_position)
+        return false;
+
+    // Calculate the viewport rectangle.
+    if(m_rebuild)
+    {
+        m_pixelViewport.x = (int)(m_viewport.x * m_windowSize.x);
+        m_pixelViewport.y = (int)(m_viewport.y * m_windowSize.y);
+        m_pixelViewport.z = (int)(m_viewport.z * m_windowSize.x);
+        m_pixelViewport.w = (int)(m_viewport.w * m_windowSize.y);
+
+        m_screenSpace.SetSourceSize(m_pixelViewport.z, m_pixelViewport.w);
+    }
+
+    // Snap the view to whole pixels.
+    glm::vec2 center = position;
+
+    if(m_pixelsPerUnit > 0.0f)
+    {
+        center = glm::round(center * m_pixelsPerUnit) / m_pixelsPerUnit;
+    }
+
+    // Calculate view transform and visible bounds.
+    const glm::vec4& rectangle = m_screenSpace.GetRectangle();
+
+    m_viewTransform = m_screenSpace.GetProjection() * glm::translate(glm::mat4(1.0f), -glm::vec3(center, 0.0f));
+    m_visibleBounds = rectangle + glm::vec4(center.x, center.x, center.y, center.y);
+
+    m_position = position;
+    m_rebuild = false;
+
+    return true;
+}
+
+const glm::vec2& Camera::GetViewSize() const
+{
+    return m_viewSize;
+}
+
+int Camera::GetOrder() const
+{
+    return m_order;
+}
+
+const glm::vec4& Camera::GetClearColor() const
+{
+    return m_clearColor;
+}
+
+const glm::ivec4& Camera::GetPixelViewport() const
+{
+    return m_pixelViewport;
+}
+
+const glm::ivec2& Camera::GetPixelSize() const
+{
+    return m_screenSpace.GetPixelSize();
+}
+
+const glm::mat4& Camera::GetViewTransform() const
+{
+    return m_viewTransform;
+}
+
+const glm::vec4& Camera::GetVisibleBounds() const
+{
+    return m_visibleBounds;
+}
+
+Transform* Camera::GetTransform()
+{
+    return m_transform;
+}
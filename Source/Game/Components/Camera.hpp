@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Game/Component.hpp"
+#include "Game/EntityHandle.hpp"
+#include "Graphics/ScreenSpace.hpp"
+
+//
+// Camera Component
+//
+//  Defines a view of the world rendered into a rectangle of the window.
+//  Camera is centered at the entity position and encloses a view of the
+//  specified size, preserving its aspect ratio. View projection and visible
+//  bounds are cached and only rebuilt when the window resizes, the camera
+//  moves or one of its parameters changes.
+//
+//  Multiple cameras can be used at once (e.g. for split screen or minimap),
+//  each rendering its own culled set of sprites. Cameras are drawn in the
+//  order of their order values.
+//
+//  Creating a camera for the left half of the window:
+//      auto camera = componentSystem.Create<Game::Components::Camera>(entity);
+//      camera->SetViewSize(glm::vec2(10.0f, 10.0f));
+//      camera->SetViewport(glm::vec4(0.0f, 0.0f, 0.5f, 1.0f));
+//
+
+namespace Game
+{
+    // Forward declarations.
+    class RenderSystem;
+
+    namespace Components
+    {
+        // Forward declarations.
+        class Transform;
+
+        // Camera component class.
+        class Camera : public Component
+        {
+        public:
+            Camera();
+            ~Camera();
+
+            // Sets the size of the view (in world units).
+            void SetViewSize(const glm::vec2& size);
+
+            // Sets the viewport rectangle (x, y, width, height).
+            // Rectangle is specified as a fraction of the window size.
+            void SetViewport(const glm::vec4& viewport);
+
+            // Sets the draw order among other cameras.
+            void SetOrder(int order);
+
+            // Sets the clear color.
+            void SetClearColor(const glm::vec4& color);
+
+            // Updates cached view parameters if needed.
+            // Returns true if view parameters have changed.
+            bool Update();
+
+            // Gets the size of the view.
+            const glm::vec2& GetViewSize() const;
+
+            // Gets the draw order.
+            int GetOrder() const;
+
+            // Gets the clear color.
+            const glm::vec4& GetClearColor() const;
+
+            // Gets the viewport rectangle in window pixels (x, y, width, height).
+            const glm::ivec4& GetPixelViewport() const;
+
+            // Gets the size of the view in pixels.
+            // Returns zero if pixel snapping is disabled.
+            const glm::ivec2& GetPixelSize() const;
+
+            // Gets the combined view and projection transform.
+            const glm::mat4& GetViewTransform() const;
+
+            // Gets visible world bounds.
+            // Returns a [left, right, bottom, top] vector.
+            const glm::vec4& GetVisibleBounds() const;
+
+            // Gets the transform component.
+            Transform* GetTransform();
+
+        protected:
+            // Finalizes the camera component.
+            bool Finalize(EntityHandle self, const Context& context) override;
+
+        private:
+            // Sets the window size.
+            void SetWindowSize(int width, int height);
+
+            // Sets the number of pixels per world unit the view is snapped to.
+            void SetPixelsPerUnit(float pixels);
+
+            // Allows the render system to update window parameters.
+            friend class Game::RenderSystem;
+
+        private:
+            // View parameters.
+            glm::vec2  m_viewSize;
+            glm::vec4  m_viewport;
+            int        m_order;
+            glm::vec4  m_clearColor;
+            float      m_pixelsPerUnit;
+            glm::ivec2 m_windowSize;
+
+            // Cached view state.
+            Graphics::ScreenSpace m_screenSpace;
+
+            glm::vec2  m_position;
+            glm::ivec4 m_pixelViewport;
+            glm::mat4  m_viewTransform;
+            glm::vec4  m_visibleBounds;
+            bool       m_rebuild;
+
+            // Entity components.
+            Transform* m_transform;
+        };
+    }
+}
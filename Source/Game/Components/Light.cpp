@@ -0,0 +1,88 @@
+#include "Precompiled.hpp"
+#include "Light.hpp"
+#include "Transform.hpp"
+#include "Game/ComponentSystem.hpp"
+using namespace Game;
+using namespace Components;
+
+Light::Light() :
+    m_color(1.0f, 1.0f, 1.0f),
+    m_intensity(1.0f),
+    m_radius(1.0f),
+    m_offset(0.0f, 0.0f),
+    m_enabled(true),
+    m_transform(nullptr)
+{
+}
+
+Light::~Light()
+{
+}
+
+bool Light::Finalize(EntityHandle self, const Context& context)
+{
+    // Get required systems.
+    ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+    if(componentSystem == nullptr) return false;
+
+    // Get required components.
+    m_transform = componentSystem->Lookup<Transform>(self);
+    if(m_transform == nullptr) return false;
+
+    return true;
+}
+
+void Light::SetColor(const glm::vec3& color)
+{
+    m_color = color;
+}
+
+void Light::SetIntensity(float intensity)
+{
+    m_intensity = std::max(0.0f, intensity);
+}
+
+void Light::SetRadius(float radius)
+{
+    m_radius = std::max(0.0f, radius);
+}
+
+void Light::SetOffset(const glm::vec2& offset)
+{
+    m_offset = offset;
+}
+
+void Light::SetEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+const glm::vec3& Light::GetColor() const
+{
+    return m_color;
+}
+
+float Light::GetIntensity() const
+{
+    return m_intensity;
+}
+
+float Light::GetRadius() const
+{
+    return m_radius;
+}
+
+const glm::vec2& Light::GetOffset() const
+{
+    return m_offset;
+}
+
+bool Light::IsEnabled() const
+{
+    return m_enabled;
+}
+
+Transform* Light::GetTransform()
+{
+    return m_transform;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Game/Component.hpp"
+#include "Game/EntityHandle.hpp"
+
+//
+// Light Component
+//
+//  Point light placed at the entity position. Light falls off
+//  quadratically and reaches zero at the edge of its radius.
+//  Lit scene is the unlit scene multiplied by the sum of the ambient
+//  color and all lights, so lights can't brighten sprites above their
+//  own colors.
+//
+//  Creating a light:
+//      auto light = componentSystem.Create<Game::Components::Light>(entity);
+//      light->SetColor(glm::vec3(1.0f, 0.8f, 0.6f));
+//      light->SetRadius(4.0f);
+//
+
+namespace Game
+{
+    namespace Components
+    {
+        // Forward declarations.
+        class Transform;
+
+        // Light component class.
+        class Light : public Component
+        {
+        public:
+            Light();
+            ~Light();
+
+            // Sets the light color.
+            void SetColor(const glm::vec3& color);
+
+            // Sets the light intensity.
+            void SetIntensity(float intensity);
+
+            // Sets the light radius (in world units).
+            void SetRadius(float radius);
+
+            // Sets the offset from the entity position.
+            void SetOffset(const glm::vec2& offset);
+
+            // Sets the enabled state.
+            void SetEnabled(bool enabled);
+
+            // Gets the light color.
+            const glm::vec3& GetColor() const;
+
+            // Gets the light intensity.
+            float GetIntensity() const;
+
+            // Gets the light radius.
+            float GetRadius() const;
+
+            // Gets the offset from the entity position.
+            const glm::vec2& GetOffset() const;
+
+            // Checks if the light is enabled.
+            bool IsEnabled() const;
+
+            // Gets the transform component.
+            Transform* GetTransform();
+
+        protected:
+            // Finalizes the light component.
+            bool Finalize(EntityHandle self, const Context& context) override;
+
+        private:
+            // Light parameters.
+            glm::vec3 m_color;
+            float     m_intensity;
+            float     m_radius;
+            glm::vec2 m_offset;
+            bool      m_enabled;
+
+            // Entity components.
+            Transform* m_transform;
+        };
+    }
+}
@@ -0,0 +1,260 @@
+#include "Precompiled.hpp"
+#include "ParticleEmitter.hpp"
+#include "Transform.hpp"
+#include "Game/ComponentSystem.hpp"
+#include "Graphics/Texture.hpp"
+#include "Graphics/AnimationList.hpp"
+using namespace Game;
+using namespace Components;
+
+namespace
+{
+    // Rounds a particle count up to a multiple of four.
+    int PadParticleCount(int count)
+    {
+        return (count + 3) & ~3;
+    }
+}
+
+ParticleEmitter::Particles::Particles() :
+    count(0)
+{
+}
+
+ParticleEmitter::ParticleEmitter() :
+    m_emissionRate(0.0f),
+    m_emissionTime(0.0f),
+    m_lifetime(1.0f, 1.0f),
+    m_speed(1.0f, 1.0f),
+    m_direction(0.0f),
+    m_spread(glm::pi<float>()),
+    m_maxParticles(0),
+    m_emitting(true),
+    m_acceleration(0.0f, 0.0f),
+    m_startColor(1.0f, 1.0f, 1.0f, 1.0f),
+    m_endColor(1.0f, 1.0f, 1.0f, 1.0f),
+    m_scale(1.0f, 1.0f),
+    m_layer(0),
+    m_transparent(true),
+    m_random(std::random_device()()),
+    m_transform(nullptr)
+{
+    this->SetMaxParticles(1024);
+}
+
+ParticleEmitter::~ParticleEmitter()
+{
+}
+
+bool ParticleEmitter::Finalize(EntityHandle self, const Context& context)
+{
+    // Get required systems.
+    ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+    if(componentSystem == nullptr) return false;
+
+    // Get required components.
+    m_transform = componentSystem->Lookup<Transform>(self);
+    if(m_transform == nullptr) return false;
+
+    return true;
+}
+
+void ParticleEmitter::SetSprite(const TextureHandle& texture, const glm::vec4& rectangle)
+{
+    m_texture = texture;
+
+    m_frames.clear();
+    m_frames.push_back(rectangle);
+}
+
+void ParticleEmitter::SetAnimation(const AnimationListHandle& animationList, std::string name)
+{
+    m_texture = TextureHandle();
+    m_frames.clear();
+
+    if(!animationList.IsValid())
+        return;
+
+    const Graphics::AnimationList::Animation* animation = animationList->GetAnimation(name);
+
+    if(animation == nullptr)
+        return;
+
+    // Frames are spread evenly over the particle lifetime.
+    m_texture = animationList->GetTexture();
+
+    for(int i = 0; i < animation->frameCount; ++i)
+    {
+        m_frames.push_back(animationList->GetFrame(animation->firstFrame + i).rectangle);
+    }
+}
+
+void ParticleEmitter::SetEmissionRate(float rate)
+{
+    m_emissionRate = std::max(0.0f, rate);
+}
+
+void ParticleEmitter::SetLifetime(float minimum, float maximum)
+{
+    // Lifetime can't be zero, as particles store its inverse.
+    const float MinimumLifetime = 0.001f;
+
+    m_lifetime.x = std::max(MinimumLifetime, minimum);
+    m_lifetime.y = std::max(m_lifetime.x, maximum);
+}
+
+void ParticleEmitter::SetSpeed(float minimum, float maximum)
+{
+    m_speed.x = minimum;
+    m_speed.y = std::max(minimum, maximum);
+}
+
+void ParticleEmitter::SetDirection(float angle, float spread)
+{
+    m_direction = angle;
+    m_spread = std::abs(spread);
+}
+
+void ParticleEmitter::SetAcceleration(const glm::vec2& acceleration)
+{
+    m_acceleration = acceleration;
+}
+
+void ParticleEmitter::SetColor(const glm::vec4& start, const glm::vec4& end)
+{
+    m_startColor = start;
+    m_endColor = end;
+}
+
+void ParticleEmitter::SetScale(const glm::vec2& scale)
+{
+    m_scale = scale;
+}
+
+void ParticleEmitter::SetMaxParticles(int count)
+{
+    m_maxParticles = std::max(0, count);
+
+    // Resize particle arrays.
+    int capacity = PadParticleCount(m_maxParticles);
+
+    m_particles.positionX.resize(capacity, 0.0f);
+    m_particles.positionY.resize(capacity, 0.0f);
+    m_particles.velocityX.resize(capacity, 0.0f);
+    m_particles.velocityY.resize(capacity, 0.0f);
+    m_particles.life.resize(capacity, 0.0f);
+    m_particles.lifeRate.resize(capacity, 0.0f);
+
+    m_particles.count = std::min(m_particles.count, m_maxParticles);
+}
+
+void ParticleEmitter::SetLayer(int layer)
+{
+    m_layer = layer;
+}
+
+void ParticleEmitter::SetTransparent(bool transparent)
+{
+    m_transparent = transparent;
+}
+
+void ParticleEmitter::SetEmitting(bool emitting)
+{
+    m_emitting = emitting;
+    m_emissionTime = 0.0f;
+}
+
+const ParticleEmitter::TextureHandle& ParticleEmitter::GetTexture() const
+{
+    return m_texture;
+}
+
+const ParticleEmitter::FrameList& ParticleEmitter::GetFrames() const
+{
+    return m_frames;
+}
+
+float ParticleEmitter::GetEmissionRate() const
+{
+    return m_emissionRate;
+}
+
+const glm::vec4& ParticleEmitter::GetStartColor() const
+{
+    return m_startColor;
+}
+
+const glm::vec4& ParticleEmitter::GetEndColor() const
+{
+    return m_endColor;
+}
+
+const glm::vec2& ParticleEmitter::GetAcceleration() const
+{
+    return m_acceleration;
+}
+
+const glm::vec2& ParticleEmitter::GetScale() const
+{
+    return m_scale;
+}
+
+int ParticleEmitter::GetMaxParticles() const
+{
+    return m_maxParticles;
+}
+
+int ParticleEmitter::GetLayer() const
+{
+    return m_layer;
+}
+
+bool ParticleEmitter::IsTransparent() const
+{
+    return m_transparent;
+}
+
+bool ParticleEmitter::IsEmitting() const
+{
+    return m_emitting;
+}
+
+ParticleEmitter::Particles& ParticleEmitter::GetParticles()
+{
+    return m_particles;
+}
+
+const ParticleEmitter::Particles& ParticleEmitter::GetParticles() const
+{
+    return m_particles;
+}
+
+Transform* ParticleEmitter::GetTransform()
+{
+    return m_transform;
+}
+
+bool ParticleEmitter::Emit(const glm::vec2& position)
+{
+    if(m_particles.count >= m_maxParticles)
+        return false;
+
+    // Pick random particle parameters.
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    float angle = m_direction + (unit(m_random) * 2.0f - 1.0f) * m_spread;
+    float speed = glm::mix(m_speed.x, m_speed.y, unit(m_random));
+    float lifetime = glm::mix(m_lifetime.x, m_lifetime.y, unit(m_random));
+
+    // Append the particle.
+    int index = m_particles.count++;
+
+    m_particles.positionX[index] = position.x;
+    m_particles.positionY[index] = position.y;
+    m_particles.velocityX[index] = std::cos(angle) * speed;
+    m_particles.velocityY[index] = std::sin(angle) * speed;
+    m_particles.life[index] = 0.0f;
+    m_particles.lifeRate[index] = 1.0f / lifetime;
+
+    return true;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Game/Component.hpp"
+#include "Game/EntityHandle.hpp"
+#include "System/ResourceManager.hpp"
+
+// Forward declarations.
+namespace Graphics
+{
+    class Texture;
+    class AnimationList;
+}
+
+//
+// Particle Emitter Component
+//
+//  Spawns particles at the entity position. Particle state is kept in
+//  separate arrays (structure of arrays) that the particle system updates
+//  in parallel. Particles are never individual components and are drawn
+//  as a single sprite stream. An animation can be used as a flipbook that
+//  plays over the lifetime of each particle.
+//
+//  Creating a particle emitter:
+//      auto emitter = componentSystem.Create<Game::Components::ParticleEmitter>(entity);
+//      emitter->SetAnimation(animationList, "smoke");
+//      emitter->SetEmissionRate(200.0f);
+//      emitter->SetLifetime(0.5f, 1.5f);
+//      emitter->SetSpeed(1.0f, 2.0f);
+//      emitter->SetColor(glm::vec4(1.0f), glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+//
+
+namespace Game
+{
+    // Forward declarations.
+    class ParticleSystem;
+
+    namespace Components
+    {
+        // Forward declarations.
+        class Transform;
+
+        // Particle emitter component class.
+        class ParticleEmitter : public Component
+        {
+        public:
+            // Type declarations.
+            typedef System::ResourceHandle<Graphics::Texture> TextureHandle;
+            typedef System::ResourceHandle<Graphics::AnimationList> AnimationListHandle;
+            typedef std::vector<glm::vec4> FrameList;
+
+            // Particle state arrays.
+            // Arrays are padded to a multiple of four elements, so
+            // they can be processed in vector sized steps.
+            struct Particles
+            {
+                Particles();
+
+                std::vector<float> positionX;
+                std::vector<float> positionY;
+                std::vector<float> velocityX;
+                std::vector<float> velocityY;
+
+                // Normalized age in [0, 1] range and its rate of change.
+                std::vector<float> life;
+                std::vector<float> lifeRate;
+
+                int count;
+            };
+
+        public:
+            ParticleEmitter();
+            ~ParticleEmitter();
+
+            // Sets a single sprite used by all particles.
+            void SetSprite(const TextureHandle& texture, const glm::vec4& rectangle);
+
+            // Sets an animation used as a flipbook over the particle lifetime.
+            void SetAnimation(const AnimationListHandle& animationList, std::string name);
+
+            // Sets the number of particles emitted per second.
+            void SetEmissionRate(float rate);
+
+            // Sets the range of particle lifetimes (in seconds).
+            void SetLifetime(float minimum, float maximum);
+
+            // Sets the range of initial particle speeds.
+            void SetSpeed(float minimum, float maximum);
+
+            // Sets the emission direction and spread (in radians).
+            void SetDirection(float angle, float spread);
+
+            // Sets the acceleration applied to all particles.
+            void SetAcceleration(const glm::vec2& acceleration);
+
+            // Sets the color at the beginning and the end of the particle lifetime.
+            void SetColor(const glm::vec4& start, const glm::vec4& end);
+
+            // Sets the particle scale.
+            void SetScale(const glm::vec2& scale);
+
+            // Sets the maximum number of alive particles.
+            void SetMaxParticles(int count);
+
+            // Sets the render layer.
+            void SetLayer(int layer);
+
+            // Sets transparency state.
+            void SetTransparent(bool transparent);
+
+            // Sets emitting state.
+            // Already emitted particles live until they expire.
+            void SetEmitting(bool emitting);
+
+            // Gets the texture.
+            const TextureHandle& GetTexture() const;
+
+            // Gets the list of flipbook frames.
+            const FrameList& GetFrames() const;
+
+            // Gets the number of particles emitted per second.
+            float GetEmissionRate() const;
+
+            // Gets the color at the beginning of the particle lifetime.
+            const glm::vec4& GetStartColor() const;
+
+            // Gets the color at the end of the particle lifetime.
+            const glm::vec4& GetEndColor() const;
+
+            // Gets the acceleration.
+            const glm::vec2& GetAcceleration() const;
+
+            // Gets the particle scale.
+            const glm::vec2& GetScale() const;
+
+            // Gets the maximum number of alive particles.
+            int GetMaxParticles() const;
+
+            // Gets the render layer.
+            int GetLayer() const;
+
+            // Checks if is transparent.
+            bool IsTransparent() const;
+
+            // Checks if is emitting.
+            bool IsEmitting() const;
+
+            // Gets the particle state.
+            Particles& GetParticles();
+            const Particles& GetParticles() const;
+
+            // Gets the transform component.
+            Transform* GetTransform();
+
+        protected:
+            // Finalizes the particle emitter component.
+            bool Finalize(EntityHandle self, const Context& context) override;
+
+        private:
+            // Emits a single particle at a position.
+            // Returns false if the particle limit was reached.
+            bool Emit(const glm::vec2& position);
+
+            // Allows the particle system to emit particles.
+            friend class Game::ParticleSystem;
+
+        private:
+            // Sprite resources.
+            TextureHandle m_texture;
+            FrameList  m_frames;
+
+            // Emission parameters.
+            float     m_emissionRate;
+            float     m_emissionTime;
+            glm::vec2 m_lifetime;
+            glm::vec2 m_speed;
+            float     m_direction;
+            float     m_spread;
+            int       m_maxParticles;
+            bool      m_emitting;
+
+            // Particle parameters.
+            glm::vec2 m_acceleration;
+            glm::vec4 m_startColor;
+            glm::vec4 m_endColor;
+            glm::vec2 m_scale;
+
+            // Render parameters.
+            int  m_layer;
+            bool m_transparent;
+
+            // Particle state.
+            Particles    m_particles;
+            std::mt19937 m_random;
+
+            // Entity components.
+            Transform* m_transform;
+        };
+    }
+}
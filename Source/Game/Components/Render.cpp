@@ -2,23 +2,34 @@
 #include "Render.hpp"
 #include "Transform.hpp"
 #include "Game/ComponentSystem.hpp"
+#include "Game/RenderSystem.hpp"
 #include "Graphics/Texture.hpp"
+#include "Graphics/Buffer.hpp"
 using namespace Game;
 using namespace Components;
 
 Render::Render() :
     m_offset(0.0f, 0.0f),
     m_rectangle(0.0f, 0.0f, 1.0f, 1.0f),
+    m_frameAnimation(0.0f, 0.0f, 0.0f, 0.0f),
     m_diffuseColor(1.0f, 1.0f, 1.0f, 1.0f),
     m_emissiveColor(1.0f, 1.0f, 1.0f, 1.0f),
     m_emissivePower(0.0f),
     m_transparent(true),
-    m_transform(nullptr)
+    m_layer(0),
+    m_static(false),
+    m_transform(nullptr),
+    m_renderSystem(nullptr)
 {
 }
 
 Render::~Render()
 {
+    // Remove static sprite from the render system.
+    if(m_static && m_renderSystem != nullptr)
+    {
+        m_renderSystem->RemoveStatic(this);
+    }
 }
 
 bool Render::Finalize(EntityHandle self, const Context& context)
@@ -31,12 +42,23 @@ bool Render::Finalize(EntityHandle self, const Context& context)
     m_transform = componentSystem->Lookup<Transform>(self);
     if(m_transform == nullptr) return false;
 
+    // Get the render system.
+    m_renderSystem = context[ContextTypes::Game].Get<RenderSystem>();
+    if(m_renderSystem == nullptr) return false;
+
+    // Add static sprite to the render system.
+    if(m_static)
+    {
+        m_renderSystem->AddStatic(this);
+    }
+
     return true;
 }
 
 void Render::SetOffset(const glm::vec2& offset)
 {
     m_offset = offset;
+    this->Invalidate();
 }
 
 glm::vec4 Render::CalculateColor() const
@@ -44,41 +66,91 @@ glm::vec4 Render::CalculateColor() const
     return glm::mix(m_diffuseColor, m_emissiveColor, m_emissivePower);
 }
 
-void Render::SetTexture(TexturePtr texture)
+void Render::SetTexture(const TextureHandle& texture)
 {
     m_texture = texture;
     m_rectangle = glm::vec4(0.0f, 0.0f, texture->GetWidth(), texture->GetHeight());
+    this->Invalidate();
 }
 
-void Render::SetTexture(TexturePtr texture, const glm::vec4& rectangle)
+void Render::SetTexture(const TextureHandle& texture, const glm::vec4& rectangle)
 {
     m_texture = texture;
     m_rectangle = rectangle;
+    this->Invalidate();
 }
 
 void Render::SetRectangle(const glm::vec4& rectangle)
 {
     m_rectangle = rectangle;
+    this->Invalidate();
+}
+
+void Render::SetFrameAnimation(FrameTablePtr frameTable, const glm::vec4& animation)
+{
+    m_frameTable = frameTable;
+    m_frameAnimation = frameTable != nullptr ? animation : glm::vec4(0.0f);
+    this->Invalidate();
 }
 
 void Render::SetDiffuseColor(const glm::vec4& color)
 {
     m_diffuseColor = color;
+    this->Invalidate();
 }
 
 void Render::SetEmissiveColor(const glm::vec4& color)
 {
     m_emissiveColor = color;
+    this->Invalidate();
 }
 
 void Render::SetEmissivePower(float power)
 {
     m_emissivePower = power;
+    this->Invalidate();
 }
 
 void Render::SetTransparent(bool transparent)
 {
     m_transparent = transparent;
+    this->Invalidate();
+}
+
+void Render::SetLayer(int layer)
+{
+    m_layer = layer;
+    this->Invalidate();
+}
+
+void Render::SetStatic(bool value)
+{
+    if(m_static == value)
+        return;
+
+    m_static = value;
+
+    // Update static sprites of the render system.
+    // Sprites that are not finalized yet are added on finalization.
+    if(m_renderSystem != nullptr)
+    {
+        if(m_static)
+        {
+            m_renderSystem->AddStatic(this);
+        }
+        else
+        {
+            m_renderSystem->RemoveStatic(this);
+        }
+    }
+}
+
+void Render::Invalidate()
+{
+    if(m_static && m_renderSystem != nullptr)
+    {
+        m_renderSystem->InvalidateStatic(this);
+    }
 }
 
 const glm::vec2& Render::GetOffset() const
@@ -86,7 +158,7 @@ const glm::vec2& Render::GetOffset() const
     return m_offset;
 }
 
-const Render::TexturePtr& Render::GetTexture() const
+const Render::TextureHandle& Render::GetTexture() const
 {
     return m_texture;
 }
@@ -96,6 +168,16 @@ const glm::vec4& Render::GetRectangle() const
     return m_rectangle;
 }
 
+const Render::FrameTablePtr& Render::GetFrameTable() const
+{
+    return m_frameTable;
+}
+
+const glm::vec4& Render::GetFrameAnimation() const
+{
+    return m_frameAnimation;
+}
+
 const glm::vec4& Render::GetDiffuseColor() const
 {
     return m_diffuseColor;
@@ -116,6 +198,16 @@ bool Render::IsTransparent() const
     return m_transparent;
 }
 
+int Render::GetLayer() const
+{
+    return m_layer;
+}
+
+bool Render::IsStatic() const
+{
+    return m_static;
+}
+
 Transform* Render::GetTransform()
 {
     return m_transform;
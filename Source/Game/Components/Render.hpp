@@ -3,11 +3,13 @@
 #include "Precompiled.hpp"
 #include "Game/Component.hpp"
 #include "Game/EntityHandle.hpp"
+#include "System/ResourceManager.hpp"
 
 // Forward declarations.
 namespace Graphics
 {
     class Texture;
+    class TextureBuffer;
 }
 
 //
@@ -16,6 +18,9 @@ namespace Graphics
 
 namespace Game
 {
+    // Forward declarations.
+    class RenderSystem;
+
     namespace Components
     {
         // Forward declarations.
@@ -26,7 +31,8 @@ namespace Game
         {
         public:
             // Type declarations.
-            typedef std::shared_ptr<const Graphics::Texture> TexturePtr;
+            typedef System::ResourceHandle<Graphics::Texture> TextureHandle;
+            typedef std::shared_ptr<const Graphics::TextureBuffer> FrameTablePtr;
 
         public:
             Render();
@@ -39,12 +45,17 @@ namespace Game
             void SetOffset(const glm::vec2& offset);
 
             // Sets the texture.
-            void SetTexture(TexturePtr texture);
-            void SetTexture(TexturePtr texture, const glm::vec4& rectangle);
+            void SetTexture(const TextureHandle& texture);
+            void SetTexture(const TextureHandle& texture, const glm::vec4& rectangle);
 
             // Sets the rectangle.
             void SetRectangle(const glm::vec4& rectangle);
 
+            // Sets the frame animation played by the shader.
+            // Animation is a (first frame, frame count, start time, speed)
+            // vector indexing the frame table. Pass null table to disable it.
+            void SetFrameAnimation(FrameTablePtr frameTable, const glm::vec4& animation);
+
             // Set the diffuse color.
             void SetDiffuseColor(const glm::vec4& color);
 
@@ -57,15 +68,33 @@ namespace Game
             // Sets transparency state.
             void SetTransparent(bool transparent);
 
+            // Sets the render layer.
+            void SetLayer(int layer);
+
+            // Sets static state.
+            // Static sprites are kept in graphics memory and only rebuilt when
+            // they change. Call Invalidate() after moving a static sprite.
+            // Only opaque sprites are kept static, transparent ones stay sorted.
+            void SetStatic(bool value);
+
+            // Informs the render system that a static sprite has changed.
+            void Invalidate();
+
             // Gets the offset.
             const glm::vec2& GetOffset() const;
 
             // Gets the texture.
-            const TexturePtr& GetTexture() const;
+            const TextureHandle& GetTexture() const;
 
             // Gets the rectangle.
             const glm::vec4& GetRectangle() const;
 
+            // Gets the frame table.
+            const FrameTablePtr& GetFrameTable() const;
+
+            // Gets the frame animation.
+            const glm::vec4& GetFrameAnimation() const;
+
             // Gets the diffuse color.
             const glm::vec4& GetDiffuseColor() const;
 
@@ -78,6 +107,12 @@ namespace Game
             // Checks if is transparent.
             bool IsTransparent() const;
 
+            // Gets the render layer.
+            int GetLayer() const;
+
+            // Checks if is static.
+            bool IsStatic() const;
+
             // Gets the transform component.
             Transform* GetTransform();
 
@@ -87,18 +122,29 @@ namespace Game
 
         private:
             // Texture resource.
-            TexturePtr m_texture;
+            TextureHandle m_texture;
             glm::vec4 m_rectangle;
 
+            // Frame animation.
+            FrameTablePtr m_frameTable;
+            glm::vec4 m_frameAnimation;
+
             // Render parameters.
             glm::vec2 m_offset;
             glm::vec4 m_diffuseColor;
             glm::vec4 m_emissiveColor;
             float m_emissivePower;
             bool m_transparent;
+            int m_layer;
+            bool m_static;
 
             // Entity components.
             Transform* m_transform;
+
+            // Render system reference.
+            RenderSystem* m_renderSystem;
+
+            friend class Game::RenderSystem;
         };
     }
 }
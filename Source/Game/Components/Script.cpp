@@ -1,9 +1,14 @@
 #include "Precompiled.hpp"
 #include "Script.hpp"
+#include "Transform.hpp"
+#include "Game/ComponentSystem.hpp"
 using namespace Game;
 using namespace Components;
 
-Script::Script()
+Script::Script() :
+    m_skippedTime(0.0f),
+    m_alwaysUpdate(false),
+    m_transform(nullptr)
 {
 }
 
@@ -13,6 +18,13 @@ Script::~Script()
 
 bool Script::Finalize(EntityHandle self, const Context& context)
 {
+    // Get optional components.
+    ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+    if(componentSystem == nullptr) return false;
+
+    m_transform = componentSystem->Lookup<Transform>(self);
+
+    // Finalize scripts.
     for(auto& script : m_scripts)
     {
         if(!script->OnFinalize(self, context))
@@ -24,8 +36,32 @@ bool Script::Finalize(EntityHandle self, const Context& context)
 
 void Script::Update(EntityHandle self, float timeDelta)
 {
+    // Add time of skipped updates.
+    timeDelta += m_skippedTime;
+    m_skippedTime = 0.0f;
+
     for(auto& script : m_scripts)
     {
         script->OnUpdate(self, timeDelta);
     }
 }
+
+void Script::Skip(float timeDelta)
+{
+    m_skippedTime += timeDelta;
+}
+
+void Script::SetAlwaysUpdate(bool enabled)
+{
+    m_alwaysUpdate = enabled;
+}
+
+bool Script::IsAlwaysUpdated() const
+{
+    return m_alwaysUpdate;
+}
+
+Transform* Script::GetTransform()
+{
+    return m_transform;
+}
@@ -15,6 +15,9 @@ namespace Game
 
     namespace Components
     {
+        // Forward declarations.
+        class Transform;
+
         // Script component class.
         class Script : public Component
         {
@@ -37,8 +40,22 @@ namespace Game
             }
 
             // Updates scripts.
+            // Time of skipped updates is added to the time delta.
             void Update(EntityHandle self, float timeDelta);
 
+            // Skips an update and accumulates its time delta.
+            void Skip(float timeDelta);
+
+            // Sets whether scripts are updated every frame regardless of visibility.
+            void SetAlwaysUpdate(bool enabled);
+
+            // Checks if scripts are updated every frame.
+            bool IsAlwaysUpdated() const;
+
+            // Gets the transform component.
+            // Returns null if the entity doesn't have one.
+            Transform* GetTransform();
+
         protected:
             // Finalizes scripts.
             bool Finalize(EntityHandle self, const Context& context) override;
@@ -46,6 +63,13 @@ namespace Game
         private:
             // List of scripts.
             ScriptList m_scripts;
+
+            // Update state.
+            float m_skippedTime;
+            bool  m_alwaysUpdate;
+
+            // Entity components.
+            Transform* m_transform;
         };
     }
 }
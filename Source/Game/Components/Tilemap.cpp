@@ -0,0 +1,220 @@
+#include "Precompiled.hpp"
+#include "Tilemap.hpp"
+#include "Transform.hpp"
+#include "Game/ComponentSystem.hpp"
+#include "Graphics/SpriteSheet.hpp"
+using namespace Game;
+using namespace Components;
+
+namespace
+{
+    // Invalid tile rectangle.
+    const glm::vec4 InvalidTile(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+Tilemap::Chunk::Chunk() :
+    origin(0.0f, 0.0f),
+    dirty(true)
+{
+}
+
+Tilemap::Tilemap() :
+    m_width(0),
+    m_height(0),
+    m_chunkCountX(0),
+    m_chunkCountY(0),
+    m_tileSize(1.0f, 1.0f),
+    m_layer(0),
+    m_transparent(false),
+    m_transform(nullptr)
+{
+}
+
+Tilemap::~Tilemap()
+{
+}
+
+bool Tilemap::Finalize(EntityHandle self, const Context& context)
+{
+    // Get required systems.
+    ComponentSystem* componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+    if(componentSystem == nullptr) return false;
+
+    // Get required components.
+    m_transform = componentSystem->Lookup<Transform>(self);
+    if(m_transform == nullptr) return false;
+
+    return true;
+}
+
+void Tilemap::SetSize(int width, int height)
+{
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+
+    // Create empty chunks.
+    m_chunkCountX = (m_width + ChunkSize - 1) / ChunkSize;
+    m_chunkCountY = (m_height + ChunkSize - 1) / ChunkSize;
+
+    m_chunks.clear();
+    m_chunks.resize(m_chunkCountX * m_chunkCountY);
+}
+
+void Tilemap::SetSpriteSheet(SpriteSheetPtr spriteSheet)
+{
+    m_spriteSheet = spriteSheet;
+
+    // Tile types refer to sprites of the previous sheet.
+    Utility::ClearContainer(m_tileTypes);
+
+    this->InvalidateChunks();
+}
+
+Tilemap::Tile Tilemap::AddTileType(std::string sprite)
+{
+    if(m_spriteSheet == nullptr)
+        return EmptyTile;
+
+    if(m_tileTypes.size() >= std::numeric_limits<Tile>::max())
+        return EmptyTile;
+
+    // Add sprite rectangle to the list.
+    m_tileTypes.push_back(m_spriteSheet->GetSprite(sprite));
+
+    return (Tile)m_tileTypes.size();
+}
+
+void Tilemap::SetTile(int x, int y, Tile tile)
+{
+    if(x < 0 || x >= m_width)
+        return;
+
+    if(y < 0 || y >= m_height)
+        return;
+
+    // Get the chunk.
+    Chunk& chunk = this->GetChunk(x / ChunkSize, y / ChunkSize);
+
+    if(chunk.tiles.empty())
+    {
+        if(tile == EmptyTile)
+            return;
+
+        chunk.tiles.resize(ChunkSize * ChunkSize, EmptyTile);
+    }
+
+    // Set the tile.
+    Tile& current = chunk.tiles[(y % ChunkSize) * ChunkSize + (x % ChunkSize)];
+
+    if(current != tile)
+    {
+        current = tile;
+        chunk.dirty = true;
+    }
+}
+
+void Tilemap::SetTileSize(const glm::vec2& size)
+{
+    m_tileSize = size;
+
+    this->InvalidateChunks();
+}
+
+void Tilemap::SetLayer(int layer)
+{
+    m_layer = layer;
+}
+
+void Tilemap::SetTransparent(bool transparent)
+{
+    m_transparent = transparent;
+
+    this->InvalidateChunks();
+}
+
+Tilemap::Tile Tilemap::GetTile(int x, int y) const
+{
+    if(x < 0 || x >= m_width)
+        return EmptyTile;
+
+    if(y < 0 || y >= m_height)
+        return EmptyTile;
+
+    // Get the chunk.
+    const Chunk& chunk = m_chunks[(y / ChunkSize) * m_chunkCountX + (x / ChunkSize)];
+
+    if(chunk.tiles.empty())
+        return EmptyTile;
+
+    // Return the tile.
+    return chunk.tiles[(y % ChunkSize) * ChunkSize + (x % ChunkSize)];
+}
+
+const glm::vec4& Tilemap::GetTileRectangle(Tile tile) const
+{
+    if(tile == EmptyTile || tile > m_tileTypes.size())
+        return InvalidTile;
+
+    return m_tileTypes[tile - 1];
+}
+
+const Tilemap::SpriteSheetPtr& Tilemap::GetSpriteSheet() const
+{
+    return m_spriteSheet;
+}
+
+int Tilemap::GetWidth() const
+{
+    return m_width;
+}
+
+int Tilemap::GetHeight() const
+{
+    return m_height;
+}
+
+const glm::vec2& Tilemap::GetTileSize() const
+{
+    return m_tileSize;
+}
+
+int Tilemap::GetLayer() const
+{
+    return m_layer;
+}
+
+bool Tilemap::IsTransparent() const
+{
+    return m_transparent;
+}
+
+int Tilemap::GetChunkCountX() const
+{
+    return m_chunkCountX;
+}
+
+int Tilemap::GetChunkCountY() const
+{
+    return m_chunkCountY;
+}
+
+Tilemap::Chunk& Tilemap::GetChunk(int x, int y)
+{
+    assert(x >= 0 && x < m_chunkCountX);
+    assert(y >= 0 && y < m_chunkCountY);
+
+    return m_chunks[y * m_chunkCountX + x];
+}
+
+Transform* Tilemap::GetTransform()
+{
+    return m_transform;
+}
+
+void Tilemap::InvalidateChunks()
+{
+    for(auto& chunk : m_chunks)
+    {
+        chunk.dirty = true;
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Game/Component.hpp"
+#include "Game/EntityHandle.hpp"
+
+// Forward declarations.
+namespace Graphics
+{
+    class SpriteSheet;
+    class SpriteBuffer;
+}
+
+//
+// Tilemap Component
+//
+//  Grid of tiles that reference sprites of a sprite sheet. Tiles are stored
+//  in fixed size chunks, each baked into a sprite buffer by the render system
+//  when it becomes visible. Editing a tile only rebuilds the chunk it's in.
+//  Map origin (bottom left corner) is placed at the transform position,
+//  and visible chunks are baked again when it moves.
+//
+//  Creating a tilemap:
+//      auto tilemap = componentSystem.Create<Game::Components::Tilemap>(entity);
+//      tilemap->SetSpriteSheet(spriteSheet);
+//      tilemap->SetSize(1024, 1024);
+//
+//      auto grass = tilemap->AddTileType("grass");
+//      tilemap->SetTile(0, 0, grass);
+//
+
+namespace Game
+{
+    namespace Components
+    {
+        // Forward declarations.
+        class Transform;
+
+        // Tilemap component class.
+        class Tilemap : public Component
+        {
+        public:
+            // Type declarations.
+            typedef uint16_t Tile;
+            typedef std::shared_ptr<const Graphics::SpriteSheet> SpriteSheetPtr;
+            typedef std::shared_ptr<const Graphics::SpriteBuffer> SpriteBufferPtr;
+
+            // Constant variables.
+            static const Tile EmptyTile = 0;
+            static const int ChunkSize = 32;
+
+            // Chunk of tiles.
+            struct Chunk
+            {
+                Chunk();
+
+                // Tiles are allocated on the first edit.
+                std::vector<Tile> tiles;
+
+                // Baked sprite buffer, and the map origin it was baked at.
+                SpriteBufferPtr buffer;
+                glm::vec2       origin;
+                bool            dirty;
+            };
+
+            typedef std::vector<Chunk> ChunkList;
+            typedef std::vector<glm::vec4> TileTypeList;
+
+        public:
+            Tilemap();
+            ~Tilemap();
+
+            // Sets the map size in tiles.
+            // All tiles are cleared.
+            void SetSize(int width, int height);
+
+            // Sets the sprite sheet.
+            void SetSpriteSheet(SpriteSheetPtr spriteSheet);
+
+            // Adds a tile type that uses a sprite from the sprite sheet.
+            // Returns an empty tile if the type couldn't be added.
+            Tile AddTileType(std::string sprite);
+
+            // Sets a tile.
+            void SetTile(int x, int y, Tile tile);
+
+            // Sets the size of a single tile (in world units).
+            void SetTileSize(const glm::vec2& size);
+
+            // Sets the render layer.
+            void SetLayer(int layer);
+
+            // Sets transparency state.
+            void SetTransparent(bool transparent);
+
+            // Gets a tile.
+            Tile GetTile(int x, int y) const;
+
+            // Gets the sprite rectangle of a tile type.
+            const glm::vec4& GetTileRectangle(Tile tile) const;
+
+            // Gets the sprite sheet.
+            const SpriteSheetPtr& GetSpriteSheet() const;
+
+            // Gets the map width in tiles.
+            int GetWidth() const;
+
+            // Gets the map height in tiles.
+            int GetHeight() const;
+
+            // Gets the size of a single tile.
+            const glm::vec2& GetTileSize() const;
+
+            // Gets the render layer.
+            int GetLayer() const;
+
+            // Checks if is transparent.
+            bool IsTransparent() const;
+
+            // Gets the number of chunks along the x axis.
+            int GetChunkCountX() const;
+
+            // Gets the number of chunks along the y axis.
+            int GetChunkCountY() const;
+
+            // Gets a chunk.
+            Chunk& GetChunk(int x, int y);
+
+            // Gets the transform component.
+            Transform* GetTransform();
+
+        protected:
+            // Finalizes the tilemap component.
+            bool Finalize(EntityHandle self, const Context& context) override;
+
+        private:
+            // Marks all chunks as dirty.
+            void InvalidateChunks();
+
+        private:
+            // Sprite sheet resource.
+            SpriteSheetPtr m_spriteSheet;
+            TileTypeList   m_tileTypes;
+
+            // Map data.
+            int       m_width;
+            int       m_height;
+            int       m_chunkCountX;
+            int       m_chunkCountY;
+            ChunkList m_chunks;
+
+            // Render parameters.
+            glm::vec2 m_tileSize;
+            int m_layer;
+            bool m_transparent;
+
+            // Entity components.
+            Transform* m_transform;
+        };
+    }
+}
@@ -0,0 +1,318 @@
+#include "Precompiled.hpp"
+#include "LightSystem.hpp"
+#include "ComponentSystem.hpp"
+#include "Components/Transform.hpp"
+#include "Components/Light.hpp"
+#include "System/JobPool.hpp"
+using namespace Game;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define LIGHTS_USE_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the light system! "
+
+    // Number of tile rows culled by a single job.
+    const int CullChunkSize = 2;
+}
+
+LightSystem::LightSystem() :
+    m_componentSystem(nullptr),
+    m_jobPool(nullptr),
+    m_ambientColor(1.0f, 1.0f, 1.0f),
+    m_initialized(false)
+{
+}
+
+LightSystem::~LightSystem()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void LightSystem::Cleanup()
+{
+    // Reset context references.
+    m_componentSystem = nullptr;
+    m_jobPool = nullptr;
+
+    // Reset ambient light color.
+    m_ambientColor = glm::vec3(1.0f, 1.0f, 1.0f);
+
+    // Cleanup light lists.
+    Utility::ClearContainer(m_lights);
+    Utility::ClearContainer(m_viewLights);
+    Utility::ClearContainer(m_viewLightX);
+    Utility::ClearContainer(m_viewLightY);
+    Utility::ClearContainer(m_viewLightRadiusSquared);
+
+    Utility::ClearContainer(m_tileLights);
+    Utility::ClearContainer(m_tileLightCounts);
+    Utility::ClearContainer(m_tiles);
+    Utility::ClearContainer(m_indices);
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool LightSystem::Initialize(Context& context)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Add instance to the context.
+    if(context[ContextTypes::Game].Has<LightSystem>())
+    {
+        Log() << LogInitializeError() << "Context is invalid.";
+        return false;
+    }
+
+    context[ContextTypes::Game].Set(this);
+
+    // Get the component system.
+    m_componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+
+    if(m_componentSystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing ComponentSystem instance.";
+        return false;
+    }
+
+    // Get the job pool.
+    m_jobPool = context[ContextTypes::Main].Get<System::JobPool>();
+
+    if(m_jobPool == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing JobPool instance.";
+        return false;
+    }
+
+    // Success!
+    return m_initialized = true;
+}
+
+void LightSystem::SetAmbientColor(const glm::vec3& color)
+{
+    m_ambientColor = color;
+}
+
+const glm::vec3& LightSystem::GetAmbientColor() const
+{
+    return m_ambientColor;
+}
+
+void LightSystem::GatherLights()
+{
+    if(!m_initialized)
+        return;
+
+    m_lights.clear();
+
+    // Iterate over all light components.
+    auto componentsBegin = m_componentSystem->Begin<Components::Light>();
+    auto componentsEnd = m_componentSystem->End<Components::Light>();
+
+    for(auto it = componentsBegin; it != componentsEnd; ++it)
+    {
+        Components::Light& light = it->second;
+
+        // Check if the light was finalized.
+        Components::Transform* transform = light.GetTransform();
+
+        if(transform == nullptr)
+            continue;
+
+        if(!light.IsEnabled() || light.GetRadius() <= 0.0f || light.GetIntensity() <= 0.0f)
+            continue;
+
+        // Add the light.
+        Graphics::BasicRenderer::Light data;
+        data.position = glm::vec4(transform->GetPosition() + light.GetOffset(), light.GetRadius(), 0.0f);
+        data.color = glm::vec4(light.GetColor(), light.GetIntensity());
+
+        m_lights.push_back(data);
+    }
+}
+
+void LightSystem::RecordLighting(Graphics::CommandList::SortKey key, const glm::vec4& visible, const glm::ivec2& resolution, Graphics::CommandList& commandList)
+{
+    if(!m_initialized)
+        return;
+
+    if(resolution.x <= 0 || resolution.y <= 0)
+        return;
+
+    // Gather lights that touch the visible area.
+    m_viewLights.clear();
+    m_viewLightX.clear();
+    m_viewLightY.clear();
+    m_viewLightRadiusSquared.clear();
+
+    for(const auto& light : m_lights)
+    {
+        if((int)m_viewLights.size() == Graphics::BasicRenderer::MaxLights)
+            break;
+
+        float radius = light.position.z;
+
+        if(light.position.x + radius < visible.x || light.position.x - radius > visible.y ||
+           light.position.y + radius < visible.z || light.position.y - radius > visible.w)
+            continue;
+
+        m_viewLights.push_back(light);
+        m_viewLightX.push_back(light.position.x);
+        m_viewLightY.push_back(light.position.y);
+        m_viewLightRadiusSquared.push_back(radius * radius);
+    }
+
+    // Unlit view doesn't have to be modulated.
+    if(m_viewLights.empty() && m_ambientColor == glm::vec3(1.0f, 1.0f, 1.0f))
+        return;
+
+    // Pad culling arrays, so the last group can be processed whole.
+    // Padding has negative squared radius and never touches a tile.
+    while(m_viewLightX.size() % 4 != 0)
+    {
+        m_viewLightX.push_back(0.0f);
+        m_viewLightY.push_back(0.0f);
+        m_viewLightRadiusSquared.push_back(-1.0f);
+    }
+
+    // Calculate the number of tiles.
+    // Tiles get bigger if there would be too many of them.
+    int tileSize = TileSize;
+    glm::ivec2 tileCount;
+
+    while(true)
+    {
+        tileCount = (resolution + tileSize - 1) / tileSize;
+
+        if(tileCount.x * tileCount.y <= Graphics::BasicRenderer::MaxLightTiles)
+            break;
+
+        tileSize *= 2;
+    }
+
+    int totalTiles = tileCount.x * tileCount.y;
+
+    m_tileLights.resize(totalTiles * MaxTileLights);
+    m_tileLightCounts.resize(totalTiles);
+
+    // Bin lights into tiles on job pool workers.
+    if(!m_viewLights.empty())
+    {
+        m_jobPool->ParallelFor(tileCount.y, CullChunkSize, [&](int begin, int end, int)
+        {
+            this->CullTiles(begin, end, visible, tileCount);
+        });
+    }
+    else
+    {
+        std::fill(m_tileLightCounts.begin(), m_tileLightCounts.end(), 0);
+    }
+
+    // Compact tile light lists.
+    m_tiles.resize(totalTiles);
+    m_indices.clear();
+
+    for(int tile = 0; tile < totalTiles; ++tile)
+    {
+        int count = std::min(m_tileLightCounts[tile], Graphics::BasicRenderer::MaxLightIndices - (int)m_indices.size());
+
+        m_tiles[tile] = glm::uvec2((unsigned int)m_indices.size(), (unsigned int)count);
+
+        const uint16_t* lights = &m_tileLights[tile * MaxTileLights];
+        m_indices.insert(m_indices.end(), lights, lights + count);
+    }
+
+    // Record the lighting command.
+    Graphics::BasicRenderer::LightGrid grid;
+    grid.ambient = m_ambientColor;
+    grid.bounds = visible;
+    grid.tileCount = tileCount;
+
+    commandList.ApplyLighting(key, grid,
+        m_viewLights.data(), (int)m_viewLights.size(),
+        m_tiles.data(), m_indices.data(), (int)m_indices.size());
+}
+
+void LightSystem::CullTiles(int beginRow, int endRow, const glm::vec4& visible, const glm::ivec2& tileCount)
+{
+    // Tiles evenly divide the visible area.
+    glm::vec2 tileSize((visible.y - visible.x) / tileCount.x, (visible.w - visible.z) / tileCount.y);
+
+    const float* lightX = &m_viewLightX[0];
+    const float* lightY = &m_viewLightY[0];
+    const float* radiusSquared = &m_viewLightRadiusSquared[0];
+
+    int lightCount = (int)m_viewLightX.size();
+
+    for(int y = beginRow; y < endRow; ++y)
+    {
+        float tileMinY = visible.z + y * tileSize.y;
+        float tileMaxY = tileMinY + tileSize.y;
+
+        for(int x = 0; x < tileCount.x; ++x)
+        {
+            float tileMinX = visible.x + x * tileSize.x;
+            float tileMaxX = tileMinX + tileSize.x;
+
+            int tile = y * tileCount.x + x;
+            uint16_t* tileLights = &m_tileLights[tile * MaxTileLights];
+            int count = 0;
+
+            // Test lights by the distance from their center to the tile rectangle.
+        #if defined(LIGHTS_USE_SSE)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 minX = _mm_set1_ps(tileMinX);
+            const __m128 maxX = _mm_set1_ps(tileMaxX);
+            const __m128 minY = _mm_set1_ps(tileMinY);
+            const __m128 maxY = _mm_set1_ps(tileMaxY);
+
+            for(int i = 0; i < lightCount && count < MaxTileLights; i += 4)
+            {
+                __m128 px = _mm_loadu_ps(lightX + i);
+                __m128 py = _mm_loadu_ps(lightY + i);
+
+                __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, px), _mm_sub_ps(px, maxX)), zero);
+                __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, py), _mm_sub_ps(py, maxY)), zero);
+
+                __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_loadu_ps(radiusSquared + i)));
+
+                for(int lane = 0; mask != 0 && count < MaxTileLights; ++lane, mask >>= 1)
+                {
+                    if(mask & 1)
+                    {
+                        tileLights[count++] = (uint16_t)(i + lane);
+                    }
+                }
+            }
+        #else
+            for(int i = 0; i < lightCount && count < MaxTileLights; ++i)
+            {
+                float dx = std::max(std::max(tileMinX - lightX[i], lightX[i] - tileMaxX), 0.0f);
+                float dy = std::max(std::max(tileMinY - lightY[i], lightY[i] - tileMaxY), 0.0f);
+
+                if(dx * dx + dy * dy <= radiusSquared[i])
+                {
+                    tileLights[count++] = (uint16_t)i;
+                }
+            }
+        #endif
+
+            m_tileLightCounts[tile] = count;
+        }
+    }
+}
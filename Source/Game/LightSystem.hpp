@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Graphics/BasicRenderer.hpp"
+#include "Graphics/CommandList.hpp"
+
+// Forward declarations.
+namespace System
+{
+    class JobPool;
+}
+
+//
+// Light System
+//
+//  Gathers light components and bins them into screen tiles of each
+//  view. Lights are tested against tiles four at a time with SSE
+//  instructions (with a scalar fallback), with rows of tiles split
+//  across job pool workers. Compact per tile light lists are recorded
+//  into a lighting command, so each pixel is shaded only with lights
+//  that touch its tile, independently of the number of sprites.
+//
+
+namespace Game
+{
+    // Forward declarations.
+    class ComponentSystem;
+
+    // Light system class.
+    class LightSystem
+    {
+    public:
+        // Constant variables.
+        static const int TileSize = 32;
+        static const int MaxTileLights = 32;
+
+    public:
+        LightSystem();
+        ~LightSystem();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the light system.
+        bool Initialize(Context& context);
+
+        // Sets the ambient light color.
+        void SetAmbientColor(const glm::vec3& color);
+
+        // Gets the ambient light color.
+        const glm::vec3& GetAmbientColor() const;
+
+        // Gathers enabled lights of all light components.
+        void GatherLights();
+
+        // Bins gathered lights into tiles of a view and records the lighting command.
+        // Visible bounds are in world units and resolution is the view size in pixels.
+        void RecordLighting(Graphics::CommandList::SortKey key, const glm::vec4& visible, const glm::ivec2& resolution, Graphics::CommandList& commandList);
+
+    private:
+        // Bins view lights into a range of tile rows.
+        void CullTiles(int beginRow, int endRow, const glm::vec4& visible, const glm::ivec2& tileCount);
+
+    private:
+        // Type declarations.
+        typedef std::vector<float> FloatList;
+        typedef std::vector<Graphics::BasicRenderer::Light> LightList;
+
+        // Context references.
+        ComponentSystem* m_componentSystem;
+        System::JobPool* m_jobPool;
+
+        // Ambient light color.
+        glm::vec3 m_ambientColor;
+
+        // Gathered lights.
+        LightList m_lights;
+
+        // Lights visible in the current view.
+        // Positions are stored separately for culling and padded to multiples of four.
+        LightList m_viewLights;
+        FloatList m_viewLightX;
+        FloatList m_viewLightY;
+        FloatList m_viewLightRadiusSquared;
+
+        // Tile light lists.
+        std::vector<uint16_t>   m_tileLights;
+        std::vector<int>        m_tileLightCounts;
+        std::vector<glm::uvec2> m_tiles;
+        std::vector<uint16_t>   m_indices;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -0,0 +1,266 @@
+#include "Precompiled.hpp"
+#include "ParticleSystem.hpp"
+#include "ComponentSystem.hpp"
+#include "Components/Transform.hpp"
+#include "Components/ParticleEmitter.hpp"
+#include "System/JobPool.hpp"
+using namespace Game;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define PARTICLES_USE_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the particle system! "
+
+    // Number of particle groups (of four) simulated by a single job.
+    const int SimulateChunkSize = 1024;
+
+    // Number of particle sprites written by a single job.
+    const int WriteChunkSize = 2048;
+}
+
+ParticleSystem::ParticleSystem() :
+    m_componentSystem(nullptr),
+    m_jobPool(nullptr),
+    m_initialized(false)
+{
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void ParticleSystem::Cleanup()
+{
+    // Reset context references.
+    m_componentSystem = nullptr;
+    m_jobPool = nullptr;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool ParticleSystem::Initialize(Context& context)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Add instance to the context.
+    if(context[ContextTypes::Game].Has<ParticleSystem>())
+    {
+        Log() << LogInitializeError() << "Context is invalid.";
+        return false;
+    }
+
+    context[ContextTypes::Game].Set(this);
+
+    // Get the component system.
+    m_componentSystem = context[ContextTypes::Game].Get<ComponentSystem>();
+
+    if(m_componentSystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing ComponentSystem instance.";
+        return false;
+    }
+
+    // Get the job pool.
+    m_jobPool = context[ContextTypes::Main].Get<System::JobPool>();
+
+    if(m_jobPool == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing JobPool instance.";
+        return false;
+    }
+
+    // Success!
+    return m_initialized = true;
+}
+
+void ParticleSystem::Update(float timeDelta)
+{
+    if(!m_initialized)
+        return;
+
+    // Iterate over all particle emitter components.
+    auto componentsBegin = m_componentSystem->Begin<Components::ParticleEmitter>();
+    auto componentsEnd = m_componentSystem->End<Components::ParticleEmitter>();
+
+    for(auto it = componentsBegin; it != componentsEnd; ++it)
+    {
+        Components::ParticleEmitter& emitter = it->second;
+
+        // Check if the emitter was finalized.
+        if(emitter.GetTransform() == nullptr)
+            continue;
+
+        // Update particles.
+        this->Simulate(emitter, timeDelta);
+        this->RemoveExpired(emitter);
+        this->Emit(emitter, timeDelta);
+    }
+}
+
+void ParticleSystem::Simulate(Components::ParticleEmitter& emitter, float timeDelta)
+{
+    Components::ParticleEmitter::Particles& particles = emitter.GetParticles();
+
+    if(particles.count == 0)
+        return;
+
+    const glm::vec2& acceleration = emitter.GetAcceleration();
+
+    // Process particles in groups of four.
+    // Arrays are padded, so the last group can be processed whole.
+    int groupCount = (particles.count + 3) / 4;
+
+    m_jobPool->ParallelFor(groupCount, SimulateChunkSize, [&](int begin, int end, int)
+    {
+        float* positionX = &particles.positionX[0];
+        float* positionY = &particles.positionY[0];
+        float* velocityX = &particles.velocityX[0];
+        float* velocityY = &particles.velocityY[0];
+        float* life = &particles.life[0];
+        const float* lifeRate = &particles.lifeRate[0];
+
+    #if defined(PARTICLES_USE_SSE)
+        const __m128 delta = _mm_set1_ps(timeDelta);
+        const __m128 deltaVelocityX = _mm_set1_ps(acceleration.x * timeDelta);
+        const __m128 deltaVelocityY = _mm_set1_ps(acceleration.y * timeDelta);
+
+        for(int i = begin * 4; i < end * 4; i += 4)
+        {
+            __m128 vx = _mm_add_ps(_mm_loadu_ps(velocityX + i), deltaVelocityX);
+            __m128 vy = _mm_add_ps(_mm_loadu_ps(velocityY + i), deltaVelocityY);
+
+            _mm_storeu_ps(velocityX + i, vx);
+            _mm_storeu_ps(velocityY + i, vy);
+
+            _mm_storeu_ps(positionX + i, _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(vx, delta)));
+            _mm_storeu_ps(positionY + i, _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(vy, delta)));
+
+            _mm_storeu_ps(life + i, _mm_add_ps(_mm_loadu_ps(life + i), _mm_mul_ps(_mm_loadu_ps(lifeRate + i), delta)));
+        }
+    #else
+        const float deltaVelocityX = acceleration.x * timeDelta;
+        const float deltaVelocityY = acceleration.y * timeDelta;
+
+        for(int i = begin * 4; i < end * 4; ++i)
+        {
+            velocityX[i] += deltaVelocityX;
+            velocityY[i] += deltaVelocityY;
+
+            positionX[i] += velocityX[i] * timeDelta;
+            positionY[i] += velocityY[i] * timeDelta;
+
+            life[i] += lifeRate[i] * timeDelta;
+        }
+    #endif
+    });
+}
+
+void ParticleSystem::RemoveExpired(Components::ParticleEmitter& emitter)
+{
+    Components::ParticleEmitter::Particles& particles = emitter.GetParticles();
+
+    // Replace expired particles with the last ones.
+    int index = 0;
+
+    while(index < particles.count)
+    {
+        if(particles.life[index] < 1.0f)
+        {
+            ++index;
+            continue;
+        }
+
+        int last = --particles.count;
+
+        particles.positionX[index] = particles.positionX[last];
+        particles.positionY[index] = particles.positionY[last];
+        particles.velocityX[index] = particles.velocityX[last];
+        particles.velocityY[index] = particles.velocityY[last];
+        particles.life[index] = particles.life[last];
+        particles.lifeRate[index] = particles.lifeRate[last];
+    }
+}
+
+void ParticleSystem::Emit(Components::ParticleEmitter& emitter, float timeDelta)
+{
+    if(!emitter.IsEmitting())
+        return;
+
+    // Accumulate emission time.
+    emitter.m_emissionTime += emitter.GetEmissionRate() * timeDelta;
+
+    // Emit particles at the entity position.
+    glm::vec2 position = emitter.GetTransform()->GetPosition();
+
+    while(emitter.m_emissionTime >= 1.0f)
+    {
+        // Don't carry over particles that didn't fit.
+        if(!emitter.Emit(position))
+        {
+            emitter.m_emissionTime = 0.0f;
+            break;
+        }
+
+        emitter.m_emissionTime -= 1.0f;
+    }
+}
+
+void ParticleSystem::WriteSprites(const Components::ParticleEmitter& emitter, Graphics::BasicRenderer::Sprite::Data* output, const glm::vec2& scale) const
+{
+    if(!m_initialized)
+        return;
+
+    assert(output != nullptr);
+
+    const Components::ParticleEmitter::Particles& particles = emitter.GetParticles();
+    const Components::ParticleEmitter::FrameList& frames = emitter.GetFrames();
+
+    if(particles.count == 0 || frames.empty())
+        return;
+
+    // Write sprites on job pool workers.
+    m_jobPool->ParallelFor(particles.count, WriteChunkSize, [&](int begin, int end, int)
+    {
+        const glm::vec4& startColor = emitter.GetStartColor();
+        const glm::vec4& endColor = emitter.GetEndColor();
+
+        int frameCount = (int)frames.size();
+
+        for(int i = begin; i < end; ++i)
+        {
+            float life = std::min(particles.life[i], 1.0f);
+
+            // Pick the flipbook frame.
+            int frame = std::min((int)(life * frameCount), frameCount - 1);
+            const glm::vec4& rectangle = frames[frame];
+
+            // Center the sprite at the particle position.
+            glm::vec2 size = glm::abs(glm::vec2(rectangle.z, rectangle.w)) * scale;
+
+            Graphics::BasicRenderer::Sprite::Data& data = output[i];
+            data.transform = glm::mat4(1.0f);
+            data.transform[0][0] = scale.x;
+            data.transform[1][1] = scale.y;
+            data.transform[3][0] = particles.positionX[i] - size.x * 0.5f;
+            data.transform[3][1] = particles.positionY[i] - size.y * 0.5f;
+            data.rectangle = rectangle;
+            data.color = glm::mix(startColor, endColor, life);
+        }
+    });
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Graphics/BasicRenderer.hpp"
+
+// Forward declarations.
+namespace System
+{
+    class JobPool;
+}
+
+//
+// Particle System
+//
+//  Simulates particles of all emitter components. Particle arrays are
+//  processed four at a time with SSE instructions (with a scalar fallback)
+//  and split across job pool workers. Sprites are written directly into
+//  sprite stream memory of a command list, without intermediate copies.
+//
+
+namespace Game
+{
+    // Forward declarations.
+    class ComponentSystem;
+
+    namespace Components
+    {
+        class ParticleEmitter;
+    }
+
+    // Particle system class.
+    class ParticleSystem
+    {
+    public:
+        ParticleSystem();
+        ~ParticleSystem();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the particle system.
+        bool Initialize(Context& context);
+
+        // Updates all particle emitter components.
+        void Update(float timeDelta);
+
+        // Writes sprites of all alive particles of an emitter.
+        // Output has to have room for the emitter's particle count.
+        void WriteSprites(const Components::ParticleEmitter& emitter, Graphics::BasicRenderer::Sprite::Data* output, const glm::vec2& scale) const;
+
+    private:
+        // Advances particles of an emitter.
+        void Simulate(Components::ParticleEmitter& emitter, float timeDelta);
+
+        // Removes expired particles of an emitter.
+        void RemoveExpired(Components::ParticleEmitter& emitter);
+
+        // Emits new particles of an emitter.
+        void Emit(Components::ParticleEmitter& emitter, float timeDelta);
+
+    private:
+        // Context references.
+        ComponentSystem* m_componentSystem;
+        System::JobPool* m_jobPool;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -1,24 +1,336 @@
 #include "Precompiled.hpp"
 #include "RenderSystem.hpp"
+#include "System/Config.hpp"
 #include "System/Window.hpp"
+#include "System/JobPool.hpp"
 #include "Graphics/BasicRenderer.hpp"
+#include "Graphics/Texture.hpp"
+#include "Graphics/SpriteBuffer.hpp"
+#include "Graphics/Buffer.hpp"
 #include "ComponentSystem.hpp"
+#include "AnimationSystem.hpp"
+#include "ParticleSystem.hpp"
+#include "LightSystem.hpp"
+#include "VisibilitySystem.hpp"
 #include "Components/Transform.hpp"
 #include "Components/Render.hpp"
+#include "Components/Camera.hpp"
+#include "Components/Tilemap.hpp"
+#include "Components/ParticleEmitter.hpp"
+#include "Graphics/SpriteSheet.hpp"
 using namespace Game;
 
 namespace
 {
     // Log messages.
     #define LogInitializeError() "Failed to initialize the render system! "
+
+    // Interval between frame statistics reports (in seconds).
+    const double StatisticsInterval = 5.0;
+
+    // Number of render components extracted by a single job.
+    const int ExtractChunkSize = 256;
+
+    // Global rendering scale.
+    const glm::vec3 RenderScale(1.0f / 16.0f, 1.0f / 16.0f, 1.0f);
+
+    // Calculates the window viewport of an upscaled low resolution target.
+    glm::ivec4 CalculateUpscaleViewport(const glm::ivec2& resolution, int windowWidth, int windowHeight, Graphics::UpscaleModes::Type mode)
+    {
+        if(resolution.x <= 0 || resolution.y <= 0)
+            return glm::ivec4(0, 0, windowWidth, windowHeight);
+
+        // Fit the target inside the window.
+        float scale = std::min((float)windowWidth / resolution.x, (float)windowHeight / resolution.y);
+
+        if(mode == Graphics::UpscaleModes::Integer)
+        {
+            scale = std::max(1.0f, std::floor(scale));
+        }
+
+        // Center the target.
+        int width = (int)(resolution.x * scale);
+        int height = (int)(resolution.y * scale);
+
+        return glm::ivec4((windowWidth - width) / 2, (windowHeight - height) / 2, width, height);
+    }
+
+    // Size of a static sprite chunk (in world units).
+    const float StaticChunkSize = 16.0f;
+
+    // Sort key layout (from the most significant bit):
+    //   3 bits - Camera view slot (views are drawn in camera order).
+    //   8 bits - Layer, clamped to [-127, 126] range (zero is reserved for view setup,
+    //            the last value for view post processing).
+    //   1 bit  - Transparency (opaque first).
+    //   1 bit  - Weighted transparency.
+    //  51 bits - Sprite order within the group.
+    typedef Graphics::CommandList::SortKey SortKey;
+
+    const int CameraShift = 61;
+    const int LayerShift = 53;
+    const int TransparentShift = 52;
+    const int WeightedShift = 51;
+
+    const SortKey OrderMask = (SortKey(1) << WeightedShift) - 1;
+    const SortKey ViewMask = (SortKey(1) << CameraShift) - 1;
+
+    // Number of layer buckets in the sort key.
+    const int LayerBucketCount = 256;
+
+    // Layer bucket of view post processing commands.
+    const int PostProcessBucket = LayerBucketCount - 1;
+
+    // Margin around the visible area kept in a layer cache (fraction of its size).
+    const float LayerCacheMargin = 0.25f;
+
+    // Converts a float into an integer that keeps the order of values.
+    uint32_t FloatToOrder(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+
+    // Calculates the sort key of a sprite group.
+    SortKey CalculateGroupKey(int layer, bool transparent, bool weighted)
+    {
+        SortKey key = 0;
+        key |= SortKey(std::max(-127, std::min(layer, 126)) + 128) << LayerShift;
+        key |= SortKey(transparent ? 1 : 0) << TransparentShift;
+        key |= SortKey(weighted ? 1 : 0) << WeightedShift;
+
+        return key;
+    }
+
+    // Calculates the sort key bucket of a layer.
+    int CalculateLayerBucket(int layer)
+    {
+        return (int)((CalculateGroupKey(layer, false, false) >> LayerShift) & (LayerBucketCount - 1));
+    }
+
+    // Hashes a block of memory (FNV-1a).
+    uint64_t HashBytes(const void* data, std::size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    // Hashes sprite info fields (without struct padding).
+    uint64_t HashSpriteInfo(const Graphics::BasicRenderer::Sprite::Info& info, uint64_t hash)
+    {
+        hash = HashBytes(&info.texture, sizeof(info.texture), hash);
+        hash = HashBytes(&info.transparent, sizeof(info.transparent), hash);
+        hash = HashBytes(&info.filter, sizeof(info.filter), hash);
+        hash = HashBytes(&info.frames, sizeof(info.frames), hash);
+
+        return hash;
+    }
+
+    // Hashes a recorded command with its parameters.
+    uint64_t HashCommand(const Graphics::CommandList& commandList, const Graphics::CommandList::Command& command)
+    {
+        uint64_t hash = HashBytes(&command.key, sizeof(command.key));
+        hash = HashBytes(&command.type, sizeof(command.type), hash);
+
+        switch(command.type)
+        {
+        case Graphics::CommandTypes::DrawSprite:
+            {
+                hash = HashSpriteInfo(commandList.GetSpriteInfo(command.index), hash);
+                hash = HashBytes(&commandList.GetSpriteData(command.index), sizeof(Graphics::BasicRenderer::Sprite::Data), hash);
+            }
+            break;
+
+        case Graphics::CommandTypes::DrawSpriteBuffer:
+            {
+                const Graphics::SpriteBuffer* spriteBuffer = commandList.GetSpriteBuffer(command.index);
+                hash = HashBytes(&spriteBuffer, sizeof(spriteBuffer), hash);
+            }
+            break;
+
+        case Graphics::CommandTypes::DrawSpriteStream:
+            {
+                const Graphics::CommandList::StreamParameters& stream = commandList.GetStream(command.index);
+                hash = HashSpriteInfo(stream.info, hash);
+                hash = HashBytes(commandList.GetStreamData(stream.first), stream.count * sizeof(Graphics::BasicRenderer::Sprite::Data), hash);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        return hash;
+    }
+
+    // Checks if a recorded command draws sprites animated by shaders.
+    bool IsCommandAnimated(const Graphics::CommandList& commandList, const Graphics::CommandList::Command& command)
+    {
+        switch(command.type)
+        {
+        case Graphics::CommandTypes::DrawSprite:
+            return commandList.GetSpriteInfo(command.index).frames != nullptr;
+
+        case Graphics::CommandTypes::DrawSpriteBuffer:
+            return commandList.GetSpriteBuffer(command.index)->IsAnimated();
+
+        case Graphics::CommandTypes::DrawSpriteStream:
+            return commandList.GetStream(command.index).info.frames != nullptr;
+
+        default:
+            return false;
+        }
+    }
+
+    // Calculates the sort order of a sprite within its group.
+    SortKey CalculateSpriteOrder(const Graphics::BasicRenderer::Sprite::Info& info, const Graphics::BasicRenderer::Sprite::Data& data, bool weighted)
+    {
+        SortKey texture = info.texture != nullptr ? info.texture->GetHandle() : 0;
+
+        uint32_t depth = FloatToOrder(data.transform[3][2]);
+        uint32_t height = FloatToOrder(data.transform[3][1]);
+
+        if(weighted)
+        {
+            // Weighted transparency doesn't depend on order, sort by texture.
+            // Leaves room for commands at the beginning and the end of the group.
+            return 1 + texture;
+        }
+        else
+        if(info.transparent)
+        {
+            // Sort transparent by depth (back to front), then by the y position and texture.
+            return SortKey(depth >> 16) << 35 | SortKey(~height >> 8) << 11 | (texture & 0x7FF);
+        }
+        else
+        {
+            // Sort opaque by depth (front to back), then by texture.
+            return SortKey(~depth >> 8) << 27 | (texture & 0x7FFFFFF);
+        }
+    }
+
+    // Calculates world bounds of a sprite from its corners.
+    // Returns a [left, right, bottom, top] vector.
+    glm::vec4 CalculateSpriteBounds(const Graphics::BasicRenderer::Sprite::Data& data)
+    {
+        glm::vec2 size = glm::abs(glm::vec2(data.rectangle.z, data.rectangle.w));
+
+        const glm::vec2 corners[4] =
+        {
+            glm::vec2(0.0f, 0.0f),
+            glm::vec2(size.x, 0.0f),
+            glm::vec2(0.0f, size.y),
+            glm::vec2(size.x, size.y),
+        };
+
+        glm::vec2 boundsMin(std::numeric_limits<float>::max());
+        glm::vec2 boundsMax(-std::numeric_limits<float>::max());
+
+        for(const auto& corner : corners)
+        {
+            glm::vec2 position = glm::vec2(data.transform * glm::vec4(corner, 0.0f, 1.0f));
+
+            boundsMin = glm::min(boundsMin, position);
+            boundsMax = glm::max(boundsMax, position);
+        }
+
+        return glm::vec4(boundsMin.x, boundsMax.x, boundsMin.y, boundsMax.y);
+    }
+
+    // Checks if two [left, right, bottom, top] rectangles overlap.
+    bool CheckOverlap(const glm::vec4& a, const glm::vec4& b)
+    {
+        return a.y >= b.x && a.x <= b.y && a.w >= b.z && a.z <= b.w;
+    }
+}
+
+RenderSystem::Layer::Layer() :
+    transparency(TransparencyModes::Sorted),
+    cached(false)
+{
+}
+
+RenderSystem::LayerCache::LayerCache() :
+    dirty(true),
+    signature(0),
+    rectangle(0.0f, 0.0f, 0.0f, 0.0f),
+    size(0, 0)
+{
+}
+
+RenderSystem::View::View() :
+    camera(nullptr),
+    key(0),
+    transform(1.0f),
+    visible(0.0f, 0.0f, 0.0f, 0.0f),
+    resolution(0, 0)
+{
+}
+
+RenderSystem::StaticChunk::StaticChunk() :
+    bounds(0.0f, 0.0f, 0.0f, 0.0f),
+    dirty(true)
+{
+}
+
+RenderSystem::FramePacket::FramePacket() :
+    fence(nullptr),
+    animationTime(0.0f),
+    verticalSync(true)
+{
+}
+
+void RenderSystem::FramePacket::Clear()
+{
+    for(auto& commandList : commandLists)
+    {
+        commandList.Reset();
+    }
+
+    textures.clear();
+    spriteBuffers.clear();
+    frameTables.clear();
+}
+
+RenderSystem::FrameStatistics::FrameStatistics() :
+    frameTime(0.0),
+    renderTime(0.0),
+    waitTime(0.0),
+    frameCount(0),
+    lastFrame(0.0),
+    lastReport(0.0)
+{
 }
 
 RenderSystem::RenderSystem() :
     m_window(nullptr),
     m_basicRenderer(nullptr),
     m_componentSystem(nullptr),
+    m_animationSystem(nullptr),
+    m_particleSystem(nullptr),
+    m_lightSystem(nullptr),
+    m_visibilitySystem(nullptr),
+    m_jobPool(nullptr),
+    m_viewCount(0),
+    m_windowSize(0, 0),
+    m_currentPacket(nullptr),
+    m_renderThreadExit(false),
+    m_threaded(false),
+    m_lowResolution(false),
+    m_upscaleMode(Graphics::UpscaleModes::SharpBilinear),
     m_initialized(false)
 {
+    // Bind event receivers.
+    m_windowResize.Bind<RenderSystem, &RenderSystem::OnWindowResize>(this);
 }
 
 RenderSystem::~RenderSystem()
@@ -29,18 +341,90 @@ RenderSystem::~RenderSystem()
 
 void RenderSystem::Cleanup()
 {
+    // Stop the render thread.
+    if(m_renderThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_packetMutex);
+            m_renderThreadExit = true;
+        }
+
+        m_packetCondition.notify_all();
+        m_renderThread.join();
+
+        // Take back the window context.
+        m_window->MakeContextCurrent();
+    }
+
+    m_renderThreadExit = false;
+    m_threaded = false;
+
+    // Reset low resolution rendering.
+    m_lowResolution = false;
+    m_upscaleMode = Graphics::UpscaleModes::SharpBilinear;
+
+    // Reset frame packets.
+    for(int i = 0; i < FramePacketCount; ++i)
+    {
+        m_framePackets[i] = FramePacket();
+    }
+
+    m_currentPacket = nullptr;
+
+    Utility::ClearContainer(m_freePackets);
+    Utility::ClearContainer(m_readyPackets);
+
+    // Reset frame statistics.
+    m_statistics = FrameStatistics();
+
+    // Unsubscribe receivers.
+    m_windowResize.Unsubscribe();
+
+    // Detach render components.
+    if(m_componentSystem != nullptr)
+    {
+        auto componentsBegin = m_componentSystem->Begin<Components::Render>();
+        auto componentsEnd = m_componentSystem->End<Components::Render>();
+
+        for(auto it = componentsBegin; it != componentsEnd; ++it)
+        {
+            it->second.m_renderSystem = nullptr;
+        }
+    }
+
+    // Cleanup static sprite chunks.
+    Utility::ClearContainer(m_staticChunks);
+    Utility::ClearContainer(m_staticSprites);
+
+    // Cleanup tilemap chunk build lists.
+    Utility::ClearContainer(m_tileInfo);
+    Utility::ClearContainer(m_tileData);
+
     // Reset context references.
     m_window = nullptr;
     m_basicRenderer = nullptr;
     m_componentSystem = nullptr;
+    m_animationSystem = nullptr;
+    m_particleSystem = nullptr;
+    m_lightSystem = nullptr;
+    m_visibilitySystem = nullptr;
+    m_jobPool = nullptr;
+
+    // Reset camera views.
+    for(int i = 0; i < MaxCameras; ++i)
+    {
+        m_views[i] = View();
+    }
 
-    // Reset graphics objects.
-    m_screenSpace.Cleanup();
+    Utility::ClearContainer(m_cameras);
+    m_viewCount = 0;
+    m_windowSize = glm::ivec2(0, 0);
 
-    // Cleanup sprite list.
-    Utility::ClearContainer(m_spriteInfo);
-    Utility::ClearContainer(m_spriteData);
-    Utility::ClearContainer(m_spriteSort);
+    // Cleanup layer list.
+    Utility::ClearContainer(m_layers);
+
+    // Cleanup render component list.
+    Utility::ClearContainer(m_renderComponents);
 
     // Reset initialization state.
     m_initialized = false;
@@ -94,14 +478,120 @@ bool RenderSystem::Initialize(Context& context)
         return false;
     }
 
-    // Set screen space target size.
-    m_screenSpace.SetTargetSize(10.0f, 10.0f);
+    // Get the animation system.
+    m_animationSystem = context[ContextTypes::Game].Get<AnimationSystem>();
+
+    if(m_animationSystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing AnimationSystem instance.";
+        return false;
+    }
+
+    // Get the particle system.
+    m_particleSystem = context[ContextTypes::Game].Get<ParticleSystem>();
+
+    if(m_particleSystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing ParticleSystem instance.";
+        return false;
+    }
+
+    // Get the light system.
+    m_lightSystem = context[ContextTypes::Game].Get<LightSystem>();
+
+    if(m_lightSystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing LightSystem instance.";
+        return false;
+    }
+
+    // Get the visibility system.
+    m_visibilitySystem = context[ContextTypes::Game].Get<VisibilitySystem>();
+
+    if(m_visibilitySystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing VisibilitySystem instance.";
+        return false;
+    }
+
+    // Get the job pool.
+    m_jobPool = context[ContextTypes::Main].Get<System::JobPool>();
+
+    if(m_jobPool == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing JobPool instance.";
+        return false;
+    }
+
+    // Subscribe to window resize events.
+    // Cameras cache their view parameters and only rebuild them on change.
+    m_window->events.resize.Subscribe(m_windowResize);
+    m_windowSize = glm::ivec2(m_window->GetWidth(), m_window->GetHeight());
 
     // Allocate initial sprite list memory.
+    // Each job pool worker records into a separate command list.
     const int SpriteListSize = 128;
-    m_spriteInfo.reserve(SpriteListSize);
-    m_spriteData.reserve(SpriteListSize);
-    m_spriteSort.reserve(SpriteListSize);
+    m_renderComponents.reserve(SpriteListSize);
+
+    for(int i = 0; i < FramePacketCount; ++i)
+    {
+        m_framePackets[i].commandLists.resize(m_jobPool->GetWorkerCount());
+
+        for(auto& commandList : m_framePackets[i].commandLists)
+        {
+            commandList.Reserve(SpriteListSize);
+        }
+    }
+
+    // Check if the render thread should be used.
+    System::Config* config = context[ContextTypes::Main].Get<System::Config>();
+
+    if(config != nullptr)
+    {
+        m_threaded = config->Get<bool>("Graphics.RenderThread", false);
+    }
+
+    // Check if the scene should be rendered at the virtual resolution.
+    // Virtual resolution has one pixel per texel of sprites in the world.
+    if(config != nullptr)
+    {
+        m_lowResolution = config->Get<bool>("Graphics.LowResolution", false);
+
+        if(config->Get<bool>("Graphics.IntegerScaling", false))
+        {
+            m_upscaleMode = Graphics::UpscaleModes::Integer;
+        }
+    }
+
+    if(m_threaded && !m_window->CreateSharedContext())
+    {
+        Log() << "Couldn't create a shared context for the render thread, falling back to immediate rendering.";
+        m_threaded = false;
+    }
+
+    if(m_threaded)
+    {
+        // Fill the queue of free frame packets.
+        for(int i = 0; i < FramePacketCount; ++i)
+        {
+            m_freePackets.push(&m_framePackets[i]);
+        }
+
+        // Hand over the window context to the render thread.
+        // This thread continues on the shared context, so
+        // resources can still be created while loading.
+        m_window->ReleaseContextCurrent();
+        m_window->MakeSharedContextCurrent();
+
+        m_renderThread = std::thread(&RenderSystem::RenderThread, this);
+
+        Log() << "Started the render thread.";
+    }
+    else
+    {
+        // Use a single frame packet.
+        m_currentPacket = &m_framePackets[0];
+    }
 
     // Success!
     return m_initialized = true;
@@ -112,127 +602,1049 @@ void RenderSystem::Draw()
     if(!m_initialized)
         return;
 
-    // Get window size.
-    int windowWidth = m_window->GetWidth();
-    int windowHeight = m_window->GetHeight();
+    // Acquire a free frame packet.
+    if(m_threaded)
+    {
+        assert(m_currentPacket == nullptr);
 
-    // Setup viewport.
-    glViewport(0, 0, windowWidth, windowHeight);
+        double waitBegin = glfwGetTime();
 
-    // Setup screen space.
-    m_screenSpace.SetSourceSize(windowWidth, windowHeight);
+        {
+            std::unique_lock<std::mutex> lock(m_packetMutex);
 
-    // Calculate camera view.
-    glm::mat4 view = glm::translate(glm::mat4(1.0f), -glm::vec3(m_screenSpace.GetOffset(), 0.0f));
+            m_packetCondition.wait(lock, [this]()
+            {
+                return !m_freePackets.empty();
+            });
 
-    // Global rendering scale.
-    glm::vec3 renderScale(1.0 / 16.0f, 1.0 / 16.0f, 1.0f);
+            m_currentPacket = m_freePackets.front();
+            m_freePackets.pop();
+        }
 
-    // Clear the back buffer.
-    m_basicRenderer->SetClearColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-    m_basicRenderer->SetClearDepth(1.0f);
+        m_statistics.waitTime += glfwGetTime() - waitBegin;
+    }
 
-    m_basicRenderer->Clear(Graphics::ClearFlags::Color | Graphics::ClearFlags::Depth);
+    assert(m_currentPacket != nullptr);
 
-    // Iterate over all render components.
-    auto componentsBegin = m_componentSystem->Begin<Components::Render>();
-    auto componentsEnd = m_componentSystem->End<Components::Render>();
+    // Extract the frame packet.
+    this->ExtractPacket(*m_currentPacket);
 
-    for(auto it = componentsBegin; it != componentsEnd; ++it)
+    // Submit the frame packet immediately.
+    if(!m_threaded)
     {
-        // Get the components.
-        Components::Render* render = &it->second;
-        assert(render != nullptr);
+        double renderBegin = glfwGetTime();
 
-        Components::Transform* transform = render->GetTransform();
-        assert(transform != nullptr);
+        this->SubmitPacket(*m_currentPacket);
 
-        // Add sprite to the list.
-        Graphics::BasicRenderer::Sprite::Info info;
-        info.texture = render->GetTexture().get();
-        info.transparent = render->IsTransparent();
-        info.filter = false;
+        m_statistics.renderTime += glfwGetTime() - renderBegin;
+    }
+}
 
-        Graphics::BasicRenderer::Sprite::Data data;
-        data.transform = glm::translate(data.transform, glm::vec3(transform->GetPosition(), 0.0f));
-        //data.transform = glm::rotate(data.transform, transform->GetRotation(), glm::vec3(0.0f, 0.0f, -1.0f));
-        data.transform = glm::scale(data.transform, glm::vec3(transform->GetScale(), 1.0f) * renderScale);
-        data.transform = glm::translate(data.transform, glm::vec3(render->GetOffset(), 0.0f));
-        data.rectangle = render->GetRectangle();
-        data.color = render->CalculateColor();
+void RenderSystem::Present(bool verticalSync)
+{
+    if(!m_initialized)
+        return;
 
-        m_spriteInfo.push_back(info);
-        m_spriteData.push_back(data);
-    }
+    if(m_threaded)
+    {
+        // Make sure a frame was drawn.
+        if(m_currentPacket == nullptr)
+            return;
+
+        // Fence resource commands issued on the shared context, so the
+        // render thread waits for them before using the resources.
+        // Flush makes sure the fence reaches the server.
+        m_currentPacket->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        // Hand over the frame packet to the render thread.
+        m_currentPacket->verticalSync = verticalSync;
+
+        {
+            std::lock_guard<std::mutex> lock(m_packetMutex);
+            m_readyPackets.push(m_currentPacket);
+        }
 
-    // Create sort permutation.
-    auto SpriteSort = [&](const int& a, const int& b)
+        m_packetCondition.notify_all();
+
+        m_currentPacket = nullptr;
+    }
+    else
     {
-        // Get sprite info and data.
-        const auto& spriteInfoA = m_spriteInfo[a];
-        const auto& spriteDataA = m_spriteData[a];
+        // Present the back buffer.
+        double presentBegin = glfwGetTime();
 
-        const auto& spriteInfoB = m_spriteInfo[b];
-        const auto& spriteDataB = m_spriteData[b];
+        m_window->Present(verticalSync);
 
-        // Sort by transparency (opaque first, transparent second).
-        if(spriteInfoA.transparent < spriteInfoB.transparent)
-            return true;
+        m_statistics.renderTime += glfwGetTime() - presentBegin;
+    }
+
+    // Update frame statistics.
+    this->UpdateStatistics();
+}
+
+bool RenderSystem::IsThreaded() const
+{
+    return m_threaded;
+}
+
+bool RenderSystem::IsLowResolution() const
+{
+    return m_lowResolution;
+}
+
+void RenderSystem::ExtractPacket(FramePacket& packet)
+{
+    // Release data of the previous frame.
+    packet.Clear();
+
+    // Take the time of shader animations.
+    packet.animationTime = (float)m_animationSystem->GetTime();
+
+    // Prepare camera views.
+    this->PrepareViews(packet);
+
+    if(m_viewCount == 0)
+        return;
+
+    Graphics::CommandList& setupList = packet.commandLists[0];
 
-        if(spriteInfoA.transparent == spriteInfoB.transparent)
+    // Record visible tilemap chunks.
+    auto tilemapsBegin = m_componentSystem->Begin<Components::Tilemap>();
+    auto tilemapsEnd = m_componentSystem->End<Components::Tilemap>();
+
+    for(auto it = tilemapsBegin; it != tilemapsEnd; ++it)
+    {
+        for(int i = 0; i < m_viewCount; ++i)
         {
-            if(spriteInfoA.transparent)
-            {
-                // Sort transparent by depth (back to front).
-                if(spriteDataA.transform[3][2] < spriteDataB.transform[3][2])
-                    return true;
-
-                if(spriteDataA.transform[3][2] == spriteDataB.transform[3][2])
-                {
-                    // Sort by the y position.
-                    if(spriteDataA.transform[3][1] > spriteDataB.transform[3][1])
-                        return true;
-
-                    if(spriteDataA.transform[3][1] == spriteDataB.transform[3][1])
-                    {
-                        // Sort by texture.
-                        if(spriteInfoA.texture < spriteInfoB.texture)
-                            return true;
-                    }
-                }
-            }
-            else
-            {
-                // Sort opaque by depth (front to back).
-                if(spriteDataA.transform[3][2] > spriteDataB.transform[3][2])
-                    return true;
-
-                if(spriteDataA.transform[3][2] == spriteDataB.transform[3][2])
-                {
-                    // Sort by texture.
-                    if(spriteInfoA.texture < spriteInfoB.texture)
-                        return true;
-                }
-            }
+            this->RecordTilemap(it->second, m_views[i], packet);
         }
+    }
 
-        return false;
-    };
+    // Rebuild changed static chunks and record visible ones.
+    for(auto it = m_staticChunks.begin(); it != m_staticChunks.end();)
+    {
+        StaticChunk& chunk = it->second;
 
-    assert(m_spriteInfo.size() == m_spriteData.size());
-    m_spriteSort.resize(m_spriteInfo.size());
+        if(chunk.dirty)
+        {
+            this->RebuildStaticChunk(chunk);
+            this->InvalidateLayerCache(std::get<0>(it->first));
+        }
 
-    std::iota(m_spriteSort.begin(), m_spriteSort.end(), 0);
-    std::sort(m_spriteSort.begin(), m_spriteSort.end(), SpriteSort);
+        // Remove empty chunks.
+        if(chunk.renders.empty())
+        {
+            it = m_staticChunks.erase(it);
+            continue;
+        }
 
-    // Sort sprite lists.
-    Utility::Reorder(m_spriteInfo, m_spriteSort);
-    Utility::Reorder(m_spriteData, m_spriteSort);
+        if(chunk.buffer == nullptr)
+        {
+            ++it;
+            continue;
+        }
 
-    // Render sprites.
-    m_basicRenderer->DrawSprites(m_spriteInfo, m_spriteData, m_screenSpace.GetTransform() * view);
+        // Record the chunk in every view that it overlaps.
+        // Static chunks are opaque and drawn after tilemaps of the same layer.
+        SortKey key = CalculateGroupKey(std::get<0>(it->first), false, false) | 2;
+        bool recorded = false;
 
-    // Clear the sprite list.
-    m_spriteInfo.clear();
-    m_spriteData.clear();
+        for(int i = 0; i < m_viewCount; ++i)
+        {
+            const View& view = m_views[i];
+
+            if(!CheckOverlap(chunk.bounds, view.visible))
+                continue;
+
+            setupList.DrawSpriteBuffer(view.key | key, chunk.buffer.get());
+            recorded = true;
+        }
+
+        // Keep resources alive until the render thread consumes the packet.
+        if(m_threaded && recorded)
+        {
+            packet.spriteBuffers.push_back(chunk.buffer);
+            packet.textures.insert(packet.textures.end(), chunk.textures.begin(), chunk.textures.end());
+            packet.frameTables.insert(packet.frameTables.end(), chunk.frameTables.begin(), chunk.frameTables.end());
+        }
+
+        ++it;
+    }
+
+    // Record particle emitters.
+    auto emittersBegin = m_componentSystem->Begin<Components::ParticleEmitter>();
+    auto emittersEnd = m_componentSystem->End<Components::ParticleEmitter>();
+
+    for(auto it = emittersBegin; it != emittersEnd; ++it)
+    {
+        for(int i = 0; i < m_viewCount; ++i)
+        {
+            this->RecordParticles(it->second, m_views[i], packet);
+        }
+    }
+
+    // Gather render components.
+    const Graphics::Texture* lastTexture = nullptr;
+    const Graphics::TextureBuffer* lastFrameTable = nullptr;
+
+    auto componentsBegin = m_componentSystem->Begin<Components::Render>();
+    auto componentsEnd = m_componentSystem->End<Components::Render>();
+
+    for(auto it = componentsBegin; it != componentsEnd; ++it)
+    {
+        Components::Render* render = &it->second;
+
+        // Opaque static sprites are already kept in chunks.
+        if(render->IsStatic() && !render->IsTransparent())
+            continue;
+
+        m_renderComponents.push_back(render);
+
+        // Keep texture alive until the render thread consumes the packet.
+        if(m_threaded && render->GetTexture().Get() != lastTexture)
+        {
+            packet.textures.push_back(render->GetTexture());
+            lastTexture = render->GetTexture().Get();
+        }
+
+        if(m_threaded && render->GetFrameTable().get() != lastFrameTable)
+        {
+            packet.frameTables.push_back(render->GetFrameTable());
+            lastFrameTable = render->GetFrameTable().get();
+        }
+    }
+
+    // Record sprites on job pool workers.
+    m_jobPool->ParallelFor((int)m_renderComponents.size(), ExtractChunkSize, [&](int begin, int end, int worker)
+    {
+        this->ExtractRange(begin, end, packet.commandLists[worker]);
+    });
+
+    m_renderComponents.clear();
+
+    // Record caches of cached layers.
+    this->RecordLayerCaches(packet);
+
+    // Record lighting of each view after all layers.
+    m_lightSystem->GatherLights();
+
+    for(int i = 0; i < m_viewCount; ++i)
+    {
+        const View& view = m_views[i];
+
+        SortKey key = view.key | SortKey(PostProcessBucket) << LayerShift;
+        m_lightSystem->RecordLighting(key, view.visible, view.resolution, setupList);
+    }
+
+    // Upscale low resolution targets after everything else in their views.
+    if(m_lowResolution)
+    {
+        for(int i = 0; i < m_viewCount; ++i)
+        {
+            const View& view = m_views[i];
+            const glm::ivec4& pixelViewport = view.camera->GetPixelViewport();
+
+            Graphics::CommandList::LowResolutionParameters parameters;
+            parameters.target = i;
+            parameters.size = view.resolution;
+            parameters.viewport = CalculateUpscaleViewport(view.resolution, pixelViewport.z, pixelViewport.w, m_upscaleMode);
+            parameters.viewport.x += pixelViewport.x;
+            parameters.viewport.y += pixelViewport.y;
+            parameters.mode = m_upscaleMode;
+
+            setupList.RenderLowResolution(view.key, view.key | ViewMask, parameters);
+        }
+    }
+}
+
+void RenderSystem::PrepareViews(FramePacket& packet)
+{
+    // Gather finalized cameras.
+    m_cameras.clear();
+
+    auto camerasBegin = m_componentSystem->Begin<Components::Camera>();
+    auto camerasEnd = m_componentSystem->End<Components::Camera>();
+
+    for(auto it = camerasBegin; it != camerasEnd; ++it)
+    {
+        Components::Camera& camera = it->second;
+
+        if(camera.GetTransform() == nullptr)
+            continue;
+
+        // Update cached view parameters.
+        // Views are snapped to whole pixels of the virtual resolution.
+        camera.SetPixelsPerUnit(m_lowResolution ? 1.0f / RenderScale.x : 0.0f);
+        camera.Update();
+
+        m_cameras.push_back(&camera);
+    }
+
+    // Sort cameras by their draw order.
+    std::stable_sort(m_cameras.begin(), m_cameras.end(), [](const Components::Camera* a, const Components::Camera* b)
+    {
+        return a->GetOrder() < b->GetOrder();
+    });
+
+    // Only cameras that fit into view slots of the sort key are drawn.
+    if((int)m_cameras.size() > MaxCameras)
+    {
+        m_cameras.resize(MaxCameras);
+    }
+
+    m_viewCount = (int)m_cameras.size();
+
+    // Record frame setup commands.
+    // Whole window is cleared first, as cameras might not cover all of it.
+    assert(!packet.commandLists.empty());
+    Graphics::CommandList& setupList = packet.commandLists[0];
+
+    setupList.SetViewport(0, glm::ivec4(0, 0, m_windowSize.x, m_windowSize.y));
+    setupList.Clear(0, Graphics::ClearFlags::Color | Graphics::ClearFlags::Depth, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f);
+
+    for(int i = 0; i < m_viewCount; ++i)
+    {
+        View& view = m_views[i];
+        Components::Camera* camera = m_cameras[i];
+
+        const glm::ivec4& pixelViewport = camera->GetPixelViewport();
+
+        view.camera = camera;
+        view.key = SortKey(i) << CameraShift;
+        view.transform = camera->GetViewTransform();
+        view.visible = camera->GetVisibleBounds();
+        view.resolution = m_lowResolution ? camera->GetPixelSize() : glm::ivec2(pixelViewport.z, pixelViewport.w);
+
+        // Record view setup commands.
+        // Setup follows the beginning of a low resolution target, which sets its own viewport.
+        SortKey setupKey = view.key | 1;
+
+        if(!m_lowResolution)
+        {
+            setupList.SetViewport(setupKey, pixelViewport);
+        }
+
+        setupList.Clear(setupKey, Graphics::ClearFlags::Color | Graphics::ClearFlags::Depth, camera->GetClearColor(), 1.0f);
+        setupList.SetTransform(setupKey, view.transform);
+
+        // Record ranges of weighted transparent sprites.
+        // Transparent sprites of a weighted layer are accumulated and resolved together.
+        for(const auto& layer : m_layers)
+        {
+            if(layer.second.transparency != TransparencyModes::Weighted)
+                continue;
+
+            SortKey groupKey = view.key | CalculateGroupKey(layer.first, true, true);
+
+            setupList.BeginWeighted(groupKey);
+            setupList.EndWeighted(groupKey | OrderMask);
+        }
+    }
+
+    // Pass visible areas to systems updating entities by their visibility.
+    glm::vec4 visibleAreas[MaxCameras];
+
+    for(int i = 0; i < m_viewCount; ++i)
+    {
+        visibleAreas[i] = m_views[i].visible;
+    }
+
+    m_visibilitySystem->SetVisibleAreas(visibleAreas, m_viewCount);
+}
+
+void RenderSystem::ExtractRange(int begin, int end, Graphics::CommandList& commandList) const
+{
+    for(int i = begin; i < end; ++i)
+    {
+        // Get the component.
+        Components::Render* render = m_renderComponents[i];
+        assert(render != nullptr);
+
+        // Create a sprite.
+        Graphics::BasicRenderer::Sprite::Info info;
+        Graphics::BasicRenderer::Sprite::Data data;
+
+        this->CreateSprite(render, info, data);
+
+        // Calculate the sort key.
+        int layer = render->GetLayer();
+        bool weighted = info.transparent && this->GetLayerTransparency(layer) == TransparencyModes::Weighted;
+
+        SortKey key = CalculateGroupKey(layer, info.transparent, weighted) | CalculateSpriteOrder(info, data, weighted);
+
+        // Record the sprite in views that it is visible in.
+        glm::vec4 bounds = CalculateSpriteBounds(data);
+
+        for(int v = 0; v < m_viewCount; ++v)
+        {
+            const View& view = m_views[v];
+
+            if(!CheckOverlap(bounds, view.visible))
+                continue;
+
+            commandList.DrawSprite(view.key | key, info, data);
+        }
+    }
+}
+
+void RenderSystem::CreateSprite(Components::Render* render, Graphics::BasicRenderer::Sprite::Info& info, Graphics::BasicRenderer::Sprite::Data& data) const
+{
+    assert(render != nullptr);
+
+    // Get the transform component.
+    Components::Transform* transform = render->GetTransform();
+    assert(transform != nullptr);
+
+    // Fill sprite info and data.
+    info.texture = render->GetTexture().Get();
+    info.transparent = render->IsTransparent();
+    info.filter = false;
+    info.frames = render->GetFrameTable().get();
+
+    data.transform = glm::mat4(1.0f);
+    data.transform = glm::translate(data.transform, glm::vec3(transform->GetPosition(), 0.0f));
+    //data.transform = glm::rotate(data.transform, transform->GetRotation(), glm::vec3(0.0f, 0.0f, -1.0f));
+    data.transform = glm::scale(data.transform, glm::vec3(transform->GetScale(), 1.0f) * RenderScale);
+    data.transform = glm::translate(data.transform, glm::vec3(render->GetOffset(), 0.0f));
+    data.rectangle = render->GetRectangle();
+    data.color = render->CalculateColor();
+    data.animation = render->GetFrameAnimation();
+}
+
+void RenderSystem::RebuildStaticChunk(StaticChunk& chunk)
+{
+    // Release the previous sprite buffer.
+    // Frame packets may still hold references to it.
+    chunk.buffer = nullptr;
+    chunk.textures.clear();
+    chunk.frameTables.clear();
+    chunk.dirty = false;
+
+    if(chunk.renders.empty())
+        return;
+
+    // Create sprites in the order they are drawn.
+    std::size_t spriteCount = chunk.renders.size();
+
+    std::vector<Graphics::BasicRenderer::Sprite::Info> spriteInfo(spriteCount);
+    std::vector<Graphics::BasicRenderer::Sprite::Data> spriteData(spriteCount);
+    std::vector<std::pair<SortKey, std::size_t>> spriteOrder(spriteCount);
+
+    for(std::size_t i = 0; i < spriteCount; ++i)
+    {
+        this->CreateSprite(chunk.renders[i], spriteInfo[i], spriteData[i]);
+
+        SortKey key = CalculateGroupKey(0, spriteInfo[i].transparent, false) | CalculateSpriteOrder(spriteInfo[i], spriteData[i], false);
+        spriteOrder[i] = std::make_pair(key, i);
+    }
+
+    std::sort(spriteOrder.begin(), spriteOrder.end());
+
+    std::vector<Graphics::BasicRenderer::Sprite::Info> sortedInfo(spriteCount);
+    std::vector<Graphics::BasicRenderer::Sprite::Data> sortedData(spriteCount);
+
+    for(std::size_t i = 0; i < spriteCount; ++i)
+    {
+        sortedInfo[i] = spriteInfo[spriteOrder[i].second];
+        sortedData[i] = spriteData[spriteOrder[i].second];
+    }
+
+    // Calculate chunk bounds from bounds of sprites.
+    chunk.bounds = CalculateSpriteBounds(sortedData[0]);
+
+    for(const auto& data : sortedData)
+    {
+        glm::vec4 bounds = CalculateSpriteBounds(data);
+
+        chunk.bounds.x = std::min(chunk.bounds.x, bounds.x);
+        chunk.bounds.y = std::max(chunk.bounds.y, bounds.y);
+        chunk.bounds.z = std::min(chunk.bounds.z, bounds.z);
+        chunk.bounds.w = std::max(chunk.bounds.w, bounds.w);
+    }
+
+    // Keep textures and frame tables alive for as long as the sprite buffer.
+    const Graphics::Texture* lastTexture = nullptr;
+    const Graphics::TextureBuffer* lastFrameTable = nullptr;
+
+    for(std::size_t i = 0; i < spriteCount; ++i)
+    {
+        Components::Render* render = chunk.renders[spriteOrder[i].second];
+
+        if(render->GetTexture().Get() != lastTexture)
+        {
+            chunk.textures.push_back(render->GetTexture());
+            lastTexture = render->GetTexture().Get();
+        }
+
+        if(render->GetFrameTable().get() != lastFrameTable)
+        {
+            chunk.frameTables.push_back(render->GetFrameTable());
+            lastFrameTable = render->GetFrameTable().get();
+        }
+    }
+
+    // Upload sprites.
+    auto buffer = std::make_shared<Graphics::SpriteBuffer>();
+
+    if(!buffer->Initialize(&sortedInfo[0], &sortedData[0], (int)spriteCount))
+    {
+        Log() << "Couldn't create a sprite buffer for a static chunk.";
+        return;
+    }
+
+    chunk.buffer = buffer;
+}
+
+void RenderSystem::RecordTilemap(Components::Tilemap& tilemap, const View& view, FramePacket& packet)
+{
+    // Check if the tilemap was finalized.
+    Components::Transform* transform = tilemap.GetTransform();
+
+    if(transform == nullptr)
+        return;
+
+    if(tilemap.GetSpriteSheet() == nullptr)
+        return;
+
+    // Calculate the range of visible chunks.
+    const glm::vec4& visible = view.visible;
+
+    glm::vec2 origin = transform->GetPosition();
+    glm::vec2 chunkSize = tilemap.GetTileSize() * (float)Components::Tilemap::ChunkSize;
+
+    if(chunkSize.x <= 0.0f || chunkSize.y <= 0.0f)
+        return;
+
+    int beginX = std::max(0, (int)std::floor((visible.x - origin.x) / chunkSize.x));
+    int beginY = std::max(0, (int)std::floor((visible.z - origin.y) / chunkSize.y));
+    int endX = std::min(tilemap.GetChunkCountX(), (int)std::floor((visible.y - origin.x) / chunkSize.x) + 1);
+    int endY = std::min(tilemap.GetChunkCountY(), (int)std::floor((visible.w - origin.y) / chunkSize.y) + 1);
+
+    // Record visible chunks.
+    // Tilemaps are drawn first in their layer, after the layer cache command.
+    Graphics::CommandList& setupList = packet.commandLists[0];
+    SortKey key = view.key | CalculateGroupKey(tilemap.GetLayer(), false, false) | 1;
+
+    bool recorded = false;
+
+    for(int y = beginY; y < endY; ++y)
+    {
+        for(int x = beginX; x < endX; ++x)
+        {
+            Components::Tilemap::Chunk& chunk = tilemap.GetChunk(x, y);
+
+            // Sprites are baked in world space, so chunks
+            // are rebuilt when the tilemap has moved.
+            if(chunk.dirty || chunk.origin != origin)
+            {
+                this->RebuildTilemapChunk(tilemap, x, y);
+                this->InvalidateLayerCache(tilemap.GetLayer());
+            }
+
+            if(chunk.buffer == nullptr)
+                continue;
+
+            setupList.DrawSpriteBuffer(key, chunk.buffer.get());
+            recorded = true;
+
+            // Keep the sprite buffer alive until the render thread consumes the packet.
+            if(m_threaded)
+            {
+                packet.spriteBuffers.push_back(chunk.buffer);
+            }
+        }
+    }
+
+    // Keep the texture alive until the render thread consumes the packet.
+    if(m_threaded && recorded)
+    {
+        packet.textures.push_back(tilemap.GetSpriteSheet()->GetTexture());
+    }
+}
+
+void RenderSystem::RebuildTilemapChunk(Components::Tilemap& tilemap, int chunkX, int chunkY)
+{
+    Components::Tilemap::Chunk& chunk = tilemap.GetChunk(chunkX, chunkY);
+
+    // Release the previous sprite buffer.
+    // Frame packets may still hold references to it.
+    Components::Transform* transform = tilemap.GetTransform();
+    assert(transform != nullptr);
+
+    chunk.buffer = nullptr;
+    chunk.origin = transform->GetPosition();
+    chunk.dirty = false;
+
+    if(chunk.tiles.empty())
+        return;
+
+    // Create sprites for non empty tiles.
+
+    Graphics::BasicRenderer::Sprite::Info info;
+    info.texture = tilemap.GetSpriteSheet()->GetTexture().Get();
+    info.transparent = tilemap.IsTransparent();
+    info.filter = false;
+
+    const glm::vec2& tileSize = tilemap.GetTileSize();
+
+    m_tileInfo.clear();
+    m_tileData.clear();
+
+    for(int y = 0; y < Components::Tilemap::ChunkSize; ++y)
+    {
+        for(int x = 0; x < Components::Tilemap::ChunkSize; ++x)
+        {
+            Components::Tilemap::Tile tile = chunk.tiles[y * Components::Tilemap::ChunkSize + x];
+
+            if(tile == Components::Tilemap::EmptyTile)
+                continue;
+
+            const glm::vec4& rectangle = tilemap.GetTileRectangle(tile);
+
+            if(rectangle.z == 0.0f || rectangle.w == 0.0f)
+                continue;
+
+            // Scale the sprite to fill the tile.
+            glm::vec2 coords(chunkX * Components::Tilemap::ChunkSize + x, chunkY * Components::Tilemap::ChunkSize + y);
+            glm::vec2 position = chunk.origin + coords * tileSize;
+
+            Graphics::BasicRenderer::Sprite::Data data;
+            data.transform = glm::translate(data.transform, glm::vec3(position, 0.0f));
+            data.transform = glm::scale(data.transform, glm::vec3(tileSize / glm::abs(glm::vec2(rectangle.z, rectangle.w)), 1.0f));
+            data.rectangle = rectangle;
+
+            m_tileInfo.push_back(info);
+            m_tileData.push_back(data);
+        }
+    }
+
+    if(m_tileData.empty())
+        return;
+
+    // Upload sprites.
+    auto buffer = std::make_shared<Graphics::SpriteBuffer>();
+
+    if(!buffer->Initialize(&m_tileInfo[0], &m_tileData[0], (int)m_tileData.size()))
+    {
+        Log() << "Couldn't create a sprite buffer for a tilemap chunk.";
+        return;
+    }
+
+    chunk.buffer = buffer;
+}
+
+void RenderSystem::RecordParticles(Components::ParticleEmitter& emitter, const View& view, FramePacket& packet)
+{
+    // Check if the emitter was finalized.
+    Components::Transform* transform = emitter.GetTransform();
+
+    if(transform == nullptr)
+        return;
+
+    int particleCount = emitter.GetParticles().count;
+
+    if(particleCount == 0 || emitter.GetFrames().empty())
+        return;
+
+    // Create sprite info shared by all particles.
+    Graphics::BasicRenderer::Sprite::Info info;
+    info.texture = emitter.GetTexture().Get();
+    info.transparent = emitter.IsTransparent();
+    info.filter = false;
+
+    // Sort the whole stream by the emitter position.
+    // Particles of weighted layers are still sorted, as they are drawn in one call.
+    Graphics::BasicRenderer::Sprite::Data origin;
+    origin.transform = glm::translate(glm::mat4(1.0f), glm::vec3(transform->GetPosition(), 0.0f));
+
+    SortKey key = view.key | CalculateGroupKey(emitter.GetLayer(), info.transparent, false) | CalculateSpriteOrder(info, origin, false);
+
+    // Write particle sprites directly into the command list.
+    Graphics::CommandList& setupList = packet.commandLists[0];
+    Graphics::BasicRenderer::Sprite::Data* spriteData = setupList.DrawSpriteStream(key, info, particleCount);
+
+    glm::vec2 scale = emitter.GetScale() * transform->GetScale() * glm::vec2(RenderScale);
+    m_particleSystem->WriteSprites(emitter, spriteData, scale);
+
+    // Keep the texture alive until the render thread consumes the packet.
+    if(m_threaded)
+    {
+        packet.textures.push_back(emitter.GetTexture());
+    }
+}
+
+void RenderSystem::RecordLayerCaches(FramePacket& packet)
+{
+    // Find buckets of cached layers.
+    bool cachedBuckets[LayerBucketCount] = { false };
+    bool anyCached = false;
+
+    for(const auto& layer : m_layers)
+    {
+        if(!layer.second.cached)
+            continue;
+
+        cachedBuckets[CalculateLayerBucket(layer.first)] = true;
+        anyCached = true;
+    }
+
+    if(!anyCached)
+        return;
+
+    // Calculate signatures of layer commands in each view.
+    // Hashes are summed, as the order of commands between lists changes every frame.
+    // Layers with animations played by shaders change every frame.
+    uint64_t signatures[MaxCameras][LayerBucketCount] = { { 0 } };
+    int commandCounts[MaxCameras][LayerBucketCount] = { { 0 } };
+    bool animated[MaxCameras][LayerBucketCount] = { { false } };
+
+    for(const auto& commandList : packet.commandLists)
+    {
+        for(int i = 0; i < commandList.GetCommandCount(); ++i)
+        {
+            const Graphics::CommandList::Command& command = commandList.GetCommand(i);
+
+            int slot = (int)(command.key >> CameraShift);
+            int bucket = (int)((command.key >> LayerShift) & (LayerBucketCount - 1));
+
+            if(!cachedBuckets[bucket])
+                continue;
+
+            signatures[slot][bucket] += HashCommand(commandList, command);
+            commandCounts[slot][bucket] += 1;
+
+            if(IsCommandAnimated(commandList, command))
+            {
+                animated[slot][bucket] = true;
+            }
+        }
+    }
+
+    // Record cache commands.
+    Graphics::CommandList& setupList = packet.commandLists[0];
+
+    for(int slot = 0; slot < m_viewCount; ++slot)
+    {
+        View& view = m_views[slot];
+
+        // Calculate the cache area.
+        // Cache covers the visible area with a margin of whole pixels around it.
+        const glm::vec4& visible = view.visible;
+        glm::vec2 visibleSize(visible.y - visible.x, visible.w - visible.z);
+
+        if(view.resolution.x <= 0 || view.resolution.y <= 0 || visibleSize.x <= 0.0f || visibleSize.y <= 0.0f)
+            continue;
+
+        glm::vec2 pixelSize = visibleSize / glm::vec2(view.resolution);
+        glm::ivec2 margin = glm::ivec2(glm::ceil(glm::vec2(view.resolution) * LayerCacheMargin));
+        glm::ivec2 cacheSize = view.resolution + margin * 2;
+
+        for(int bucket = 0; bucket < LayerBucketCount; ++bucket)
+        {
+            if(!cachedBuckets[bucket])
+                continue;
+
+            LayerCache& cache = view.layerCaches[bucket];
+
+            // Check if the layer has to be redrawn.
+            if(cache.signature != signatures[slot][bucket] || animated[slot][bucket])
+            {
+                cache.signature = signatures[slot][bucket];
+                cache.dirty = true;
+            }
+
+            bool covered = cache.rectangle.x <= visible.x && cache.rectangle.y >= visible.y &&
+                           cache.rectangle.z <= visible.z && cache.rectangle.w >= visible.w;
+
+            if(!covered || cache.size != cacheSize)
+            {
+                // Center the cache at the current view.
+                glm::vec2 marginSize = glm::vec2(margin) * pixelSize;
+
+                cache.rectangle.x = visible.x - marginSize.x;
+                cache.rectangle.y = visible.y + marginSize.x;
+                cache.rectangle.z = visible.z - marginSize.y;
+                cache.rectangle.w = visible.w + marginSize.y;
+                cache.size = cacheSize;
+                cache.dirty = true;
+            }
+
+            // Skip empty layers.
+            if(commandCounts[slot][bucket] == 0)
+                continue;
+
+            // Record the cache.
+            // Cache begins before the first and ends after the last command of the layer.
+            const glm::vec4& rectangle = cache.rectangle;
+
+            Graphics::CommandList::LayerCacheParameters parameters;
+            parameters.cache = slot * LayerBucketCount + bucket;
+            parameters.redraw = cache.dirty;
+            parameters.size = cache.size;
+            parameters.transform = glm::ortho(rectangle.x, rectangle.y, rectangle.z, rectangle.w);
+            parameters.composite = view.transform;
+            parameters.composite = glm::translate(parameters.composite, glm::vec3(rectangle.x, rectangle.z, 0.0f));
+            parameters.composite = glm::scale(parameters.composite, glm::vec3(rectangle.y - rectangle.x, rectangle.w - rectangle.z, 1.0f));
+
+            SortKey beginKey = view.key | SortKey(bucket) << LayerShift;
+            SortKey endKey = beginKey | (SortKey(1) << TransparentShift) | (SortKey(1) << WeightedShift) | OrderMask;
+
+            setupList.CacheLayer(beginKey, endKey, parameters);
+
+            cache.dirty = false;
+        }
+    }
+}
+
+void RenderSystem::InvalidateLayerCache(int layer)
+{
+    int bucket = CalculateLayerBucket(layer);
+
+    for(int i = 0; i < MaxCameras; ++i)
+    {
+        auto it = m_views[i].layerCaches.find(bucket);
+
+        if(it != m_views[i].layerCaches.end())
+        {
+            it->second.dirty = true;
+        }
+    }
+}
+
+void RenderSystem::OnWindowResize(const System::Window::Events::Resize& event)
+{
+    m_windowSize = glm::ivec2(event.width, event.height);
+
+    // Rebuild viewports of all cameras.
+    auto camerasBegin = m_componentSystem->Begin<Components::Camera>();
+    auto camerasEnd = m_componentSystem->End<Components::Camera>();
+
+    for(auto it = camerasBegin; it != camerasEnd; ++it)
+    {
+        it->second.SetWindowSize(event.width, event.height);
+    }
+}
+
+void RenderSystem::SubmitPacket(const FramePacket& packet)
+{
+    // Execute recorded commands.
+    m_basicRenderer->SetAnimationTime(packet.animationTime);
+    m_basicRenderer->Execute(&packet.commandLists[0], (int)packet.commandLists.size());
+}
+
+void RenderSystem::RenderThread()
+{
+    // Take ownership of the window context.
+    m_window->MakeContextCurrent();
+
+    while(true)
+    {
+        // Wait for a frame packet.
+        FramePacket* packet = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(m_packetMutex);
+
+            m_packetCondition.wait(lock, [this]()
+            {
+                return m_renderThreadExit || !m_readyPackets.empty();
+            });
+
+            // Exit only after all ready packets were consumed.
+            if(m_readyPackets.empty())
+                break;
+
+            packet = m_readyPackets.front();
+            m_readyPackets.pop();
+        }
+
+        // Submit and present the frame.
+        double renderBegin = glfwGetTime();
+
+        // Wait on the server for resource commands of the main context.
+        if(packet->fence != nullptr)
+        {
+            glWaitSync(packet->fence, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(packet->fence);
+            packet->fence = nullptr;
+        }
+
+        this->SubmitPacket(*packet);
+        m_window->Present(packet->verticalSync);
+
+        double renderTime = glfwGetTime() - renderBegin;
+
+        // Return the packet to the free queue.
+        // Packet is cleared on the main thread, so
+        // released textures get destroyed there.
+        {
+            std::lock_guard<std::mutex> lock(m_packetMutex);
+
+            m_freePackets.push(packet);
+            m_statistics.renderTime += renderTime;
+        }
+
+        m_packetCondition.notify_all();
+    }
+
+    // Release the window context.
+    m_window->ReleaseContextCurrent();
+}
+
+void RenderSystem::UpdateStatistics()
+{
+    // Measure time between presented frames.
+    double currentTime = glfwGetTime();
+
+    if(m_statistics.lastFrame != 0.0)
+    {
+        m_statistics.frameTime += currentTime - m_statistics.lastFrame;
+        m_statistics.frameCount += 1;
+    }
+    else
+    {
+        m_statistics.lastReport = currentTime;
+    }
+
+    m_statistics.lastFrame = currentTime;
+
+    // Print average frame times.
+    if(currentTime - m_statistics.lastReport < StatisticsInterval)
+        return;
+
+    if(m_statistics.frameCount == 0)
+        return;
+
+    double renderTime = 0.0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_packetMutex);
+
+        renderTime = m_statistics.renderTime;
+        m_statistics.renderTime = 0.0;
+    }
+
+    double frames = (double)m_statistics.frameCount;
+
+    Log() << std::fixed << std::setprecision(2)
+        << "Frame statistics (" << (m_threaded ? "render thread" : "immediate") << "): "
+        << "frame " << 1000.0 * m_statistics.frameTime / frames << " ms, "
+        << "render " << 1000.0 * renderTime / frames << " ms, "
+        << "wait " << 1000.0 * m_statistics.waitTime / frames << " ms.";
+
+    m_statistics.frameTime = 0.0;
+    m_statistics.waitTime = 0.0;
+    m_statistics.frameCount = 0;
+    m_statistics.lastReport = currentTime;
+}
+
+void RenderSystem::SetLayerTransparency(int layer, TransparencyModes::Type mode)
+{
+    m_layers[layer].transparency = mode;
+}
+
+RenderSystem::TransparencyModes::Type RenderSystem::GetLayerTransparency(int layer) const
+{
+    // Find layer settings.
+    auto it = m_layers.find(layer);
+
+    if(it == m_layers.end())
+        return TransparencyModes::Sorted;
+
+    return it->second.transparency;
+}
+
+void RenderSystem::SetLayerCached(int layer, bool cached)
+{
+    Layer& settings = m_layers[layer];
+
+    if(settings.cached != cached)
+    {
+        settings.cached = cached;
+
+        // Release cache state in all views.
+        int bucket = CalculateLayerBucket(layer);
+
+        for(int i = 0; i < MaxCameras; ++i)
+        {
+            m_views[i].layerCaches.erase(bucket);
+        }
+    }
+}
+
+bool RenderSystem::IsLayerCached(int layer) const
+{
+    // Find layer settings.
+    auto it = m_layers.find(layer);
+
+    if(it == m_layers.end())
+        return false;
+
+    return it->second.cached;
+}
+
+void RenderSystem::AddStatic(Components::Render* render)
+{
+    if(!m_initialized)
+        return;
+
+    assert(render != nullptr);
+
+    // Check if sprite was already added.
+    if(m_staticSprites.find(render) != m_staticSprites.end())
+        return;
+
+    // Transparent sprites stay dynamic, as they have to be
+    // sorted by depth and position against other sprites.
+    if(render->IsTransparent())
+        return;
+
+    // Find the chunk at the sprite position.
+    Components::Transform* transform = render->GetTransform();
+    assert(transform != nullptr);
+
+    glm::vec2 cell = glm::floor(transform->GetPosition() / StaticChunkSize);
+    StaticChunkIndex index(render->GetLayer(), (int)cell.x, (int)cell.y);
+
+    // Add sprite to the chunk.
+    StaticChunk& chunk = m_staticChunks[index];
+    chunk.renders.push_back(render);
+    chunk.dirty = true;
+
+    m_staticSprites.emplace(render, index);
+}
+
+void RenderSystem::RemoveStatic(Components::Render* render)
+{
+    if(!m_initialized)
+        return;
+
+    // Find the chunk of the sprite.
+    auto it = m_staticSprites.find(render);
+
+    if(it == m_staticSprites.end())
+        return;
+
+    auto chunkIt = m_staticChunks.find(it->second);
+    assert(chunkIt != m_staticChunks.end());
+
+    // Remove sprite from the chunk.
+    StaticChunk& chunk = chunkIt->second;
+
+    auto renderIt = std::find(chunk.renders.begin(), chunk.renders.end(), render);
+    assert(renderIt != chunk.renders.end());
+
+    *renderIt = chunk.renders.back();
+    chunk.renders.pop_back();
+    chunk.dirty = true;
+
+    m_staticSprites.erase(it);
+}
+
+void RenderSystem::InvalidateStatic(Components::Render* render)
+{
+    // Add sprite again, as it might have moved to a different chunk.
+    this->RemoveStatic(render);
+    this->AddStatic(render);
 }
@@ -1,13 +1,22 @@
 #pragma once
 
 #include "Precompiled.hpp"
-#include "Graphics/ScreenSpace.hpp"
+#include "System/Window.hpp"
+#include "System/ResourceManager.hpp"
 #include "Graphics/BasicRenderer.hpp"
+#include "Graphics/CommandList.hpp"
 
 // Forward declarations.
 namespace System
 {
-    class Window;
+    class JobPool;
+}
+
+namespace Graphics
+{
+    class Texture;
+    class TextureBuffer;
+    class SpriteBuffer;
 }
 
 //
@@ -18,15 +27,79 @@ namespace Game
 {
     // Forward declarations.
     class ComponentSystem;
+    class AnimationSystem;
+    class ParticleSystem;
+    class LightSystem;
+    class VisibilitySystem;
+
+    namespace Components
+    {
+        class Render;
+        class Camera;
+        class Tilemap;
+        class ParticleEmitter;
+    }
 
     // Render system class.
     class RenderSystem
     {
     public:
+        // Layer transparency modes.
+        struct TransparencyModes
+        {
+            enum Type
+            {
+                // Transparent sprites are sorted back to front.
+                Sorted,
+
+                // Transparent sprites are not sorted and blended with
+                // weighted blended order independent transparency.
+                Weighted,
+            };
+        };
+
         // Type delcarations.
-        typedef std::vector<Graphics::BasicRenderer::Sprite::Info> SpriteInfoList;
-        typedef std::vector<Graphics::BasicRenderer::Sprite::Data> SpriteDataList;
-        typedef std::vector<std::size_t> SpriteSortList;
+        typedef std::vector<Components::Render*> RenderComponentList;
+
+        // Frame packet.
+        //  Self-contained description of a frame extracted from components
+        //  that can be submitted to the renderer on a different thread.
+        //  Each job pool worker records into its own command list.
+        struct FramePacket
+        {
+            // Type declarations.
+            typedef std::vector<Graphics::CommandList> CommandListArray;
+            typedef std::vector<System::ResourceHandle<Graphics::Texture>> TextureList;
+            typedef std::vector<std::shared_ptr<const Graphics::SpriteBuffer>> SpriteBufferList;
+            typedef std::vector<std::shared_ptr<const Graphics::TextureBuffer>> FrameTableList;
+
+            FramePacket();
+
+            // Clears the packet while keeping allocated memory.
+            void Clear();
+
+            // Recorded commands.
+            CommandListArray commandLists;
+
+            // Resources kept alive until the packet is consumed.
+            TextureList      textures;
+            SpriteBufferList spriteBuffers;
+            FrameTableList   frameTables;
+
+            // Fence of resource commands issued on the main context.
+            // Render thread waits for it before executing the commands.
+            GLsync fence;
+
+            // Time of animations played by shaders.
+            float animationTime;
+
+            // Presentation parameters.
+            bool verticalSync;
+        };
+
+        // Constant variables.
+        static const int FramePacketCount = 2;
+        static const int MaxCameras = 8;
 
     public:
         RenderSystem();
@@ -39,21 +112,215 @@ namespace Game
         bool Initialize(Context& context);
 
         // Draws the scene.
+        // Extracts a frame packet and submits it immediately, or hands
+        // it over to the render thread on the following Present() call.
         void Draw();
 
+        // Presents the drawn frame to the window.
+        void Present(bool verticalSync);
+
+        // Checks if a dedicated render thread is used.
+        bool IsThreaded() const;
+
+        // Checks if the scene is rendered at the virtual resolution.
+        bool IsLowResolution() const;
+
+        // Sets the transparency mode of a render layer.
+        void SetLayerTransparency(int layer, TransparencyModes::Type mode);
+
+        // Gets the transparency mode of a render layer.
+        TransparencyModes::Type GetLayerTransparency(int layer) const;
+
+        // Sets cached state of a render layer.
+        // Cached layers are rendered into their own target and only redrawn
+        // when their contents change or the view moves past a margin.
+        void SetLayerCached(int layer, bool cached);
+
+        // Checks if a render layer is cached.
+        bool IsLayerCached(int layer) const;
+
+        // Adds a static sprite.
+        // Static sprites are grouped into spatial chunks that are uploaded
+        // once and drawn before dynamic sprites of the same layer.
+        // Transparent sprites are not chunked and are drawn as dynamic.
+        void AddStatic(Components::Render* render);
+
+        // Removes a static sprite.
+        void RemoveStatic(Components::Render* render);
+
+        // Marks a static sprite as changed.
+        void InvalidateStatic(Components::Render* render);
+
+    private:
+        // Layer settings.
+        struct Layer
+        {
+            Layer();
+
+            TransparencyModes::Type transparency;
+            bool                    cached;
+        };
+
+        typedef std::map<int, Layer> LayerList;
+
+        // Layer cache state.
+        struct LayerCache
+        {
+            LayerCache();
+
+            bool       dirty;
+            uint64_t   signature;
+            glm::vec4  rectangle;
+            glm::ivec2 size;
+        };
+
+        typedef std::map<int, LayerCache> LayerCacheList;
+
+        // Camera view.
+        //  Parameters of a camera gathered for the current frame.
+        //  Views are kept by their slot, along with layer caches.
+        struct View
+        {
+            View();
+
+            Components::Camera*            camera;
+            Graphics::CommandList::SortKey key;
+            glm::mat4                      transform;
+            glm::vec4                      visible;
+            glm::ivec2                     resolution;
+            LayerCacheList                 layerCaches;
+        };
+
+        // Static chunk index (layer, x, y).
+        typedef std::tuple<int, int, int> StaticChunkIndex;
+
+        // Static chunk.
+        struct StaticChunk
+        {
+            StaticChunk();
+
+            RenderComponentList                           renders;
+            std::shared_ptr<const Graphics::SpriteBuffer> buffer;
+            FramePacket::TextureList                      textures;
+            FramePacket::FrameTableList                   frameTables;
+            glm::vec4                                     bounds;
+            bool                                          dirty;
+        };
+
+        typedef std::map<StaticChunkIndex, StaticChunk> StaticChunkList;
+        typedef std::unordered_map<const Components::Render*, StaticChunkIndex> StaticSpriteList;
+
+        // Frame statistics.
+        struct FrameStatistics
+        {
+            FrameStatistics();
+
+            double frameTime;
+            double renderTime;
+            double waitTime;
+            int    frameCount;
+            double lastFrame;
+            double lastReport;
+        };
+
+    private:
+        // Extracts render components into a frame packet.
+        void ExtractPacket(FramePacket& packet);
+
+        // Gathers cameras and prepares their views.
+        void PrepareViews(FramePacket& packet);
+
+        // Records a range of render components into a command list.
+        // Sprites are recorded once for every view that they are visible in.
+        void ExtractRange(int begin, int end, Graphics::CommandList& commandList) const;
+
+        // Creates a sprite from a render component.
+        void CreateSprite(Components::Render* render, Graphics::BasicRenderer::Sprite::Info& info, Graphics::BasicRenderer::Sprite::Data& data) const;
+
+        // Rebuilds the sprite buffer of a static chunk.
+        void RebuildStaticChunk(StaticChunk& chunk);
+
+        // Records visible chunks of a tilemap, rebuilding them if needed.
+        void RecordTilemap(Components::Tilemap& tilemap, const View& view, FramePacket& packet);
+
+        // Rebuilds the sprite buffer of a tilemap chunk.
+        void RebuildTilemapChunk(Components::Tilemap& tilemap, int chunkX, int chunkY);
+
+        // Records particles of an emitter as a sprite stream.
+        void RecordParticles(Components::ParticleEmitter& emitter, const View& view, FramePacket& packet);
+
+        // Records cache commands of cached layers in every view.
+        // Layers are redrawn if signatures of their commands have changed.
+        void RecordLayerCaches(FramePacket& packet);
+
+        // Forces a cached layer to be redrawn in every view.
+        void InvalidateLayerCache(int layer);
+
+        // Called when the window gets resized.
+        void OnWindowResize(const System::Window::Events::Resize& event);
+
+        // Submits a frame packet to the renderer.
+        void SubmitPacket(const FramePacket& packet);
+
+        // Render thread entry point.
+        void RenderThread();
+
+        // Updates and periodically prints frame statistics.
+        void UpdateStatistics();
+
     private:
         // Context references.
         System::Window*          m_window;
         Graphics::BasicRenderer* m_basicRenderer;
         ComponentSystem*         m_componentSystem;
+        AnimationSystem*         m_animationSystem;
+        ParticleSystem*          m_particleSystem;
+        LightSystem*             m_lightSystem;
+        VisibilitySystem*        m_visibilitySystem;
+        System::JobPool*         m_jobPool;
+
+        // Camera views.
+        std::vector<Components::Camera*> m_cameras;
+        View                             m_views[MaxCameras];
+        int                              m_viewCount;
+        glm::ivec2                       m_windowSize;
+
+        // Layer list.
+        LayerList m_layers;
+
+        // List of render components being extracted.
+        RenderComponentList m_renderComponents;
+
+        // Static sprite chunks.
+        StaticChunkList  m_staticChunks;
+        StaticSpriteList m_staticSprites;
+
+        // Tilemap chunk build lists.
+        Graphics::BasicRenderer::SpriteInfoList m_tileInfo;
+        Graphics::BasicRenderer::SpriteDataList m_tileData;
+
+        // Frame packets.
+        FramePacket  m_framePackets[FramePacketCount];
+        FramePacket* m_currentPacket;
+
+        // Render thread.
+        std::thread              m_renderThread;
+        std::mutex               m_packetMutex;
+        std::condition_variable  m_packetCondition;
+        std::queue<FramePacket*> m_freePackets;
+        std::queue<FramePacket*> m_readyPackets;
+        bool                     m_renderThreadExit;
+        bool                     m_threaded;
+
+        // Low resolution rendering.
+        bool                         m_lowResolution;
+        Graphics::UpscaleModes::Type m_upscaleMode;
 
-        // Graphics objects.
-        Graphics::ScreenSpace  m_screenSpace;
+        // Frame statistics.
+        FrameStatistics m_statistics;
 
-        // Sprite list.
-        SpriteInfoList m_spriteInfo;
-        SpriteDataList m_spriteData;
-        SpriteSortList m_spriteSort;
+        // Event receivers.
+        Receiver<void(const System::Window::Events::Resize&)> m_windowResize;
 
         // Initialization state.
         bool m_initialized;
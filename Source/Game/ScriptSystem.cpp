@@ -2,7 +2,9 @@
 #include "ScriptSystem.hpp"
 #include "EntitySystem.hpp"
 #include "ComponentSystem.hpp"
+#include "VisibilitySystem.hpp"
 #include "Components/Script.hpp"
+#include "Components/Transform.hpp"
 using namespace Game;
 
 namespace
@@ -11,9 +13,16 @@ namespace
     #define LogInitializeError() "Failed to initialize the script system! "
 }
 
+ScriptSystem::Statistics::Statistics() :
+    updatedCount(0),
+    skippedCount(0)
+{
+}
+
 ScriptSystem::ScriptSystem() :
     m_entitySystem(nullptr),
     m_componentSystem(nullptr),
+    m_visibilitySystem(nullptr),
     m_initialized(false)
 {
 }
@@ -29,6 +38,10 @@ void ScriptSystem::Cleanup()
     // Reset context references.
     m_entitySystem = nullptr;
     m_componentSystem = nullptr;
+    m_visibilitySystem = nullptr;
+
+    // Reset update statistics.
+    m_statistics = Statistics();
 
     // Reset initialization state.
     m_initialized = false;
@@ -73,6 +86,15 @@ bool ScriptSystem::Initialize(Context& context)
         return false;
     }
 
+    // Get the visibility system.
+    m_visibilitySystem = context[ContextTypes::Game].Get<VisibilitySystem>();
+
+    if(m_visibilitySystem == nullptr)
+    {
+        Log() << LogInitializeError() << "Context is missing VisibilitySystem instance.";
+        return false;
+    }
+
     // Success!
     return m_initialized = true;
 }
@@ -82,6 +104,9 @@ void ScriptSystem::Update(float timeDelta)
     if(!m_initialized)
         return;
 
+    // Reset update statistics.
+    m_statistics = Statistics();
+
     // Iterate over all script components.
     auto componentsBegin = m_componentSystem->Begin<Components::Script>();
     auto componentsEnd = m_componentSystem->End<Components::Script>();
@@ -95,7 +120,28 @@ void ScriptSystem::Update(float timeDelta)
         if(!m_entitySystem->IsHandleValid(it->first))
             continue;
 
+        // Skip updates of entities that can't be seen.
+        Components::Transform* transform = script.GetTransform();
+
+        if(!script.IsAlwaysUpdated() && transform != nullptr)
+        {
+            auto level = m_visibilitySystem->CalculateDetailLevel(transform->GetPosition());
+
+            if(!m_visibilitySystem->ShouldUpdate(level, entity.identifier))
+            {
+                script.Skip(timeDelta);
+                ++m_statistics.skippedCount;
+                continue;
+            }
+        }
+
         // Update script component.
         script.Update(entity, timeDelta);
+        ++m_statistics.updatedCount;
     }
 }
+
+const ScriptSystem::Statistics& ScriptSystem::GetStatistics() const
+{
+    return m_statistics;
+}
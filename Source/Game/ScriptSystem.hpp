@@ -5,16 +5,31 @@
 //
 // Script System
 //
+//  Scripts of entities that are not visible are updated at a reduced rate
+//  set by the visibility system, and receive the accumulated time delta.
+//  Scripts that have to run every frame can opt out with SetAlwaysUpdate().
+//
 
 namespace Game
 {
     // Forward declarations.
     class EntitySystem;
     class ComponentSystem;
+    class VisibilitySystem;
 
     // Script system class.
     class ScriptSystem
     {
+    public:
+        // Update statistics.
+        struct Statistics
+        {
+            Statistics();
+
+            int updatedCount;
+            int skippedCount;
+        };
+
     public:
         ScriptSystem();
         ~ScriptSystem();
@@ -28,10 +43,17 @@ namespace Game
         // Updates all script components.
         void Update(float timeDelta);
 
+        // Gets statistics of the last update.
+        const Statistics& GetStatistics() const;
+
     private:
         // Context references.
-        EntitySystem*    m_entitySystem;
-        ComponentSystem* m_componentSystem;
+        EntitySystem*     m_entitySystem;
+        ComponentSystem*  m_componentSystem;
+        VisibilitySystem* m_visibilitySystem;
+
+        // Update statistics.
+        Statistics m_statistics;
 
         // Initialization state.
         bool m_initialized;
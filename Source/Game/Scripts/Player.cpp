@@ -7,11 +7,36 @@
 using namespace Game;
 using namespace Scripts;
 
+namespace
+{
+    // Animation names for every heading.
+    const char* MovingAnimationNames[] =
+    {
+        "moving_up",
+        "moving_right",
+        "moving_down",
+        "moving_left",
+    };
+
+    const char* StandingAnimationNames[] =
+    {
+        "standing_up",
+        "standing_right",
+        "standing_down",
+        "standing_left",
+    };
+}
+
 Player::Player() :
     m_inputState(nullptr),
     m_transform(nullptr),
     m_animation(nullptr)
 {
+    for(int i = 0; i < Headings::Count; ++i)
+    {
+        m_movingAnimations[i] = Graphics::AnimationList::InvalidId;
+        m_standingAnimations[i] = Graphics::AnimationList::InvalidId;
+    }
 }
 
 Player::~Player()
@@ -34,9 +59,35 @@ bool Player::OnFinalize(EntityHandle self, const Context& context)
     m_animation = componentSystem->Lookup<Components::Animation>(self);
     if(m_animation == nullptr) return false;
 
+    // Resolve animation names.
+    const auto& animationList = m_animation->GetAnimationList();
+
+    if(animationList.IsValid())
+    {
+        for(int i = 0; i < Headings::Count; ++i)
+        {
+            m_movingAnimations[i] = animationList->GetAnimationId(MovingAnimationNames[i]);
+            m_standingAnimations[i] = animationList->GetAnimationId(StandingAnimationNames[i]);
+        }
+    }
+
     return true;
 }
 
+Player::Headings::Type Player::CalculateHeading(float rotation)
+{
+    if(330.0f < rotation || rotation <= 30.0f)
+        return Headings::Up;
+
+    if(30.0f < rotation && rotation <= 150.0f)
+        return Headings::Right;
+
+    if(150.0f < rotation && rotation <= 210.0f)
+        return Headings::Down;
+
+    return Headings::Left;
+}
+
 void Player::OnUpdate(EntityHandle self, float timeDelta)
 {
     // Move entity.
@@ -72,49 +123,13 @@ void Player::OnUpdate(EntityHandle self, float timeDelta)
         m_transform->SetRotation(rotation);
 
         // Play moving animation.
-        if(330.0f < rotation || rotation <= 30.0f)
-        {
-            m_animation->Play("moving_up", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(30.0f < rotation && rotation <= 150.0f)
-        {
-            m_animation->Play("moving_right", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(150.0f < rotation && rotation <= 210.0f)
-        {
-            m_animation->Play("moving_down", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(210.0f < rotation && rotation <= 330.0f)
-        {
-            m_animation->Play("moving_left", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
+        Headings::Type facing = CalculateHeading(rotation);
+        m_animation->Play(m_movingAnimations[facing], Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
     }
     else
     {
         // Play standing animation.
-        float rotation = m_transform->GetRotation();
-
-        if(330.0f < rotation || rotation <= 30.0f)
-        {
-            m_animation->Play("standing_up", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(30.0f < rotation && rotation <= 150.0f)
-        {
-            m_animation->Play("standing_right", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(150.0f < rotation && rotation <= 210.0f)
-        {
-            m_animation->Play("standing_down", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
-        else
-        if(210.0f < rotation && rotation <= 330.0f)
-        {
-            m_animation->Play("standing_left", Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
-        }
+        Headings::Type facing = CalculateHeading(m_transform->GetRotation());
+        m_animation->Play(m_standingAnimations[facing], Components::Animation::PlayFlags::Continue | Components::Animation::PlayFlags::Loop);
     }
 }
@@ -36,10 +36,32 @@ namespace Game
             bool OnFinalize(EntityHandle self, const Context& context) override;
             void OnUpdate(EntityHandle self, float timeDelta) override;
 
+        private:
+            // Headings of the player.
+            struct Headings
+            {
+                enum Type
+                {
+                    Up,
+                    Right,
+                    Down,
+                    Left,
+
+                    Count,
+                };
+            };
+
+            // Calculates the heading from a rotation.
+            static Headings::Type CalculateHeading(float rotation);
+
         private:
             System::InputState*    m_inputState;
             Components::Transform* m_transform;
             Components::Animation* m_animation;
+
+            // Animations resolved for every heading.
+            int m_movingAnimations[Headings::Count];
+            int m_standingAnimations[Headings::Count];
         };
     }
 }
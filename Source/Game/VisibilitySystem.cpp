@@ -0,0 +1,176 @@
+#include "Precompiled.hpp"
+#include "VisibilitySystem.hpp"
+#include "System/Config.hpp"
+using namespace Game;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the visibility system! "
+
+    // Default detail parameters.
+    const float DefaultVisibleMargin = 0.1f;
+    const float DefaultNearMargin = 1.0f;
+    const int DefaultNearInterval = 4;
+    const int DefaultFarInterval = 16;
+
+    // Expands an area by a fraction of its size.
+    glm::vec4 ExpandArea(const glm::vec4& area, float margin)
+    {
+        float x = (area.y - area.x) * margin;
+        float y = (area.w - area.z) * margin;
+
+        return glm::vec4(area.x - x, area.y + x, area.z - y, area.w + y);
+    }
+
+    // Checks if a position is inside of an area.
+    bool ContainsPosition(const glm::vec4& area, const glm::vec2& position)
+    {
+        return area.x <= position.x && position.x <= area.y && area.z <= position.y && position.y <= area.w;
+    }
+}
+
+VisibilitySystem::VisibilitySystem() :
+    m_areaCount(0),
+    m_visibleMargin(DefaultVisibleMargin),
+    m_nearMargin(DefaultNearMargin),
+    m_enabled(true),
+    m_frameIndex(0),
+    m_initialized(false)
+{
+    m_updateIntervals[DetailLevels::Visible] = 1;
+    m_updateIntervals[DetailLevels::Near] = DefaultNearInterval;
+    m_updateIntervals[DetailLevels::Far] = DefaultFarInterval;
+}
+
+VisibilitySystem::~VisibilitySystem()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void VisibilitySystem::Cleanup()
+{
+    // Reset visible areas.
+    m_areaCount = 0;
+
+    // Reset detail parameters.
+    m_visibleMargin = DefaultVisibleMargin;
+    m_nearMargin = DefaultNearMargin;
+
+    m_updateIntervals[DetailLevels::Visible] = 1;
+    m_updateIntervals[DetailLevels::Near] = DefaultNearInterval;
+    m_updateIntervals[DetailLevels::Far] = DefaultFarInterval;
+
+    m_enabled = true;
+
+    // Reset frame counter.
+    m_frameIndex = 0;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool VisibilitySystem::Initialize(Context& context)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Add instance to the context.
+    if(context[ContextTypes::Game].Has<VisibilitySystem>())
+    {
+        Log() << LogInitializeError() << "Context is invalid.";
+        return false;
+    }
+
+    context[ContextTypes::Game].Set(this);
+
+    // Read config settings.
+    System::Config* config = context[ContextTypes::Main].Get<System::Config>();
+
+    if(config != nullptr)
+    {
+        m_enabled = config->Get<bool>("Game.VisibilityCulling", true);
+    }
+
+    // Success!
+    return m_initialized = true;
+}
+
+void VisibilitySystem::SetVisibleAreas(const glm::vec4* areas, int count)
+{
+    assert(count == 0 || areas != nullptr);
+
+    // Store visible areas with their margins.
+    m_areaCount = std::min(count, MaxAreas);
+
+    for(int i = 0; i < m_areaCount; ++i)
+    {
+        m_visibleAreas[i] = ExpandArea(areas[i], m_visibleMargin);
+        m_nearAreas[i] = ExpandArea(areas[i], m_nearMargin);
+    }
+
+    // Advance to the next frame.
+    ++m_frameIndex;
+}
+
+void VisibilitySystem::SetMargins(float visible, float near)
+{
+    m_visibleMargin = std::max(0.0f, visible);
+    m_nearMargin = std::max(m_visibleMargin, near);
+}
+
+void VisibilitySystem::SetUpdateInterval(DetailLevels::Type level, int frames)
+{
+    assert(level >= 0 && level < DetailLevels::Count);
+
+    m_updateIntervals[level] = std::max(1, frames);
+}
+
+void VisibilitySystem::SetEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+VisibilitySystem::DetailLevels::Type VisibilitySystem::CalculateDetailLevel(const glm::vec2& position) const
+{
+    // Everything is visible until the first frame is drawn.
+    if(!m_enabled || m_areaCount == 0)
+        return DetailLevels::Visible;
+
+    DetailLevels::Type level = DetailLevels::Far;
+
+    for(int i = 0; i < m_areaCount; ++i)
+    {
+        if(ContainsPosition(m_visibleAreas[i], position))
+            return DetailLevels::Visible;
+
+        if(ContainsPosition(m_nearAreas[i], position))
+        {
+            level = DetailLevels::Near;
+        }
+    }
+
+    return level;
+}
+
+bool VisibilitySystem::ShouldUpdate(DetailLevels::Type level, int stagger) const
+{
+    assert(level >= 0 && level < DetailLevels::Count);
+
+    unsigned int interval = (unsigned int)m_updateIntervals[level];
+
+    return (m_frameIndex + (unsigned int)stagger) % interval == 0;
+}
+
+bool VisibilitySystem::IsEnabled() const
+{
+    return m_enabled;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Visibility System
+//
+//  Keeps visible areas of cameras drawn by the render system and sorts
+//  positions into detail levels, which other systems use to skip or slow
+//  down updates of entities that can't be seen. Areas are those of the
+//  last drawn frame, and every position is visible until the first one.
+//
+//  Updating an entity at a reduced rate:
+//      auto level = visibilitySystem->CalculateDetailLevel(position);
+//      if(visibilitySystem->ShouldUpdate(level, entity.identifier)) ...
+//
+
+namespace Game
+{
+    // Visibility system class.
+    class VisibilitySystem
+    {
+    public:
+        // Detail levels.
+        struct DetailLevels
+        {
+            enum Type
+            {
+                // Inside a visible area.
+                Visible,
+
+                // Close to a visible area.
+                Near,
+
+                // Far away from any visible area.
+                Far,
+
+                Count,
+            };
+        };
+
+        // Constant variables.
+        static const int MaxAreas = 8;
+
+    public:
+        VisibilitySystem();
+        ~VisibilitySystem();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the visibility system.
+        bool Initialize(Context& context);
+
+        // Sets visible areas of a new frame.
+        // Areas are [left, right, bottom, top] vectors.
+        void SetVisibleAreas(const glm::vec4* areas, int count);
+
+        // Sets margins around visible areas (as fractions of their size).
+        // Visible margin covers extents of sprites around their positions.
+        void SetMargins(float visible, float near);
+
+        // Sets the update interval of a detail level (in frames).
+        void SetUpdateInterval(DetailLevels::Type level, int frames);
+
+        // Sets the enabled state.
+        // Every position is visible when disabled.
+        void SetEnabled(bool enabled);
+
+        // Calculates the detail level of a position.
+        DetailLevels::Type CalculateDetailLevel(const glm::vec2& position) const;
+
+        // Checks if an entity at a detail level should be updated this frame.
+        // Updates of entities with different stagger values are spread over frames.
+        bool ShouldUpdate(DetailLevels::Type level, int stagger) const;
+
+        // Checks if is enabled.
+        bool IsEnabled() const;
+
+    private:
+        // Visible areas.
+        glm::vec4 m_visibleAreas[MaxAreas];
+        glm::vec4 m_nearAreas[MaxAreas];
+        int       m_areaCount;
+
+        // Detail parameters.
+        float m_visibleMargin;
+        float m_nearMargin;
+        int   m_updateIntervals[DetailLevels::Count];
+        bool  m_enabled;
+
+        // Frame counter.
+        unsigned int m_frameIndex;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -1,24 +1,34 @@
 #include "Precompiled.hpp"
 #include "AnimationList.hpp"
-#include "Lua/State.hpp"
+#include "Lua/Loader.hpp"
 #include "System/ResourceManager.hpp"
+#include "System/FileSystem.hpp"
+#include "System/BakedFile.hpp"
 #include "Graphics/SpriteSheet.hpp"
+#include "Graphics/Texture.hpp"
+#include "Graphics/Buffer.hpp"
 using namespace Graphics;
 
 namespace
 {
     // Log messages.
     #define LogLoadError(filename) "Failed to load an animation list from \"" << filename << "\" file! "
+
+    // Baked file type.
+    const uint32_t BakedType = 0x4D494E41; // "ANIM"
 }
 
 AnimationList::Frame::Frame() :
     rectangle(0.0f, 0.0f, 1.0f, 1.0f),
     offset(0.0f, 0.0f),
-    duration(0.0f)
+    duration(0.0f),
+    endTime(0.0f)
 {
 }
 
 AnimationList::Animation::Animation() :
+    firstFrame(0),
+    frameCount(0),
     totalDuration(0.0f)
 {
 }
@@ -36,14 +46,36 @@ AnimationList::~AnimationList()
 void AnimationList::Cleanup()
 {
     // Reset texture reference.
-    m_texture = nullptr;
+    m_texture = TextureHandle();
 
     // Clear the list of animations.
+    Utility::ClearContainer(m_frames);
     Utility::ClearContainer(m_animations);
+    Utility::ClearContainer(m_names);
+
+    // Release the frame table.
+    m_frameTable = nullptr;
+
+    // Reset decoded state.
+    m_spriteSheetName.clear();
+    m_spriteSheetFuture = SpriteSheetFuture();
+    Utility::ClearContainer(m_frameSprites);
 }
 
 bool AnimationList::Load(std::string filename)
 {
+    // Decode and upload the animation list on the calling thread.
+    if(!this->Decode(filename))
+        return false;
+
+    return this->Upload(filename);
+}
+
+bool AnimationList::Decode(std::string filename)
+{
+    // Measure the decoding time.
+    auto startTime = std::chrono::high_resolution_clock::now();
+
     // Restore instance to it's original state.
     this->Cleanup();
 
@@ -62,17 +94,66 @@ bool AnimationList::Load(std::string filename)
         return false;
     }
 
-    // Load sprite sheet file.
-    Lua::State lua;
+    // Open animation list files.
+    System::FileView sourceFile;
+    System::FileView bakedFile;
+
+    bool hasSource = this->OpenFile(filename, sourceFile);
+    bool hasBaked = this->OpenFile(System::BakedFile::GetBakedName(filename), bakedFile);
+
+    // Read the baked animation list, unless it's stale.
+    bool decoded = false;
+
+    if(hasBaked)
+    {
+        uint64_t sourceHash = System::BakedFile::Hash(sourceFile.GetData(), sourceFile.GetSize());
+        decoded = this->DecodeBaked(filename, bakedFile, hasSource ? &sourceHash : nullptr);
+
+        if(!decoded)
+        {
+            this->Cleanup();
+        }
+    }
+
+    // Read the animation list source.
+    if(!decoded)
+    {
+        if(!hasSource)
+        {
+            Log() << LogLoadError(filename) << "Couldn't open the file.";
+            return false;
+        }
+
+        if(!this->DecodeSource(filename, sourceFile))
+            return false;
+    }
+
+    // Request the sprite sheet.
+    m_spriteSheetFuture = resourceManager->LoadAsync<SpriteSheet>(m_spriteSheetName);
+
+    // Print the decoding time.
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
 
-    if(!lua.Load(filename))
+    Log() << "Decoded an animation list from \"" << filename << "\" file in " << duration.count() << " ms" << (decoded ? " (baked)." : ".");
+
+    return success = true;
+}
+
+bool AnimationList::DecodeSource(std::string filename, const System::FileView& file)
+{
+    // Load animation list file.
+    Lua::Loader& lua = Lua::Loader::GetThreadLoader();
+
+    SCOPE_GUARD(lua.Reset());
+
+    if(!lua.Run(filename, file.GetData(), file.GetSize()))
     {
         Log() << LogLoadError(filename) << "Couldn't load the file.";
         return false;
     }
 
     // Get the global table.
-    lua_getglobal(lua, "AnimationList");
+    lua_getfield(lua, -1, "AnimationList");
 
     if(!lua_istable(lua, -1))
     {
@@ -80,7 +161,7 @@ bool AnimationList::Load(std::string filename)
         return false;
     }
 
-    // Load the sprite sheet.
+    // Read the sprite sheet.
     lua_getfield(lua, -1, "SpriteSheet");
 
     if(!lua_isstring(lua, -1))
@@ -89,13 +170,10 @@ bool AnimationList::Load(std::string filename)
         return false;
     }
 
-    auto spriteSheet = resourceManager->Load<SpriteSheet>(lua_tostring(lua, -1));
+    m_spriteSheetName = lua_tostring(lua, -1);
 
     lua_pop(lua, 1);
 
-    // Save sprite sheet texture.
-    m_texture = spriteSheet->GetTexture();
-
     // Read the animation table.
     lua_getfield(lua, -1, "Animations");
 
@@ -124,6 +202,7 @@ bool AnimationList::Load(std::string filename)
 
         // Read animation frames.
         std::vector<Frame> frames;
+        std::vector<std::string> sprites;
 
         for(lua_pushnil(lua); lua_next(lua, -2); lua_pop(lua, 1))
         {
@@ -145,7 +224,7 @@ bool AnimationList::Load(std::string filename)
                 return false;
             }
 
-            frame.rectangle = spriteSheet->GetSprite(lua_tostring(lua, -1));
+            sprites.push_back(lua_tostring(lua, -1));
 
             lua_pop(lua, 1);
 
@@ -185,74 +264,354 @@ bool AnimationList::Load(std::string filename)
         }
 
         // Add animation.
-        if(!this->AddAnimation(lua_tostring(lua, -2), frames))
+        if(this->AddAnimation(lua_tostring(lua, -2), frames) == InvalidId)
         {
             Log() << LogLoadError(filename) << "Couldn't add an animation.";
             return false;
         }
+
+        // Keep sprite names until the sprite sheet is loaded.
+        m_frameSprites.insert(m_frameSprites.end(), sprites.begin(), sprites.end());
     }
 
     lua_pop(lua, 1);
 
+    return true;
+}
+
+bool AnimationList::DecodeBaked(std::string filename, const System::FileView& file, const uint64_t* sourceHash)
+{
+    System::BakedReader reader;
+
+    if(!reader.Open(filename, file.GetData(), file.GetSize(), BakedType, sourceHash))
+        return false;
+
+    // Read the sprite sheet.
+    if(reader.GetDependencies().size() != 1)
+    {
+        Log() << LogLoadError(filename) << "Baked file has invalid dependencies.";
+        return false;
+    }
+
+    m_spriteSheetName = reader.GetDependencies()[0];
+
+    // Read the sprite name table.
+    uint32_t spriteCount = 0;
+    reader.Read(spriteCount);
+
+    std::vector<std::string> sprites;
+
+    for(uint32_t i = 0; i < spriteCount && reader.IsValid(); ++i)
+    {
+        sprites.emplace_back();
+        reader.Read(sprites.back());
+    }
+
+    // Read animation names and their frame counts.
+    uint32_t animationCount = 0;
+    reader.Read(animationCount);
+
+    std::vector<std::pair<std::string, uint32_t>> animations;
+
+    for(uint32_t i = 0; i < animationCount && reader.IsValid(); ++i)
+    {
+        animations.emplace_back();
+        reader.Read(animations.back().first);
+        reader.Read(animations.back().second);
+    }
+
+    // Read the frame array.
+    for(std::size_t i = 0; i < animations.size() && reader.IsValid(); ++i)
+    {
+        std::vector<Frame> frames;
+
+        for(uint32_t j = 0; j < animations[i].second && reader.IsValid(); ++j)
+        {
+            Frame frame;
+
+            uint32_t sprite = 0;
+            reader.Read(sprite);
+            reader.Read(frame.offset);
+            reader.Read(frame.duration);
+
+            if(!reader.IsValid())
+                break;
+
+            if(sprite >= sprites.size())
+            {
+                Log() << LogLoadError(filename) << "Baked file has an invalid frame sprite.";
+                return false;
+            }
+
+            frames.push_back(frame);
+            m_frameSprites.push_back(sprites[sprite]);
+        }
+
+        if(!reader.IsValid())
+            break;
+
+        if(this->AddAnimation(animations[i].first, frames) == InvalidId)
+        {
+            Log() << LogLoadError(filename) << "Couldn't add an animation.";
+            return false;
+        }
+    }
+
+    if(!reader.IsValid())
+    {
+        Log() << LogLoadError(filename) << "Baked file is truncated.";
+        return false;
+    }
+
+    return true;
+}
+
+bool AnimationList::Bake(std::string path, uint64_t sourceHash) const
+{
+    System::BakedWriter writer(BakedType);
+
+    // Write the sprite sheet.
+    writer.AddDependency(m_spriteSheetName);
+
+    // Write the sprite name table.
+    // Frames refer to sprites by their indices in this table.
+    std::vector<std::string> sprites;
+    std::map<std::string, uint32_t> spriteIndices;
+
+    for(const std::string& sprite : m_frameSprites)
+    {
+        auto result = spriteIndices.emplace(sprite, (uint32_t)sprites.size());
+
+        if(result.second)
+        {
+            sprites.push_back(sprite);
+        }
+    }
+
+    writer.Write((uint32_t)sprites.size());
+
+    for(const std::string& sprite : sprites)
+    {
+        writer.Write(sprite);
+    }
+
+    // Write animation names and their frame counts in id order.
+    std::vector<std::string> names(m_animations.size());
+
+    for(const auto& name : m_names)
+    {
+        names[name.second] = name.first;
+    }
+
+    writer.Write((uint32_t)m_animations.size());
+
+    for(std::size_t i = 0; i < m_animations.size(); ++i)
+    {
+        writer.Write(names[i]);
+        writer.Write((uint32_t)m_animations[i].frameCount);
+    }
+
+    // Write the frame array.
+    assert(m_frameSprites.size() == m_frames.size());
+
+    for(std::size_t i = 0; i < m_frames.size(); ++i)
+    {
+        writer.Write(spriteIndices[m_frameSprites[i]]);
+        writer.Write(m_frames[i].offset);
+        writer.Write(m_frames[i].duration);
+    }
+
+    return writer.Save(path, sourceHash);
+}
+
+bool AnimationList::Upload(std::string filename)
+{
+    if(!m_spriteSheetFuture.IsValid())
+    {
+        Log() << LogLoadError(filename) << "Animation list hasn't been decoded.";
+        return false;
+    }
+
+    // Setup the cleanup scope guard.
+    bool success = false;
+
+    SCOPE_GUARD_IF(!success,
+        this->Cleanup());
+
+    // Take the loaded sprite sheet.
+    auto spriteSheet = m_spriteSheetFuture.Get();
+    m_spriteSheetFuture = SpriteSheetFuture();
+
+    // Save sprite sheet texture.
+    m_texture = spriteSheet->GetTexture();
+
+    // Resolve frame sprites.
+    assert(m_frameSprites.size() == m_frames.size());
+
+    for(std::size_t i = 0; i < m_frames.size(); ++i)
+    {
+        m_frames[i].rectangle = spriteSheet->GetSprite(m_frameSprites[i]);
+    }
+
+    Utility::ClearContainer(m_frameSprites);
+
+    // Upload the frame table.
+    if(!this->BuildFrameTable())
+    {
+        Log() << LogLoadError(filename) << "Couldn't create a frame table.";
+        return false;
+    }
+
     // Success!
     Log() << "Loaded an animation list from \"" << filename << "\" file.";
 
     return success = true;
 }
 
-void AnimationList::SetTexture(TexturePtr texture)
+std::size_t AnimationList::GetCpuMemorySize() const
+{
+    std::size_t size = sizeof(AnimationList);
+    size += m_frames.capacity() * sizeof(Frame);
+    size += m_animations.capacity() * sizeof(Animation);
+
+    for(const auto& name : m_names)
+    {
+        size += sizeof(name) + name.first.capacity();
+    }
+
+    return size;
+}
+
+std::size_t AnimationList::GetGpuMemorySize() const
+{
+    if(m_frameTable == nullptr)
+        return 0;
+
+    return (std::size_t)m_frameTable->GetElementSize() * m_frameTable->GetElementCount();
+}
+
+void AnimationList::SetTexture(TextureHandle texture)
 {
     m_texture = texture;
 }
 
-const AnimationList::TexturePtr& AnimationList::GetTexture() const
+const AnimationList::TextureHandle& AnimationList::GetTexture() const
 {
     return m_texture;
 }
 
-bool AnimationList::AddAnimation(std::string name, const std::vector<Frame>& frames)
+AnimationList::AnimationId AnimationList::AddAnimation(std::string name, const std::vector<Frame>& frames)
 {
     if(name.empty())
-        return false;
+        return InvalidId;
 
     if(frames.empty())
-        return false;
+        return InvalidId;
 
-    // Add an animation entry.
-    auto result = m_animations.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(name),
-        std::forward_as_tuple()
-    );
+    // Add an animation name.
+    AnimationId id = (AnimationId)m_animations.size();
+
+    auto result = m_names.emplace(name, id);
 
     if(!result.second)
     {
         Log() << "Animation with \"" << name << "\" name already exists within this animation list!";
-        return false;
+        return InvalidId;
     }
 
-    auto& entry = result.first->second;
-    entry.frames = frames;
+    // Add an animation entry.
+    Animation animation;
+    animation.firstFrame = (int)m_frames.size();
+    animation.frameCount = (int)frames.size();
 
-    // Calculate animation duration.
-    for(auto& frame : frames)
+    // Append frames with their cumulative end times.
+    for(const auto& frame : frames)
     {
-        entry.totalDuration += frame.duration;
+        animation.totalDuration += frame.duration;
+
+        m_frames.push_back(frame);
+        m_frames.back().endTime = animation.totalDuration;
     }
 
-    return true;
+    m_animations.push_back(animation);
+
+    return id;
 }
 
-const AnimationList::Animation* AnimationList::GetAnimation(std::string name) const
+AnimationList::AnimationId AnimationList::GetAnimationId(const std::string& name) const
 {
-    if(name.empty())
-        return nullptr;
+    auto it = m_names.find(name);
+
+    if(it == m_names.end())
+        return InvalidId;
 
-    // Find animation by name,
-    auto it = m_animations.find(name);
+    return it->second;
+}
 
-    if(it == m_animations.end())
+const AnimationList::Animation* AnimationList::GetAnimation(AnimationId id) const
+{
+    if(id < 0 || id >= (AnimationId)m_animations.size())
         return nullptr;
 
-    return &it->second;
+    return &m_animations[id];
+}
+
+const AnimationList::Animation* AnimationList::GetAnimation(const std::string& name) const
+{
+    return this->GetAnimation(this->GetAnimationId(name));
+}
+
+const AnimationList::Frame& AnimationList::GetFrame(int index) const
+{
+    assert(index >= 0 && index < (int)m_frames.size());
+
+    return m_frames[index];
+}
+
+int AnimationList::FindFrame(const Animation& animation, float time) const
+{
+    assert(animation.frameCount > 0);
+
+    // Find the first frame that ends after the given time.
+    auto begin = m_frames.begin() + animation.firstFrame;
+    auto last = begin + (animation.frameCount - 1);
+
+    auto it = std::upper_bound(begin, last, time, [](float time, const Frame& frame)
+    {
+        return time < frame.endTime;
+    });
+
+    return (int)(it - m_frames.begin());
+}
+
+bool AnimationList::BuildFrameTable()
+{
+    if(m_frames.empty())
+        return false;
+
+    // Write frames of all animations.
+    std::vector<glm::vec4> frameData(m_frames.size() * 2);
+
+    for(std::size_t i = 0; i < m_frames.size(); ++i)
+    {
+        const Frame& frame = m_frames[i];
+
+        frameData[i * 2 + 0] = frame.rectangle;
+        frameData[i * 2 + 1] = glm::vec4(frame.offset, frame.endTime, 0.0f);
+    }
+
+    // Upload the frame table.
+    auto frameTable = std::make_shared<TextureBuffer>();
+
+    if(!frameTable->Initialize(GL_RGBA32F, sizeof(glm::vec4), frameData.size(), &frameData[0], GL_STATIC_DRAW))
+        return false;
+
+    m_frameTable = frameTable;
+
+    return true;
+}
+
+std::shared_ptr<const TextureBuffer> AnimationList::GetFrameTable() const
+{
+    return m_frameTable;
 }
@@ -1,17 +1,40 @@
 #pragma once
 
 #include "Precompiled.hpp"
-#include "System/Resource.hpp"
+#include "System/ResourceManager.hpp"
 
 // Forward declarations.
+namespace System
+{
+    class FileView;
+}
+
 namespace Graphics
 {
     class Texture;
+    class TextureBuffer;
+    class SpriteSheet;
 }
 
 //
 // Animation List
 //
+//  Animations are compiled into one flat array of frames with cumulative
+//  end times, and are referred to by integer ids. Names should only be
+//  resolved once, as playing an animation by its id does no string work.
+//
+//  Frames are also uploaded into a frame table, which lets shaders play
+//  looping animations without any work on the CPU. Every frame takes two
+//  texels: the rectangle, then the offset and the end time of the frame
+//  within its animation.
+//
+//  Animation lists are read from baked files written by the asset baker
+//  when they are up to date, and from Lua sources otherwise.
+//
+//  Resolving and playing an animation:
+//      auto id = animationList->GetAnimationId("moving_up");
+//      animation->Play(id, Game::Components::Animation::PlayFlags::Loop);
+//
 
 namespace Graphics
 {
@@ -27,20 +50,31 @@ namespace Graphics
             glm::vec4 rectangle;
             glm::vec2 offset;
             float duration;
+            float endTime;
         };
 
         // Animation entry.
+        //  Frames of an animation are a range of the frame array.
         struct Animation
         {
             Animation();
 
-            std::vector<Frame> frames;
+            int firstFrame;
+            int frameCount;
             float totalDuration;
         };
 
         // Type declarations.
-        typedef std::shared_ptr<const Texture>   TexturePtr;
-        typedef std::map<std::string, Animation> AnimationMap;
+        typedef int AnimationId;
+        typedef System::ResourceHandle<Texture>    TextureHandle;
+        typedef std::shared_ptr<TextureBuffer>     FrameTablePtr;
+        typedef std::vector<Frame>                 FrameList;
+        typedef std::vector<Animation>             AnimationArray;
+        typedef std::map<std::string, AnimationId> AnimationNameMap;
+        typedef System::ResourceFuture<SpriteSheet> SpriteSheetFuture;
+
+        // Constant variables.
+        static const AnimationId InvalidId = -1;
 
     public:
         AnimationList(System::ResourceManager* resourceManager);
@@ -52,23 +86,75 @@ namespace Graphics
         // Loads the animation list from a file.
         bool Load(std::string filename);
 
+        // Reads animations from a file and requests the sprite sheet.
+        bool Decode(std::string filename) override;
+
+        // Resolves frame sprites and uploads the frame table.
+        bool Upload(std::string filename) override;
+
+        // Gets the estimated size of animations.
+        std::size_t GetCpuMemorySize() const override;
+
+        // Gets the size of the frame table.
+        std::size_t GetGpuMemorySize() const override;
+
+        // Reads animations from a Lua source.
+        bool DecodeSource(std::string filename, const System::FileView& file);
+
+        // Reads animations from a baked file.
+        // Fails if the source hash doesn't match, unless it's null.
+        bool DecodeBaked(std::string filename, const System::FileView& file, const uint64_t* sourceHash = nullptr);
+
+        // Writes decoded animations into a baked file.
+        bool Bake(std::string path, uint64_t sourceHash) const;
+
         // Sets the texture.
-        void SetTexture(TexturePtr texture);
+        void SetTexture(TextureHandle texture);
 
         // Gets the texture.
-        const TexturePtr& GetTexture() const;
+        const TextureHandle& GetTexture() const;
 
         // Adds an animation.
-        bool AddAnimation(std::string name, const std::vector<Frame>& frames);
+        // Returns an invalid id on failure.
+        AnimationId AddAnimation(std::string name, const std::vector<Frame>& frames);
+
+        // Resolves an animation name into its id.
+        // Returns an invalid id if there is no such animation.
+        AnimationId GetAnimationId(const std::string& name) const;
 
         // Gets an animation.
-        const Animation* GetAnimation(std::string name) const;
+        const Animation* GetAnimation(AnimationId id) const;
+        const Animation* GetAnimation(const std::string& name) const;
+
+        // Gets a frame from the frame array.
+        const Frame& GetFrame(int index) const;
+
+        // Finds the index of an animation frame shown at a given time.
+        // Time is clamped to the duration of the animation.
+        int FindFrame(const Animation& animation, float time) const;
+
+        // Uploads frames of all animations into the frame table.
+        // Has to be called again after adding animations.
+        bool BuildFrameTable();
+
+        // Gets the frame table.
+        std::shared_ptr<const TextureBuffer> GetFrameTable() const;
 
     private:
         // Sprite sheet texture.
-        TexturePtr m_texture;
+        TextureHandle m_texture;
+
+        // Compiled animations.
+        FrameList        m_frames;
+        AnimationArray   m_animations;
+        AnimationNameMap m_names;
+
+        // Frame table of all animations.
+        FrameTablePtr m_frameTable;
 
-        // List of animations.
-        AnimationMap m_animations;
+        // Sprite sheet being loaded and sprite names of frames.
+        std::string              m_spriteSheetName;
+        SpriteSheetFuture        m_spriteSheetFuture;
+        std::vector<std::string> m_frameSprites;
     };
 }
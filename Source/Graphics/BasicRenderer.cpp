@@ -2,6 +2,8 @@
 #include "BasicRenderer.hpp"
 #include "System/ResourceManager.hpp"
 #include "Graphics/Texture.hpp"
+#include "Graphics/CommandList.hpp"
+#include "Graphics/SpriteBuffer.hpp"
 using namespace Graphics;
 
 namespace
@@ -15,10 +17,14 @@ namespace
         glm::vec2 position;
         glm::vec2 texture;
     };
+
+    // Location of the first instance attribute.
+    const int InstanceAttributeLocation = 2;
 }
 
 BasicRenderer::Sprite::Info::Info() :
     texture(nullptr),
+    frames(nullptr),
     transparent(false),
     filter(true)
 {
@@ -26,7 +32,7 @@ BasicRenderer::Sprite::Info::Info() :
 
 bool BasicRenderer::Sprite::Info::operator==(const Info& right) const
 {
-    return this->texture == right.texture && this->transparent == right.transparent && this->filter == right.filter;
+    return this->texture == right.texture && this->frames == right.frames && this->transparent == right.transparent && this->filter == right.filter;
 }
 
 bool BasicRenderer::Sprite::Info::operator!=(const Info& right) const
@@ -37,11 +43,36 @@ bool BasicRenderer::Sprite::Info::operator!=(const Info& right) const
 BasicRenderer::Sprite::Data::Data() :
     transform(1.0f),
     rectangle(0.0f, 0.0f, 1.0f, 1.0f),
-    color(1.0f, 1.0f, 1.0f, 1.0f)
+    color(1.0f, 1.0f, 1.0f, 1.0f),
+    animation(0.0f, 0.0f, 0.0f, 0.0f)
+{
+}
+
+BasicRenderer::LightGrid::LightGrid() :
+    ambient(1.0f, 1.0f, 1.0f),
+    bounds(0.0f, 0.0f, 0.0f, 0.0f),
+    tileCount(0, 0)
 {
 }
 
-BasicRenderer::BasicRenderer()
+bool BasicRenderer::CommandReference::operator<(const CommandReference& other) const
+{
+    if(key != other.key)
+        return key < other.key;
+
+    if(list != other.list)
+        return list < other.list;
+
+    return command < other.command;
+}
+
+BasicRenderer::BasicRenderer() :
+    m_previousFramebuffer(0),
+    m_lowResolution(false),
+    m_layerPreviousFramebuffer(0),
+    m_layerPreviousViewport(0, 0, 0, 0),
+    m_animationTime(0.0f),
+    m_initialized(false)
 {
 }
 
@@ -56,12 +87,49 @@ void BasicRenderer::Cleanup()
     // Cleanup graphics objects.
     m_vertexBuffer.Cleanup();
     m_instanceBuffer.Cleanup();
+    m_streamBuffer.Cleanup();
     m_vertexInput.Cleanup();
+    m_screenInput.Cleanup();
     m_nearestSampler.Cleanup();
     m_linearSampler.Cleanup();
 
     m_shader = nullptr;
 
+    // Cleanup weighted blending objects.
+    m_weightedFramebuffer.Cleanup();
+
+    m_weightedShader = nullptr;
+    m_resolveShader = nullptr;
+
+    // Cleanup low resolution objects.
+    Utility::ClearContainer(m_lowResolutionTargets);
+
+    m_upscaleShader = nullptr;
+    m_previousFramebuffer = 0;
+    m_lowResolution = false;
+
+    // Cleanup layer cache objects.
+    Utility::ClearContainer(m_layerCaches);
+
+    m_compositeShader = nullptr;
+    m_layerPreviousFramebuffer = 0;
+    m_layerPreviousViewport = glm::ivec4(0, 0, 0, 0);
+
+    // Cleanup lighting objects.
+    m_lightBuffer.Cleanup();
+    m_lightTileBuffer.Cleanup();
+    m_lightIndexBuffer.Cleanup();
+
+    m_lightingShader = nullptr;
+
+    // Reset animation time.
+    m_animationTime = 0.0f;
+
+    // Cleanup command execution lists.
+    Utility::ClearContainer(m_commandOrder);
+    Utility::ClearContainer(m_commandSpriteInfo);
+    Utility::ClearContainer(m_commandSpriteData);
+
     // Reset initialization state.
     m_initialized = false;
 }
@@ -119,6 +187,13 @@ bool BasicRenderer::Initialize(Context& context)
         return false;
     }
 
+    // Create a stream buffer.
+    if(!m_streamBuffer.Initialize(sizeof(Sprite::Data), StreamBatchSize, nullptr, GL_STREAM_DRAW))
+    {
+        Log() << LogInitializeError() << "Couldn't create a stream buffer.";
+        return false;
+    }
+
     // Create a vertex input.
     const VertexAttribute attributes[] =
     {
@@ -127,6 +202,7 @@ bool BasicRenderer::Initialize(Context& context)
         { &m_instanceBuffer, VertexAttributeTypes::Float4x4 }, // Transform
         { &m_instanceBuffer, VertexAttributeTypes::Float4   }, // Rectangle
         { &m_instanceBuffer, VertexAttributeTypes::Float4   }, // Color
+        { &m_instanceBuffer, VertexAttributeTypes::Float4   }, // Animation
     };
 
     if(!m_vertexInput.Initialize(Utility::ArraySize(attributes), &attributes[0]))
@@ -135,6 +211,19 @@ bool BasicRenderer::Initialize(Context& context)
         return false;
     }
 
+    // Create a screen vertex input.
+    const VertexAttribute screenAttributes[] =
+    {
+        { &m_vertexBuffer, VertexAttributeTypes::Float2 }, // Position
+        { &m_vertexBuffer, VertexAttributeTypes::Float2 }, // Texture
+    };
+
+    if(!m_screenInput.Initialize(Utility::ArraySize(screenAttributes), &screenAttributes[0]))
+    {
+        Log() << LogInitializeError() << "Couldn't create a screen vertex input.";
+        return false;
+    }
+
     // Create samplers.
     if(!m_nearestSampler.Initialize() || !m_linearSampler.Initialize())
     {
@@ -156,6 +245,52 @@ bool BasicRenderer::Initialize(Context& context)
         return false;
     }
 
+    // Load weighted blending shaders.
+    m_weightedShader = resourceManager->Load<Shader>("Data/Shaders/SpriteWeighted.glsl");
+    m_resolveShader = resourceManager->Load<Shader>("Data/Shaders/WeightedResolve.glsl");
+
+    if(m_weightedShader == nullptr || m_resolveShader == nullptr)
+    {
+        Log() << LogInitializeError() << "Couldn't load weighted blending shaders.";
+        return false;
+    }
+
+    // Load the upscale shader.
+    m_upscaleShader = resourceManager->Load<Shader>("Data/Shaders/Upscale.glsl");
+
+    if(m_upscaleShader == nullptr)
+    {
+        Log() << LogInitializeError() << "Couldn't load the upscale shader.";
+        return false;
+    }
+
+    // Load the layer composite shader.
+    m_compositeShader = resourceManager->Load<Shader>("Data/Shaders/LayerComposite.glsl");
+
+    if(m_compositeShader == nullptr)
+    {
+        Log() << LogInitializeError() << "Couldn't load the layer composite shader.";
+        return false;
+    }
+
+    // Create lighting buffers.
+    if(!m_lightBuffer.Initialize(GL_RGBA32F, sizeof(glm::vec4), MaxLights * 2, nullptr) ||
+       !m_lightTileBuffer.Initialize(GL_RG32UI, sizeof(glm::uvec2), MaxLightTiles, nullptr) ||
+       !m_lightIndexBuffer.Initialize(GL_R16UI, sizeof(uint16_t), MaxLightIndices, nullptr))
+    {
+        Log() << LogInitializeError() << "Couldn't create lighting buffers.";
+        return false;
+    }
+
+    // Load the lighting shader.
+    m_lightingShader = resourceManager->Load<Shader>("Data/Shaders/Lighting.glsl");
+
+    if(m_lightingShader == nullptr)
+    {
+        Log() << LogInitializeError() << "Couldn't load the lighting shader.";
+        return false;
+    }
+
     // Make sure we have a valid sprite batch size.
     static_assert(SpriteBatchSize >= 1, "Invalid sprite batch size.");
 
@@ -175,19 +310,37 @@ void BasicRenderer::Clear(uint32_t flags)
     if(flags & ClearFlags::Depth)   mask |= GL_DEPTH_BUFFER_BIT;
     if(flags & ClearFlags::Stencil) mask |= GL_STENCIL_BUFFER_BIT;
 
+    // Limit clearing to the viewport area.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+
     glClear(mask);
+
+    glDisable(GL_SCISSOR_TEST);
 }
 
 void BasicRenderer::DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDataList& spriteData, const glm::mat4& transform)
 {
-    if(!m_initialized)
-        return;
-
     // Make sure both lists have the same size.
     if(spriteInfo.size() != spriteData.size())
         return;
 
-    const int spriteCount = spriteInfo.size();
+    if(spriteInfo.empty())
+        return;
+
+    this->DrawSprites(&spriteInfo[0], &spriteData[0], spriteInfo.size(), transform);
+}
+
+void BasicRenderer::DrawSprites(const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform)
+{
+    if(!m_initialized)
+        return;
+
+    if(spriteCount <= 0)
+        return;
 
     // Bind the vertex input.
     glBindVertexArray(m_vertexInput.GetHandle());
@@ -206,6 +359,137 @@ void BasicRenderer::DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDa
     );
 
     glUniformMatrix4fv(m_shader->GetUniform("viewTransform"), 1, GL_FALSE, glm::value_ptr(transform));
+    glUniform1i(m_shader->GetUniform("frameTable"), 1);
+    glUniform1f(m_shader->GetUniform("animationTime"), m_animationTime);
+
+    // Render sprites.
+    this->DrawBatches(*m_shader, spriteInfo, spriteData, spriteCount, true);
+}
+
+void BasicRenderer::DrawSpritesWeighted(const SpriteInfoList& spriteInfo, const SpriteDataList& spriteData, const glm::mat4& transform)
+{
+    // Make sure both lists have the same size.
+    if(spriteInfo.size() != spriteData.size())
+        return;
+
+    if(spriteInfo.empty())
+        return;
+
+    this->DrawSpritesWeighted(&spriteInfo[0], &spriteData[0], spriteInfo.size(), transform);
+}
+
+void BasicRenderer::DrawSpritesWeighted(const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform)
+{
+    if(!m_initialized)
+        return;
+
+    if(spriteCount <= 0)
+        return;
+
+    // Get the current viewport size.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+
+    int viewportWidth = viewport[2];
+    int viewportHeight = viewport[3];
+
+    // Resize accumulation targets if needed.
+    if(m_weightedFramebuffer.GetWidth() != viewportWidth || m_weightedFramebuffer.GetHeight() != viewportHeight)
+    {
+        const GLenum formats[] =
+        {
+            GL_RGBA16F, // Accumulation (revealage in alpha)
+            GL_R16F,    // Weight
+        };
+
+        if(!m_weightedFramebuffer.Initialize(viewportWidth, viewportHeight, Utility::ArraySize(formats), &formats[0]))
+        {
+            // Fall back to unsorted regular blending.
+            this->DrawSprites(spriteInfo, spriteData, spriteCount, transform);
+            return;
+        }
+    }
+
+    // Bind the accumulation framebuffer.
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_weightedFramebuffer.GetHandle());
+    glViewport(0, 0, viewportWidth, viewportHeight);
+
+    SCOPE_GUARD
+    (
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    );
+
+    // Clear accumulation targets.
+    const GLfloat clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const GLfloat clearWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    glClearBufferfv(GL_COLOR, 0, &clearAccumulation[0]);
+    glClearBufferfv(GL_COLOR, 1, &clearWeight[0]);
+
+    // Enable accumulation blending.
+    // Color channels are summed, while alpha channel is multiplied by inversed alpha.
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    SCOPE_GUARD
+    (
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    );
+
+    // Accumulate sprites.
+    {
+        glBindVertexArray(m_vertexInput.GetHandle());
+        glUseProgram(m_weightedShader->GetHandle());
+
+        glUniformMatrix4fv(m_weightedShader->GetUniform("viewTransform"), 1, GL_FALSE, glm::value_ptr(transform));
+        glUniform1i(m_weightedShader->GetUniform("frameTable"), 1);
+        glUniform1f(m_weightedShader->GetUniform("animationTime"), m_animationTime);
+
+        this->DrawBatches(*m_weightedShader, spriteInfo, spriteData, spriteCount, false);
+    }
+
+    // Resolve accumulated sprites over the previous framebuffer.
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glBindVertexArray(m_screenInput.GetHandle());
+    glUseProgram(m_resolveShader->GetHandle());
+
+    glUniform1i(m_resolveShader->GetUniform("textureAccumulation"), 0);
+    glUniform1i(m_resolveShader->GetUniform("textureWeight"), 1);
+    glUniform2i(m_resolveShader->GetUniform("viewportOrigin"), viewport[0], viewport[1]);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_weightedFramebuffer.GetColorTexture(0));
+    glBindSampler(0, m_nearestSampler.GetHandle());
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_weightedFramebuffer.GetColorTexture(1));
+    glBindSampler(1, m_nearestSampler.GetHandle());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Restore state.
+    glBindSampler(1, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+}
+
+void BasicRenderer::DrawBatches(const Shader& shader, const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, bool blendingState)
+{
+    assert(spriteInfo != nullptr);
+    assert(spriteData != nullptr);
 
     // Current transparency state.
     bool currentTransparent = false;
@@ -231,7 +515,7 @@ void BasicRenderer::DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDa
         }
     );
 
-    glUniform1i(m_shader->GetUniform("textureDiffuse"), 0);
+    glUniform1i(shader.GetUniform("textureDiffuse"), 0);
 
     // Render sprites.
     int spritesDrawn = 0;
@@ -258,7 +542,13 @@ void BasicRenderer::DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDa
                 break;
 
             // Check if the next sprite can be batched.
-            if(info != spriteInfo[spriteNext])
+            // Transparency state is ignored if blending is managed by the caller.
+            const Sprite::Info& next = spriteInfo[spriteNext];
+
+            if(info.texture != next.texture || info.filter != next.filter)
+                break;
+
+            if(blendingState && info.transparent != next.transparent)
                 break;
 
             // Add sprite to batch.
@@ -268,72 +558,717 @@ void BasicRenderer::DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDa
         // Update the instance buffer with sprite data.
         m_instanceBuffer.Update(&spriteData[spritesDrawn], spritesBatched);
 
-        // Set transparency state.
-        if(currentTransparent != info.transparent)
+        // Set batch state.
+        this->SetBatchState(shader, info, blendingState, currentTransparent, currentTexture);
+
+        // Draw instanced sprite batch.
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, spritesBatched);
+
+        // Update the counter of drawn sprites.
+        spritesDrawn += spritesBatched;
+    }
+}
+
+void BasicRenderer::DrawSpriteBuffer(const SpriteBuffer& spriteBuffer, const glm::mat4& transform)
+{
+    if(!m_initialized)
+        return;
+
+    if(!spriteBuffer.IsValid())
+        return;
+
+    // Bind the vertex input.
+    // Instance attributes are pointed back at the streaming buffer afterwards.
+    glBindVertexArray(m_vertexInput.GetHandle());
+
+    SCOPE_GUARD
+    (
+        this->SetInstanceSource(m_instanceBuffer, 0);
+        glBindVertexArray(0);
+    );
+
+    // Bind shader program.
+    glUseProgram(m_shader->GetHandle());
+
+    SCOPE_GUARD
+    (
+        glUseProgram(0);
+    );
+
+    glUniformMatrix4fv(m_shader->GetUniform("viewTransform"), 1, GL_FALSE, glm::value_ptr(transform));
+    glUniform1i(m_shader->GetUniform("frameTable"), 1);
+    glUniform1f(m_shader->GetUniform("animationTime"), m_animationTime);
+    glUniform1i(m_shader->GetUniform("textureDiffuse"), 0);
+
+    // Current transparency state.
+    bool currentTransparent = false;
+
+    SCOPE_GUARD
+    (
+        if(currentTransparent)
         {
-            if(info.transparent)
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+        }
+    );
+
+    // Current texture state.
+    const Texture* currentTexture = nullptr;
+
+    SCOPE_GUARD
+    (
+        if(currentTexture != nullptr)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    );
+
+    // Render sprite batches.
+    for(const auto& batch : spriteBuffer.GetBatches())
+    {
+        // Point instance attributes at the first sprite of the batch.
+        this->SetInstanceSource(spriteBuffer.GetInstanceBuffer(), batch.first);
+
+        // Set batch state.
+        this->SetBatchState(*m_shader, batch.info, true, currentTransparent, currentTexture);
+
+        // Draw instanced sprite batch.
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch.count);
+    }
+}
+
+void BasicRenderer::DrawSpriteStream(const Sprite::Info& info, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform)
+{
+    if(!m_initialized)
+        return;
+
+    if(spriteData == nullptr || spriteCount <= 0)
+        return;
+
+    // Bind the vertex input with instance attributes read from the stream buffer.
+    glBindVertexArray(m_vertexInput.GetHandle());
+
+    this->SetInstanceSource(m_streamBuffer, 0);
+
+    SCOPE_GUARD
+    (
+        this->SetInstanceSource(m_instanceBuffer, 0);
+        glBindVertexArray(0);
+    );
+
+    // Bind shader program.
+    glUseProgram(m_shader->GetHandle());
+
+    SCOPE_GUARD
+    (
+        glUseProgram(0);
+    );
+
+    glUniformMatrix4fv(m_shader->GetUniform("viewTransform"), 1, GL_FALSE, glm::value_ptr(transform));
+    glUniform1i(m_shader->GetUniform("frameTable"), 1);
+    glUniform1f(m_shader->GetUniform("animationTime"), m_animationTime);
+    glUniform1i(m_shader->GetUniform("textureDiffuse"), 0);
+
+    // Set batch state.
+    bool currentTransparent = false;
+    const Texture* currentTexture = nullptr;
+
+    this->SetBatchState(*m_shader, info, true, currentTransparent, currentTexture);
+
+    SCOPE_GUARD
+    (
+        if(currentTransparent)
+        {
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+        }
+
+        if(currentTexture != nullptr)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    );
+
+    // Upload and draw sprites in batches.
+    int spritesDrawn = 0;
+
+    while(spritesDrawn != spriteCount)
+    {
+        int spritesBatched = std::min(spriteCount - spritesDrawn, StreamBatchSize);
+
+        // Orphan the buffer, so the upload doesn't wait for the previous batch.
+        m_streamBuffer.Orphan();
+        m_streamBuffer.Update(&spriteData[spritesDrawn], spritesBatched);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, spritesBatched);
+
+        spritesDrawn += spritesBatched;
+    }
+}
+
+void BasicRenderer::BeginLowResolution(int target, const glm::ivec2& size)
+{
+    if(!m_initialized)
+        return;
+
+    if(m_lowResolution)
+        return;
+
+    // Resize the target if needed.
+    Framebuffer& framebuffer = m_lowResolutionTargets[target];
+
+    if(framebuffer.GetWidth() != size.x || framebuffer.GetHeight() != size.y)
+    {
+        const GLenum formats[] =
+        {
+            GL_RGBA8, // Color
+        };
+
+        if(!framebuffer.Initialize(size.x, size.y, Utility::ArraySize(formats), &formats[0]))
+        {
+            // Keep rendering at full resolution.
+            m_lowResolutionTargets.erase(target);
+            return;
+        }
+    }
+
+    // Bind the target.
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.GetHandle());
+    glViewport(0, 0, size.x, size.y);
+
+    m_lowResolution = true;
+}
+
+void BasicRenderer::EndLowResolution(int target, const glm::ivec4& viewport, UpscaleModes::Type mode)
+{
+    if(!m_initialized)
+        return;
+
+    if(!m_lowResolution)
+        return;
+
+    m_lowResolution = false;
+
+    // Find the target.
+    auto it = m_lowResolutionTargets.find(target);
+    assert(it != m_lowResolutionTargets.end());
+
+    const Framebuffer& framebuffer = it->second;
+
+    // Bind the previous framebuffer.
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_previousFramebuffer);
+    glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+
+    // Draw the upscaled target.
+    glBindVertexArray(m_screenInput.GetHandle());
+    glUseProgram(m_upscaleShader->GetHandle());
+
+    glm::vec2 sourceSize((float)framebuffer.GetWidth(), (float)framebuffer.GetHeight());
+    glm::vec2 targetSize((float)viewport.z, (float)viewport.w);
+
+    glUniform1i(m_upscaleShader->GetUniform("textureSource"), 0);
+    glUniform2fv(m_upscaleShader->GetUniform("sourceSize"), 1, glm::value_ptr(sourceSize));
+    glUniform2fv(m_upscaleShader->GetUniform("targetSize"), 1, glm::value_ptr(targetSize));
+
+    // Sharp bilinear filtering relies on hardware interpolation at pixel edges.
+    const Sampler& sampler = mode == UpscaleModes::SharpBilinear ? m_linearSampler : m_nearestSampler;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, framebuffer.GetColorTexture(0));
+    glBindSampler(0, sampler.GetHandle());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Restore state.
+    glBindSampler(0, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+}
+
+bool BasicRenderer::BeginLayerCache(int cache, const glm::ivec2& size)
+{
+    if(!m_initialized)
+        return false;
+
+    // Resize the cache if needed.
+    Framebuffer& framebuffer = m_layerCaches[cache];
+
+    if(framebuffer.GetWidth() != size.x || framebuffer.GetHeight() != size.y)
+    {
+        const GLenum formats[] =
+        {
+            GL_RGBA8, // Premultiplied color
+        };
+
+        if(!framebuffer.Initialize(size.x, size.y, Utility::ArraySize(formats), &formats[0]))
+        {
+            m_layerCaches.erase(cache);
+            return false;
+        }
+    }
+
+    // Bind the cache.
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_layerPreviousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, glm::value_ptr(m_layerPreviousViewport));
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.GetHandle());
+    glViewport(0, 0, size.x, size.y);
+
+    // Clear the cache.
+    const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, &clearColor[0]);
+
+    return true;
+}
+
+void BasicRenderer::EndLayerCache()
+{
+    if(!m_initialized)
+        return;
+
+    // Restore the previous framebuffer.
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_layerPreviousFramebuffer);
+    glViewport(m_layerPreviousViewport.x, m_layerPreviousViewport.y, m_layerPreviousViewport.z, m_layerPreviousViewport.w);
+}
+
+void BasicRenderer::DrawLayerCache(int cache, const glm::mat4& transform)
+{
+    if(!m_initialized)
+        return;
+
+    // Find the cache.
+    auto it = m_layerCaches.find(cache);
+
+    if(it == m_layerCaches.end() || !it->second.IsValid())
+        return;
+
+    // Blend premultiplied cache contents.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    // Draw the cache quad.
+    glBindVertexArray(m_screenInput.GetHandle());
+    glUseProgram(m_compositeShader->GetHandle());
+
+    glUniformMatrix4fv(m_compositeShader->GetUniform("transform"), 1, GL_FALSE, glm::value_ptr(transform));
+    glUniform1i(m_compositeShader->GetUniform("textureLayer"), 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, it->second.GetColorTexture(0));
+    glBindSampler(0, m_nearestSampler.GetHandle());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Restore state.
+    glBindSampler(0, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
+
+void BasicRenderer::ApplyLighting(const LightGrid& grid, const Light* lights, int lightCount, const glm::uvec2* tiles, const uint16_t* indices, int indexCount)
+{
+    if(!m_initialized)
+        return;
+
+    int tileCount = grid.tileCount.x * grid.tileCount.y;
+
+    if(tileCount <= 0 || tileCount > MaxLightTiles)
+        return;
+
+    if(lightCount > MaxLights || indexCount > MaxLightIndices)
+        return;
+
+    // Upload light lists.
+    // Buffers are orphaned, as previous views may still be using them.
+    m_lightTileBuffer.Orphan();
+    m_lightTileBuffer.Update(tiles, tileCount);
+
+    if(lightCount > 0)
+    {
+        m_lightBuffer.Orphan();
+        m_lightBuffer.Update(lights, lightCount * 2);
+    }
+
+    if(indexCount > 0)
+    {
+        m_lightIndexBuffer.Orphan();
+        m_lightIndexBuffer.Update(indices, indexCount);
+    }
+
+    // Multiply the framebuffer by the light color.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_DST_COLOR, GL_ZERO);
+    glDepthMask(GL_FALSE);
+
+    // Draw the lighting quad.
+    glBindVertexArray(m_screenInput.GetHandle());
+    glUseProgram(m_lightingShader->GetHandle());
+
+    glUniform3fv(m_lightingShader->GetUniform("ambientColor"), 1, glm::value_ptr(grid.ambient));
+    glUniform4fv(m_lightingShader->GetUniform("gridBounds"), 1, glm::value_ptr(grid.bounds));
+    glUniform2iv(m_lightingShader->GetUniform("tileCount"), 1, glm::value_ptr(grid.tileCount));
+    glUniform1i(m_lightingShader->GetUniform("lightData"), 0);
+    glUniform1i(m_lightingShader->GetUniform("lightTiles"), 1);
+    glUniform1i(m_lightingShader->GetUniform("lightIndices"), 2);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, m_lightBuffer.GetTexture());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, m_lightTileBuffer.GetTexture());
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, m_lightIndexBuffer.GetTexture());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Restore state.
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
+
+void BasicRenderer::SetAnimationTime(float time)
+{
+    m_animationTime = time;
+}
+
+void BasicRenderer::Execute(const CommandList* commandLists, int listCount)
+{
+    if(!m_initialized)
+        return;
+
+    if(commandLists == nullptr || listCount <= 0)
+        return;
+
+    // Merge commands from all lists.
+    m_commandOrder.clear();
+
+    for(int list = 0; list < listCount; ++list)
+    {
+        const CommandList& commandList = commandLists[list];
+
+        for(int command = 0; command < commandList.GetCommandCount(); ++command)
+        {
+            CommandReference reference;
+            reference.key = commandList.GetCommand(command).key;
+            reference.list = list;
+            reference.command = command;
+
+            m_commandOrder.push_back(reference);
+        }
+    }
+
+    // Sort commands by their keys.
+    std::sort(m_commandOrder.begin(), m_commandOrder.end());
+
+    // Current execution state.
+    glm::mat4 transform(1.0f);
+    bool weighted = false;
+
+    // Layer cache state.
+    glm::mat4 layerTransform(1.0f);
+    bool layerCaching = false;
+    bool layerSkipping = false;
+
+    // Draws sprites gathered from consecutive commands.
+    auto FlushSprites = [&]()
+    {
+        if(m_commandSpriteInfo.empty())
+            return;
+
+        if(weighted)
+        {
+            this->DrawSpritesWeighted(m_commandSpriteInfo, m_commandSpriteData, transform);
+        }
+        else
+        {
+            this->DrawSprites(m_commandSpriteInfo, m_commandSpriteData, transform);
+        }
+
+        m_commandSpriteInfo.clear();
+        m_commandSpriteData.clear();
+    };
+
+    // Execute commands.
+    for(const auto& reference : m_commandOrder)
+    {
+        const CommandList& commandList = commandLists[reference.list];
+        const CommandList::Command& command = commandList.GetCommand(reference.command);
+
+        // Skip commands of a layer that is already cached.
+        if(layerSkipping && command.type != CommandTypes::EndLayerCache)
+            continue;
+
+        switch(command.type)
+        {
+        case CommandTypes::SetViewport:
             {
-                // Enable alpha blending.
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                FlushSprites();
 
-                // Disable depth writing.
-                glDepthMask(GL_FALSE);
+                const glm::ivec4& viewport = commandList.GetViewport(command.index);
+                glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
             }
-            else
+            break;
+
+        case CommandTypes::SetTransform:
             {
-                // Disable alpha blending.
-                glDisable(GL_BLEND);
+                FlushSprites();
 
-                // Enable depth writing.
-                glDepthMask(GL_TRUE);
+                transform = commandList.GetTransform(command.index);
             }
+            break;
 
-            currentTransparent = info.transparent;
-        }
+        case CommandTypes::Clear:
+            {
+                FlushSprites();
 
-        // Set texture state.
-        if(currentTexture != info.texture)
-        {
-            // Set texture uniform.
-            if(info.texture != nullptr)
+                const CommandList::ClearParameters& clear = commandList.GetClear(command.index);
+                this->SetClearColor(clear.color);
+                this->SetClearDepth(clear.depth);
+                this->Clear(clear.flags);
+            }
+            break;
+
+        case CommandTypes::DrawSprite:
             {
-                // Calculate inversed texture size.
-                glm::vec2 textureInvSize;
-                textureInvSize.x = 1.0f / info.texture->GetWidth();
-                textureInvSize.y = 1.0f / info.texture->GetHeight();
-
-                glUniform2fv(m_shader->GetUniform("textureSizeInv"), 1, glm::value_ptr(textureInvSize));
-
-                // Enable texture unit.
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, info.texture->GetHandle());
-                
-                if(info.filter)
+                m_commandSpriteInfo.push_back(commandList.GetSpriteInfo(command.index));
+                m_commandSpriteData.push_back(commandList.GetSpriteData(command.index));
+            }
+            break;
+
+        case CommandTypes::DrawSpriteBuffer:
+            {
+                FlushSprites();
+
+                this->DrawSpriteBuffer(*commandList.GetSpriteBuffer(command.index), transform);
+            }
+            break;
+
+        case CommandTypes::DrawSpriteStream:
+            {
+                FlushSprites();
+
+                const CommandList::StreamParameters& stream = commandList.GetStream(command.index);
+                this->DrawSpriteStream(stream.info, commandList.GetStreamData(stream.first), stream.count, transform);
+            }
+            break;
+
+        case CommandTypes::BeginWeighted:
+            {
+                FlushSprites();
+
+                weighted = true;
+            }
+            break;
+
+        case CommandTypes::EndWeighted:
+            {
+                FlushSprites();
+
+                weighted = false;
+            }
+            break;
+
+        case CommandTypes::BeginLowResolution:
+            {
+                FlushSprites();
+
+                const CommandList::LowResolutionParameters& lowResolution = commandList.GetLowResolution(command.index);
+                this->BeginLowResolution(lowResolution.target, lowResolution.size);
+            }
+            break;
+
+        case CommandTypes::EndLowResolution:
+            {
+                FlushSprites();
+
+                const CommandList::LowResolutionParameters& lowResolution = commandList.GetLowResolution(command.index);
+                this->EndLowResolution(lowResolution.target, lowResolution.viewport, lowResolution.mode);
+            }
+            break;
+
+        case CommandTypes::BeginLayerCache:
+            {
+                FlushSprites();
+
+                const CommandList::LayerCacheParameters& layer = commandList.GetLayerCache(command.index);
+
+                if(!layer.redraw)
                 {
-                    glBindSampler(0, m_linearSampler.GetHandle());
+                    layerSkipping = true;
                 }
                 else
+                if(this->BeginLayerCache(layer.cache, layer.size))
+                {
+                    // Render layer contents with the cache transform.
+                    layerTransform = transform;
+                    transform = layer.transform;
+                    layerCaching = true;
+                }
+            }
+            break;
+
+        case CommandTypes::EndLayerCache:
+            {
+                FlushSprites();
+
+                const CommandList::LayerCacheParameters& layer = commandList.GetLayerCache(command.index);
+
+                // Contents were drawn directly if the cache couldn't be created.
+                bool composite = layerCaching || layerSkipping;
+
+                if(layerCaching)
+                {
+                    this->EndLayerCache();
+                    transform = layerTransform;
+                }
+
+                layerCaching = false;
+                layerSkipping = false;
+
+                if(composite)
                 {
-                    glBindSampler(0, m_nearestSampler.GetHandle());
+                    this->DrawLayerCache(layer.cache, layer.composite);
                 }
             }
-            else
+            break;
+
+        case CommandTypes::ApplyLighting:
             {
-                // Disable texture unit.
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, 0);
+                FlushSprites();
+
+                const CommandList::LightingParameters& lighting = commandList.GetLighting(command.index);
+
+                this->ApplyLighting(lighting.grid,
+                    commandList.GetLightData(lighting.firstLight), lighting.lightCount,
+                    commandList.GetLightTileData(lighting.firstTile),
+                    commandList.GetLightIndexData(lighting.firstIndex), lighting.indexCount);
             }
+            break;
+        }
+    }
+
+    FlushSprites();
+}
 
-            currentTexture = info.texture;
+void BasicRenderer::SetBatchState(const Shader& shader, const Sprite::Info& info, bool blendingState, bool& currentTransparent, const Texture*& currentTexture)
+{
+    // Set transparency state.
+    if(blendingState && currentTransparent != info.transparent)
+    {
+        if(info.transparent)
+        {
+            // Enable alpha blending.
+            // Alpha is accumulated separately, so offscreen targets end up premultiplied.
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+            // Disable depth writing.
+            glDepthMask(GL_FALSE);
         }
+        else
+        {
+            // Disable alpha blending.
+            glDisable(GL_BLEND);
 
-        // Draw instanced sprite batch.
-        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, spritesBatched);
+            // Enable depth writing.
+            glDepthMask(GL_TRUE);
+        }
 
-        // Update the counter of drawn sprites.
-        spritesDrawn += spritesBatched;
+        currentTransparent = info.transparent;
     }
+
+    // Set texture state.
+    if(currentTexture != info.texture)
+    {
+        // Set texture uniform.
+        if(info.texture != nullptr)
+        {
+            // Calculate inversed texture size.
+            glm::vec2 textureInvSize;
+            textureInvSize.x = 1.0f / info.texture->GetWidth();
+            textureInvSize.y = 1.0f / info.texture->GetHeight();
+
+            glUniform2fv(shader.GetUniform("textureSizeInv"), 1, glm::value_ptr(textureInvSize));
+
+            // Enable texture unit.
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, info.texture->GetHandle());
+        }
+        else
+        {
+            // Disable texture unit.
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        currentTexture = info.texture;
+    }
+
+    // Set frame table state.
+    // Frame tables are only sampled by sprites that have an animation.
+    if(info.frames != nullptr)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, info.frames->GetTexture());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Set sampler state.
+    if(info.filter)
+    {
+        glBindSampler(0, m_linearSampler.GetHandle());
+    }
+    else
+    {
+        glBindSampler(0, m_nearestSampler.GetHandle());
+    }
+}
+
+void BasicRenderer::SetInstanceSource(const Buffer& buffer, int firstInstance)
+{
+    // Calculate the offset of the first instance.
+    const GLsizei stride = sizeof(Sprite::Data);
+    const std::size_t offset = stride * firstInstance;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.GetHandle());
+
+    // Transform matrix takes four attribute locations.
+    for(int i = 0; i < 4; ++i)
+    {
+        std::size_t column = offset + offsetof(Sprite::Data, transform) + sizeof(glm::vec4) * i;
+        glVertexAttribPointer(InstanceAttributeLocation + i, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)column);
+    }
+
+    std::size_t rectangle = offset + offsetof(Sprite::Data, rectangle);
+    glVertexAttribPointer(InstanceAttributeLocation + 4, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)rectangle);
+
+    std::size_t color = offset + offsetof(Sprite::Data, color);
+    glVertexAttribPointer(InstanceAttributeLocation + 5, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)color);
+
+    std::size_t animation = offset + offsetof(Sprite::Data, animation);
+    glVertexAttribPointer(InstanceAttributeLocation + 6, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)animation);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void BasicRenderer::SetClearColor(const glm::vec4& color)
@@ -5,6 +5,7 @@
 #include "VertexInput.hpp"
 #include "Sampler.hpp"
 #include "Shader.hpp"
+#include "Framebuffer.hpp"
 
 //
 // Basic Renderer
@@ -14,6 +15,8 @@ namespace Graphics
 {
     // Forward declarations.
     class Texture;
+    class CommandList;
+    class SpriteBuffer;
 
     // Clear flags.
     struct ClearFlags
@@ -27,6 +30,19 @@ namespace Graphics
         };
     };
 
+    // Upscale modes.
+    struct UpscaleModes
+    {
+        enum Type
+        {
+            // Scales by the largest whole factor that fits, leaving borders.
+            Integer,
+
+            // Scales to fill the viewport, interpolating only at pixel edges.
+            SharpBilinear,
+        };
+    };
+
     // Basic renderer class.
     class BasicRenderer
     {
@@ -42,6 +58,7 @@ namespace Graphics
                 bool operator!=(const Info& right) const;
 
                 const Texture* texture;
+                const TextureBuffer* frames;
                 bool transparent;
                 bool filter;
             } info;
@@ -53,9 +70,34 @@ namespace Graphics
                 glm::mat4 transform;
                 glm::vec4 rectangle;
                 glm::vec4 color;
+
+                // Looping animation played from the frame table:
+                // first frame, frame count, start time and speed.
+                // Frame count of zero uses the rectangle instead.
+                glm::vec4 animation;
             } data;
         };
 
+        // Point light structure.
+        struct Light
+        {
+            glm::vec4 position; // Position (xy) and radius (z).
+            glm::vec4 color;    // Color (rgb) and intensity (a).
+        };
+
+        // Light grid structure.
+        //  Grid of tiles stretched over the current viewport. Each tile
+        //  references a range of light indices (first, count) of lights
+        //  that touch it, so pixels are shaded only with those lights.
+        struct LightGrid
+        {
+            LightGrid();
+
+            glm::vec3  ambient;
+            glm::vec4  bounds;
+            glm::ivec2 tileCount;
+        };
+
         // Type declarations.
         typedef std::shared_ptr<const Shader> ShaderPtr;
         typedef std::vector<Sprite::Info> SpriteInfoList;
@@ -63,6 +105,10 @@ namespace Graphics
 
         // Constant variables.
         static const int SpriteBatchSize = 128;
+        static const int StreamBatchSize = 16384;
+        static const int MaxLights = 1024;
+        static const int MaxLightTiles = 16384;
+        static const int MaxLightIndices = 65536;
 
     public:
         BasicRenderer();
@@ -75,10 +121,55 @@ namespace Graphics
         bool Initialize(Context& context);
 
         // Clears the frame buffer.
+        // Only the area of the current viewport is cleared.
         void Clear(uint32_t flags);
 
         // Draws sprites.
         void DrawSprites(const SpriteInfoList& spriteInfo, const SpriteDataList& spriteData, const glm::mat4& transform);
+        void DrawSprites(const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform);
+
+        // Draws transparent sprites with weighted blended order independent transparency.
+        // Sprites do not have to be sorted, only grouping by texture matters for batching.
+        // Result is composited over the currently bound framebuffer.
+        void DrawSpritesWeighted(const SpriteInfoList& spriteInfo, const SpriteDataList& spriteData, const glm::mat4& transform);
+        void DrawSpritesWeighted(const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform);
+
+        // Draws sprites resident in a sprite buffer.
+        void DrawSpriteBuffer(const SpriteBuffer& spriteBuffer, const glm::mat4& transform);
+
+        // Draws a large number of sprites sharing the same info.
+        // Sprites are uploaded in big batches through a separate streaming buffer.
+        void DrawSpriteStream(const Sprite::Info& info, const Sprite::Data* spriteData, int spriteCount, const glm::mat4& transform);
+
+        // Begins rendering into a low resolution target.
+        // Binds the target and sets the viewport to its size.
+        void BeginLowResolution(int target, const glm::ivec2& size);
+
+        // Ends rendering into a low resolution target.
+        // Target is upscaled into a viewport rectangle of the previous framebuffer.
+        void EndLowResolution(int target, const glm::ivec4& viewport, UpscaleModes::Type mode);
+
+        // Begins rendering into a layer cache.
+        // Cache is resized if needed and cleared to transparent black.
+        bool BeginLayerCache(int cache, const glm::ivec2& size);
+
+        // Ends rendering into a layer cache.
+        void EndLayerCache();
+
+        // Draws a layer cache as a single quad.
+        // Transform places a unit quad in the clip space.
+        void DrawLayerCache(int cache, const glm::mat4& transform);
+
+        // Modulates the current viewport by the light of a light grid.
+        // Light grid bounds are in world units and match the viewport area.
+        void ApplyLighting(const LightGrid& grid, const Light* lights, int lightCount, const glm::uvec2* tiles, const uint16_t* indices, int indexCount);
+
+        // Sets the time of animations played from frame tables.
+        void SetAnimationTime(float time);
+
+        // Executes commands recorded in a number of command lists.
+        // Commands from all lists are merged and executed in the order of their sort keys.
+        void Execute(const CommandList* commandLists, int listCount);
 
         // Sets the clear color.
         void SetClearColor(const glm::vec4& color);
@@ -89,15 +180,72 @@ namespace Graphics
         // Sets the stencil depth.
         void SetClearStencil(int stencil);
 
+    private:
+        // Reference to a recorded command.
+        struct CommandReference
+        {
+            uint64_t key;
+            int      list;
+            int      command;
+
+            bool operator<(const CommandReference& other) const;
+        };
+
+        typedef std::vector<CommandReference> CommandReferenceList;
+        typedef std::map<int, Framebuffer> FramebufferList;
+
+    private:
+        // Draws batches of sprites with the currently bound shader.
+        void DrawBatches(const Shader& shader, const Sprite::Info* spriteInfo, const Sprite::Data* spriteData, int spriteCount, bool blendingState);
+
+        // Sets transparency and texture state for a batch of sprites.
+        void SetBatchState(const Shader& shader, const Sprite::Info& info, bool blendingState, bool& currentTransparent, const Texture*& currentTexture);
+
+        // Points instance attributes of the bound vertex input at a buffer.
+        void SetInstanceSource(const Buffer& buffer, int firstInstance);
+
     private:
         // Graphics objects.
-        VertexBuffer   m_vertexBuffer;
-        InstanceBuffer m_instanceBuffer;
-        VertexInput    m_vertexInput;
-        Sampler        m_nearestSampler;
-        Sampler        m_linearSampler;
-        ShaderPtr      m_shader;
-        
+        VertexBuffer    m_vertexBuffer;
+        InstanceBuffer  m_instanceBuffer;
+        InstanceBuffer  m_streamBuffer;
+        VertexInput     m_vertexInput;
+        VertexInput     m_screenInput;
+        Sampler         m_nearestSampler;
+        Sampler         m_linearSampler;
+        ShaderPtr       m_shader;
+
+        // Weighted blending objects.
+        Framebuffer     m_weightedFramebuffer;
+        ShaderPtr       m_weightedShader;
+        ShaderPtr       m_resolveShader;
+
+        // Low resolution objects.
+        FramebufferList m_lowResolutionTargets;
+        ShaderPtr       m_upscaleShader;
+        GLint           m_previousFramebuffer;
+        bool            m_lowResolution;
+
+        // Layer cache objects.
+        FramebufferList m_layerCaches;
+        ShaderPtr       m_compositeShader;
+        GLint           m_layerPreviousFramebuffer;
+        glm::ivec4      m_layerPreviousViewport;
+
+        // Lighting objects.
+        TextureBuffer   m_lightBuffer;
+        TextureBuffer   m_lightTileBuffer;
+        TextureBuffer   m_lightIndexBuffer;
+        ShaderPtr       m_lightingShader;
+
+        // Animation time.
+        float m_animationTime;
+
+        // Command execution lists.
+        CommandReferenceList m_commandOrder;
+        SpriteInfoList       m_commandSpriteInfo;
+        SpriteDataList       m_commandSpriteData;
+
         // Initialization state.
         bool m_initialized;
     };
@@ -17,6 +17,7 @@ Buffer::Buffer(GLenum type) :
     m_handle(InvalidHandle),
     m_elementSize(0),
     m_elementCount(0),
+    m_usage(GL_STATIC_DRAW),
     m_initialized(false)
 {
 }
@@ -39,6 +40,7 @@ void Buffer::Cleanup()
     // Reset buffer parameters.
     m_elementSize = 0;
     m_elementCount = 0;
+    m_usage = GL_STATIC_DRAW;
 
     // Reset initialization state.
     m_initialized = false;
@@ -71,6 +73,7 @@ bool Buffer::Initialize(unsigned int elementSize, unsigned int elementCount, con
 
     m_elementSize = elementSize;
     m_elementCount = elementCount;
+    m_usage = usage;
 
     // Create a buffer.
     glGenBuffers(1, &m_handle);
@@ -118,6 +121,17 @@ void Buffer::Update(const void* data, int count)
     glBindBuffer(m_type, 0);
 }
 
+void Buffer::Orphan()
+{
+    if(!m_initialized)
+        return;
+
+    // Allocate new buffer storage.
+    glBindBuffer(m_type, m_handle);
+    glBufferData(m_type, m_elementSize * m_elementCount, nullptr, m_usage);
+    glBindBuffer(m_type, 0);
+}
+
 GLenum IndexBuffer::GetElementType() const
 {
     if(!m_initialized)
@@ -135,3 +149,63 @@ GLenum IndexBuffer::GetElementType() const
 
     return InvalidEnum;
 }
+
+TextureBuffer::TextureBuffer() :
+    Buffer(GL_TEXTURE_BUFFER),
+    m_texture(InvalidHandle)
+{
+}
+
+TextureBuffer::~TextureBuffer()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void TextureBuffer::Cleanup()
+{
+    // Release the texture handle.
+    if(m_texture != InvalidHandle)
+    {
+        glDeleteTextures(1, &m_texture);
+        m_texture = InvalidHandle;
+    }
+
+    // Cleanup the buffer.
+    Buffer::Cleanup();
+}
+
+bool TextureBuffer::Initialize(GLenum format, unsigned int elementSize, unsigned int elementCount, const void* data, GLenum usage)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Create the buffer.
+    if(!Buffer::Initialize(elementSize, elementCount, data, usage))
+        return false;
+
+    m_initialized = false;
+
+    // Create a buffer texture.
+    glGenTextures(1, &m_texture);
+
+    if(m_texture == InvalidHandle)
+    {
+        Log() << LogInitializeError() << "Couldn't create a buffer texture.";
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, m_handle);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // Success!
+    return m_initialized = true;
+}
@@ -47,6 +47,10 @@ namespace Graphics
         // Updates buffer data.
         void Update(const void* data, int count = -1);
 
+        // Discards buffer data storage.
+        // Allows the buffer to be updated again without waiting for pending draws.
+        void Orphan();
+
         // Checks if buffer is valid.
         bool IsValid() const
         {
@@ -102,6 +106,7 @@ namespace Graphics
         // Buffer parameters.
         unsigned int m_elementSize;
         unsigned int m_elementCount;
+        GLenum       m_usage;
 
         // Initialization state.
         bool m_initialized;
@@ -177,3 +182,41 @@ namespace Graphics
         }
     };
 }
+
+//
+// Texture Buffer
+//
+//  Buffer that can be sampled in shaders through a buffer texture.
+//  Element format is specified as an internal texture format.
+//
+
+namespace Graphics
+{
+    class TextureBuffer : public Buffer
+    {
+    public:
+        TextureBuffer();
+        ~TextureBuffer();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the texture buffer instance.
+        bool Initialize(GLenum format, unsigned int elementSize, unsigned int elementCount, const void* data, GLenum usage = GL_STREAM_DRAW);
+
+        // Gets the buffer texture handle.
+        GLuint GetTexture() const
+        {
+            return m_texture;
+        }
+
+        const char* GetName() const override
+        {
+            return "a texture buffer";
+        }
+
+    private:
+        // Buffer texture handle.
+        GLuint m_texture;
+    };
+}
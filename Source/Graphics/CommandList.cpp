@@ -0,0 +1,184 @@
+#include "Precompiled.hpp"
+#include "CommandList.hpp"
+using namespace Graphics;
+
+CommandList::CommandList()
+{
+}
+
+CommandList::~CommandList()
+{
+}
+
+void CommandList::Cleanup()
+{
+    // Release all memory.
+    Utility::ClearContainer(m_commands);
+    Utility::ClearContainer(m_viewports);
+    Utility::ClearContainer(m_transforms);
+    Utility::ClearContainer(m_clears);
+    Utility::ClearContainer(m_spriteInfo);
+    Utility::ClearContainer(m_spriteData);
+    Utility::ClearContainer(m_spriteBuffers);
+    Utility::ClearContainer(m_streams);
+    Utility::ClearContainer(m_streamData);
+    Utility::ClearContainer(m_lowResolutions);
+    Utility::ClearContainer(m_layerCaches);
+    Utility::ClearContainer(m_lightings);
+    Utility::ClearContainer(m_lights);
+    Utility::ClearContainer(m_lightTiles);
+    Utility::ClearContainer(m_lightIndices);
+}
+
+void CommandList::Reset()
+{
+    // Clear lists without releasing memory.
+    m_commands.clear();
+    m_viewports.clear();
+    m_transforms.clear();
+    m_clears.clear();
+    m_spriteInfo.clear();
+    m_spriteData.clear();
+    m_spriteBuffers.clear();
+    m_streams.clear();
+    m_streamData.clear();
+    m_lowResolutions.clear();
+    m_layerCaches.clear();
+    m_lightings.clear();
+    m_lights.clear();
+    m_lightTiles.clear();
+    m_lightIndices.clear();
+}
+
+void CommandList::Reserve(int spriteCount)
+{
+    if(spriteCount <= 0)
+        return;
+
+    m_commands.reserve(spriteCount);
+    m_spriteInfo.reserve(spriteCount);
+    m_spriteData.reserve(spriteCount);
+}
+
+void CommandList::SetViewport(SortKey key, const glm::ivec4& viewport)
+{
+    this->AddCommand(key, CommandTypes::SetViewport, m_viewports.size());
+    m_viewports.push_back(viewport);
+}
+
+void CommandList::SetTransform(SortKey key, const glm::mat4& transform)
+{
+    this->AddCommand(key, CommandTypes::SetTransform, m_transforms.size());
+    m_transforms.push_back(transform);
+}
+
+void CommandList::Clear(SortKey key, uint32_t flags, const glm::vec4& color, float depth)
+{
+    ClearParameters parameters;
+    parameters.flags = flags;
+    parameters.color = color;
+    parameters.depth = depth;
+
+    this->AddCommand(key, CommandTypes::Clear, m_clears.size());
+    m_clears.push_back(parameters);
+}
+
+void CommandList::DrawSprite(SortKey key, const BasicRenderer::Sprite::Info& info, const BasicRenderer::Sprite::Data& data)
+{
+    assert(m_spriteInfo.size() == m_spriteData.size());
+
+    this->AddCommand(key, CommandTypes::DrawSprite, m_spriteInfo.size());
+    m_spriteInfo.push_back(info);
+    m_spriteData.push_back(data);
+}
+
+void CommandList::DrawSpriteBuffer(SortKey key, const SpriteBuffer* spriteBuffer)
+{
+    assert(spriteBuffer != nullptr);
+
+    this->AddCommand(key, CommandTypes::DrawSpriteBuffer, m_spriteBuffers.size());
+    m_spriteBuffers.push_back(spriteBuffer);
+}
+
+BasicRenderer::Sprite::Data* CommandList::DrawSpriteStream(SortKey key, const BasicRenderer::Sprite::Info& info, int count)
+{
+    if(count <= 0)
+        return nullptr;
+
+    StreamParameters parameters;
+    parameters.info = info;
+    parameters.first = (uint32_t)m_streamData.size();
+    parameters.count = (uint32_t)count;
+
+    this->AddCommand(key, CommandTypes::DrawSpriteStream, m_streams.size());
+    m_streams.push_back(parameters);
+
+    // Allocate sprite data.
+    m_streamData.resize(m_streamData.size() + count);
+
+    return &m_streamData[parameters.first];
+}
+
+void CommandList::BeginWeighted(SortKey key)
+{
+    this->AddCommand(key, CommandTypes::BeginWeighted, 0);
+}
+
+void CommandList::EndWeighted(SortKey key)
+{
+    this->AddCommand(key, CommandTypes::EndWeighted, 0);
+}
+
+void CommandList::RenderLowResolution(SortKey beginKey, SortKey endKey, const LowResolutionParameters& parameters)
+{
+    assert(beginKey <= endKey);
+
+    // Both commands share the same parameters.
+    this->AddCommand(beginKey, CommandTypes::BeginLowResolution, m_lowResolutions.size());
+    this->AddCommand(endKey, CommandTypes::EndLowResolution, m_lowResolutions.size());
+    m_lowResolutions.push_back(parameters);
+}
+
+void CommandList::CacheLayer(SortKey beginKey, SortKey endKey, const LayerCacheParameters& parameters)
+{
+    assert(beginKey <= endKey);
+
+    // Both commands share the same parameters.
+    this->AddCommand(beginKey, CommandTypes::BeginLayerCache, m_layerCaches.size());
+    this->AddCommand(endKey, CommandTypes::EndLayerCache, m_layerCaches.size());
+    m_layerCaches.push_back(parameters);
+}
+
+void CommandList::ApplyLighting(SortKey key, const BasicRenderer::LightGrid& grid, const BasicRenderer::Light* lights, int lightCount, const glm::uvec2* tiles, const uint16_t* indices, int indexCount)
+{
+    int tileCount = grid.tileCount.x * grid.tileCount.y;
+
+    if(tileCount <= 0)
+        return;
+
+    LightingParameters parameters;
+    parameters.grid = grid;
+    parameters.firstLight = (uint32_t)m_lights.size();
+    parameters.lightCount = (uint32_t)lightCount;
+    parameters.firstTile = (uint32_t)m_lightTiles.size();
+    parameters.firstIndex = (uint32_t)m_lightIndices.size();
+    parameters.indexCount = (uint32_t)indexCount;
+
+    this->AddCommand(key, CommandTypes::ApplyLighting, m_lightings.size());
+    m_lightings.push_back(parameters);
+
+    // Copy light lists.
+    m_lights.insert(m_lights.end(), lights, lights + lightCount);
+    m_lightTiles.insert(m_lightTiles.end(), tiles, tiles + tileCount);
+    m_lightIndices.insert(m_lightIndices.end(), indices, indices + indexCount);
+}
+
+void CommandList::AddCommand(SortKey key, CommandTypes::Type type, std::size_t index)
+{
+    Command command;
+    command.key = key;
+    command.type = type;
+    command.index = (uint32_t)index;
+
+    m_commands.push_back(command);
+}
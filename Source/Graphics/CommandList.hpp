@@ -0,0 +1,311 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "BasicRenderer.hpp"
+
+// Forward declarations.
+namespace Graphics
+{
+    class SpriteBuffer;
+}
+
+//
+// Command List
+//
+//  Records render commands that can be executed later by the thread
+//  owning the graphics context. Recording doesn't touch any graphics
+//  state, so multiple threads can each fill their own list. Every
+//  command carries a sort key, and lists are merged and executed in
+//  the order of their keys. Commands with equal keys keep the order
+//  of lists and the order they were recorded in.
+//
+//  Memory is kept between frames when a list is reset, so recording
+//  doesn't allocate once lists have grown to their working size.
+//
+//  Recording and executing commands:
+//      Graphics::CommandList commandList;
+//      commandList.SetViewport(0, glm::ivec4(0, 0, width, height));
+//      commandList.Clear(0, Graphics::ClearFlags::Color, glm::vec4(1.0f), 1.0f);
+//      commandList.SetTransform(0, transform);
+//      commandList.DrawSprite(key, info, data);
+//
+//      basicRenderer.Execute(&commandList, 1);
+//      commandList.Reset();
+//
+
+namespace Graphics
+{
+    // Command types.
+    struct CommandTypes
+    {
+        enum Type
+        {
+            SetViewport,
+            SetTransform,
+            Clear,
+            DrawSprite,
+            DrawSpriteBuffer,
+            DrawSpriteStream,
+            BeginWeighted,
+            EndWeighted,
+            BeginLowResolution,
+            EndLowResolution,
+            BeginLayerCache,
+            EndLayerCache,
+            ApplyLighting,
+        };
+    };
+
+    // Command list class.
+    class CommandList
+    {
+    public:
+        // Type declarations.
+        typedef uint64_t SortKey;
+
+        // Command entry.
+        //  Parameters are stored in separate lists based on the command
+        //  type and the index points to an element in one of them.
+        struct Command
+        {
+            SortKey            key;
+            CommandTypes::Type type;
+            uint32_t           index;
+        };
+
+        // Clear parameters.
+        struct ClearParameters
+        {
+            uint32_t  flags;
+            glm::vec4 color;
+            float     depth;
+        };
+
+        // Low resolution parameters.
+        struct LowResolutionParameters
+        {
+            int                target;
+            glm::ivec2         size;
+            glm::ivec4         viewport;
+            UpscaleModes::Type mode;
+        };
+
+        // Layer cache parameters.
+        struct LayerCacheParameters
+        {
+            int        cache;
+            bool       redraw;
+            glm::ivec2 size;
+            glm::mat4  transform;
+            glm::mat4  composite;
+        };
+
+        // Sprite stream parameters.
+        struct StreamParameters
+        {
+            BasicRenderer::Sprite::Info info;
+            uint32_t                    first;
+            uint32_t                    count;
+        };
+
+        // Lighting parameters.
+        struct LightingParameters
+        {
+            BasicRenderer::LightGrid grid;
+            uint32_t                 firstLight;
+            uint32_t                 lightCount;
+            uint32_t                 firstTile;
+            uint32_t                 firstIndex;
+            uint32_t                 indexCount;
+        };
+
+        // Type declarations.
+        typedef std::vector<glm::ivec4> ViewportList;
+        typedef std::vector<glm::mat4> TransformList;
+        typedef std::vector<ClearParameters> ClearList;
+        typedef std::vector<const SpriteBuffer*> SpriteBufferList;
+        typedef std::vector<StreamParameters> StreamList;
+        typedef std::vector<LowResolutionParameters> LowResolutionList;
+        typedef std::vector<LayerCacheParameters> LayerCacheList;
+        typedef std::vector<LightingParameters> LightingList;
+        typedef std::vector<BasicRenderer::Light> LightList;
+        typedef std::vector<glm::uvec2> LightTileList;
+        typedef std::vector<uint16_t> LightIndexList;
+
+    public:
+        CommandList();
+        ~CommandList();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Removes all recorded commands while keeping allocated memory.
+        void Reset();
+
+        // Reserves memory for a total number of sprite commands.
+        void Reserve(int spriteCount);
+
+        // Sets the viewport rectangle (x, y, width, height).
+        void SetViewport(SortKey key, const glm::ivec4& viewport);
+
+        // Sets the view transform of following sprite commands.
+        void SetTransform(SortKey key, const glm::mat4& transform);
+
+        // Clears the frame buffer.
+        void Clear(SortKey key, uint32_t flags, const glm::vec4& color, float depth);
+
+        // Draws a sprite.
+        void DrawSprite(SortKey key, const BasicRenderer::Sprite::Info& info, const BasicRenderer::Sprite::Data& data);
+
+        // Draws sprites resident in a sprite buffer.
+        // Sprite buffer has to remain valid until the list is executed.
+        void DrawSpriteBuffer(SortKey key, const SpriteBuffer* spriteBuffer);
+
+        // Draws a stream of sprites sharing the same info.
+        // Returns memory for sprite data that has to be filled before the list
+        // is executed. Pointer remains valid until the next stream is recorded.
+        BasicRenderer::Sprite::Data* DrawSpriteStream(SortKey key, const BasicRenderer::Sprite::Info& info, int count);
+
+        // Begins a range of sprites drawn with weighted blended transparency.
+        void BeginWeighted(SortKey key);
+
+        // Ends a range of sprites drawn with weighted blended transparency.
+        void EndWeighted(SortKey key);
+
+        // Draws commands between two keys through a low resolution target.
+        // Target is upscaled into a viewport rectangle of the window framebuffer at the end key.
+        void RenderLowResolution(SortKey beginKey, SortKey endKey, const LowResolutionParameters& parameters);
+
+        // Draws commands between two keys through a layer cache.
+        // When redrawn, commands are rendered into the cache with the given
+        // transform. Otherwise they are skipped. In both cases the cache is
+        // composited at the end key as a quad placed by the composite transform.
+        void CacheLayer(SortKey beginKey, SortKey endKey, const LayerCacheParameters& parameters);
+
+        // Modulates the current viewport by the light of a light grid.
+        // Light lists are copied into the command list.
+        void ApplyLighting(SortKey key, const BasicRenderer::LightGrid& grid, const BasicRenderer::Light* lights, int lightCount, const glm::uvec2* tiles, const uint16_t* indices, int indexCount);
+
+        // Gets the number of recorded commands.
+        int GetCommandCount() const
+        {
+            return (int)m_commands.size();
+        }
+
+        // Gets a recorded command.
+        const Command& GetCommand(int index) const
+        {
+            assert(index >= 0 && index < (int)m_commands.size());
+            return m_commands[index];
+        }
+
+        // Gets command parameters.
+        const glm::ivec4& GetViewport(uint32_t index) const
+        {
+            assert(index < m_viewports.size());
+            return m_viewports[index];
+        }
+
+        const glm::mat4& GetTransform(uint32_t index) const
+        {
+            assert(index < m_transforms.size());
+            return m_transforms[index];
+        }
+
+        const ClearParameters& GetClear(uint32_t index) const
+        {
+            assert(index < m_clears.size());
+            return m_clears[index];
+        }
+
+        const BasicRenderer::Sprite::Info& GetSpriteInfo(uint32_t index) const
+        {
+            assert(index < m_spriteInfo.size());
+            return m_spriteInfo[index];
+        }
+
+        const BasicRenderer::Sprite::Data& GetSpriteData(uint32_t index) const
+        {
+            assert(index < m_spriteData.size());
+            return m_spriteData[index];
+        }
+
+        const SpriteBuffer* GetSpriteBuffer(uint32_t index) const
+        {
+            assert(index < m_spriteBuffers.size());
+            return m_spriteBuffers[index];
+        }
+
+        const StreamParameters& GetStream(uint32_t index) const
+        {
+            assert(index < m_streams.size());
+            return m_streams[index];
+        }
+
+        const BasicRenderer::Sprite::Data* GetStreamData(uint32_t first) const
+        {
+            assert(first < m_streamData.size());
+            return &m_streamData[first];
+        }
+
+        const LowResolutionParameters& GetLowResolution(uint32_t index) const
+        {
+            assert(index < m_lowResolutions.size());
+            return m_lowResolutions[index];
+        }
+
+        const LayerCacheParameters& GetLayerCache(uint32_t index) const
+        {
+            assert(index < m_layerCaches.size());
+            return m_layerCaches[index];
+        }
+
+        const LightingParameters& GetLighting(uint32_t index) const
+        {
+            assert(index < m_lightings.size());
+            return m_lightings[index];
+        }
+
+        const BasicRenderer::Light* GetLightData(uint32_t first) const
+        {
+            assert(first <= m_lights.size());
+            return m_lights.data() + first;
+        }
+
+        const glm::uvec2* GetLightTileData(uint32_t first) const
+        {
+            assert(first <= m_lightTiles.size());
+            return m_lightTiles.data() + first;
+        }
+
+        const uint16_t* GetLightIndexData(uint32_t first) const
+        {
+            assert(first <= m_lightIndices.size());
+            return m_lightIndices.data() + first;
+        }
+
+    private:
+        // Adds a command entry.
+        void AddCommand(SortKey key, CommandTypes::Type type, std::size_t index);
+
+    private:
+        // List of commands.
+        std::vector<Command> m_commands;
+
+        // Command parameters.
+        ViewportList                  m_viewports;
+        TransformList                 m_transforms;
+        ClearList                     m_clears;
+        BasicRenderer::SpriteInfoList m_spriteInfo;
+        BasicRenderer::SpriteDataList m_spriteData;
+        SpriteBufferList              m_spriteBuffers;
+        StreamList                    m_streams;
+        BasicRenderer::SpriteDataList m_streamData;
+        LowResolutionList             m_lowResolutions;
+        LayerCacheList                m_layerCaches;
+        LightingList                  m_lightings;
+        LightList                     m_lights;
+        LightTileList                 m_lightTiles;
+        LightIndexList                m_lightIndices;
+    };
+}
@@ -0,0 +1,224 @@
+#include "Precompiled.hpp"
+#include "Framebuffer.hpp"
+using namespace Graphics;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize a framebuffer! "
+
+    // Invalid types.
+    const GLuint InvalidHandle = 0;
+
+    // Gets the base format for an internal texture format.
+    GLenum GetBaseFormat(GLenum internalFormat)
+    {
+        switch(internalFormat)
+        {
+        case GL_R8:
+        case GL_R16F:
+        case GL_R32F:
+            return GL_RED;
+
+        case GL_RG8:
+        case GL_RG16F:
+        case GL_RG32F:
+            return GL_RG;
+
+        case GL_RGB8:
+        case GL_RGB16F:
+        case GL_RGB32F:
+            return GL_RGB;
+        }
+
+        return GL_RGBA;
+    }
+}
+
+Framebuffer::Framebuffer() :
+    m_handle(InvalidHandle),
+    m_depthStencil(InvalidHandle),
+    m_colorCount(0),
+    m_width(0),
+    m_height(0),
+    m_initialized(false)
+{
+    for(int i = 0; i < MaxColorAttachments; ++i)
+    {
+        m_colorTextures[i] = InvalidHandle;
+    }
+}
+
+Framebuffer::~Framebuffer()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void Framebuffer::Cleanup()
+{
+    // Release the framebuffer handle.
+    if(m_handle != InvalidHandle)
+    {
+        glDeleteFramebuffers(1, &m_handle);
+        m_handle = InvalidHandle;
+    }
+
+    // Release attachment handles.
+    for(int i = 0; i < MaxColorAttachments; ++i)
+    {
+        if(m_colorTextures[i] != InvalidHandle)
+        {
+            glDeleteTextures(1, &m_colorTextures[i]);
+            m_colorTextures[i] = InvalidHandle;
+        }
+    }
+
+    if(m_depthStencil != InvalidHandle)
+    {
+        glDeleteRenderbuffers(1, &m_depthStencil);
+        m_depthStencil = InvalidHandle;
+    }
+
+    m_colorCount = 0;
+
+    // Reset framebuffer parameters.
+    m_width = 0;
+    m_height = 0;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool Framebuffer::Initialize(int width, int height, int colorCount, const GLenum* colorFormats, bool depthStencil)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Validate arguments.
+    if(width <= 0)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"width\" is invalid.";
+        return false;
+    }
+
+    if(height <= 0)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"height\" is invalid.";
+        return false;
+    }
+
+    if(colorCount < 0 || colorCount > MaxColorAttachments)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"colorCount\" is invalid.";
+        return false;
+    }
+
+    if(colorCount > 0 && colorFormats == nullptr)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"colorFormats\" is null.";
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+
+    // Create a framebuffer handle.
+    glGenFramebuffers(1, &m_handle);
+
+    if(m_handle == InvalidHandle)
+    {
+        Log() << LogInitializeError() << "Couldn't create a framebuffer.";
+        return false;
+    }
+
+    // Remember the previously bound framebuffer.
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_handle);
+
+    SCOPE_GUARD
+    (
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+    );
+
+    // Create color attachments.
+    GLenum drawBuffers[MaxColorAttachments];
+
+    for(int i = 0; i < colorCount; ++i)
+    {
+        glGenTextures(1, &m_colorTextures[i]);
+
+        if(m_colorTextures[i] == InvalidHandle)
+        {
+            Log() << LogInitializeError() << "Couldn't create a color attachment texture.";
+            return false;
+        }
+
+        m_colorCount = i + 1;
+
+        // Allocate a texture surface without mipmaps.
+        glBindTexture(GL_TEXTURE_2D, m_colorTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, colorFormats[i], m_width, m_height, 0, GetBaseFormat(colorFormats[i]), GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // Attach the texture.
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_colorTextures[i], 0);
+
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+
+    // Create a depth/stencil attachment.
+    if(depthStencil)
+    {
+        glGenRenderbuffers(1, &m_depthStencil);
+
+        if(m_depthStencil == InvalidHandle)
+        {
+            Log() << LogInitializeError() << "Couldn't create a depth/stencil attachment.";
+            return false;
+        }
+
+        glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencil);
+    }
+
+    // Enable draw buffers.
+    if(m_colorCount > 0)
+    {
+        glDrawBuffers(m_colorCount, &drawBuffers[0]);
+    }
+    else
+    {
+        glDrawBuffer(GL_NONE);
+    }
+
+    // Check framebuffer completeness.
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Log() << LogInitializeError() << "Framebuffer is incomplete (status " << status << ").";
+        return false;
+    }
+
+    // Success!
+    Log() << "Created a framebuffer (" << m_width << "x" << m_height << ", " << m_colorCount << " color attachments).";
+
+    return m_initialized = true;
+}
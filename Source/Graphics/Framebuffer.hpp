@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Framebuffer
+//
+//  Creates an offscreen render target with a number of color texture
+//  attachments and an optional depth/stencil attachment. All color
+//  attachments are enabled as draw buffers in the order they were given.
+//
+//  Creating and binding a framebuffer:
+//      const GLenum formats[] =
+//      {
+//          GL_RGBA16F, // Color
+//          GL_R16F,    // Weight
+//      };
+//
+//      Graphics::Framebuffer framebuffer;
+//      framebuffer.Initialize(width, height, Utility::ArraySize(formats), &formats[0]);
+//
+//      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.GetHandle());
+//
+
+namespace Graphics
+{
+    // Framebuffer class.
+    class Framebuffer
+    {
+    public:
+        // Constant variables.
+        static const int MaxColorAttachments = 4;
+
+    public:
+        Framebuffer();
+        ~Framebuffer();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the framebuffer instance.
+        bool Initialize(int width, int height, int colorCount, const GLenum* colorFormats, bool depthStencil = false);
+
+        // Gets the framebuffer handle.
+        GLuint GetHandle() const
+        {
+            return m_handle;
+        }
+
+        // Gets the color attachment texture handle.
+        GLuint GetColorTexture(int index) const
+        {
+            assert(index >= 0 && index < m_colorCount);
+            return m_colorTextures[index];
+        }
+
+        // Gets the number of color attachments.
+        int GetColorCount() const
+        {
+            return m_colorCount;
+        }
+
+        // Gets the framebuffer width.
+        int GetWidth() const
+        {
+            return m_width;
+        }
+
+        // Gets the framebuffer height.
+        int GetHeight() const
+        {
+            return m_height;
+        }
+
+        // Checks if instance is valid.
+        bool IsValid() const
+        {
+            return m_initialized;
+        }
+
+    private:
+        // Framebuffer handle.
+        GLuint m_handle;
+
+        // Attachment handles.
+        GLuint m_colorTextures[MaxColorAttachments];
+        GLuint m_depthStencil;
+        int    m_colorCount;
+
+        // Framebuffer parameters.
+        int m_width;
+        int m_height;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
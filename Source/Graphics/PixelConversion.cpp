@@ -0,0 +1,175 @@
+#include "Precompiled.hpp"
+#include "PixelConversion.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PIXEL_CONVERSION_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace Graphics;
+
+namespace
+{
+    // Opaque alpha of a little endian RGBA8 pixel.
+    const uint32_t OpaqueAlpha = 0xFF000000;
+
+    // Multiplies a channel by alpha with rounding.
+    inline uint8_t MultiplyChannel(uint32_t channel, uint32_t alpha)
+    {
+        uint32_t t = channel * alpha + 128;
+        return (uint8_t)((t + (t >> 8)) >> 8);
+    }
+}
+
+void PixelConversion::GrayToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(source + i));
+
+        // Pair gray with gray and gray with alpha, then interleave the pairs.
+        __m128i grayLow = _mm_unpacklo_epi8(gray, gray);
+        __m128i grayHigh = _mm_unpackhi_epi8(gray, gray);
+        __m128i alphaLow = _mm_unpacklo_epi8(gray, alpha);
+        __m128i alphaHigh = _mm_unpackhi_epi8(gray, alpha);
+
+        __m128i* output = (__m128i*)(destination + i * 4);
+        _mm_storeu_si128(output + 0, _mm_unpacklo_epi16(grayLow, alphaLow));
+        _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(grayLow, alphaLow));
+        _mm_storeu_si128(output + 2, _mm_unpacklo_epi16(grayHigh, alphaHigh));
+        _mm_storeu_si128(output + 3, _mm_unpackhi_epi16(grayHigh, alphaHigh));
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        uint8_t* pixel = destination + i * 4;
+        pixel[0] = source[i];
+        pixel[1] = source[i];
+        pixel[2] = source[i];
+        pixel[3] = 0xFF;
+    }
+}
+
+void PixelConversion::GrayAlphaToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i grayAlpha = _mm_loadu_si128((const __m128i*)(source + i * 2));
+
+        // Duplicate gray in each 16-bit lane, then interleave with gray and alpha.
+        __m128i gray = _mm_and_si128(grayAlpha, mask);
+        __m128i grayGray = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+
+        __m128i* output = (__m128i*)(destination + i * 4);
+        _mm_storeu_si128(output + 0, _mm_unpacklo_epi16(grayGray, grayAlpha));
+        _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(grayGray, grayAlpha));
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        uint8_t* pixel = destination + i * 4;
+        pixel[0] = source[i * 2 + 0];
+        pixel[1] = source[i * 2 + 0];
+        pixel[2] = source[i * 2 + 0];
+        pixel[3] = source[i * 2 + 1];
+    }
+}
+
+void PixelConversion::RGBToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+    const __m128i alpha = _mm_set1_epi32((int)OpaqueAlpha);
+
+    // Each pixel is loaded with a 32-bit read that overlaps the next one,
+    // so the last pixel is left for the scalar loop to stay within the row.
+    for(; i + 5 <= count; i += 4)
+    {
+        uint32_t pixels[4];
+        std::memcpy(&pixels[0], source + (i + 0) * 3, 4);
+        std::memcpy(&pixels[1], source + (i + 1) * 3, 4);
+        std::memcpy(&pixels[2], source + (i + 2) * 3, 4);
+        std::memcpy(&pixels[3], source + (i + 3) * 3, 4);
+
+        __m128i rgbx = _mm_set_epi32((int)pixels[3], (int)pixels[2], (int)pixels[1], (int)pixels[0]);
+        __m128i rgba = _mm_or_si128(_mm_and_si128(rgbx, _mm_set1_epi32(0x00FFFFFF)), alpha);
+
+        _mm_storeu_si128((__m128i*)(destination + i * 4), rgba);
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        uint8_t* pixel = destination + i * 4;
+        pixel[0] = source[i * 3 + 0];
+        pixel[1] = source[i * 3 + 1];
+        pixel[2] = source[i * 3 + 2];
+        pixel[3] = 0xFF;
+    }
+}
+
+void PixelConversion::PaletteToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count, const Palette& palette)
+{
+    // SSE2 has no gather, so a table lookup is as fast as it gets.
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(destination + i * 4, &palette[source[i]], 4);
+    }
+}
+
+void PixelConversion::PremultiplyAlpha(uint8_t* pixels, std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef PIXEL_CONVERSION_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(128);
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i alphaScale = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i rgba = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+
+        __m128i halves[2] =
+        {
+            _mm_unpacklo_epi8(rgba, zero),
+            _mm_unpackhi_epi8(rgba, zero),
+        };
+
+        for(int h = 0; h < 2; ++h)
+        {
+            // Broadcast alpha of each pixel, scaling alpha itself by one.
+            __m128i alpha = _mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_or_si128(_mm_andnot_si128(alphaMask, alpha), alphaScale);
+
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], alpha), rounding);
+            halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        uint8_t* pixel = pixels + i * 4;
+        pixel[0] = MultiplyChannel(pixel[0], pixel[3]);
+        pixel[1] = MultiplyChannel(pixel[1], pixel[3]);
+        pixel[2] = MultiplyChannel(pixel[2], pixel[3]);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Pixel Conversion
+//
+//  Converts rows of decoded pixels into tightly packed RGBA8. Kernels process
+//  sixteen source bytes at a time with SSE2 when it's available, with scalar
+//  loops handling remaining pixels and other architectures.
+//
+//  Expanding a grayscale row:
+//      Graphics::PixelConversion::GrayToRGBA(rgba, gray, width);
+//
+
+namespace Graphics
+{
+    namespace PixelConversion
+    {
+        // Palette lookup table with RGBA8 entries.
+        typedef uint32_t Palette[256];
+
+        // Expands gray pixels to opaque RGBA8.
+        void GrayToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count);
+
+        // Expands gray and alpha pixels to RGBA8.
+        void GrayAlphaToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count);
+
+        // Expands RGB8 pixels to opaque RGBA8.
+        void RGBToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count);
+
+        // Expands palette indices to RGBA8.
+        void PaletteToRGBA(uint8_t* destination, const uint8_t* source, std::size_t count, const Palette& palette);
+
+        // Multiplies color channels of RGBA8 pixels by their alpha in place.
+        void PremultiplyAlpha(uint8_t* pixels, std::size_t count);
+    }
+}
@@ -18,6 +18,8 @@ ScreenSpace::ScreenSpace() :
     m_sourceSize(4.0f, 4.0f),
     m_targetSize(4.0f, 4.0f),
     m_targetAspect(1.0f),
+    m_pixelsPerUnit(0.0f),
+    m_pixelSize(0, 0),
     m_rectangle(0.0f, 0.0f, 0.0f, 0.0f),
     m_offset(0.0f, 0.0f),
     m_projection(1.0f),
@@ -40,8 +42,13 @@ void ScreenSpace::Cleanup()
 void ScreenSpace::SetSourceSize(int width, int height)
 {
     // Floor and make a multiple of 2.
-    m_sourceSize.x = FloorMultipleTwo(width);
-    m_sourceSize.y = FloorMultipleTwo(height);
+    glm::vec2 sourceSize(FloorMultipleTwo(width), FloorMultipleTwo(height));
+
+    // Rebuild only if the size has changed.
+    if(m_sourceSize == sourceSize)
+        return;
+
+    m_sourceSize = sourceSize;
 
     m_rebuild = true;
 }
@@ -63,6 +70,13 @@ void ScreenSpace::SetTargetSizeAspect(float aspect)
     m_rebuild = true;
 }
 
+void ScreenSpace::SetPixelsPerUnit(float pixels)
+{
+    m_pixelsPerUnit = std::max(0.0f, pixels);
+
+    m_rebuild = true;
+}
+
 void ScreenSpace::Rebuild() const
 {
     if(m_rebuild)
@@ -115,6 +129,23 @@ void ScreenSpace::Rebuild() const
             m_rectangle.w /= aspectRatio;
         }
 
+        // Expand screen space coordinates to whole pixels.
+        if(m_pixelsPerUnit > 0.0f)
+        {
+            // Round up and make a multiple of 2, so the rectangle stays centered.
+            m_pixelSize.x = (int)FloorMultipleTwo(std::ceil((m_rectangle.y - m_rectangle.x) * m_pixelsPerUnit));
+            m_pixelSize.y = (int)FloorMultipleTwo(std::ceil((m_rectangle.w - m_rectangle.z) * m_pixelsPerUnit));
+
+            m_rectangle.x = -m_pixelSize.x * 0.5f / m_pixelsPerUnit;
+            m_rectangle.y =  m_pixelSize.x * 0.5f / m_pixelsPerUnit;
+            m_rectangle.z = -m_pixelSize.y * 0.5f / m_pixelsPerUnit;
+            m_rectangle.w =  m_pixelSize.y * 0.5f / m_pixelsPerUnit;
+        }
+        else
+        {
+            m_pixelSize = glm::ivec2(0, 0);
+        }
+
         // Calculate screen space offset.
         m_offset.x = -m_targetSize.x * 0.5f;
         m_offset.y = -m_targetSize.y * 0.5f;
@@ -144,6 +175,12 @@ const glm::vec4& ScreenSpace::GetRectangle() const
     return m_rectangle;
 }
 
+const glm::ivec2& ScreenSpace::GetPixelSize() const
+{
+    Rebuild();
+    return m_pixelSize;
+}
+
 const glm::vec2& ScreenSpace::GetOffset() const
 {
     Rebuild();
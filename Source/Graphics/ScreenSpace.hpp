@@ -21,6 +21,13 @@
 //      
 //      glm::mat4 transform = screenSpace.GetTransform();
 //
+//  When the number of pixels per unit is specified, the source rectangle
+//  is expanded to cover a whole number of pixels. Its pixel size can then
+//  be used as the resolution of a low resolution render target.
+//
+//      screenSpace.SetPixelsPerUnit(16.0f);
+//      glm::ivec2 resolution = screenSpace.GetPixelSize();
+//
 
 namespace Graphics
 {
@@ -45,6 +52,10 @@ namespace Graphics
         // Aspect is equal to horizontal width divided by vertical height.
         void SetTargetSizeAspect(float aspect);
 
+        // Sets the number of pixels per target unit.
+        // Zero disables snapping of the source rectangle to pixels.
+        void SetPixelsPerUnit(float pixels);
+
         // Gets the source size.
         const glm::vec2& GetSourceSize() const;
 
@@ -55,6 +66,10 @@ namespace Graphics
         // Returns a [left, right, bottom, top] vector.
         const glm::vec4& GetRectangle() const;
 
+        // Gets the size of the source rectangle in pixels.
+        // Returns zero if the number of pixels per unit is not set.
+        const glm::ivec2& GetPixelSize() const;
+
         // Gets the offset from the center to bottom left corner of the target.
         // Can be used to move the origin to the center.
         const glm::vec2& GetOffset() const;
@@ -74,6 +89,9 @@ namespace Graphics
         mutable glm::vec2 m_targetSize;
         float m_targetAspect;
 
+        float m_pixelsPerUnit;
+        mutable glm::ivec2 m_pixelSize;
+
         mutable glm::vec4 m_rectangle;
         mutable glm::vec2 m_offset;
 
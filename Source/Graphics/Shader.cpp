@@ -1,5 +1,6 @@
 #include "Precompiled.hpp"
 #include "Graphics/Shader.hpp"
+#include "System/FileSystem.hpp"
 using namespace Graphics;
 
 namespace
@@ -51,21 +52,50 @@ void Shader::Cleanup()
         m_handle = InvalidHandle;
     }
 
+    // Release the shader code.
+    Utility::ClearContainer(m_decodedCode);
+
     // Reset initialization state.
     m_initialized = false;
 }
 
 bool Shader::Load(std::string filename)
+{
+    // Read and compile the shader on the calling thread.
+    if(!this->Decode(filename))
+        return false;
+
+    return this->Upload(filename);
+}
+
+bool Shader::Decode(std::string filename)
 {
     // Load the shader code from a file.
-    std::string shaderCode = Utility::GetTextFileContent(Build::GetWorkingDir() + filename);
+    System::FileView file;
 
-    if(shaderCode.empty())
+    if(!this->OpenFile(filename, file) || file.GetSize() == 0)
     {
         Log() << LogLoadError(filename) << "Couldn't read the file.";
         return false;
     }
 
+    m_decodedCode.assign((const char*)file.GetData(), file.GetSize());
+
+    return true;
+}
+
+bool Shader::Upload(std::string filename)
+{
+    // Take out the shader code.
+    std::string shaderCode;
+    shaderCode.swap(m_decodedCode);
+
+    if(shaderCode.empty())
+    {
+        Log() << LogLoadError(filename) << "Shader code hasn't been read.";
+        return false;
+    }
+
     // Call the initialization method.
     if(!this->Initialize(shaderCode))
     {
@@ -54,6 +54,12 @@ namespace Graphics
         // Loads the shader from a file.
         bool Load(std::string filename);
 
+        // Reads the shader code from a file.
+        bool Decode(std::string filename) override;
+
+        // Compiles the read shader code.
+        bool Upload(std::string filename) override;
+
         // Initializes the shader instance.
         bool Initialize(std::string shaderCode);
 
@@ -79,6 +85,9 @@ namespace Graphics
         // Linked program handle.
         GLuint m_handle;
 
+        // Shader code waiting for compilation.
+        std::string m_decodedCode;
+
         // Initialization state.
         bool m_initialized;
     };
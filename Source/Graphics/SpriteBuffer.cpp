@@ -0,0 +1,101 @@
+#include "Precompiled.hpp"
+#include "SpriteBuffer.hpp"
+using namespace Graphics;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize a sprite buffer! "
+}
+
+SpriteBuffer::SpriteBuffer() :
+    m_spriteCount(0),
+    m_animated(false),
+    m_initialized(false)
+{
+}
+
+SpriteBuffer::~SpriteBuffer()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void SpriteBuffer::Cleanup()
+{
+    // Cleanup graphics objects.
+    m_instanceBuffer.Cleanup();
+
+    // Cleanup sprite batches.
+    Utility::ClearContainer(m_batches);
+    m_spriteCount = 0;
+    m_animated = false;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool SpriteBuffer::Initialize(const BasicRenderer::Sprite::Info* spriteInfo, const BasicRenderer::Sprite::Data* spriteData, int spriteCount)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Validate arguments.
+    if(spriteInfo == nullptr)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"spriteInfo\" is null.";
+        return false;
+    }
+
+    if(spriteData == nullptr)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"spriteData\" is null.";
+        return false;
+    }
+
+    if(spriteCount <= 0)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"spriteCount\" is invalid.";
+        return false;
+    }
+
+    // Upload sprite data.
+    if(!m_instanceBuffer.Initialize(sizeof(BasicRenderer::Sprite::Data), spriteCount, spriteData, GL_STATIC_DRAW))
+    {
+        Log() << LogInitializeError() << "Couldn't create an instance buffer.";
+        return false;
+    }
+
+    m_spriteCount = spriteCount;
+
+    // Group consecutive sprites into batches.
+    for(int i = 0; i < spriteCount; ++i)
+    {
+        if(m_batches.empty() || m_batches.back().info != spriteInfo[i])
+        {
+            Batch batch;
+            batch.info = spriteInfo[i];
+            batch.first = i;
+            batch.count = 0;
+
+            m_batches.push_back(batch);
+
+            if(batch.info.frames != nullptr)
+            {
+                m_animated = true;
+            }
+        }
+
+        m_batches.back().count += 1;
+    }
+
+    // Success!
+    return m_initialized = true;
+}
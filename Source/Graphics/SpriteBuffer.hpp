@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "Buffer.hpp"
+#include "BasicRenderer.hpp"
+
+//
+// Sprite Buffer
+//
+//  Keeps a list of sprites resident in graphics memory, so they can be
+//  drawn every frame without being uploaded again. Consecutive sprites
+//  with identical info are grouped into batches, so sprites should be
+//  sorted by texture before creating the buffer.
+//
+//  Creating and drawing a sprite buffer:
+//      Graphics::SpriteBuffer spriteBuffer;
+//      spriteBuffer.Initialize(&spriteInfo[0], &spriteData[0], spriteCount);
+//
+//      basicRenderer.DrawSpriteBuffer(spriteBuffer, transform);
+//
+
+namespace Graphics
+{
+    // Sprite buffer class.
+    class SpriteBuffer
+    {
+    public:
+        // Batch of sprites sharing the same info.
+        struct Batch
+        {
+            BasicRenderer::Sprite::Info info;
+            int                         first;
+            int                         count;
+        };
+
+        // Type declarations.
+        typedef std::vector<Batch> BatchList;
+
+    public:
+        SpriteBuffer();
+        ~SpriteBuffer();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the sprite buffer instance.
+        bool Initialize(const BasicRenderer::Sprite::Info* spriteInfo, const BasicRenderer::Sprite::Data* spriteData, int spriteCount);
+
+        // Gets the instance buffer.
+        const InstanceBuffer& GetInstanceBuffer() const
+        {
+            return m_instanceBuffer;
+        }
+
+        // Gets the list of batches.
+        const BatchList& GetBatches() const
+        {
+            return m_batches;
+        }
+
+        // Gets the number of sprites.
+        int GetSpriteCount() const
+        {
+            return m_spriteCount;
+        }
+
+        // Checks if any sprite has an animation played from a frame table.
+        bool IsAnimated() const
+        {
+            return m_animated;
+        }
+
+        // Checks if instance is valid.
+        bool IsValid() const
+        {
+            return m_initialized;
+        }
+
+    private:
+        // Graphics objects.
+        InstanceBuffer m_instanceBuffer;
+
+        // Sprite batches.
+        BatchList m_batches;
+        int       m_spriteCount;
+        bool      m_animated;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -1,8 +1,10 @@
 #include "Precompiled.hpp"
 #include "SpriteSheet.hpp"
 #include "Texture.hpp"
-#include "Lua/State.hpp"
+#include "Lua/Loader.hpp"
 #include "System/ResourceManager.hpp"
+#include "System/FileSystem.hpp"
+#include "System/BakedFile.hpp"
 #include "Graphics/Texture.hpp"
 using namespace Graphics;
 
@@ -13,6 +15,9 @@ namespace
 
     // Invalid sprite rectangle.
     const glm::vec4 InvalidSprite(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Baked file type.
+    const uint32_t BakedType = 0x54525053; // "SPRT"
 }
 
 SpriteSheet::SpriteSheet(System::ResourceManager* resourceManager) :
@@ -27,7 +32,9 @@ SpriteSheet::~SpriteSheet()
 void SpriteSheet::Cleanup()
 {
     // Reset texture reference.
-    m_texture = nullptr;
+    m_texture = TextureHandle();
+    m_textureName.clear();
+    m_textureFuture = TextureFuture();
 
     // Clear the list of sprites.
     Utility::ClearContainer(m_sprites);
@@ -35,6 +42,18 @@ void SpriteSheet::Cleanup()
 
 bool SpriteSheet::Load(std::string filename)
 {
+    // Decode and upload the sprite sheet on the calling thread.
+    if(!this->Decode(filename))
+        return false;
+
+    return this->Upload(filename);
+}
+
+bool SpriteSheet::Decode(std::string filename)
+{
+    // Measure the decoding time.
+    auto startTime = std::chrono::high_resolution_clock::now();
+
     // Restore instance to it's original state.
     this->Cleanup();
 
@@ -53,17 +72,66 @@ bool SpriteSheet::Load(std::string filename)
         return false;
     }
 
+    // Open sprite sheet files.
+    System::FileView sourceFile;
+    System::FileView bakedFile;
+
+    bool hasSource = this->OpenFile(filename, sourceFile);
+    bool hasBaked = this->OpenFile(System::BakedFile::GetBakedName(filename), bakedFile);
+
+    // Read the baked sprite sheet, unless it's stale.
+    bool decoded = false;
+
+    if(hasBaked)
+    {
+        uint64_t sourceHash = System::BakedFile::Hash(sourceFile.GetData(), sourceFile.GetSize());
+        decoded = this->DecodeBaked(filename, bakedFile, hasSource ? &sourceHash : nullptr);
+
+        if(!decoded)
+        {
+            this->Cleanup();
+        }
+    }
+
+    // Read the sprite sheet source.
+    if(!decoded)
+    {
+        if(!hasSource)
+        {
+            Log() << LogLoadError(filename) << "Couldn't open the file.";
+            return false;
+        }
+
+        if(!this->DecodeSource(filename, sourceFile))
+            return false;
+    }
+
+    // Request the sprite texture.
+    m_textureFuture = resourceManager->LoadAsync<Texture>(m_textureName);
+
+    // Print the decoding time.
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+
+    Log() << "Decoded a sprite sheet from \"" << filename << "\" file in " << duration.count() << " ms" << (decoded ? " (baked)." : ".");
+
+    return success = true;
+}
+
+bool SpriteSheet::DecodeSource(std::string filename, const System::FileView& file)
+{
     // Load sprite sheet file.
-    Lua::State lua;
+    Lua::Loader& lua = Lua::Loader::GetThreadLoader();
+
+    SCOPE_GUARD(lua.Reset());
 
-    if(!lua.Load(filename))
+    if(!lua.Run(filename, file.GetData(), file.GetSize()))
     {
         Log() << LogLoadError(filename) << "Couldn't load the file.";
         return false;
     }
 
     // Get the global table.
-    lua_getglobal(lua, "SpriteSheet");
+    lua_getfield(lua, -1, "SpriteSheet");
 
     if(!lua_istable(lua, -1))
     {
@@ -71,7 +139,7 @@ bool SpriteSheet::Load(std::string filename)
         return false;
     }
 
-    // Load the sprite texture.
+    // Read the sprite texture.
     lua_getfield(lua, -1, "Texture");
 
     if(!lua_isstring(lua, -1))
@@ -80,7 +148,7 @@ bool SpriteSheet::Load(std::string filename)
         return false;
     }
 
-    m_texture = resourceManager->Load<Texture>(lua_tostring(lua, -1));
+    m_textureName = lua_tostring(lua, -1);
 
     lua_pop(lua, 1);
 
@@ -126,18 +194,117 @@ bool SpriteSheet::Load(std::string filename)
 
     lua_pop(lua, 1);
 
+    return true;
+}
+
+bool SpriteSheet::DecodeBaked(std::string filename, const System::FileView& file, const uint64_t* sourceHash)
+{
+    System::BakedReader reader;
+
+    if(!reader.Open(filename, file.GetData(), file.GetSize(), BakedType, sourceHash))
+        return false;
+
+    // Read the sprite texture.
+    if(reader.GetDependencies().size() != 1)
+    {
+        Log() << LogLoadError(filename) << "Baked file has invalid dependencies.";
+        return false;
+    }
+
+    m_textureName = reader.GetDependencies()[0];
+
+    // Read the name table, followed by rectangles.
+    uint32_t spriteCount = 0;
+    reader.Read(spriteCount);
+
+    std::vector<std::string> names;
+
+    for(uint32_t i = 0; i < spriteCount && reader.IsValid(); ++i)
+    {
+        names.emplace_back();
+        reader.Read(names.back());
+    }
+
+    for(uint32_t i = 0; i < spriteCount && reader.IsValid(); ++i)
+    {
+        glm::vec4 rectangle;
+        reader.Read(rectangle);
+
+        if(reader.IsValid() && !this->AddSprite(names[i], rectangle))
+        {
+            Log() << LogLoadError(filename) << "Couldn't add a sprite.";
+            return false;
+        }
+    }
+
+    if(!reader.IsValid())
+    {
+        Log() << LogLoadError(filename) << "Baked file is truncated.";
+        return false;
+    }
+
+    return true;
+}
+
+bool SpriteSheet::Bake(std::string path, uint64_t sourceHash) const
+{
+    System::BakedWriter writer(BakedType);
+
+    // Write the sprite texture.
+    writer.AddDependency(m_textureName);
+
+    // Write the name table, followed by rectangles.
+    writer.Write((uint32_t)m_sprites.size());
+
+    for(const auto& sprite : m_sprites)
+    {
+        writer.Write(sprite.first);
+    }
+
+    for(const auto& sprite : m_sprites)
+    {
+        writer.Write(sprite.second);
+    }
+
+    return writer.Save(path, sourceHash);
+}
+
+bool SpriteSheet::Upload(std::string filename)
+{
+    if(!m_textureFuture.IsValid())
+    {
+        Log() << LogLoadError(filename) << "Sprite sheet hasn't been decoded.";
+        return false;
+    }
+
+    // Take the loaded texture.
+    m_texture = m_textureFuture.GetHandle();
+    m_textureFuture = TextureFuture();
+
     // Success!
     Log() << "Loaded a sprite sheet from \"" << filename << "\" file.";
 
-    return success = true;
+    return true;
+}
+
+std::size_t SpriteSheet::GetCpuMemorySize() const
+{
+    std::size_t size = sizeof(SpriteSheet);
+
+    for(const auto& sprite : m_sprites)
+    {
+        size += sizeof(sprite) + sprite.first.capacity();
+    }
+
+    return size;
 }
 
-void SpriteSheet::SetTexture(TexturePtr texture)
+void SpriteSheet::SetTexture(TextureHandle texture)
 {
     m_texture = texture;
 }
 
-const SpriteSheet::TexturePtr& SpriteSheet::GetTexture() const
+const SpriteSheet::TextureHandle& SpriteSheet::GetTexture() const
 {
     return m_texture;
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "Precompiled.hpp"
-#include "System/Resource.hpp"
+#include "System/ResourceManager.hpp"
 
 // Forward declarations.
+namespace System
+{
+    class FileView;
+}
+
 namespace Graphics
 {
     class Texture;
@@ -12,6 +17,9 @@ namespace Graphics
 //
 // Sprite Sheet
 //
+//  Sprite sheets are read from baked files written by the asset baker
+//  when they are up to date, and from Lua sources otherwise.
+//
 
 namespace Graphics
 {
@@ -20,7 +28,8 @@ namespace Graphics
     {
     public:
         // Type declarations.
-        typedef std::shared_ptr<const Texture> TexturePtr;
+        typedef System::ResourceHandle<Texture> TextureHandle;
+        typedef System::ResourceFuture<Texture> TextureFuture;
         typedef std::map<std::string, glm::vec4> SpriteList;
 
     public:
@@ -33,11 +42,30 @@ namespace Graphics
         // Loads the sprite sheet from a file.
         bool Load(std::string filename);
 
+        // Reads sprites from a file and requests the texture.
+        bool Decode(std::string filename) override;
+
+        // Takes the loaded texture.
+        bool Upload(std::string filename) override;
+
+        // Gets the estimated size of the sprite list.
+        std::size_t GetCpuMemorySize() const override;
+
+        // Reads sprites from a Lua source.
+        bool DecodeSource(std::string filename, const System::FileView& file);
+
+        // Reads sprites from a baked file.
+        // Fails if the source hash doesn't match, unless it's null.
+        bool DecodeBaked(std::string filename, const System::FileView& file, const uint64_t* sourceHash = nullptr);
+
+        // Writes decoded sprites into a baked file.
+        bool Bake(std::string path, uint64_t sourceHash) const;
+
         // Sets the texture.
-        void SetTexture(TexturePtr texture);
+        void SetTexture(TextureHandle texture);
 
         // Gets the texture.
-        const TexturePtr& GetTexture() const;
+        const TextureHandle& GetTexture() const;
 
         // Adds a sprite.
         bool AddSprite(std::string name, const glm::vec4& rectangle);
@@ -47,7 +75,11 @@ namespace Graphics
 
     private:
         // Sprite sheet data.
-        TexturePtr m_texture;
-        SpriteList m_sprites;
+        TextureHandle m_texture;
+        SpriteList    m_sprites;
+
+        // Texture file and the texture being loaded.
+        std::string   m_textureName;
+        TextureFuture m_textureFuture;
     };
 }
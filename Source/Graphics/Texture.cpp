@@ -1,5 +1,10 @@
 #include "Precompiled.hpp"
 #include "Texture.hpp"
+#include "TextureUploader.hpp"
+#include "TextureContainer.hpp"
+#include "PixelConversion.hpp"
+#include "System/ResourceManager.hpp"
+#include "System/FileSystem.hpp"
 using namespace Graphics;
 
 namespace
@@ -11,6 +16,37 @@ namespace
     // Invalid types.
     const GLuint InvalidHandle = 0;
     const GLenum InvalidEnum = 0;
+
+    // Reader of an image mapped into memory.
+    struct MemoryReader
+    {
+        const uint8_t* data;
+        std::size_t    size;
+        std::size_t    offset;
+    };
+
+    // Decode buffers reused between images on the same thread.
+    thread_local std::vector<uint8_t>   DecodeScratch;
+    thread_local std::vector<png_bytep> DecodeRows;
+
+    // Gets the size of a pixel in a format (in bytes).
+    std::size_t GetPixelSize(GLenum format)
+    {
+        switch(format)
+        {
+        case GL_RED:
+            return 1;
+
+        case GL_RG:
+            return 2;
+
+        case GL_RGB:
+            return 3;
+
+        default:
+            return 4;
+        }
+    }
 }
 
 Texture::Texture(System::ResourceManager* resourceManager) :
@@ -18,7 +54,13 @@ Texture::Texture(System::ResourceManager* resourceManager) :
     m_handle(InvalidHandle),
     m_width(0),
     m_height(0),
+    m_levelCount(0),
     m_format(InvalidEnum),
+    m_decodedWidth(0),
+    m_decodedHeight(0),
+    m_decodedLevels(0),
+    m_decodedFormat(InvalidEnum),
+    m_uploader(nullptr),
     m_initialized(false)
 {
 }
@@ -31,6 +73,13 @@ Texture::~Texture()
 
 void Texture::Cleanup()
 {
+    // Cancel pending uploads.
+    if(m_uploader != nullptr)
+    {
+        m_uploader->Cancel(this);
+        m_uploader = nullptr;
+    }
+
     // Destroy the texture handle.
     if(m_handle != InvalidHandle)
     {
@@ -41,14 +90,34 @@ void Texture::Cleanup()
     // Reset texture parameters.
     m_width = 0;
     m_height = 0;
+    m_levelCount = 0;
     m_format = InvalidEnum;
 
+    // Release the decoded image.
+    Utility::ClearContainer(m_decodedData);
+    m_decodedWidth = 0;
+    m_decodedHeight = 0;
+    m_decodedLevels = 0;
+    m_decodedFormat = InvalidEnum;
+
     // Reset initialization state.
     m_initialized = false;
 }
 
 bool Texture::Load(std::string filename)
 {
+    // Decode and upload the image on the calling thread.
+    if(!this->Decode(filename))
+        return false;
+
+    return this->Upload(filename);
+}
+
+bool Texture::Decode(std::string filename)
+{
+    // Release a previously decoded image.
+    Utility::ClearContainer(m_decodedData);
+
     // Validate arguments.
     if(filename.empty())
     {
@@ -56,29 +125,98 @@ bool Texture::Load(std::string filename)
         return false;
     }
 
-    // Check the file extenstion.
-    if(Utility::GetFileExtension(filename) != "png")
+    // Measure the decoding time.
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::string extension = Utility::GetFileExtension(filename);
+
+    TextureContainer::Image image;
+    bool converted = false;
+
+    if(extension == "texture")
     {
-        Log() << LogLoadError(filename) << "Unsupported file extension.";
-        return false;
+        // Read a baked container.
+        System::FileView file;
+
+        if(!this->OpenFile(filename, file))
+        {
+            Log() << LogLoadError(filename) << "Couldn't open the file.";
+            return false;
+        }
+
+        if(!TextureContainer::Read(filename, file.GetData(), file.GetSize(), image))
+        {
+            Log() << LogLoadError(filename) << "Couldn't read the container.";
+            return false;
+        }
     }
+    else if(extension == "png")
+    {
+        // Read the container converted from this image, if it's up to date.
+        // Only loose images can be checked against and converted, while
+        // containers next to images in archives are assumed to be baked.
+        std::string containerName = filename.substr(0, filename.size() - extension.size()) + "texture";
+
+        System::FileSystem* fileSystem = this->GetFileSystem();
+        std::string path = fileSystem != nullptr ? fileSystem->GetNativePath(filename) : Build::GetWorkingDir() + filename;
+
+        TextureContainer::Source source;
+        bool isLoose = !path.empty() && TextureContainer::GetSource(path, source);
 
-    // Open the file stream.
-    std::ifstream file(Build::GetWorkingDir() + filename, std::ios::binary);
+        System::FileView file;
 
-    if(!file.is_open())
+        if(!this->OpenFile(containerName, file) ||
+            !TextureContainer::Read(containerName, file.GetData(), file.GetSize(), image, isLoose ? &source : nullptr))
+        {
+            // Decode the image and build its mip chain.
+            if(!this->OpenFile(filename, file))
+            {
+                Log() << LogLoadError(filename) << "Couldn't open the file.";
+                return false;
+            }
+
+            if(!this->DecodePNG(filename, file, image))
+                return false;
+
+            TextureContainer::BuildMipChain(image);
+
+            // Convert it for next loads.
+            if(isLoose)
+            {
+                std::string containerPath = path.substr(0, path.size() - extension.size()) + "texture";
+                TextureContainer::Write(containerPath, image, source);
+            }
+
+            converted = true;
+        }
+    }
+    else
     {
-        Log() << LogLoadError(filename) << "Couldn't open the file.";
+        Log() << LogLoadError(filename) << "Unsupported file extension.";
         return false;
     }
 
+    // Keep the image for upload.
+    m_decodedData.swap(image.data);
+    m_decodedWidth = image.width;
+    m_decodedHeight = image.height;
+    m_decodedLevels = image.levelCount;
+    m_decodedFormat = GL_RGBA;
+
+    // Print the decoding time.
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+
+    Log() << "Decoded a texture from \"" << filename << "\" file in " << duration.count() << " ms" << (converted ? " (converted)." : ".");
+
+    return true;
+}
+
+bool Texture::DecodePNG(std::string filename, const System::FileView& file, TextureContainer::Image& image)
+{
     // Validate the file header.
     const size_t png_sig_size = 8;
-    png_byte png_sig[png_sig_size];
-
-    file.read((char*)png_sig, png_sig_size);
 
-    if(png_sig_cmp(png_sig, 0, png_sig_size) != 0)
+    if(file.GetSize() < png_sig_size || png_sig_cmp((png_const_bytep)file.GetData(), 0, png_sig_size) != 0)
     {
         Log() << LogLoadError(filename) << "Not a valid PNG file.";
         return false;
@@ -106,22 +244,25 @@ bool Texture::Load(std::string filename)
         png_destroy_read_struct(&png_read_ptr, &png_info_ptr, nullptr);
     );
 
-    // Declare file read function.
+    // Declare memory read function.
+    // Compressed data is read straight from the file view.
+    MemoryReader png_reader;
+    png_reader.data = file.GetData();
+    png_reader.size = file.GetSize();
+    png_reader.offset = png_sig_size;
+
     auto png_read_function = [](png_structp png_ptr, png_bytep data, png_size_t length) -> void
     {
-        std::ifstream* stream = (std::ifstream*)png_get_io_ptr(png_ptr);
-        stream->read((char*)data, length);
-    };
+        MemoryReader* reader = (MemoryReader*)png_get_io_ptr(png_ptr);
 
-    // Declare image buffers.
-    png_bytep* png_row_ptrs = nullptr;
-    png_byte* png_data_ptr = nullptr;
+        if(length > reader->size - reader->offset)
+        {
+            png_error(png_ptr, "Unexpected end of file.");
+        }
 
-    SCOPE_GUARD
-    (
-        delete [] png_row_ptrs;
-        delete [] png_data_ptr;
-    );
+        std::memcpy(data, reader->data + reader->offset, length);
+        reader->offset += length;
+    };
 
     // Setup the error handling routine.
     // This is apparently a standard way to handle errors with libpng and some
@@ -136,8 +277,8 @@ bool Texture::Load(std::string filename)
         return false;
     }
 
-    // Setup the file read function.
-    png_set_read_fn(png_read_ptr, (png_voidp)&file, png_read_function);
+    // Setup the memory read function.
+    png_set_read_fn(png_read_ptr, (png_voidp)&png_reader, png_read_function);
 
     // Set the amount of already read signature bytes.
     png_set_sig_bytes(png_read_ptr, png_sig_size);
@@ -148,33 +289,64 @@ bool Texture::Load(std::string filename)
     png_uint_32 width = png_get_image_width(png_read_ptr, png_info_ptr);
     png_uint_32 height = png_get_image_height(png_read_ptr, png_info_ptr);
     png_uint_32 depth = png_get_bit_depth(png_read_ptr, png_info_ptr);
-    png_uint_32 channels = png_get_channels(png_read_ptr, png_info_ptr);
     png_uint_32 format = png_get_color_type(png_read_ptr, png_info_ptr);
 
-    // Process different format types.
+    // Let libpng only unpack channels to 8bits.
+    // Expansion to RGBA is done afterwards with conversion kernels.
+    PixelConversion::Palette palette;
+
     switch(format)
     {
     case PNG_COLOR_TYPE_GRAY:
     case PNG_COLOR_TYPE_GRAY_ALPHA:
-        if(depth < 8)
         {
-            // Convert gray scale image to single 8bit channel.
-            png_set_expand_gray_1_2_4_to_8(png_read_ptr);
-            depth = 8;
+            // Unpack low bit depth gray scale images.
+            if(depth < 8)
+            {
+                png_set_expand_gray_1_2_4_to_8(png_read_ptr);
+            }
         }
         break;
 
     case PNG_COLOR_TYPE_PALETTE:
         {
-            // Convert indexed palette to RGB.
-            png_set_palette_to_rgb(png_read_ptr);
-            channels = 3;
+            // Unpack low bit depth indices to one byte each.
+            if(depth < 8)
+            {
+                png_set_packing(png_read_ptr);
+            }
 
-            // Create alpha channel if pallete has transparency.
-            if(png_get_valid(png_read_ptr, png_info_ptr, PNG_INFO_tRNS))
+            // Build a lookup table from palette and transparency chunks.
+            png_colorp png_palette = nullptr;
+            int png_palette_size = 0;
+
+            if(!png_get_PLTE(png_read_ptr, png_info_ptr, &png_palette, &png_palette_size))
+            {
+                Log() << LogLoadError(filename) << "Missing image palette.";
+                return false;
+            }
+
+            png_bytep png_alpha = nullptr;
+            int png_alpha_size = 0;
+
+            png_get_tRNS(png_read_ptr, png_info_ptr, &png_alpha, &png_alpha_size, nullptr);
+
+            for(int i = 0; i < 256; ++i)
             {
-                png_set_tRNS_to_alpha(png_read_ptr);
-                channels += 1;
+                uint8_t* entry = (uint8_t*)&palette[i];
+
+                if(i < png_palette_size)
+                {
+                    entry[0] = png_palette[i].red;
+                    entry[1] = png_palette[i].green;
+                    entry[2] = png_palette[i].blue;
+                }
+                else
+                {
+                    entry[0] = entry[1] = entry[2] = 0;
+                }
+
+                entry[3] = i < png_alpha_size ? png_alpha[i] : 0xFF;
             }
         }
         break;
@@ -187,54 +359,84 @@ bool Texture::Load(std::string filename)
         Log() << LogLoadError(filename) << "Unsupported image format.";
         return false;
     }
-    
+
+    // Create alpha channel from transparency chunk.
+    // Palette transparency is already in the lookup table.
+    if(format != PNG_COLOR_TYPE_PALETTE && png_get_valid(png_read_ptr, png_info_ptr, PNG_INFO_tRNS))
+    {
+        png_set_tRNS_to_alpha(png_read_ptr);
+    }
+
     // Make sure we only get 8bits per channel.
     if(depth == 16)
     {
         png_set_strip_16(png_read_ptr);
     }
 
-    if(depth != 8)
+    // Let libpng combine interlaced passes.
+    png_set_interlace_handling(png_read_ptr);
+
+    // Read transformed image info.
+    png_read_update_info(png_read_ptr, png_info_ptr);
+
+    if(png_get_bit_depth(png_read_ptr, png_info_ptr) != 8)
     {
         Log() << LogLoadError(filename) << "Unsupported image depth size.";
         return false;
     }
 
+    png_uint_32 channels = png_get_channels(png_read_ptr, png_info_ptr);
+    png_uint_32 transformed = png_get_color_type(png_read_ptr, png_info_ptr);
+
     // Allocate image buffers.
-    png_row_ptrs = new png_bytep[height];
-    png_data_ptr = new png_byte[width * height * channels];
+    // RGBA images are decoded straight into the first level of the image,
+    // other formats into a scratch buffer reused by the decoding thread.
+    image.data.resize(width * height * TextureContainer::PixelSize);
 
-    // Setup an array of row pointers to the actual data buffer.
+    png_byte* png_data_ptr = &image.data[0];
+
+    if(transformed != PNG_COLOR_TYPE_RGBA)
+    {
+        DecodeScratch.resize(width * height * channels);
+        png_data_ptr = &DecodeScratch[0];
+    }
+
+    // Setup an array of row pointers to the decode buffer.
     png_uint_32 png_stride = width * channels;
 
+    DecodeRows.resize(height);
+
     for(png_uint_32 i = 0; i < height; ++i)
     {
         png_uint_32 png_offset = i * png_stride;
-        png_row_ptrs[i] = png_data_ptr + png_offset;
+        DecodeRows[i] = png_data_ptr + png_offset;
     }
 
     // Read image data.
-    png_read_image(png_read_ptr, png_row_ptrs);
+    png_read_image(png_read_ptr, &DecodeRows[0]);
 
-    // Determine the texture format.
-    GLenum textureFormat = GL_NONE;
+    // Convert decoded pixels to RGBA.
+    std::size_t count = (std::size_t)width * height;
 
-    switch(channels)
+    switch(transformed)
     {
-    case 1:
-        textureFormat = GL_R;
+    case PNG_COLOR_TYPE_GRAY:
+        PixelConversion::GrayToRGBA(&image.data[0], png_data_ptr, count);
         break;
 
-    case 2:
-        textureFormat = GL_RG;
+    case PNG_COLOR_TYPE_GRAY_ALPHA:
+        PixelConversion::GrayAlphaToRGBA(&image.data[0], png_data_ptr, count);
         break;
 
-    case 3:
-        textureFormat = GL_RGB;
+    case PNG_COLOR_TYPE_RGB:
+        PixelConversion::RGBToRGBA(&image.data[0], png_data_ptr, count);
         break;
 
-    case 4:
-        textureFormat = GL_RGBA;
+    case PNG_COLOR_TYPE_PALETTE:
+        PixelConversion::PaletteToRGBA(&image.data[0], png_data_ptr, count, palette);
+        break;
+
+    case PNG_COLOR_TYPE_RGBA:
         break;
 
     default:
@@ -242,20 +444,125 @@ bool Texture::Load(std::string filename)
         return false;
     }
 
+    // Set the image level.
+    image.width = width;
+    image.height = height;
+    image.levelCount = 1;
+
+    return true;
+}
+
+bool Texture::Upload(std::string filename)
+{
+    if(m_decodedData.empty())
+    {
+        Log() << LogLoadError(filename) << "Image hasn't been decoded.";
+        return false;
+    }
+
+    // Take out the decoded image, which is released once uploaded.
+    std::vector<uint8_t> data;
+    data.swap(m_decodedData);
+
+    // Get the texture uploader.
+    TextureUploader* uploader = this->GetUploader();
+
+    // Gather pointers to levels.
+    // Storage is only allocated if pixels are streamed by the uploader.
+    std::vector<const void*> levels(m_decodedLevels, nullptr);
+
+    if(uploader == nullptr)
+    {
+        for(int i = 0; i < m_decodedLevels; ++i)
+        {
+            levels[i] = &data[TextureContainer::GetLevelOffset(m_decodedWidth, m_decodedHeight, i)];
+        }
+    }
+
     // Call the initialization method.
-    if(!this->Initialize(width, height, textureFormat, png_data_ptr))
+    if(!this->Initialize(m_decodedWidth, m_decodedHeight, m_decodedFormat, m_decodedLevels, &levels[0]))
     {
         Log() << LogLoadError(filename) << "Initialization failed.";
         return false;
     }
 
+    // Stream levels over the following frames.
+    if(uploader != nullptr)
+    {
+        for(int i = 0; i < m_decodedLevels; ++i)
+        {
+            std::size_t begin = TextureContainer::GetLevelOffset(m_decodedWidth, m_decodedHeight, i);
+            std::size_t end = TextureContainer::GetLevelOffset(m_decodedWidth, m_decodedHeight, i + 1);
+
+            int width = TextureContainer::GetLevelSize(m_width, i);
+            int height = TextureContainer::GetLevelSize(m_height, i);
+
+            TextureUploader::PixelData level(data.begin() + begin, data.begin() + end);
+
+            if(!uploader->Upload(this, glm::ivec4(0, 0, width, height), std::move(level), false, i))
+            {
+                Log() << LogLoadError(filename) << "Couldn't queue the upload.";
+                return false;
+            }
+        }
+    }
+
     // Success!
     Log() << "Loaded a texture from \"" << filename << "\" file.";
 
     return true;
 }
 
+std::size_t Texture::GetCpuMemorySize() const
+{
+    std::size_t size = m_decodedData.size();
+
+    // Include pixels held by the texture uploader.
+    TextureUploader* uploader = this->GetUploader();
+
+    if(uploader != nullptr)
+    {
+        size += uploader->GetStagingSize(this);
+    }
+
+    return size;
+}
+
+std::size_t Texture::GetGpuMemorySize() const
+{
+    std::size_t size = 0;
+
+    for(int i = 0; i < m_levelCount; ++i)
+    {
+        std::size_t levelWidth = TextureContainer::GetLevelSize(m_width, i);
+        std::size_t levelHeight = TextureContainer::GetLevelSize(m_height, i);
+
+        size += levelWidth * levelHeight * GetPixelSize(m_format);
+    }
+
+    return size;
+}
+
 bool Texture::Initialize(int width, int height, GLenum format, const void* data)
+{
+    // Allocate a single level.
+    if(!this->Initialize(width, height, format, 1, &data))
+        return false;
+
+    // Generate texture mipmap.
+    if(data != nullptr)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_handle);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_levelCount = TextureContainer::GetLevelCount(width, height);
+    }
+
+    return true;
+}
+
+bool Texture::Initialize(int width, int height, GLenum format, int levelCount, const void* const* levels)
 {
     // Setup initialization routine.
     if(m_initialized)
@@ -280,8 +587,21 @@ bool Texture::Initialize(int width, int height, GLenum format, const void* data)
         return false;
     }
 
+    if(levelCount <= 0 || levelCount > TextureContainer::GetLevelCount(width, height))
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"levelCount\" is invalid.";
+        return false;
+    }
+
+    if(levels == nullptr)
+    {
+        Log() << LogInitializeError() << "Invalid argument - \"levels\" is null.";
+        return false;
+    }
+
     m_width = width;
     m_height = height;
+    m_levelCount = levelCount;
     m_format = format;
 
     // Create a texture handle.
@@ -305,10 +625,19 @@ bool Texture::Initialize(int width, int height, GLenum format, const void* data)
     */
 
     // Allocated a texture surface on the hardware.
-    glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
+    for(int i = 0; i < levelCount; ++i)
+    {
+        int levelWidth = TextureContainer::GetLevelSize(m_width, i);
+        int levelHeight = TextureContainer::GetLevelSize(m_height, i);
 
-    // Generate texture mipmap.
-    glGenerateMipmap(GL_TEXTURE_2D);
+        glTexImage2D(GL_TEXTURE_2D, i, format, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE, levels[i]);
+    }
+
+    // Limit sampling to provided levels.
+    if(levelCount > 1)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    }
 
     // Unbind the texture.
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -322,11 +651,28 @@ void Texture::Update(const void* data)
     if(!m_initialized)
         return;
 
+    if(data == nullptr)
+        return;
+
+    // Stream new texture data through the uploader, instead of stalling
+    // on a synchronous upload of the whole image.
+    TextureUploader* uploader = this->GetUploader();
+
+    if(uploader != nullptr && uploader->Upload(this, glm::ivec4(0, 0, m_width, m_height), data))
+        return;
+
     // Upload new texture data.
-    if(data != nullptr)
-    {
-        glBindTexture(GL_TEXTURE_2D, m_handle);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, m_format, GL_UNSIGNED_BYTE, data);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
+    glBindTexture(GL_TEXTURE_2D, m_handle);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, m_format, GL_UNSIGNED_BYTE, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+TextureUploader* Texture::GetUploader() const
+{
+    System::ResourceManager* resourceManager = this->GetResourceManager();
+
+    if(resourceManager == nullptr || resourceManager->GetContext() == nullptr)
+        return nullptr;
+
+    return (*resourceManager->GetContext())[ContextTypes::Main].Get<TextureUploader>();
 }
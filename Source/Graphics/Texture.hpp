@@ -3,9 +3,33 @@
 #include "Precompiled.hpp"
 #include "System/Resource.hpp"
 
+// Forward declarations.
+namespace System
+{
+    class FileView;
+}
+
+namespace Graphics
+{
+    class TextureUploader;
+
+    namespace TextureContainer
+    {
+        struct Image;
+    }
+}
+
 //
 // Texture
 //
+//  Images are converted into texture containers with full mip chains when
+//  they are first loaded, and later loads read the containers instead.
+//
+//  Textures loaded through a resource manager stream their pixels in
+//  through the texture uploader when one is present in the main context.
+//  Their storage is allocated right away, while pixels and mipmaps are
+//  filled in over the following frames.
+//
 
 namespace Graphics
 {
@@ -22,10 +46,29 @@ namespace Graphics
         // Loads the texture from a file.
         bool Load(std::string filename);
 
+        // Decodes the image from a file.
+        // Reads a texture container, or converts an image into one.
+        bool Decode(std::string filename) override;
+
+        // Uploads the decoded image.
+        bool Upload(std::string filename) override;
+
+        // Gets the size of pixel data waiting for upload.
+        std::size_t GetCpuMemorySize() const override;
+
+        // Gets the estimated size of the texture storage, including mipmaps.
+        std::size_t GetGpuMemorySize() const override;
+
         // Initializes the texture instance.
+        // Only allocates the storage if data is null, without mipmaps.
         bool Initialize(int width, int height, GLenum format, const void* data);
 
+        // Initializes the texture instance with a chain of mip levels.
+        // Storage of levels with null data is only allocated.
+        bool Initialize(int width, int height, GLenum format, int levelCount, const void* const* levels);
+
         // Updates the texture data.
+        // Streamed by the texture uploader if there's one.
         void Update(const void* data);
 
         // Gets the texture handle.
@@ -46,12 +89,28 @@ namespace Graphics
             return m_height;
         }
 
+        // Gets the texture format.
+        GLenum GetFormat() const
+        {
+            return m_format;
+        }
+
         // Checks if instance is valid.
         bool IsValid() const
         {
             return m_initialized;
         }
 
+    private:
+        // Decodes a PNG image into the first level of an image.
+        bool DecodePNG(std::string filename, const System::FileView& file, TextureContainer::Image& image);
+
+        // Gets the texture uploader of the resource manager context.
+        TextureUploader* GetUploader() const;
+
+        // Allows the uploader to track textures with pending uploads.
+        friend class TextureUploader;
+
     private:
         // Texture handle.
         GLuint m_handle;
@@ -59,8 +118,19 @@ namespace Graphics
         // Texture parameters.
         int m_width;
         int m_height;
+        int m_levelCount;
         GLenum m_format;
 
+        // Decoded image waiting for upload.
+        std::vector<uint8_t> m_decodedData;
+        int                  m_decodedWidth;
+        int                  m_decodedHeight;
+        int                  m_decodedLevels;
+        GLenum               m_decodedFormat;
+
+        // Uploader with pending uploads of this texture.
+        TextureUploader* m_uploader;
+
         // Initialization state.
         bool m_initialized;
     };
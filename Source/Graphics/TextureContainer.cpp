@@ -0,0 +1,296 @@
+#include "Precompiled.hpp"
+#include "TextureContainer.hpp"
+#include <sys/stat.h>
+using namespace Graphics;
+
+namespace
+{
+    // Log error messages.
+    #define LogReadError(filename) "Failed to read a texture container from \"" << filename << "\" file! "
+    #define LogWriteError(filename) "Failed to write a texture container to \"" << filename << "\" file! "
+
+    // Container identification.
+    const uint32_t Magic = 0x58455450; // "PTEX"
+    const uint32_t Version = 1;
+
+    // Validate header layout, as it's read and written directly.
+    static_assert(sizeof(TextureContainer::Header) == 56, "Unexpected texture container header size.");
+}
+
+TextureContainer::Source::Source() :
+    size(0),
+    time(0)
+{
+}
+
+TextureContainer::Image::Image() :
+    width(0),
+    height(0),
+    levelCount(0)
+{
+}
+
+bool TextureContainer::GetSource(std::string filename, Source& source)
+{
+#ifdef WIN32
+    struct _stat64 info;
+
+    if(_stat64(filename.c_str(), &info) != 0)
+        return false;
+#else
+    struct stat info;
+
+    if(stat(filename.c_str(), &info) != 0)
+        return false;
+#endif
+
+    source.size = (uint64_t)info.st_size;
+    source.time = (int64_t)info.st_mtime;
+
+    return true;
+}
+
+int TextureContainer::GetLevelCount(int width, int height)
+{
+    int levelCount = 1;
+
+    while(width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levelCount += 1;
+    }
+
+    return levelCount;
+}
+
+int TextureContainer::GetLevelSize(int size, int level)
+{
+    return std::max(1, size >> level);
+}
+
+std::size_t TextureContainer::GetLevelOffset(int width, int height, int level)
+{
+    std::size_t offset = 0;
+
+    for(int i = 0; i < level; ++i)
+    {
+        offset += (std::size_t)GetLevelSize(width, i) * GetLevelSize(height, i) * PixelSize;
+    }
+
+    return offset;
+}
+
+void TextureContainer::BuildMipChain(Image& image)
+{
+    assert(image.width > 0 && image.height > 0);
+    assert(image.levelCount >= 1);
+
+    int levelCount = GetLevelCount(image.width, image.height);
+
+    if(image.levelCount >= levelCount)
+        return;
+
+    // Allocate missing levels.
+    image.data.resize(GetLevelOffset(image.width, image.height, levelCount));
+
+    // Average 2x2 blocks of each previous level.
+    // Edges of odd sized levels are clamped.
+    for(int level = image.levelCount; level < levelCount; ++level)
+    {
+        int sourceWidth = GetLevelSize(image.width, level - 1);
+        int sourceHeight = GetLevelSize(image.height, level - 1);
+        int width = GetLevelSize(image.width, level);
+        int height = GetLevelSize(image.height, level);
+
+        const uint8_t* source = &image.data[GetLevelOffset(image.width, image.height, level - 1)];
+        uint8_t* destination = &image.data[GetLevelOffset(image.width, image.height, level)];
+
+        for(int y = 0; y < height; ++y)
+        {
+            int y0 = std::min(y * 2, sourceHeight - 1);
+            int y1 = std::min(y * 2 + 1, sourceHeight - 1);
+
+            for(int x = 0; x < width; ++x)
+            {
+                int x0 = std::min(x * 2, sourceWidth - 1);
+                int x1 = std::min(x * 2 + 1, sourceWidth - 1);
+
+                const uint8_t* p00 = source + (y0 * sourceWidth + x0) * PixelSize;
+                const uint8_t* p01 = source + (y0 * sourceWidth + x1) * PixelSize;
+                const uint8_t* p10 = source + (y1 * sourceWidth + x0) * PixelSize;
+                const uint8_t* p11 = source + (y1 * sourceWidth + x1) * PixelSize;
+
+                uint8_t* pixel = destination + (y * width + x) * PixelSize;
+
+                for(int c = 0; c < PixelSize; ++c)
+                {
+                    pixel[c] = (uint8_t)((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    image.levelCount = levelCount;
+}
+
+bool TextureContainer::Read(std::string filename, const uint8_t* data, std::size_t size, Image& image, const Source* source)
+{
+    // Read and validate the header.
+    Header header;
+
+    if(data == nullptr || size < sizeof(Header))
+    {
+        Log() << LogReadError(filename) << "Couldn't read the header.";
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(Header));
+
+    data += sizeof(Header);
+    size -= sizeof(Header);
+
+    if(header.magic != Magic || header.version != Version)
+    {
+        Log() << LogReadError(filename) << "Unsupported file format or version.";
+        return false;
+    }
+
+    if(source != nullptr)
+    {
+        // Stale containers are silently rebuilt from their sources.
+        if(header.sourceSize != source->size || header.sourceTime != source->time)
+            return false;
+    }
+
+    if(header.width == 0 || header.height == 0 || header.levelCount == 0 ||
+        (int)header.levelCount > GetLevelCount(header.width, header.height))
+    {
+        Log() << LogReadError(filename) << "Invalid image dimensions.";
+        return false;
+    }
+
+    if(header.rawSize != GetLevelOffset(header.width, header.height, header.levelCount))
+    {
+        Log() << LogReadError(filename) << "Invalid image data size.";
+        return false;
+    }
+
+    if(header.dataSize > size)
+    {
+        Log() << LogReadError(filename) << "Couldn't read image data.";
+        return false;
+    }
+
+    // Read level data.
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.levelCount = (int)header.levelCount;
+    image.data.resize((std::size_t)header.rawSize);
+
+    switch(header.compression)
+    {
+    case Compression::None:
+        {
+            // Copy straight into the image.
+            if(header.dataSize != header.rawSize)
+            {
+                Log() << LogReadError(filename) << "Couldn't read image data.";
+                return false;
+            }
+
+            std::memcpy(&image.data[0], data, (std::size_t)header.dataSize);
+        }
+        break;
+
+    case Compression::ZLib:
+        {
+            uLongf rawSize = (uLongf)header.rawSize;
+
+            if(uncompress(&image.data[0], &rawSize, data, (uLong)header.dataSize) != Z_OK || rawSize != header.rawSize)
+            {
+                Log() << LogReadError(filename) << "Couldn't decompress image data.";
+                return false;
+            }
+        }
+        break;
+
+    default:
+        Log() << LogReadError(filename) << "Unsupported compression type.";
+        return false;
+    }
+
+    return true;
+}
+
+bool TextureContainer::Write(std::string filename, const Image& image, const Source& source, Compression::Type compression)
+{
+    // Validate arguments.
+    if(image.width <= 0 || image.height <= 0 || image.levelCount <= 0)
+    {
+        Log() << LogWriteError(filename) << "Invalid argument - \"image\" is invalid.";
+        return false;
+    }
+
+    std::size_t rawSize = GetLevelOffset(image.width, image.height, image.levelCount);
+
+    if(image.data.size() != rawSize)
+    {
+        Log() << LogWriteError(filename) << "Invalid argument - \"image\" has invalid data size.";
+        return false;
+    }
+
+    // Compress level data.
+    std::vector<uint8_t> compressed;
+
+    const uint8_t* data = &image.data[0];
+    std::size_t dataSize = rawSize;
+
+    if(compression == Compression::ZLib)
+    {
+        uLongf size = compressBound((uLong)rawSize);
+        compressed.resize(size);
+
+        if(compress2(&compressed[0], &size, data, (uLong)rawSize, Z_BEST_COMPRESSION) != Z_OK)
+        {
+            Log() << LogWriteError(filename) << "Couldn't compress image data.";
+            return false;
+        }
+
+        data = &compressed[0];
+        dataSize = size;
+    }
+
+    // Fill the header.
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.levelCount = (uint32_t)image.levelCount;
+    header.compression = (uint32_t)compression;
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    header.rawSize = rawSize;
+    header.dataSize = dataSize;
+
+    // Write the file.
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+    if(!file.is_open())
+    {
+        Log() << LogWriteError(filename) << "Couldn't open the file.";
+        return false;
+    }
+
+    file.write((const char*)&header, sizeof(Header));
+    file.write((const char*)data, dataSize);
+
+    if(!file)
+    {
+        Log() << LogWriteError(filename) << "Couldn't write the file.";
+        return false;
+    }
+
+    return true;
+}
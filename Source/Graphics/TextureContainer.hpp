@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Texture Container
+//
+//  Raw format for textures that are ready to be handed to the GPU. Images
+//  are stored as RGBA8 with a complete chain of mip levels built on the CPU,
+//  optionally compressed with zlib. Loading takes a copy of the level data
+//  out of the file, without any decoding or conversion.
+//
+//  Containers converted from source images keep the size and modification
+//  time of their source, so they can be rebuilt when the source changes.
+//
+//  Converting a decoded image:
+//      Graphics::TextureContainer::Image image;
+//      image.width = width;
+//      image.height = height;
+//      image.levelCount = 1;
+//      image.data.assign(pixels, pixels + width * height * 4);
+//
+//      Graphics::TextureContainer::BuildMipChain(image);
+//      Graphics::TextureContainer::Write("Data/Texture.texture", image, source);
+//
+
+namespace Graphics
+{
+    namespace TextureContainer
+    {
+        // Compression types.
+        struct Compression
+        {
+            enum Type
+            {
+                None,
+                ZLib,
+            };
+        };
+
+        // Container header.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t levelCount;
+            uint32_t compression;
+            uint64_t sourceSize;
+            int64_t  sourceTime;
+            uint64_t rawSize;
+            uint64_t dataSize;
+        };
+
+        // Source file description.
+        struct Source
+        {
+            Source();
+
+            uint64_t size;
+            int64_t  time;
+        };
+
+        // Image with a chain of RGBA8 levels.
+        //  Levels are stored one after another, starting with the largest.
+        struct Image
+        {
+            Image();
+
+            int                  width;
+            int                  height;
+            int                  levelCount;
+            std::vector<uint8_t> data;
+        };
+
+        // Constant variables.
+        const int PixelSize = 4;
+
+        // Gets the size and modification time of a source file.
+        bool GetSource(std::string filename, Source& source);
+
+        // Gets the number of levels in a full mip chain.
+        int GetLevelCount(int width, int height);
+
+        // Gets the width or height of a level.
+        int GetLevelSize(int size, int level);
+
+        // Gets the offset of a level in image data.
+        std::size_t GetLevelOffset(int width, int height, int level);
+
+        // Builds missing levels of the mip chain with a box filter.
+        void BuildMipChain(Image& image);
+
+        // Reads a container from file data.
+        // Fails if the source doesn't match, unless it's null.
+        bool Read(std::string filename, const uint8_t* data, std::size_t size, Image& image, const Source* source = nullptr);
+
+        // Writes a container file.
+        bool Write(std::string filename, const Image& image, const Source& source, Compression::Type compression = Compression::None);
+    }
+}
@@ -0,0 +1,487 @@
+#include "Precompiled.hpp"
+#include "TextureUploader.hpp"
+#include "Texture.hpp"
+#include "TextureContainer.hpp"
+#include "System/Config.hpp"
+using namespace Graphics;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the texture uploader! "
+    #define LogUploadError() "Failed to queue a texture upload! "
+
+    // Invalid types.
+    const GLuint InvalidHandle = 0;
+
+    // Default byte budget of one update.
+    const int DefaultBudget = 1024 * 1024;
+
+    // Gets the size of a pixel in bytes.
+    int GetPixelSize(GLenum format)
+    {
+        switch(format)
+        {
+        case GL_R:
+        case GL_RED:
+            return 1;
+
+        case GL_RG:
+            return 2;
+
+        case GL_RGB:
+            return 3;
+
+        case GL_RGBA:
+            return 4;
+        }
+
+        return 0;
+    }
+}
+
+TextureUploader::StagingBuffer::StagingBuffer() :
+    handle(InvalidHandle),
+    fence(nullptr)
+{
+}
+
+TextureUploader::TextureUploader() :
+    m_bufferSize(DefaultBudget),
+    m_nextBuffer(0),
+    m_budget(DefaultBudget),
+    m_initialized(false)
+{
+}
+
+TextureUploader::~TextureUploader()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void TextureUploader::Cleanup()
+{
+    // Drop queued uploads.
+    for(auto& request : m_requests)
+    {
+        request.texture->m_uploader = nullptr;
+    }
+
+    Utility::ClearContainer(m_requests);
+
+    Utility::ClearContainer(m_bands);
+
+    // Destroy staging buffers.
+    for(auto& buffer : m_buffers)
+    {
+        if(buffer.fence != nullptr)
+        {
+            glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
+        }
+
+        if(buffer.handle != InvalidHandle)
+        {
+            glDeleteBuffers(1, &buffer.handle);
+            buffer.handle = InvalidHandle;
+        }
+    }
+
+    m_bufferSize = DefaultBudget;
+    m_nextBuffer = 0;
+
+    // Reset the byte budget.
+    m_budget = DefaultBudget;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool TextureUploader::Initialize(Context& context)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Add instance to the context.
+    if(context[ContextTypes::Main].Has<TextureUploader>())
+    {
+        Log() << LogInitializeError() << "Context is invalid.";
+        return false;
+    }
+
+    context[ContextTypes::Main].Set(this);
+
+    // Read config settings.
+    System::Config* config = context[ContextTypes::Main].Get<System::Config>();
+
+    if(config != nullptr)
+    {
+        // Budget is set in kilobytes.
+        int budget = config->Get<int>("Graphics.TextureUploadBudget", DefaultBudget / 1024);
+        this->SetBudget(budget * 1024);
+    }
+
+    // Staging buffers hold one update worth of data.
+    m_bufferSize = m_budget;
+
+    // Create staging buffers.
+    for(auto& buffer : m_buffers)
+    {
+        glGenBuffers(1, &buffer.handle);
+
+        if(buffer.handle == InvalidHandle)
+        {
+            Log() << LogInitializeError() << "Couldn't create a staging buffer.";
+            return false;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.handle);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Success!
+    return m_initialized = true;
+}
+
+bool TextureUploader::Upload(Texture* texture, const glm::ivec4& region, const void* data, bool generateMipmap, int level)
+{
+    if(data == nullptr)
+    {
+        Log() << LogUploadError() << "Invalid argument - \"data\" is null.";
+        return false;
+    }
+
+    if(texture == nullptr)
+    {
+        Log() << LogUploadError() << "Invalid argument - \"texture\" is null.";
+        return false;
+    }
+
+    // Copy the pixel data, as the upload outlives the call.
+    std::size_t size = (std::size_t)std::max(0, region.z * region.w) * GetPixelSize(texture->GetFormat());
+
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(data);
+
+    return this->Upload(texture, region, PixelData(pixels, pixels + size), generateMipmap, level);
+}
+
+bool TextureUploader::Upload(Texture* texture, const glm::ivec4& region, PixelData&& data, bool generateMipmap, int level)
+{
+    if(!m_initialized)
+        return false;
+
+    // Validate arguments.
+    if(texture == nullptr || !texture->IsValid())
+    {
+        Log() << LogUploadError() << "Invalid argument - \"texture\" is invalid.";
+        return false;
+    }
+
+    if(level < 0 || level >= TextureContainer::GetLevelCount(texture->GetWidth(), texture->GetHeight()))
+    {
+        Log() << LogUploadError() << "Invalid argument - \"level\" is invalid.";
+        return false;
+    }
+
+    int levelWidth = TextureContainer::GetLevelSize(texture->GetWidth(), level);
+    int levelHeight = TextureContainer::GetLevelSize(texture->GetHeight(), level);
+
+    if(region.x < 0 || region.y < 0 || region.z <= 0 || region.w <= 0 ||
+        region.x + region.z > levelWidth || region.y + region.w > levelHeight)
+    {
+        Log() << LogUploadError() << "Invalid argument - \"region\" is out of bounds.";
+        return false;
+    }
+
+    int pixelSize = GetPixelSize(texture->GetFormat());
+
+    if(pixelSize == 0)
+    {
+        Log() << LogUploadError() << "Unsupported texture format.";
+        return false;
+    }
+
+    if(data.size() != (std::size_t)region.z * region.w * pixelSize)
+    {
+        Log() << LogUploadError() << "Invalid argument - \"data\" has invalid size.";
+        return false;
+    }
+
+    // Queue the upload.
+    UploadRequest request;
+    request.texture = texture;
+    request.region = region;
+    request.data = std::move(data);
+    request.level = level;
+    request.rowSize = region.z * pixelSize;
+    request.uploadedRows = 0;
+    request.generateMipmap = generateMipmap;
+
+    m_requests.push_back(std::move(request));
+
+    // Let the texture cancel its uploads.
+    texture->m_uploader = this;
+
+    return true;
+}
+
+void TextureUploader::Update()
+{
+    if(!m_initialized)
+        return;
+
+    if(m_requests.empty())
+        return;
+
+    // Rows are copied tightly packed.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    std::size_t budget = m_budget;
+
+    while(!m_requests.empty() && budget > 0)
+    {
+        StagingBuffer& buffer = m_buffers[m_nextBuffer];
+
+        // Skip the rest of the frame if the next buffer is still in use.
+        if(buffer.fence != nullptr)
+        {
+            GLenum result = glClientWaitSync(buffer.fence, 0, 0);
+
+            if(result == GL_TIMEOUT_EXPIRED)
+                break;
+
+            glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
+        }
+
+        // Upload requests with rows larger than a staging buffer directly.
+        UploadRequest& front = m_requests.front();
+
+        if((std::size_t)front.rowSize > m_bufferSize)
+        {
+            budget -= std::min(budget, front.data.size());
+
+            this->UploadDirect(front);
+            this->FinishRequest(front);
+            this->PopRequest();
+            continue;
+        }
+
+        // Split requests into bands of rows that fit into the buffer.
+        // At least one row is uploaded, even if it exceeds the budget.
+        std::size_t space = std::min(budget, m_bufferSize);
+        space = std::max(space, (std::size_t)front.rowSize);
+        std::size_t offset = 0;
+
+        for(std::size_t i = 0; i < m_requests.size(); ++i)
+        {
+            const UploadRequest& request = m_requests[i];
+
+            int remainingRows = request.region.w - request.uploadedRows;
+            int rowCount = std::min(remainingRows, (int)((space - offset) / request.rowSize));
+
+            if(rowCount <= 0)
+                break;
+
+            UploadBand band;
+            band.request = i;
+            band.firstRow = request.uploadedRows;
+            band.rowCount = rowCount;
+            band.offset = offset;
+
+            m_bands.push_back(band);
+
+            offset += (std::size_t)rowCount * request.rowSize;
+
+            if(rowCount < remainingRows)
+                break;
+        }
+
+        if(m_bands.empty())
+            break;
+
+        // Copy bands into the staging buffer.
+        // Invalidation lets the driver hand out fresh memory instead of waiting.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.handle);
+
+        void* memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, offset, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if(memory == nullptr)
+        {
+            Log() << "Couldn't map a texture staging buffer!";
+
+            m_bands.clear();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            break;
+        }
+
+        for(const auto& band : m_bands)
+        {
+            const UploadRequest& request = m_requests[band.request];
+
+            std::size_t source = (std::size_t)band.firstRow * request.rowSize;
+            std::size_t size = (std::size_t)band.rowCount * request.rowSize;
+
+            std::memcpy((uint8_t*)memory + band.offset, &request.data[source], size);
+        }
+
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Transfer bands from the staging buffer.
+        for(const auto& band : m_bands)
+        {
+            UploadRequest& request = m_requests[band.request];
+
+            glBindTexture(GL_TEXTURE_2D, request.texture->GetHandle());
+
+            glTexSubImage2D(GL_TEXTURE_2D, request.level,
+                request.region.x, request.region.y + band.firstRow,
+                request.region.z, band.rowCount,
+                request.texture->GetFormat(), GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(band.offset));
+
+            request.uploadedRows += band.rowCount;
+
+            if(request.uploadedRows == request.region.w)
+            {
+                this->FinishRequest(request);
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        // Fence the transfers before the buffer is reused.
+        buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_nextBuffer = (m_nextBuffer + 1) % BufferCount;
+
+        // Remove finished requests.
+        while(!m_requests.empty() && m_requests.front().uploadedRows == m_requests.front().region.w)
+        {
+            this->PopRequest();
+        }
+
+        m_bands.clear();
+
+        budget -= std::min(budget, offset);
+    }
+
+    // Restore the default row alignment.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureUploader::UploadDirect(UploadRequest& request)
+{
+    assert(request.uploadedRows == 0);
+
+    glBindTexture(GL_TEXTURE_2D, request.texture->GetHandle());
+
+    glTexSubImage2D(GL_TEXTURE_2D, request.level,
+        request.region.x, request.region.y,
+        request.region.z, request.region.w,
+        request.texture->GetFormat(), GL_UNSIGNED_BYTE, &request.data[0]);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    request.uploadedRows = request.region.w;
+}
+
+void TextureUploader::FinishRequest(UploadRequest& request)
+{
+    assert(request.uploadedRows == request.region.w);
+
+    // Generate mipmaps from the complete image.
+    if(request.generateMipmap)
+    {
+        glBindTexture(GL_TEXTURE_2D, request.texture->GetHandle());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    // Release pixel data early.
+    Utility::ClearContainer(request.data);
+}
+
+void TextureUploader::PopRequest()
+{
+    assert(!m_requests.empty());
+
+    Texture* texture = m_requests.front().texture;
+    m_requests.pop_front();
+
+    // Detach the texture after its last upload.
+    // Requests finished in the same update are popped one by one,
+    // so the texture is only detached when the last one is gone.
+    auto it = std::find_if(m_requests.begin(), m_requests.end(), [texture](const UploadRequest& other)
+    {
+        return other.texture == texture;
+    });
+
+    if(it == m_requests.end())
+    {
+        texture->m_uploader = nullptr;
+    }
+}
+
+void TextureUploader::Cancel(const Texture* texture)
+{
+    // Remove queued uploads of the texture.
+    auto it = std::remove_if(m_requests.begin(), m_requests.end(), [texture](const UploadRequest& request)
+    {
+        return request.texture == texture;
+    });
+
+    m_requests.erase(it, m_requests.end());
+}
+
+void TextureUploader::SetBudget(int bytes)
+{
+    m_budget = (std::size_t)std::max(1, bytes);
+}
+
+bool TextureUploader::IsPending(const Texture* texture) const
+{
+    for(const auto& request : m_requests)
+    {
+        if(request.texture == texture)
+            return true;
+    }
+
+    return false;
+}
+
+std::size_t TextureUploader::GetPendingBytes() const
+{
+    std::size_t bytes = 0;
+
+    for(const auto& request : m_requests)
+    {
+        bytes += (std::size_t)(request.region.w - request.uploadedRows) * request.rowSize;
+    }
+
+    return bytes;
+}
+
+std::size_t TextureUploader::GetStagingSize(const Texture* texture) const
+{
+    std::size_t size = 0;
+
+    for(const auto& request : m_requests)
+    {
+        if(request.texture == texture)
+        {
+            size += request.data.capacity();
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+// Forward declarations.
+namespace Graphics
+{
+    class Texture;
+}
+
+//
+// Texture Uploader
+//
+//  Streams pixel data into textures through a ring of pixel buffer objects.
+//  Queued uploads are copied into staging buffers in bands of rows, up to
+//  a byte budget per update, so large textures are spread over frames.
+//  Staging buffers are reused only after fences of their transfers have
+//  signaled, and the uploader skips a frame rather than waiting for one.
+//
+//  Streaming a region of an atlas:
+//      glm::ivec4 region(x, y, width, height);
+//      textureUploader->Upload(texture, region, pixels);
+//
+
+namespace Graphics
+{
+    // Texture uploader class.
+    class TextureUploader
+    {
+    public:
+        // Type declarations.
+        typedef std::vector<uint8_t> PixelData;
+
+        // Constant variables.
+        static const int BufferCount = 3;
+
+    public:
+        TextureUploader();
+        ~TextureUploader();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the texture uploader.
+        bool Initialize(Context& context);
+
+        // Queues an upload of a texture region.
+        // Region is a [x, y, width, height] vector with tightly packed pixels.
+        // Mipmaps are generated after the last row has been uploaded.
+        bool Upload(Texture* texture, const glm::ivec4& region, const void* data, bool generateMipmap = false, int level = 0);
+        bool Upload(Texture* texture, const glm::ivec4& region, PixelData&& data, bool generateMipmap = false, int level = 0);
+
+        // Streams queued uploads within the byte budget.
+        void Update();
+
+        // Cancels pending uploads of a texture.
+        void Cancel(const Texture* texture);
+
+        // Sets the byte budget of one update.
+        void SetBudget(int bytes);
+
+        // Checks if a texture has pending uploads.
+        bool IsPending(const Texture* texture) const;
+
+        // Gets the number of bytes waiting for upload.
+        std::size_t GetPendingBytes() const;
+
+        // Gets the size of pixel data held for uploads of a texture.
+        std::size_t GetStagingSize(const Texture* texture) const;
+
+    private:
+        // Staging buffer.
+        struct StagingBuffer
+        {
+            StagingBuffer();
+
+            GLuint handle;
+            GLsync fence;
+        };
+
+        // Upload request.
+        struct UploadRequest
+        {
+            Texture*   texture;
+            glm::ivec4 region;
+            PixelData  data;
+            int        level;
+            int        rowSize;
+            int        uploadedRows;
+            bool       generateMipmap;
+        };
+
+        // Band of rows copied into a staging buffer.
+        struct UploadBand
+        {
+            std::size_t request;
+            int         firstRow;
+            int         rowCount;
+            std::size_t offset;
+        };
+
+        typedef std::deque<UploadRequest> RequestQueue;
+        typedef std::vector<UploadBand>   BandList;
+
+    private:
+        // Uploads a request that doesn't fit into a staging buffer.
+        void UploadDirect(UploadRequest& request);
+
+        // Finishes an uploaded request.
+        void FinishRequest(UploadRequest& request);
+
+        // Removes the front request, which has to be finished.
+        // Detaches its texture if no other uploads refer to it.
+        void PopRequest();
+
+    private:
+        // Staging buffers.
+        StagingBuffer m_buffers[BufferCount];
+        std::size_t   m_bufferSize;
+        int           m_nextBuffer;
+
+        // Queued uploads.
+        RequestQueue m_requests;
+        BandList     m_bands;
+
+        // Byte budget of one update.
+        std::size_t m_budget;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
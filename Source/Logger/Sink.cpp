@@ -38,6 +38,8 @@ void Sink::RemoveOutput(Logger::Output* output)
 
 void Sink::Write(const Logger::Message& message)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     for(auto output : m_outputs)
     {
         output->Write(message);
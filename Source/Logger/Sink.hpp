@@ -45,5 +45,8 @@ namespace Logger
     private:
         // List of outputs.
         OutputList m_outputs;
+
+        // Serializes writes from multiple threads.
+        std::mutex m_mutex;
     };
 }
@@ -0,0 +1,304 @@
+#include "Precompiled.hpp"
+#include "Loader.hpp"
+#include "System/MappedFile.hpp"
+#include "System/BakedFile.hpp"
+
+#include <sys/stat.h>
+
+using namespace Lua;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize a Lua loader! "
+    #define LogRunError(name) "Failed to run \"" << name << "\" script! "
+
+    // Directory of cached bytecode, in the working directory.
+    const char* CacheDirectory = "Cache/";
+
+    // Baked file type of cached bytecode.
+    const uint32_t BytecodeType = 0x4342554C; // "LUBC"
+
+    // Globals visible to sandboxed scripts.
+    const char* SandboxGlobals[] =
+    {
+        "assert", "error", "ipairs", "next", "pairs", "pcall", "select",
+        "tonumber", "tostring", "type", "unpack", "xpcall",
+    };
+
+    // Libraries visible to sandboxed scripts.
+    // Scripts get read-only proxies, as library tables are shared by all of them.
+    const char* SandboxLibraries[] =
+    {
+        "math", "string", "table",
+    };
+
+    // Libraries opened in loader states.
+    const lua_CFunction Libraries[] =
+    {
+        luaopen_base, luaopen_table, luaopen_string, luaopen_math,
+    };
+
+    // Bytecode cached in memory, shared by loaders of all threads.
+    // The lock also serializes access to the cache directory.
+    std::mutex CacheLock;
+    std::unordered_map<uint64_t, std::string> CachedBytecode;
+
+    // Appends dumped bytecode to a string.
+    int WriteBytecode(lua_State*, const void* data, std::size_t size, void* output)
+    {
+        ((std::string*)output)->append((const char*)data, size);
+        return 0;
+    }
+
+    // Raises an error on writes to a read-only table.
+    int WriteReadOnly(lua_State* state)
+    {
+        return luaL_error(state, "attempt to modify a read-only table");
+    }
+
+    // Gets the path of cached bytecode.
+    std::string GetCachePath(uint64_t hash)
+    {
+        std::ostringstream path;
+        path << Build::GetWorkingDir() << CacheDirectory;
+        path << std::hex << std::setw(16) << std::setfill('0') << hash << ".luac";
+        return path.str();
+    }
+
+    // Creates the cache directory, if it doesn't exist.
+    void CreateCacheDirectory()
+    {
+        std::string path = Build::GetWorkingDir() + CacheDirectory;
+
+#ifdef WIN32
+        CreateDirectoryA(path.c_str(), nullptr);
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+}
+
+Loader& Loader::GetThreadLoader()
+{
+    thread_local Loader loader;
+    return loader;
+}
+
+Loader::Loader() :
+    m_state(nullptr),
+    m_environment(LUA_NOREF),
+    m_initialized(false)
+{
+}
+
+Loader::~Loader()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void Loader::Cleanup()
+{
+    // Cleanup Lua state.
+    if(m_state != nullptr)
+    {
+        lua_close(m_state);
+        m_state = nullptr;
+    }
+
+    m_environment = LUA_NOREF;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool Loader::Initialize()
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD_IF(!m_initialized,
+        this->Cleanup());
+
+    // Create Lua state.
+    m_state = luaL_newstate();
+
+    if(m_state == nullptr)
+    {
+        Log() << LogInitializeError() << "Couldn't create Lua state.";
+        return false;
+    }
+
+    // Open safe libraries.
+    for(lua_CFunction library : Libraries)
+    {
+        lua_pushcfunction(m_state, library);
+        lua_call(m_state, 0, 0);
+    }
+
+    // Create the environment metatable, which looks up
+    // missing globals in a table of sandboxed ones.
+    lua_newtable(m_state);
+    lua_newtable(m_state);
+
+    for(const char* name : SandboxGlobals)
+    {
+        lua_getglobal(m_state, name);
+        lua_setfield(m_state, -2, name);
+    }
+
+    // Expose libraries through empty proxy tables, which read from
+    // the library and refuse writes, so scripts can't alter them.
+    for(const char* name : SandboxLibraries)
+    {
+        lua_newtable(m_state);
+        lua_newtable(m_state);
+
+        lua_getglobal(m_state, name);
+        lua_setfield(m_state, -2, "__index");
+
+        lua_pushcfunction(m_state, WriteReadOnly);
+        lua_setfield(m_state, -2, "__newindex");
+
+        lua_pushboolean(m_state, 0);
+        lua_setfield(m_state, -2, "__metatable");
+
+        lua_setmetatable(m_state, -2);
+        lua_setfield(m_state, -2, name);
+    }
+
+    lua_setfield(m_state, -2, "__index");
+
+    m_environment = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+    // Success!
+    return m_initialized = true;
+}
+
+bool Loader::Run(std::string name, const void* data, std::size_t size)
+{
+    // Initialize if needed.
+    if(!m_initialized)
+    {
+        if(!this->Initialize())
+            return false;
+    }
+
+    // Clear leftovers of the previous script.
+    this->Reset();
+
+    // Load the script chunk.
+    if(!this->LoadChunk(name, data, size))
+        return false;
+
+    // Run the script in a fresh environment.
+    lua_newtable(m_state);
+    lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_environment);
+    lua_setmetatable(m_state, -2);
+
+    lua_pushvalue(m_state, -1);
+    lua_setfenv(m_state, -3);
+    lua_insert(m_state, -2);
+
+    if(lua_pcall(m_state, 0, 0, 0) != 0)
+    {
+        Log() << "Lua Error: " << lua_tostring(m_state, -1);
+        this->Reset();
+        return false;
+    }
+
+    return true;
+}
+
+bool Loader::LoadChunk(std::string name, const void* data, std::size_t size)
+{
+    // Don't accept precompiled scripts from data files,
+    // as bytecode isn't verified by the virtual machine.
+    if(size != 0 && ((const char*)data)[0] == LUA_SIGNATURE[0])
+    {
+        Log() << LogRunError(name) << "Precompiled scripts are not allowed.";
+        return false;
+    }
+
+    // Chunk name is prefixed the same way as with files.
+    std::string chunkName = "@" + name;
+
+    // Find cached bytecode of the same content.
+    uint64_t hash = System::BakedFile::Hash(data, size);
+    std::string cachePath = GetCachePath(hash);
+    std::string bytecode;
+
+    {
+        std::lock_guard<std::mutex> lock(CacheLock);
+
+        auto it = CachedBytecode.find(hash);
+
+        if(it != CachedBytecode.end())
+        {
+            bytecode = it->second;
+        }
+        else
+        {
+            System::MappedFile file;
+            System::BakedReader reader;
+
+            if(file.Open(cachePath) && reader.Open(cachePath, file.GetData(), file.GetSize(), BytecodeType, &hash) && reader.Read(bytecode))
+            {
+                CachedBytecode.emplace(hash, bytecode);
+            }
+        }
+    }
+
+    if(!bytecode.empty())
+    {
+        if(luaL_loadbuffer(m_state, bytecode.data(), bytecode.size(), chunkName.c_str()) == 0)
+            return true;
+
+        // Bytecode of a different LuaJIT build, compile the source again.
+        lua_pop(m_state, 1);
+    }
+
+    // Compile the script.
+    if(luaL_loadbuffer(m_state, (const char*)data, size, chunkName.c_str()) != 0)
+    {
+        Log() << "Lua Error: " << lua_tostring(m_state, -1);
+        lua_pop(m_state, 1);
+        return false;
+    }
+
+    // Cache compiled bytecode.
+    bytecode.clear();
+
+    if(lua_dump(m_state, WriteBytecode, &bytecode) == 0 && !bytecode.empty())
+    {
+        std::lock_guard<std::mutex> lock(CacheLock);
+
+        CachedBytecode[hash] = bytecode;
+
+        CreateCacheDirectory();
+
+        System::BakedWriter writer(BytecodeType);
+        writer.Write(bytecode);
+        writer.Save(cachePath, hash);
+    }
+
+    return true;
+}
+
+void Loader::Reset()
+{
+    if(!m_initialized)
+        return;
+
+    // Drop the stack and collect garbage
+    // of previous scripts in small steps.
+    lua_settop(m_state, 0);
+    lua_gc(m_state, LUA_GCSTEP, 0);
+}
+
+Loader::operator lua_State*()
+{
+    return m_state;
+}
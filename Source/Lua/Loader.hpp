@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Loader
+//
+//  Lua state for running data scripts of resource loaders. Every thread
+//  gets its own loader, which is kept alive and reset between files instead
+//  of creating a new virtual machine for each of them.
+//
+//  Scripts run in a sandbox - each one gets a fresh environment table with
+//  read-only access to a small set of safe libraries, so globals don't leak
+//  between files and scripts can't touch the file system.
+//
+//  Compiled bytecode is cached by the hash of script content, in memory and
+//  in the cache directory, so scripts only have to be parsed once.
+//
+//  Running a script:
+//      Lua::Loader& lua = Lua::Loader::GetThreadLoader();
+//      SCOPE_GUARD(lua.Reset());
+//      if(lua.Run(filename, file.GetData(), file.GetSize()))
+//      {
+//          lua_getfield(lua, -1, "Table");
+//      }
+//
+
+namespace Lua
+{
+    // Loader class.
+    class Loader : private NonCopyable
+    {
+    public:
+        // Gets the loader of the calling thread.
+        static Loader& GetThreadLoader();
+
+    public:
+        Loader();
+        ~Loader();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the loader state.
+        bool Initialize();
+
+        // Runs a script from memory.
+        // Leaves the environment table with globals of the script on the stack.
+        bool Run(std::string name, const void* data, std::size_t size);
+
+        // Resets the stack after a script has been read.
+        void Reset();
+
+        // Conversion operator.
+        operator lua_State*();
+
+    private:
+        // Loads a compiled script chunk on the stack.
+        bool LoadChunk(std::string name, const void* data, std::size_t size);
+
+    private:
+        // Lua state.
+        lua_State* m_state;
+
+        // Registry reference to the environment metatable.
+        int m_environment;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
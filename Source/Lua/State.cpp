@@ -63,6 +63,29 @@ bool State::Load(std::string filename)
     return true;
 }
 
+bool State::Load(std::string name, const void* data, std::size_t size)
+{
+    // Initialize if needed.
+    if(!m_initialized)
+    {
+        if(!this->Initialize())
+            return false;
+    }
+
+    // Parse the script.
+    // Chunk name is prefixed the same way as with files.
+    std::string chunkName = "@" + name;
+
+    if(luaL_loadbuffer(m_state, (const char*)data, size, chunkName.c_str()) != 0 || lua_pcall(m_state, 0, LUA_MULTRET, 0) != 0)
+    {
+        Log() << "Lua Error: " << lua_tostring(m_state, -1);
+        lua_pop(m_state, 1);
+        return false;
+    }
+
+    return true;
+}
+
 State::operator lua_State*()
 {
     return m_state;
@@ -23,6 +23,10 @@ namespace Lua
 
         // Loads a script file.
         bool Load(std::string filename);
+
+        // Loads a script from memory.
+        // Name identifies the script in error messages.
+        bool Load(std::string name, const void* data, std::size_t size);
         
         // Conversion operator.
         operator lua_State*();
@@ -1,9 +1,12 @@
 #include "Precompiled.hpp"
 #include "System/Config.hpp"
 #include "System/Timer.hpp"
+#include "System/FileSystem.hpp"
+#include "System/JobPool.hpp"
 #include "System/Window.hpp"
 #include "System/InputState.hpp"
 #include "System/ResourceManager.hpp"
+#include "Graphics/TextureUploader.hpp"
 #include "Graphics/BasicRenderer.hpp"
 #include "Game/EntitySystem.hpp"
 #include "Game/ComponentSystem.hpp"
@@ -11,10 +14,14 @@
 #include "Game/Components/Script.hpp"
 #include "Game/Components/Animation.hpp"
 #include "Game/Components/Render.hpp"
+#include "Game/Components/Camera.hpp"
 #include "Game/IdentitySystem.hpp"
+#include "Game/VisibilitySystem.hpp"
 #include "Game/ScriptSystem.hpp"
 #include "Game/Scripts/Player.hpp"
 #include "Game/AnimationSystem.hpp"
+#include "Game/ParticleSystem.hpp"
+#include "Game/LightSystem.hpp"
 #include "Game/RenderSystem.hpp"
 
 #include "Graphics/Texture.hpp"
@@ -47,6 +54,18 @@ int main(int argc, char* argv[])
 
     context[ContextTypes::Main].Set(&timer);
 
+    // Initialize the file system.
+    System::FileSystem fileSystem;
+    if(!fileSystem.Initialize(context))
+        return -1;
+
+    // Initialize the job pool.
+    System::JobPool jobPool;
+    if(!jobPool.Initialize(config.Get<int>("System.WorkerThreads", -1)))
+        return -1;
+
+    context[ContextTypes::Main].Set(&jobPool);
+
     // Initialize the window.
     int windowWidth = config.Get<int>("Graphics.Width", 800);
     int windowHeight = config.Get<int>("Graphics.Height", 600);
@@ -65,11 +84,22 @@ int main(int argc, char* argv[])
 
     context[ContextTypes::Main].Set(&inputState);
 
+    // Initialize the texture uploader.
+    // Has to outlive textures held by the resource manager.
+    Graphics::TextureUploader textureUploader;
+    if(!textureUploader.Initialize(context))
+        return -1;
+
     // Initialize the resource manager.
     System::ResourceManager resourceManager;
     if(!resourceManager.Initialize(context))
         return -1;
 
+    // Textures get a separate cache budget (in kilobytes),
+    // as they take most of the memory.
+    int textureCacheBudget = config.Get<int>("Graphics.TextureCacheBudget", 128 * 1024);
+    resourceManager.SetBudget<Graphics::Texture>((std::size_t)std::max(0, textureCacheBudget) * 1024);
+
     // Initialize the basic renderer.
     Graphics::BasicRenderer basicRenderer;
     if(!basicRenderer.Initialize(context))
@@ -90,6 +120,11 @@ int main(int argc, char* argv[])
     if(!identitySystem.Initialize(context))
         return -1;
 
+    // Initialize the visibility system.
+    Game::VisibilitySystem visibilitySystem;
+    if(!visibilitySystem.Initialize(context))
+        return -1;
+
     // Initialize the script system.
     Game::ScriptSystem scriptSystem;
     if(!scriptSystem.Initialize(context))
@@ -100,6 +135,16 @@ int main(int argc, char* argv[])
     if(!animationSystem.Initialize(context))
         return -1;
 
+    // Initialize the particle system.
+    Game::ParticleSystem particleSystem;
+    if(!particleSystem.Initialize(context))
+        return -1;
+
+    // Initialize the light system.
+    Game::LightSystem lightSystem;
+    if(!lightSystem.Initialize(context))
+        return -1;
+
     // Initialize the render system.
     Game::RenderSystem renderSystem;
     if(!renderSystem.Initialize(context))
@@ -107,7 +152,18 @@ int main(int argc, char* argv[])
 
     // Create entities.
     {
-        auto animationList = resourceManager.Load<Graphics::AnimationList>("Data/Character.animations");
+        Game::EntityHandle entity = entitySystem.CreateEntity();
+        identitySystem.SetEntityName(entity, "Camera");
+
+        auto transform = componentSystem.Create<Game::Components::Transform>(entity);
+        transform->SetPosition(glm::vec2(0.0f, 0.0f));
+
+        auto camera = componentSystem.Create<Game::Components::Camera>(entity);
+        camera->SetViewSize(glm::vec2(10.0f, 10.0f));
+    }
+
+    {
+        auto animationList = resourceManager.Acquire<Graphics::AnimationList>("Data/Character.animations");
 
         Game::EntityHandle entity = entitySystem.CreateEntity();
         identitySystem.SetEntityName(entity, "Player");
@@ -117,6 +173,7 @@ int main(int argc, char* argv[])
 
         auto script = componentSystem.Create<Game::Components::Script>(entity);
         script->Add<Game::Scripts::Player>();
+        script->SetAlwaysUpdate(true);
 
         auto animation = componentSystem.Create<Game::Components::Animation>(entity);
         animation->SetAnimationList(animationList);
@@ -187,6 +244,12 @@ int main(int argc, char* argv[])
         // Release unused resources.
         resourceManager.ReleaseUnused();
 
+        // Upload resources loaded in the background.
+        resourceManager.Update();
+
+        // Stream texture uploads.
+        textureUploader.Update();
+
         // Update input state before processing events.
         inputState.Update();
 
@@ -205,11 +268,14 @@ int main(int argc, char* argv[])
         // Update entity animations.
         animationSystem.Update(timeDelta);
 
+        // Update particle emitters.
+        particleSystem.Update(timeDelta);
+
         // Draw the scene.
         renderSystem.Draw();
 
         // Present back buffer to the window.
-        window.Present(verticalSync);
+        renderSystem.Present(verticalSync);
 
         // Tick the timer.
         timer.Tick();
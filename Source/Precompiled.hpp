@@ -2,12 +2,15 @@
 
 #include <cassert>
 #include <cctype>
+#include <cstring>
 #include <typeinfo>
 #include <typeindex>
 #include <limits>
 #include <memory>
 #include <chrono>
+#include <random>
 #include <numeric>
+#include <tuple>
 #include <algorithm>
 #include <functional>
 #include <fstream>
@@ -17,8 +20,13 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <map>
 #include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -0,0 +1,484 @@
+#include "Precompiled.hpp"
+#include "Archive.hpp"
+#include "FileSystem.hpp"
+using namespace System;
+
+namespace
+{
+    // Log error messages.
+    #define LogOpenError(filename) "Failed to open an archive \"" << filename << "\"! "
+    #define LogReadError(filename, name) "Failed to read \"" << name << "\" from an archive \"" << filename << "\"! "
+    #define LogWriteError(filename) "Failed to write an archive \"" << filename << "\"! "
+
+    // Archive identification.
+    const uint32_t Magic = 0x4B415050; // "PPAK"
+    const uint32_t Version = 1;
+
+    // Average number of entries per bucket of the index.
+    const uint32_t EntriesPerBucket = 4;
+
+    // Number of seeds tried for a bucket before giving up.
+    const int32_t MaxSeed = 1 << 20;
+
+    // Validate table layouts, as they're read and written directly.
+    static_assert(sizeof(Archive::Header) == 24, "Unexpected archive header size.");
+    static_assert(sizeof(Archive::Entry) == 40, "Unexpected archive entry size.");
+
+    // Rounds an offset up to an alignment.
+    uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Gets offsets of index tables.
+    uint64_t GetSeedsOffset()
+    {
+        return sizeof(Archive::Header);
+    }
+
+    uint64_t GetEntriesOffset(uint32_t bucketCount)
+    {
+        return AlignOffset(GetSeedsOffset() + (uint64_t)bucketCount * sizeof(int32_t), alignof(Archive::Entry));
+    }
+
+    uint64_t GetNamesOffset(uint32_t bucketCount, uint32_t entryCount)
+    {
+        return GetEntriesOffset(bucketCount) + (uint64_t)entryCount * sizeof(Archive::Entry);
+    }
+}
+
+Archive::Archive() :
+    m_header(nullptr),
+    m_seeds(nullptr),
+    m_entries(nullptr),
+    m_names(nullptr),
+    m_initialized(false)
+{
+}
+
+Archive::~Archive()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void Archive::Cleanup()
+{
+    // Reset index tables.
+    m_header = nullptr;
+    m_seeds = nullptr;
+    m_entries = nullptr;
+    m_names = nullptr;
+
+    // Unmap the archive.
+    m_file.Cleanup();
+
+    m_filename.clear();
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool Archive::Open(std::string filename)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Map the archive file.
+    if(!m_file.Open(filename))
+    {
+        Log() << LogOpenError(filename) << "Couldn't open the file.";
+        return false;
+    }
+
+    const uint8_t* data = m_file.GetData();
+    uint64_t size = m_file.GetSize();
+
+    // Validate the header.
+    if(size < sizeof(Header))
+    {
+        Log() << LogOpenError(filename) << "Couldn't read the header.";
+        return false;
+    }
+
+    m_header = (const Header*)data;
+
+    if(m_header->magic != Magic || m_header->version != Version)
+    {
+        Log() << LogOpenError(filename) << "Unsupported file format or version.";
+        return false;
+    }
+
+    if(m_header->bucketCount == 0)
+    {
+        Log() << LogOpenError(filename) << "Invalid index size.";
+        return false;
+    }
+
+    uint64_t namesOffset = GetNamesOffset(m_header->bucketCount, m_header->entryCount);
+
+    if(namesOffset + m_header->namesSize > size)
+    {
+        Log() << LogOpenError(filename) << "Index exceeds the file size.";
+        return false;
+    }
+
+    // Set index tables.
+    m_seeds = (const int32_t*)(data + GetSeedsOffset());
+    m_entries = (const Entry*)(data + GetEntriesOffset(m_header->bucketCount));
+    m_names = (const char*)(data + namesOffset);
+
+    // Validate entries once, so reads don't have to.
+    for(uint32_t i = 0; i < m_header->entryCount; ++i)
+    {
+        const Entry& entry = m_entries[i];
+
+        bool valid = true;
+        valid = valid && (uint64_t)entry.nameOffset + entry.nameLength <= m_header->namesSize;
+        valid = valid && entry.offset <= size && entry.size <= size - entry.offset;
+        valid = valid && (entry.compression == Compression::ZLib || (entry.compression == Compression::None && entry.size == entry.rawSize));
+
+        if(!valid)
+        {
+            Log() << LogOpenError(filename) << "Invalid entry in the index.";
+            return false;
+        }
+    }
+
+    m_filename = filename;
+
+    // Success!
+    return m_initialized = true;
+}
+
+const Archive::Entry* Archive::Find(const std::string& name) const
+{
+    if(!m_initialized || m_header->entryCount == 0)
+        return nullptr;
+
+    // Get the seed of the bucket.
+    int32_t seed = m_seeds[Hash(name, 0) % m_header->bucketCount];
+
+    // Negative seeds point at slots of single entry buckets.
+    uint64_t slot = seed < 0 ? (uint64_t)(-(int64_t)seed - 1) : Hash(name, (uint32_t)seed) % m_header->entryCount;
+
+    if(slot >= m_header->entryCount)
+        return nullptr;
+
+    // Names that aren't in the archive land on any slot, so compare the name.
+    const Entry& entry = m_entries[slot];
+
+    if(entry.nameLength != name.size() || std::memcmp(m_names + entry.nameOffset, name.data(), name.size()) != 0)
+        return nullptr;
+
+    return &entry;
+}
+
+bool Archive::Contains(std::string name) const
+{
+    return this->Find(name) != nullptr;
+}
+
+bool Archive::Read(std::string name, FileView& file) const
+{
+    file.Cleanup();
+
+    // Find the entry.
+    const Entry* entry = this->Find(name);
+
+    if(entry == nullptr)
+        return false;
+
+    const uint8_t* data = m_file.GetData() + entry->offset;
+
+    switch(entry->compression)
+    {
+    case Compression::None:
+        {
+            // View the entry in place.
+            file.m_data = entry->size != 0 ? data : nullptr;
+            file.m_size = (std::size_t)entry->size;
+        }
+        break;
+
+    case Compression::ZLib:
+        {
+            // Inflate the entry into the view.
+            file.m_buffer.resize((std::size_t)entry->rawSize);
+
+            if(!file.m_buffer.empty())
+            {
+                uLongf size = (uLongf)entry->rawSize;
+
+                if(uncompress(&file.m_buffer[0], &size, data, (uLong)entry->size) != Z_OK || size != entry->rawSize)
+                {
+                    Log() << LogReadError(m_filename, name) << "Couldn't decompress the entry.";
+                    file.Cleanup();
+                    return false;
+                }
+
+                file.m_data = &file.m_buffer[0];
+            }
+
+            file.m_size = file.m_buffer.size();
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t Archive::Hash(const std::string& name, uint32_t seed)
+{
+    // FNV-1a with the seed mixed into the offset basis.
+    uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+
+    for(char character : name)
+    {
+        hash ^= (uint8_t)character;
+        hash *= 1099511628211ULL;
+    }
+
+    // Finalize, as FNV mixes the last characters poorly.
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+bool Archive::Write(std::string filename, std::string directory, const std::vector<std::string>& names)
+{
+    uint32_t entryCount = (uint32_t)names.size();
+    uint32_t bucketCount = std::max(1u, (entryCount + EntriesPerBucket - 1) / EntriesPerBucket);
+
+    // Check for duplicate names, which would never get a perfect hash.
+    {
+        std::vector<std::string> sorted(names);
+        std::sort(sorted.begin(), sorted.end());
+
+        if(std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        {
+            Log() << LogWriteError(filename) << "Invalid argument - \"names\" contains duplicates.";
+            return false;
+        }
+    }
+
+    // Group names into buckets.
+    std::vector<std::vector<uint32_t>> buckets(bucketCount);
+
+    for(uint32_t i = 0; i < entryCount; ++i)
+    {
+        buckets[Hash(names[i], 0) % bucketCount].push_back(i);
+    }
+
+    // Place largest buckets first, while most slots are free.
+    std::vector<uint32_t> order(bucketCount);
+
+    for(uint32_t i = 0; i < bucketCount; ++i)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b)
+    {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    // Find a seed for each bucket that puts all of its names into free slots.
+    std::vector<int32_t> seeds(bucketCount, 0);
+    std::vector<uint32_t> slots(entryCount, 0);
+    std::vector<bool> taken(entryCount, false);
+    uint32_t nextFree = 0;
+
+    for(uint32_t bucketIndex : order)
+    {
+        const std::vector<uint32_t>& bucket = buckets[bucketIndex];
+
+        if(bucket.empty())
+            break;
+
+        if(bucket.size() == 1)
+        {
+            // Single names are placed straight into a free slot.
+            while(taken[nextFree])
+            {
+                ++nextFree;
+            }
+
+            taken[nextFree] = true;
+            slots[bucket[0]] = nextFree;
+            seeds[bucketIndex] = -(int32_t)nextFree - 1;
+            continue;
+        }
+
+        std::vector<uint32_t> bucketSlots(bucket.size());
+        bool placed = false;
+
+        for(int32_t seed = 1; seed < MaxSeed && !placed; ++seed)
+        {
+            placed = true;
+
+            for(std::size_t i = 0; i < bucket.size() && placed; ++i)
+            {
+                uint32_t slot = (uint32_t)(Hash(names[bucket[i]], seed) % entryCount);
+
+                if(taken[slot] || std::find(bucketSlots.begin(), bucketSlots.begin() + i, slot) != bucketSlots.begin() + i)
+                {
+                    placed = false;
+                }
+
+                bucketSlots[i] = slot;
+            }
+
+            if(placed)
+            {
+                seeds[bucketIndex] = seed;
+            }
+        }
+
+        if(!placed)
+        {
+            Log() << LogWriteError(filename) << "Couldn't build the index.";
+            return false;
+        }
+
+        for(std::size_t i = 0; i < bucket.size(); ++i)
+        {
+            taken[bucketSlots[i]] = true;
+            slots[bucket[i]] = bucketSlots[i];
+        }
+    }
+
+    // Build the name table.
+    std::string nameTable;
+
+    std::vector<Entry> entries(entryCount);
+
+    for(uint32_t i = 0; i < entryCount; ++i)
+    {
+        Entry& entry = entries[slots[i]];
+        std::memset(&entry, 0, sizeof(Entry));
+
+        entry.nameOffset = (uint32_t)nameTable.size();
+        entry.nameLength = (uint32_t)names[i].size();
+
+        nameTable += names[i];
+    }
+
+    // Read and compress files.
+    // Entries are kept compressed only if that saves at least an eighth.
+    std::vector<std::vector<uint8_t>> contents(entryCount);
+
+    uint64_t offset = GetNamesOffset(bucketCount, entryCount) + nameTable.size();
+
+    for(uint32_t i = 0; i < entryCount; ++i)
+    {
+        Entry& entry = entries[slots[i]];
+
+        FileView file;
+
+        if(!file.Open(directory + names[i]))
+        {
+            Log() << LogWriteError(filename) << "Couldn't read \"" << names[i] << "\" file.";
+            return false;
+        }
+
+        std::vector<uint8_t>& content = contents[i];
+
+        entry.rawSize = file.GetSize();
+        entry.compression = Compression::None;
+
+        if(file.GetSize() != 0)
+        {
+            uLongf size = compressBound((uLong)file.GetSize());
+            content.resize(size);
+
+            if(compress2(&content[0], &size, file.GetData(), (uLong)file.GetSize(), Z_BEST_COMPRESSION) == Z_OK &&
+                size <= file.GetSize() - file.GetSize() / 8)
+            {
+                content.resize(size);
+                entry.compression = Compression::ZLib;
+            }
+            else
+            {
+                content.assign(file.GetData(), file.GetData() + file.GetSize());
+            }
+        }
+
+        // Uncompressed entries are aligned, so their views start on a page.
+        if(entry.compression == Compression::None)
+        {
+            offset = AlignOffset(offset, PageSize);
+        }
+
+        entry.offset = offset;
+        entry.size = content.size();
+
+        offset += content.size();
+    }
+
+    // Fill the header.
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.entryCount = entryCount;
+    header.bucketCount = bucketCount;
+    header.namesSize = nameTable.size();
+
+    // Write the file.
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+
+    if(!stream.is_open())
+    {
+        Log() << LogWriteError(filename) << "Couldn't open the file.";
+        return false;
+    }
+
+    uint64_t position = 0;
+
+    auto WriteData = [&stream, &position](const void* data, uint64_t size)
+    {
+        stream.write((const char*)data, size);
+        position += size;
+    };
+
+    auto WritePadding = [&stream, &position](uint64_t target)
+    {
+        while(position < target)
+        {
+            stream.put(0);
+            position += 1;
+        }
+    };
+
+    WriteData(&header, sizeof(Header));
+    WriteData(seeds.data(), seeds.size() * sizeof(int32_t));
+    WritePadding(GetEntriesOffset(bucketCount));
+    WriteData(entries.data(), entries.size() * sizeof(Entry));
+    WriteData(nameTable.data(), nameTable.size());
+
+    for(uint32_t i = 0; i < entryCount; ++i)
+    {
+        WritePadding(entries[slots[i]].offset);
+        WriteData(contents[i].data(), contents[i].size());
+    }
+
+    if(!stream)
+    {
+        Log() << LogWriteError(filename) << "Couldn't write the file.";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "MappedFile.hpp"
+
+// Forward declarations.
+namespace System
+{
+    class FileView;
+}
+
+//
+// Archive
+//
+//  Packs many files into a single file that is mapped into memory as a
+//  whole. Entries are found through a perfect hash index, so a lookup takes
+//  two hashes of the name and one comparison, without touching the disk.
+//
+//  Entries are compressed with zlib one by one, unless that doesn't save
+//  enough space. Uncompressed entries are aligned to page boundaries and
+//  read in place, without any copies.
+//
+//  Packing files from the working directory:
+//      std::vector<std::string> filenames;
+//      filenames.push_back("Data/Textures/Player.png");
+//      filenames.push_back("Data/Textures/Player.sprites");
+//
+//      System::Archive::Write("Data.pack", Build::GetWorkingDir(), filenames);
+//
+//  Reading an entry:
+//      System::Archive archive;
+//      archive.Open(Build::GetWorkingDir() + "Data.pack");
+//
+//      System::FileView file;
+//      archive.Read("Data/Textures/Player.png", file);
+//
+
+namespace System
+{
+    // Archive class.
+    class Archive : private NonCopyable
+    {
+    public:
+        // Compression types.
+        struct Compression
+        {
+            enum Type
+            {
+                None,
+                ZLib,
+            };
+        };
+
+        // Archive header.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t bucketCount;
+            uint64_t namesSize;
+        };
+
+        // Archive entry.
+        struct Entry
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t rawSize;
+            uint32_t nameOffset;
+            uint32_t nameLength;
+            uint32_t compression;
+            uint32_t reserved;
+        };
+
+        // Constant variables.
+        static const std::size_t PageSize = 4096;
+
+    public:
+        Archive();
+        ~Archive();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Opens and validates an archive.
+        bool Open(std::string filename);
+
+        // Checks if the archive has an entry.
+        bool Contains(std::string name) const;
+
+        // Reads an entry.
+        // Uncompressed entries are viewed in place.
+        bool Read(std::string name, FileView& file) const;
+
+        // Checks if the archive is open.
+        bool IsOpen() const
+        {
+            return m_initialized;
+        }
+
+        // Writes files from a directory into an archive.
+        static bool Write(std::string filename, std::string directory, const std::vector<std::string>& names);
+
+        // Hashes an entry name.
+        static uint64_t Hash(const std::string& name, uint32_t seed);
+
+    private:
+        // Finds an entry.
+        const Entry* Find(const std::string& name) const;
+
+    private:
+        // Mapped archive file.
+        MappedFile m_file;
+
+        // Index tables.
+        const Header*  m_header;
+        const int32_t* m_seeds;
+        const Entry*   m_entries;
+        const char*    m_names;
+
+        // Archive name.
+        std::string m_filename;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
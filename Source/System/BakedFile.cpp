@@ -0,0 +1,287 @@
+#include "Precompiled.hpp"
+#include "BakedFile.hpp"
+using namespace System;
+
+namespace
+{
+    // Log error messages.
+    #define LogReadError(filename) "Failed to read a baked file \"" << filename << "\"! "
+    #define LogWriteError(filename) "Failed to write a baked file \"" << filename << "\"! "
+
+    // Baked file identification.
+    const uint32_t Magic = 0x444B4250; // "PBKD"
+    const uint32_t Version = 1;
+
+    // Extension appended to source names.
+    const char* BakedExtension = ".baked";
+
+    // Validate header layout, as it's read and written directly.
+    static_assert(sizeof(BakedFile::Header) == 32, "Unexpected baked file header size.");
+
+    // Reads and validates a header.
+    bool ReadHeader(const uint8_t* data, std::size_t size, BakedFile::Header& header)
+    {
+        if(data == nullptr || size < sizeof(BakedFile::Header))
+            return false;
+
+        std::memcpy(&header, data, sizeof(BakedFile::Header));
+
+        if(header.magic != Magic || header.version != Version)
+            return false;
+
+        if(header.dataSize != size - sizeof(BakedFile::Header))
+            return false;
+
+        return true;
+    }
+}
+
+std::string BakedFile::GetBakedName(std::string filename)
+{
+    return filename + BakedExtension;
+}
+
+uint64_t BakedFile::Hash(const void* data, std::size_t size)
+{
+    // FNV-1a over the content.
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    // Mix in the size, so truncated content doesn't match.
+    hash ^= (uint64_t)size;
+    hash *= 1099511628211ULL;
+
+    return hash;
+}
+
+bool BakedFile::GetSourceHash(const uint8_t* data, std::size_t size, uint64_t& sourceHash)
+{
+    Header header;
+
+    if(!ReadHeader(data, size, header))
+        return false;
+
+    sourceHash = header.sourceHash;
+
+    return true;
+}
+
+BakedWriter::BakedWriter(uint32_t type) :
+    m_type(type)
+{
+}
+
+BakedWriter::~BakedWriter()
+{
+}
+
+void BakedWriter::AddDependency(std::string filename)
+{
+    m_dependencies.push_back(filename);
+}
+
+void BakedWriter::WriteData(const void* data, std::size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    m_data.insert(m_data.end(), bytes, bytes + size);
+}
+
+void BakedWriter::Write(uint32_t value)
+{
+    this->WriteData(&value, sizeof(value));
+}
+
+void BakedWriter::Write(float value)
+{
+    this->WriteData(&value, sizeof(value));
+}
+
+void BakedWriter::Write(double value)
+{
+    this->WriteData(&value, sizeof(value));
+}
+
+void BakedWriter::Write(const std::string& value)
+{
+    this->Write((uint32_t)value.size());
+    this->WriteData(value.data(), value.size());
+}
+
+void BakedWriter::Write(const glm::vec2& value)
+{
+    this->WriteData(glm::value_ptr(value), sizeof(value));
+}
+
+void BakedWriter::Write(const glm::vec4& value)
+{
+    this->WriteData(glm::value_ptr(value), sizeof(value));
+}
+
+bool BakedWriter::Save(std::string filename, uint64_t sourceHash) const
+{
+    // Write the dependency list.
+    std::vector<uint8_t> dependencies;
+
+    for(const std::string& dependency : m_dependencies)
+    {
+        uint32_t length = (uint32_t)dependency.size();
+
+        const uint8_t* bytes = (const uint8_t*)&length;
+        dependencies.insert(dependencies.end(), bytes, bytes + sizeof(length));
+        dependencies.insert(dependencies.end(), dependency.begin(), dependency.end());
+    }
+
+    // Fill the header.
+    BakedFile::Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.type = m_type;
+    header.dependencyCount = (uint32_t)m_dependencies.size();
+    header.sourceHash = sourceHash;
+    header.dataSize = dependencies.size() + m_data.size();
+
+    // Write the file.
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+    if(!file.is_open())
+    {
+        Log() << LogWriteError(filename) << "Couldn't open the file.";
+        return false;
+    }
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)dependencies.data(), dependencies.size());
+    file.write((const char*)m_data.data(), m_data.size());
+
+    if(!file)
+    {
+        Log() << LogWriteError(filename) << "Couldn't write the file.";
+        return false;
+    }
+
+    return true;
+}
+
+BakedReader::BakedReader() :
+    m_data(nullptr),
+    m_size(0),
+    m_offset(0),
+    m_valid(false)
+{
+}
+
+BakedReader::~BakedReader()
+{
+}
+
+bool BakedReader::Open(std::string filename, const uint8_t* data, std::size_t size, uint32_t type, const uint64_t* sourceHash)
+{
+    m_dependencies.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_valid = false;
+
+    // Read and validate the header.
+    BakedFile::Header header;
+
+    if(!ReadHeader(data, size, header) || header.type != type)
+    {
+        Log() << LogReadError(filename) << "Unsupported file format, version or type.";
+        return false;
+    }
+
+    // Stale files are silently skipped in favor of their sources.
+    if(sourceHash != nullptr && header.sourceHash != *sourceHash)
+        return false;
+
+    m_data = data + sizeof(BakedFile::Header);
+    m_size = (std::size_t)header.dataSize;
+    m_valid = true;
+
+    // Read the dependency list.
+    for(uint32_t i = 0; i < header.dependencyCount && m_valid; ++i)
+    {
+        std::string dependency;
+
+        if(this->Read(dependency))
+        {
+            m_dependencies.push_back(dependency);
+        }
+    }
+
+    if(!m_valid)
+    {
+        Log() << LogReadError(filename) << "Invalid dependency list.";
+        return false;
+    }
+
+    return true;
+}
+
+bool BakedReader::ReadData(void* data, std::size_t size)
+{
+    if(!m_valid || size > m_size - m_offset)
+    {
+        std::memset(data, 0, size);
+        m_valid = false;
+        return false;
+    }
+
+    std::memcpy(data, m_data + m_offset, size);
+    m_offset += size;
+
+    return true;
+}
+
+bool BakedReader::Read(uint32_t& value)
+{
+    return this->ReadData(&value, sizeof(value));
+}
+
+bool BakedReader::Read(float& value)
+{
+    return this->ReadData(&value, sizeof(value));
+}
+
+bool BakedReader::Read(double& value)
+{
+    return this->ReadData(&value, sizeof(value));
+}
+
+bool BakedReader::Read(std::string& value)
+{
+    value.clear();
+
+    uint32_t length = 0;
+
+    if(!this->Read(length))
+        return false;
+
+    if(length > m_size - m_offset)
+    {
+        m_valid = false;
+        return false;
+    }
+
+    value.assign((const char*)m_data + m_offset, length);
+    m_offset += length;
+
+    return true;
+}
+
+bool BakedReader::Read(glm::vec2& value)
+{
+    return this->ReadData(glm::value_ptr(value), sizeof(value));
+}
+
+bool BakedReader::Read(glm::vec4& value)
+{
+    return this->ReadData(glm::value_ptr(value), sizeof(value));
+}
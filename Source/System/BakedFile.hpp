@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Baked File
+//
+//  Binary form of data files, written by the asset baker so loaders don't
+//  have to interpret Lua sources at runtime. Baked files sit next to their
+//  sources with an added ".baked" extension.
+//
+//  Every baked file starts with a header that identifies the type of its
+//  content and keeps a hash of the source content it was baked from, which
+//  tells the baker what needs to be rebuilt and lets loaders skip stale
+//  files. The header is followed by a list of files the content depends on
+//  and then by values written one after another.
+//
+//  Writing a baked file:
+//      System::BakedWriter writer(Type);
+//      writer.AddDependency("Data/Texture.png");
+//      writer.Write(count);
+//      writer.Save(System::BakedFile::GetBakedName(filename), sourceHash);
+//
+//  Reading a baked file:
+//      System::BakedReader reader;
+//      if(reader.Open(filename, file.GetData(), file.GetSize(), Type))
+//      {
+//          reader.Read(count);
+//      }
+//
+
+namespace System
+{
+    namespace BakedFile
+    {
+        // Baked file header.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t type;
+            uint32_t dependencyCount;
+            uint64_t sourceHash;
+            uint64_t dataSize;
+        };
+
+        // Gets the name of a baked file.
+        std::string GetBakedName(std::string filename);
+
+        // Hashes source content.
+        uint64_t Hash(const void* data, std::size_t size);
+
+        // Reads the source hash of a baked file.
+        // Used to check if a file has to be baked again.
+        bool GetSourceHash(const uint8_t* data, std::size_t size, uint64_t& sourceHash);
+    }
+
+    // Baked file writer class.
+    class BakedWriter : private NonCopyable
+    {
+    public:
+        BakedWriter(uint32_t type);
+        ~BakedWriter();
+
+        // Adds a file the content depends on.
+        void AddDependency(std::string filename);
+
+        // Writes values.
+        void Write(uint32_t value);
+        void Write(float value);
+        void Write(double value);
+        void Write(const std::string& value);
+        void Write(const glm::vec2& value);
+        void Write(const glm::vec4& value);
+
+        // Saves the baked file.
+        bool Save(std::string filename, uint64_t sourceHash) const;
+
+    private:
+        // Appends raw bytes.
+        void WriteData(const void* data, std::size_t size);
+
+    private:
+        // Content type.
+        uint32_t m_type;
+
+        // Written content.
+        std::vector<std::string> m_dependencies;
+        std::vector<uint8_t>     m_data;
+    };
+
+    // Baked file reader class.
+    class BakedReader : private NonCopyable
+    {
+    public:
+        BakedReader();
+        ~BakedReader();
+
+        // Opens baked file data of a type.
+        // Fails if the source hash doesn't match, unless it's null.
+        bool Open(std::string filename, const uint8_t* data, std::size_t size, uint32_t type, const uint64_t* sourceHash = nullptr);
+
+        // Reads values.
+        // Values past the end are zeroed and mark the reader as failed.
+        bool Read(uint32_t& value);
+        bool Read(float& value);
+        bool Read(double& value);
+        bool Read(std::string& value);
+        bool Read(glm::vec2& value);
+        bool Read(glm::vec4& value);
+
+        // Gets files the content depends on.
+        const std::vector<std::string>& GetDependencies() const
+        {
+            return m_dependencies;
+        }
+
+        // Checks if all reads have succeeded.
+        bool IsValid() const
+        {
+            return m_valid;
+        }
+
+    private:
+        // Reads raw bytes.
+        bool ReadData(void* data, std::size_t size);
+
+    private:
+        // Read content.
+        std::vector<std::string> m_dependencies;
+
+        const uint8_t* m_data;
+        std::size_t    m_size;
+        std::size_t    m_offset;
+
+        // Read state.
+        bool m_valid;
+    };
+}
@@ -1,5 +1,7 @@
 #include "Precompiled.hpp"
 #include "Config.hpp"
+#include "FileSystem.hpp"
+#include "BakedFile.hpp"
 using namespace System;
 
 namespace
@@ -7,6 +9,73 @@ namespace
     // Log messages.
     #define LogInitializeError() "Failed to initialize a config instance! "
     #define LogLoadError(filename) "Failed to load a config from \"" << filename << "\" file! "
+
+    // Baked file type.
+    const uint32_t BakedType = 0x47464E43; // "CNFG"
+
+    // Baked variable types.
+    struct VariableTypes
+    {
+        enum Type
+        {
+            Boolean,
+            Number,
+            String,
+        };
+    };
+
+    // Config variable.
+    struct Variable
+    {
+        std::string name;
+        uint32_t    type;
+        bool        boolean;
+        double      number;
+        std::string string;
+    };
+
+    // Gathers variables of a table at the top of the stack.
+    void GatherVariables(lua_State* lua, const std::string& prefix, std::vector<Variable>& variables)
+    {
+        for(lua_pushnil(lua); lua_next(lua, -2); lua_pop(lua, 1))
+        {
+            // Only string keys can be referred to by variable names.
+            if(lua_type(lua, -2) != LUA_TSTRING)
+                continue;
+
+            Variable variable;
+            variable.name = prefix + lua_tostring(lua, -2);
+            variable.boolean = false;
+            variable.number = 0.0;
+
+            switch(lua_type(lua, -1))
+            {
+            case LUA_TTABLE:
+                GatherVariables(lua, variable.name + ".", variables);
+                continue;
+
+            case LUA_TBOOLEAN:
+                variable.type = VariableTypes::Boolean;
+                variable.boolean = lua_toboolean(lua, -1) != 0;
+                break;
+
+            case LUA_TNUMBER:
+                variable.type = VariableTypes::Number;
+                variable.number = lua_tonumber(lua, -1);
+                break;
+
+            case LUA_TSTRING:
+                variable.type = VariableTypes::String;
+                variable.string = lua_tostring(lua, -1);
+                break;
+
+            default:
+                continue;
+            }
+
+            variables.push_back(variable);
+        }
+    }
 }
 
 Config::Config() :
@@ -61,11 +130,34 @@ bool Config::Load(std::string filename)
     SCOPE_GUARD_IF(!success,
         this->Cleanup());
 
-    // Load the config file
-    if(!m_lua.Load(filename))
+    // Open config files.
+    // Config is read before the file system is set up, so the files are loose.
+    FileView sourceFile;
+    FileView bakedFile;
+
+    bool hasSource = sourceFile.Open(Build::GetWorkingDir() + filename);
+    bool hasBaked = bakedFile.Open(Build::GetWorkingDir() + BakedFile::GetBakedName(filename));
+
+    // Read the baked config, unless it's stale.
+    bool decoded = false;
+
+    if(hasBaked)
     {
-        Log() << LogLoadError(filename) << "Couldn't load the file.";
-        return false;
+        uint64_t sourceHash = BakedFile::Hash(sourceFile.GetData(), sourceFile.GetSize());
+        decoded = this->DecodeBaked(filename, bakedFile, hasSource ? &sourceHash : nullptr);
+    }
+
+    // Read the config source.
+    if(!decoded)
+    {
+        if(!hasSource)
+        {
+            Log() << LogLoadError(filename) << "Couldn't open the file.";
+            return false;
+        }
+
+        if(!this->DecodeSource(filename, sourceFile))
+            return false;
     }
 
     // Validate state.
@@ -85,6 +177,169 @@ bool Config::Load(std::string filename)
     return success = true;
 }
 
+bool Config::DecodeSource(std::string filename, const FileView& file)
+{
+    if(!m_initialized)
+        return false;
+
+    // Load the config file.
+    if(!m_lua.Load(filename, file.GetData(), file.GetSize()))
+    {
+        Log() << LogLoadError(filename) << "Couldn't load the file.";
+        return false;
+    }
+
+    return true;
+}
+
+bool Config::DecodeBaked(std::string filename, const FileView& file, const uint64_t* sourceHash)
+{
+    if(!m_initialized)
+        return false;
+
+    BakedReader reader;
+
+    if(!reader.Open(filename, file.GetData(), file.GetSize(), BakedType, sourceHash))
+        return false;
+
+    // Rebuild the config table from variables.
+    uint32_t count = 0;
+    reader.Read(count);
+
+    lua_newtable(m_lua);
+
+    for(uint32_t i = 0; i < count && reader.IsValid(); ++i)
+    {
+        std::string name;
+        uint32_t type = 0;
+
+        reader.Read(name);
+        reader.Read(type);
+
+        auto tokens = Utility::SplitString(name, '.');
+
+        if(tokens.empty())
+        {
+            lua_pop(m_lua, 1);
+
+            Log() << LogLoadError(filename) << "Baked file has an invalid variable name.";
+            return false;
+        }
+
+        // Create tables along the name.
+        lua_pushvalue(m_lua, -1);
+
+        for(std::size_t t = 0; t + 1 < tokens.size(); ++t)
+        {
+            lua_getfield(m_lua, -1, tokens[t].c_str());
+
+            if(!lua_istable(m_lua, -1))
+            {
+                lua_pop(m_lua, 1);
+                lua_newtable(m_lua);
+                lua_pushvalue(m_lua, -1);
+                lua_setfield(m_lua, -3, tokens[t].c_str());
+            }
+
+            lua_remove(m_lua, -2);
+        }
+
+        // Set the variable.
+        switch(type)
+        {
+        case VariableTypes::Boolean:
+            {
+                uint32_t value = 0;
+                reader.Read(value);
+                lua_pushboolean(m_lua, value != 0);
+            }
+            break;
+
+        case VariableTypes::Number:
+            {
+                double value = 0.0;
+                reader.Read(value);
+                lua_pushnumber(m_lua, value);
+            }
+            break;
+
+        case VariableTypes::String:
+            {
+                std::string value;
+                reader.Read(value);
+                lua_pushstring(m_lua, value.c_str());
+            }
+            break;
+
+        default:
+            lua_pop(m_lua, 2);
+
+            Log() << LogLoadError(filename) << "Baked file has an invalid variable type.";
+            return false;
+        }
+
+        lua_setfield(m_lua, -2, tokens.back().c_str());
+        lua_pop(m_lua, 1);
+    }
+
+    if(!reader.IsValid())
+    {
+        lua_pop(m_lua, 1);
+
+        Log() << LogLoadError(filename) << "Baked file is truncated.";
+        return false;
+    }
+
+    lua_setglobal(m_lua, "Config");
+
+    return true;
+}
+
+bool Config::Bake(std::string path, uint64_t sourceHash)
+{
+    if(!m_initialized)
+        return false;
+
+    // Gather variables of the config table.
+    std::vector<Variable> variables;
+
+    lua_getglobal(m_lua, "Config");
+
+    if(lua_istable(m_lua, -1))
+    {
+        GatherVariables(m_lua, "", variables);
+    }
+
+    lua_pop(m_lua, 1);
+
+    // Write the variable list.
+    BakedWriter writer(BakedType);
+    writer.Write((uint32_t)variables.size());
+
+    for(const Variable& variable : variables)
+    {
+        writer.Write(variable.name);
+        writer.Write(variable.type);
+
+        switch(variable.type)
+        {
+        case VariableTypes::Boolean:
+            writer.Write((uint32_t)variable.boolean);
+            break;
+
+        case VariableTypes::Number:
+            writer.Write(variable.number);
+            break;
+
+        case VariableTypes::String:
+            writer.Write(variable.string);
+            break;
+        }
+    }
+
+    return writer.Save(path, sourceHash);
+}
+
 void Config::PushReference(std::string name)
 {
     assert(m_initialized);
@@ -3,9 +3,19 @@
 #include "Precompiled.hpp"
 #include "Lua/State.hpp"
 
+// Forward declarations.
+namespace System
+{
+    class FileView;
+}
+
 //
 // Config
 //
+//  Config files are read from baked files written by the asset baker when
+//  they are up to date, and from Lua sources otherwise. Baked configs hold
+//  a flat list of variables that the config table is rebuilt from.
+//
 
 namespace System
 {
@@ -25,6 +35,16 @@ namespace System
         // Loads the config from a file.
         bool Load(std::string filename);
 
+        // Reads the config from a Lua source.
+        bool DecodeSource(std::string filename, const FileView& file);
+
+        // Reads the config from a baked file.
+        // Fails if the source hash doesn't match, unless it's null.
+        bool DecodeBaked(std::string filename, const FileView& file, const uint64_t* sourceHash = nullptr);
+
+        // Writes the config into a baked file.
+        bool Bake(std::string path, uint64_t sourceHash);
+
         // Sets a config variable.
         template<typename Type>
         void Set(std::string name, const Type& value);
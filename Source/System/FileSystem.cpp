@@ -0,0 +1,241 @@
+#include "Precompiled.hpp"
+#include "FileSystem.hpp"
+#include "Archive.hpp"
+#include "Config.hpp"
+using namespace System;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the file system! "
+    #define LogMountError(path) "Failed to mount \"" << path << "\"! "
+
+    // Default archive in the working directory.
+    const char* DefaultArchive = "Data.pack";
+
+    // Normalizes separators of a filename.
+    std::string NormalizeFilename(std::string filename)
+    {
+        std::replace(filename.begin(), filename.end(), '\\', '/');
+        return filename;
+    }
+}
+
+FileView::FileView() :
+    m_data(nullptr),
+    m_size(0)
+{
+}
+
+FileView::~FileView()
+{
+}
+
+void FileView::Cleanup()
+{
+    m_data = nullptr;
+    m_size = 0;
+
+    m_file.Cleanup();
+    Utility::ClearContainer(m_buffer);
+}
+
+bool FileView::Open(std::string path)
+{
+    this->Cleanup();
+
+    // View the whole mapped file.
+    if(!m_file.Open(path))
+        return false;
+
+    m_data = m_file.GetData();
+    m_size = m_file.GetSize();
+
+    return true;
+}
+
+FileSystem::FileSystem() :
+    m_initialized(false)
+{
+}
+
+FileSystem::~FileSystem()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void FileSystem::Cleanup()
+{
+    // Unmount everything.
+    Utility::ClearContainer(m_mounts);
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool FileSystem::Initialize(Context& context)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Add instance to the context.
+    if(context[ContextTypes::Main].Has<FileSystem>())
+    {
+        Log() << LogInitializeError() << "Context is invalid.";
+        return false;
+    }
+
+    context[ContextTypes::Main].Set(this);
+
+    // Mount the working directory.
+    if(!this->MountDirectory(Build::GetWorkingDir()))
+    {
+        Log() << LogInitializeError() << "Couldn't mount the working directory.";
+        return false;
+    }
+
+    // Mount the default archive over loose files.
+    bool mountArchive = true;
+
+    System::Config* config = context[ContextTypes::Main].Get<System::Config>();
+
+    if(config != nullptr)
+    {
+        mountArchive = config->Get<bool>("System.MountArchive", true);
+    }
+
+    std::string archivePath = Build::GetWorkingDir() + DefaultArchive;
+
+    if(mountArchive && MappedFile().Open(archivePath))
+    {
+        if(!this->MountArchive(archivePath))
+        {
+            Log() << LogInitializeError() << "Couldn't mount the default archive.";
+            return false;
+        }
+    }
+
+    // Success!
+    return m_initialized = true;
+}
+
+bool FileSystem::MountDirectory(std::string path)
+{
+    // Directories are searched by joining paths,
+    // so make sure the path ends with a separator.
+    path = NormalizeFilename(path);
+
+    if(!path.empty() && path.back() != '/')
+    {
+        path += '/';
+    }
+
+    MountPoint mount;
+    mount.directory = path;
+
+    m_mounts.push_back(std::move(mount));
+
+    Log() << "Mounted \"" << (path.empty() ? "." : path) << "\" directory.";
+
+    return true;
+}
+
+bool FileSystem::MountArchive(std::string path)
+{
+    // Open the archive.
+    std::unique_ptr<Archive> archive(new Archive());
+
+    if(!archive->Open(path))
+    {
+        Log() << LogMountError(path) << "Couldn't open the archive.";
+        return false;
+    }
+
+    MountPoint mount;
+    mount.archive = std::move(archive);
+
+    m_mounts.push_back(std::move(mount));
+
+    Log() << "Mounted \"" << path << "\" archive.";
+
+    return true;
+}
+
+bool FileSystem::Open(std::string filename, FileView& file) const
+{
+    file.Cleanup();
+
+    filename = NormalizeFilename(filename);
+
+    // Search mounts from the last one.
+    for(auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it)
+    {
+        if(it->archive)
+        {
+            if(it->archive->Read(filename, file))
+                return true;
+        }
+        else
+        {
+            if(file.Open(it->directory + filename))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool FileSystem::Exists(std::string filename) const
+{
+    filename = NormalizeFilename(filename);
+
+    // Search mounts from the last one.
+    for(auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it)
+    {
+        if(it->archive)
+        {
+            if(it->archive->Contains(filename))
+                return true;
+        }
+        else
+        {
+            if(std::ifstream(it->directory + filename).good())
+                return true;
+        }
+    }
+
+    return false;
+}
+
+std::string FileSystem::GetNativePath(std::string filename) const
+{
+    filename = NormalizeFilename(filename);
+
+    // Search mounts from the last one.
+    // Files shadowed by an archive don't have a native path.
+    for(auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it)
+    {
+        if(it->archive)
+        {
+            if(it->archive->Contains(filename))
+                return std::string();
+        }
+        else
+        {
+            std::string path = it->directory + filename;
+
+            if(std::ifstream(path).good())
+                return path;
+        }
+    }
+
+    return std::string();
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Precompiled.hpp"
+#include "MappedFile.hpp"
+
+// Forward declarations.
+namespace System
+{
+    class Archive;
+}
+
+//
+// File System
+//
+//  Reads files through a list of mount points, which are either loose
+//  directories or packed archives. Mounts are searched from the last one
+//  to the first, so an archive mounted over the working directory shadows
+//  loose files with the same names.
+//
+//  Files are returned as views. Loose files and uncompressed archive
+//  entries are viewed straight from mapped memory, while compressed entries
+//  are inflated into a buffer owned by the view.
+//
+//  Mount points are set up before loading resources and are only read
+//  afterwards, so files can be opened from any thread.
+//
+//  Reading a file:
+//      System::FileView file;
+//      if(fileSystem->Open("Data/Shaders/Sprite.glsl", file))
+//      {
+//          Process(file.GetData(), file.GetSize());
+//      }
+//
+
+namespace System
+{
+    // File view class.
+    class FileView : private NonCopyable
+    {
+    public:
+        FileView();
+        ~FileView();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Opens a file from a native path.
+        bool Open(std::string path);
+
+        // Gets the file data.
+        // Can be null for an empty file.
+        const uint8_t* GetData() const
+        {
+            return m_data;
+        }
+
+        // Gets the size of the file.
+        std::size_t GetSize() const
+        {
+            return m_size;
+        }
+
+        // Checks if the view points straight into mapped memory.
+        bool IsMapped() const
+        {
+            return m_data != nullptr && m_buffer.empty();
+        }
+
+    private:
+        // Allows archives to set up views of their entries.
+        friend class Archive;
+
+    private:
+        // Viewed data.
+        const uint8_t* m_data;
+        std::size_t    m_size;
+
+        // Storage of the viewed data.
+        MappedFile           m_file;
+        std::vector<uint8_t> m_buffer;
+    };
+
+    // File system class.
+    class FileSystem : private NonCopyable
+    {
+    public:
+        FileSystem();
+        ~FileSystem();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the file system.
+        // Mounts the working directory and the default archive, if it exists.
+        bool Initialize(Context& context);
+
+        // Mounts a directory.
+        bool MountDirectory(std::string path);
+
+        // Mounts an archive.
+        bool MountArchive(std::string path);
+
+        // Opens a file.
+        bool Open(std::string filename, FileView& file) const;
+
+        // Checks if a file exists.
+        bool Exists(std::string filename) const;
+
+        // Gets the native path of a loose file.
+        // Returns an empty string if the file isn't in a mounted directory.
+        std::string GetNativePath(std::string filename) const;
+
+    private:
+        // Mount point.
+        struct MountPoint
+        {
+            std::string              directory;
+            std::unique_ptr<Archive> archive;
+        };
+
+        typedef std::vector<MountPoint> MountList;
+
+    private:
+        // Mount points.
+        MountList m_mounts;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -0,0 +1,201 @@
+#include "Precompiled.hpp"
+#include "JobPool.hpp"
+using namespace System;
+
+namespace
+{
+    // Log error messages.
+    #define LogInitializeError() "Failed to initialize the job pool! "
+
+    // Maximum number of worker threads.
+    const int MaxThreadCount = 32;
+}
+
+JobPool::JobPool() :
+    m_function(nullptr),
+    m_count(0),
+    m_chunkSize(0),
+    m_nextChunk(0),
+    m_busyWorkers(0),
+    m_generation(0),
+    m_exit(false),
+    m_initialized(false)
+{
+}
+
+JobPool::~JobPool()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void JobPool::Cleanup()
+{
+    // Stop worker threads.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+
+    m_workCondition.notify_all();
+
+    for(auto& thread : m_threads)
+    {
+        if(thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    Utility::ClearContainer(m_threads);
+
+    // Reset range state.
+    m_function = nullptr;
+    m_count = 0;
+    m_chunkSize = 0;
+    m_nextChunk = 0;
+    m_busyWorkers = 0;
+    m_generation = 0;
+    m_exit = false;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool JobPool::Initialize(int threadCount)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+    // Pick the number of threads.
+    // The calling thread counts as one of the workers.
+    if(threadCount < 0)
+    {
+        threadCount = (int)std::thread::hardware_concurrency() - 1;
+    }
+
+    threadCount = std::max(0, std::min(threadCount, MaxThreadCount));
+
+    // Start worker threads.
+    m_threads.reserve(threadCount);
+
+    for(int i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&JobPool::WorkerThread, this, i + 1);
+    }
+
+    // Success!
+    Log() << "Created a job pool with " << threadCount << " worker threads.";
+
+    return m_initialized = true;
+}
+
+void JobPool::ParallelFor(int count, int chunkSize, const RangeFunction& function)
+{
+    if(count <= 0)
+        return;
+
+    chunkSize = std::max(1, chunkSize);
+
+    // Process small ranges on the calling thread.
+    if(m_threads.empty() || count <= chunkSize)
+    {
+        function(0, count, 0);
+        return;
+    }
+
+    // Publish the range to worker threads.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_function = &function;
+        m_count = count;
+        m_chunkSize = chunkSize;
+        m_nextChunk = 0;
+        m_busyWorkers = (int)m_threads.size();
+        m_generation += 1;
+    }
+
+    m_workCondition.notify_all();
+
+    // Help processing the range.
+    while(this->ProcessChunk(0))
+    {
+    }
+
+    // Wait for workers to finish their last chunks.
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_doneCondition.wait(lock, [this]()
+        {
+            return m_busyWorkers == 0;
+        });
+
+        m_function = nullptr;
+    }
+}
+
+int JobPool::GetWorkerCount() const
+{
+    return (int)m_threads.size() + 1;
+}
+
+void JobPool::WorkerThread(int worker)
+{
+    unsigned int generation = 0;
+
+    while(true)
+    {
+        // Wait for a new range of work.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_workCondition.wait(lock, [&]()
+            {
+                return m_exit || m_generation != generation;
+            });
+
+            if(m_exit)
+                break;
+
+            generation = m_generation;
+        }
+
+        // Process chunks until the range is exhausted.
+        while(this->ProcessChunk(worker))
+        {
+        }
+
+        // Signal that this worker is done.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busyWorkers -= 1;
+        }
+
+        m_doneCondition.notify_one();
+    }
+}
+
+bool JobPool::ProcessChunk(int worker)
+{
+    // Claim the next chunk.
+    int begin = m_nextChunk.fetch_add(m_chunkSize);
+
+    if(begin >= m_count)
+        return false;
+
+    int end = std::min(begin + m_chunkSize, m_count);
+
+    // Process the chunk.
+    (*m_function)(begin, end, worker);
+
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Job Pool
+//
+//  Keeps a number of worker threads that process ranges of work
+//  in parallel. The calling thread also takes part in processing,
+//  so a pool with zero worker threads runs everything inline.
+//  Only one thread may issue work to the pool at a time.
+//
+//  Processing a range in parallel:
+//      std::vector<Item> items;
+//      std::vector<Output> outputs(jobPool.GetWorkerCount());
+//
+//      jobPool.ParallelFor(items.size(), 64, [&](int begin, int end, int worker)
+//      {
+//          for(int i = begin; i < end; ++i)
+//          {
+//              items[i].Process(outputs[worker]);
+//          }
+//      });
+//
+
+namespace System
+{
+    // Job pool class.
+    class JobPool
+    {
+    public:
+        // Type declarations.
+        typedef std::function<void(int begin, int end, int worker)> RangeFunction;
+
+    public:
+        JobPool();
+        ~JobPool();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the job pool instance.
+        // Negative thread count picks one based on the available hardware threads.
+        bool Initialize(int threadCount = -1);
+
+        // Processes a range of items in chunks across all workers.
+        // Returns after the whole range has been processed.
+        void ParallelFor(int count, int chunkSize, const RangeFunction& function);
+
+        // Gets the number of workers, including the calling thread.
+        // Worker indices passed to functions are lower than this value.
+        int GetWorkerCount() const;
+
+    private:
+        // Worker thread entry point.
+        void WorkerThread(int worker);
+
+        // Processes the next chunk of the current range.
+        bool ProcessChunk(int worker);
+
+    private:
+        // Worker threads.
+        std::vector<std::thread> m_threads;
+
+        // Synchronization objects.
+        std::mutex              m_mutex;
+        std::condition_variable m_workCondition;
+        std::condition_variable m_doneCondition;
+
+        // Current range of work.
+        const RangeFunction* m_function;
+        int                  m_count;
+        int                  m_chunkSize;
+        std::atomic<int>     m_nextChunk;
+        int                  m_busyWorkers;
+        unsigned int         m_generation;
+        bool                 m_exit;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
@@ -0,0 +1,169 @@
+#include "Precompiled.hpp"
+#include "MappedFile.hpp"
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace System;
+
+namespace
+{
+    // Log error messages.
+    #define LogOpenError(filename) "Failed to map a file \"" << filename << "\"! "
+
+    // Invalid types.
+#ifdef WIN32
+    const HANDLE InvalidFile = INVALID_HANDLE_VALUE;
+#else
+    const int InvalidFile = -1;
+#endif
+}
+
+MappedFile::MappedFile() :
+#ifdef WIN32
+    m_file(InvalidFile),
+    m_mapping(nullptr),
+#else
+    m_file(InvalidFile),
+#endif
+    m_data(nullptr),
+    m_size(0),
+    m_initialized(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if(m_initialized)
+        this->Cleanup();
+}
+
+void MappedFile::Cleanup()
+{
+    // Unmap the file.
+#ifdef WIN32
+    if(m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+
+    if(m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    if(m_file != InvalidFile)
+    {
+        CloseHandle(m_file);
+        m_file = InvalidFile;
+    }
+#else
+    if(m_data != nullptr)
+    {
+        munmap((void*)m_data, m_size);
+    }
+
+    if(m_file != InvalidFile)
+    {
+        close(m_file);
+        m_file = InvalidFile;
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+
+    // Reset initialization state.
+    m_initialized = false;
+}
+
+bool MappedFile::Open(std::string filename)
+{
+    // Setup initialization routine.
+    if(m_initialized)
+        this->Cleanup();
+
+    SCOPE_GUARD
+    (
+        if(!m_initialized)
+            this->Cleanup();
+    );
+
+#ifdef WIN32
+    // Open the file.
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(m_file == InvalidFile)
+        return false;
+
+    LARGE_INTEGER size;
+
+    if(!GetFileSizeEx(m_file, &size))
+    {
+        Log() << LogOpenError(filename) << "Couldn't get the file size.";
+        return false;
+    }
+
+    m_size = (std::size_t)size.QuadPart;
+
+    // Map the file.
+    // Empty files can't be mapped, but are valid.
+    if(m_size > 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if(m_mapping == nullptr)
+        {
+            Log() << LogOpenError(filename) << "Couldn't create a file mapping.";
+            return false;
+        }
+
+        m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if(m_data == nullptr)
+        {
+            Log() << LogOpenError(filename) << "Couldn't map a view of the file.";
+            return false;
+        }
+    }
+#else
+    // Open the file.
+    m_file = open(filename.c_str(), O_RDONLY);
+
+    if(m_file == InvalidFile)
+        return false;
+
+    struct stat info;
+
+    if(fstat(m_file, &info) != 0)
+    {
+        Log() << LogOpenError(filename) << "Couldn't get the file size.";
+        return false;
+    }
+
+    m_size = (std::size_t)info.st_size;
+
+    // Map the file.
+    // Empty files can't be mapped, but are valid.
+    if(m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+
+        if(data == MAP_FAILED)
+        {
+            Log() << LogOpenError(filename) << "Couldn't map the file.";
+            return false;
+        }
+
+        m_data = (const uint8_t*)data;
+    }
+#endif
+
+    // Success!
+    return m_initialized = true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Precompiled.hpp"
+
+//
+// Mapped File
+//
+//  Maps a whole file into memory for reading, so its content can be read
+//  in place without copying it through stream buffers. Pages are loaded
+//  by the system on first access.
+//
+//  Reading a mapped file:
+//      System::MappedFile file;
+//      if(file.Open(Build::GetWorkingDir() + "Data/Texture.png"))
+//      {
+//          Process(file.GetData(), file.GetSize());
+//      }
+//
+
+namespace System
+{
+    // Mapped file class.
+    class MappedFile : private NonCopyable
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Opens and maps a file.
+        bool Open(std::string filename);
+
+        // Gets the mapped data.
+        // Can be null for an empty file.
+        const uint8_t* GetData() const
+        {
+            return m_data;
+        }
+
+        // Gets the size of the file.
+        std::size_t GetSize() const
+        {
+            return m_size;
+        }
+
+        // Checks if the file is open.
+        bool IsOpen() const
+        {
+            return m_initialized;
+        }
+
+    private:
+        // File handles.
+#ifdef WIN32
+        HANDLE m_file;
+        HANDLE m_mapping;
+#else
+        int m_file;
+#endif
+
+        // Mapped data.
+        const uint8_t* m_data;
+        std::size_t    m_size;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+}
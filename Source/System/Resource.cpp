@@ -0,0 +1,27 @@
+#include "Precompiled.hpp"
+#include "Resource.hpp"
+#include "ResourceManager.hpp"
+#include "FileSystem.hpp"
+using namespace System;
+
+FileSystem* Resource::GetFileSystem() const
+{
+    if(m_resourceManager == nullptr || m_resourceManager->GetContext() == nullptr)
+        return nullptr;
+
+    return (*m_resourceManager->GetContext())[ContextTypes::Main].Get<FileSystem>();
+}
+
+bool Resource::OpenFile(std::string filename, FileView& file) const
+{
+    // Open the file through the file system.
+    FileSystem* fileSystem = this->GetFileSystem();
+
+    if(fileSystem != nullptr)
+    {
+        return fileSystem->Open(filename, file);
+    }
+
+    // Open a loose file.
+    return file.Open(Build::GetWorkingDir() + filename);
+}
@@ -6,11 +6,18 @@
 namespace System
 {
     class ResourceManager;
+    class FileSystem;
+    class FileView;
 }
 
 //
 // Resource
 //
+//  Resources are loaded in two steps. Decoding reads and parses the file
+//  on a loader thread, and can request dependencies from the resource
+//  manager. Uploading creates graphics objects from decoded data on the
+//  main thread, after all dependencies requested while decoding are loaded.
+//
 
 namespace System
 {
@@ -28,6 +35,34 @@ namespace System
         {
         }
 
+        // Decodes the resource from a file.
+        // Called on a loader thread, so the graphics context can't be used.
+        virtual bool Decode(std::string filename) = 0;
+
+        // Uploads decoded data of the resource.
+        // Called on the main thread.
+        virtual bool Upload(std::string filename) = 0;
+
+        // Gets the estimated size of the resource in system memory (in bytes).
+        // Includes decoded data that is still waiting for upload.
+        virtual std::size_t GetCpuMemorySize() const
+        {
+            return 0;
+        }
+
+        // Gets the estimated size of the resource in graphics memory (in bytes).
+        virtual std::size_t GetGpuMemorySize() const
+        {
+            return 0;
+        }
+
+        // Gets the estimated memory size of the resource (in bytes).
+        // Used by the resource manager to keep caches within budget.
+        std::size_t GetMemorySize() const
+        {
+            return this->GetCpuMemorySize() + this->GetGpuMemorySize();
+        }
+
         // Gets the resource manager.
         // Can return nullptr, which means resource
         // is not bound to any resource manager.
@@ -36,6 +71,15 @@ namespace System
             return m_resourceManager;
         }
 
+    protected:
+        // Gets the file system of the resource manager.
+        // Can return nullptr, which means files are loose.
+        FileSystem* GetFileSystem() const;
+
+        // Opens a file through the file system of the resource manager.
+        // Unbound resources read loose files from the working directory.
+        bool OpenFile(std::string filename, FileView& file) const;
+
     private:
         // Resource manager that owns this resource.
         ResourceManager* m_resourceManager;
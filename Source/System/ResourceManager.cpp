@@ -1,14 +1,33 @@
 #include "Precompiled.hpp"
 #include "ResourceManager.hpp"
+#include "System/Config.hpp"
 using namespace System;
 
 namespace
 {
     // Log error messages.
     #define LogInitializeError() "Failed to initialize the resource manager! "
+
+    // Default loading parameters.
+    const int DefaultLoaderThreads = 2;
+    const int MaxLoaderThreads = 8;
+    const double DefaultUploadBudget = 0.002;
+    const std::size_t DefaultPoolBudget = 64 * 1024 * 1024;
+    const double DefaultStatisticsInterval = 0.0;
+
+    // Request being decoded on this thread.
+    thread_local ResourceRequest* DecodingRequest = nullptr;
 }
 
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager() :
+    m_context(nullptr),
+    m_exit(false),
+    m_uploadBudget(DefaultUploadBudget),
+    m_poolBudget(DefaultPoolBudget),
+    m_frame(0),
+    m_statisticsInterval(DefaultStatisticsInterval),
+    m_statisticsTime(0.0),
+    m_initialized(false)
 {
 }
 
@@ -20,9 +39,54 @@ ResourceManager::~ResourceManager()
 
 void ResourceManager::Cleanup()
 {
+    // Stop loader threads.
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_exit = true;
+    }
+
+    m_queueCondition.notify_all();
+
+    for(auto& thread : m_threads)
+    {
+        if(thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    Utility::ClearContainer(m_threads);
+
+    // Drop pending requests.
+    Utility::ClearContainer(m_queue);
+    Utility::ClearContainer(m_decoded);
+    Utility::ClearContainer(m_uploads);
+
+    m_exit = false;
+
+    // Release resources of all pools before removing any of them,
+    // as resources can hold handles to resources of other pools.
+    for(auto& pair : m_pools)
+    {
+        auto& pool = pair.second;
+        pool->ReleaseAll();
+    }
+
     // Remove all resource pools.
     Utility::ClearContainer(m_pools);
 
+    // Reset loading parameters.
+    m_uploadBudget = DefaultUploadBudget;
+    m_poolBudget = DefaultPoolBudget;
+
+    // Reset statistics parameters.
+    m_frame = 0;
+    m_statisticsInterval = DefaultStatisticsInterval;
+    m_statisticsTime = 0.0;
+
+    // Reset context reference.
+    m_context = nullptr;
+
     // Reset initialization state.
     m_initialized = false;
 }
@@ -48,19 +112,363 @@ bool ResourceManager::Initialize(Context& context)
 
     context[ContextTypes::Main].Set(this);
 
+    m_context = &context;
+
+    // Read config settings.
+    int threadCount = DefaultLoaderThreads;
+
+    System::Config* config = context[ContextTypes::Main].Get<System::Config>();
+
+    if(config != nullptr)
+    {
+        threadCount = config->Get<int>("System.LoaderThreads", DefaultLoaderThreads);
+
+        // Upload budget is set in milliseconds.
+        int uploadBudget = config->Get<int>("System.UploadBudget", (int)(DefaultUploadBudget * 1000.0));
+        m_uploadBudget = std::max(0, uploadBudget) / 1000.0;
+
+        // Cache budget is set in kilobytes.
+        int poolBudget = config->Get<int>("System.ResourceCacheBudget", (int)(DefaultPoolBudget / 1024));
+        m_poolBudget = (std::size_t)std::max(0, poolBudget) * 1024;
+
+        // Statistics interval is set in seconds, and disabled with zero.
+        int statisticsInterval = config->Get<int>("System.ResourceStatisticsInterval", (int)DefaultStatisticsInterval);
+        m_statisticsInterval = (double)std::max(0, statisticsInterval);
+    }
+
+    m_statisticsTime = glfwGetTime();
+
+    // Start loader threads.
+    // At least one thread is needed for requests to progress on their own.
+    threadCount = std::max(1, std::min(threadCount, MaxLoaderThreads));
+
+    m_threads.reserve(threadCount);
+
+    for(int i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&ResourceManager::LoaderThread, this);
+    }
+
     // Success!
     return m_initialized = true;
 }
 
+void ResourceManager::Update()
+{
+    if(!m_initialized)
+        return;
+
+    // Count updates for usage statistics.
+    m_frame += 1;
+
+    // Write statistics periodically.
+    if(m_statisticsInterval > 0.0 && glfwGetTime() - m_statisticsTime >= m_statisticsInterval)
+    {
+        this->DumpStatistics();
+        m_statisticsTime = glfwGetTime();
+    }
+
+    // Take requests decoded since the last update.
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        m_uploads.insert(m_uploads.end(), m_decoded.begin(), m_decoded.end());
+        m_decoded.clear();
+    }
+
+    // Upload requests until the time budget is spent.
+    // At least one request is uploaded on every update.
+    double startTime = glfwGetTime();
+    int uploadCount = 0;
+
+    bool progress = true;
+
+    while(progress)
+    {
+        progress = false;
+
+        auto it = m_uploads.begin();
+
+        while(it != m_uploads.end())
+        {
+            const RequestPtr& request = *it;
+
+            // Remove requests finished by synchronous loads.
+            if(request->completed)
+            {
+                it = m_uploads.erase(it);
+                continue;
+            }
+
+            // Wait for dependencies to be uploaded first.
+            if(!this->IsUploadable(*request))
+            {
+                ++it;
+                continue;
+            }
+
+            // Check the time budget.
+            if(uploadCount > 0 && glfwGetTime() - startTime >= m_uploadBudget)
+                return;
+
+            // Upload the request.
+            this->Complete(request);
+
+            it = m_uploads.erase(it);
+
+            uploadCount += 1;
+            progress = true;
+        }
+    }
+}
+
 void ResourceManager::ReleaseUnused()
 {
     if(!m_initialized)
         return;
 
-    // Release all unused resources.
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    // Release unused resources over the budget.
     for(auto& pair : m_pools)
     {
         auto& pool = pair.second;
         pool->ReleaseUnused();
     }
 }
+
+void ResourceManager::DumpStatistics()
+{
+    if(!m_initialized)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    // Write statistics of every pool, followed by its resources.
+    Log() << "Resource statistics on frame " << m_frame << ":";
+
+    for(auto& pair : m_pools)
+    {
+        auto& pool = pair.second;
+
+        ResourceStatisticsList resources;
+        ResourcePoolStatistics statistics = pool->GetStatistics(&resources);
+
+        Log() << "  " << statistics.type << ": "
+            << statistics.resourceCount << " resources (" << statistics.cachedCount << " cached), "
+            << statistics.cpuMemory / 1024 << " KB system memory, "
+            << statistics.gpuMemory / 1024 << " KB graphics memory, "
+            << statistics.budget / 1024 << " KB budget, "
+            << statistics.hits << " hits, " << statistics.joins << " joined loads, "
+            << statistics.misses << " misses.";
+
+        // List largest resources first.
+        std::sort(resources.begin(), resources.end(), [](const ResourceStatistics& a, const ResourceStatistics& b)
+        {
+            return a.cpuMemory + a.gpuMemory > b.cpuMemory + b.gpuMemory;
+        });
+
+        for(const auto& resource : resources)
+        {
+            Log() << "    \"" << resource.filename << "\": "
+                << resource.cpuMemory / 1024 << " KB system memory, "
+                << resource.gpuMemory / 1024 << " KB graphics memory, "
+                << "loaded in " << resource.loadTime * 1000.0 << " ms, "
+                << "last used on frame " << resource.lastUseFrame << ", "
+                << resource.hits << " hits, " << resource.references << " handles"
+                << (resource.cached ? ", cached." : ".");
+        }
+    }
+}
+
+std::vector<ResourcePoolStatistics> ResourceManager::GetStatistics()
+{
+    std::vector<ResourcePoolStatistics> statistics;
+
+    if(!m_initialized)
+        return statistics;
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    // Gather statistics of all pools.
+    for(auto& pair : m_pools)
+    {
+        auto& pool = pair.second;
+        statistics.push_back(pool->GetStatistics(nullptr));
+    }
+
+    return statistics;
+}
+
+uint64_t ResourceManager::GetFrame() const
+{
+    return m_frame;
+}
+
+Context* ResourceManager::GetContext() const
+{
+    return m_context;
+}
+
+void ResourceManager::QueueRequest(const RequestPtr& request)
+{
+    assert(request != nullptr);
+
+    // Add request to the queue.
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queue.push(request);
+    }
+
+    m_queueCondition.notify_one();
+}
+
+void ResourceManager::AddDependency(const RequestPtr& request)
+{
+    assert(request != nullptr);
+
+    // Resources requested while decoding are dependencies.
+    if(DecodingRequest != nullptr && DecodingRequest != request.get())
+    {
+        DecodingRequest->dependencies.push_back(request);
+    }
+}
+
+void ResourceManager::Wait(const RequestPtr& request)
+{
+    assert(request != nullptr);
+
+    // Decode a queued request on this thread.
+    int expected = ResourceRequestStates::Queued;
+
+    if(request->state.compare_exchange_strong(expected, ResourceRequestStates::Decoding))
+    {
+        this->Decode(request);
+    }
+    else
+    {
+        // Wait for a loader thread to finish decoding.
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+
+        m_decodeCondition.wait(lock, [&]()
+        {
+            return request->state != ResourceRequestStates::Decoding;
+        });
+    }
+
+    // Upload the request.
+    this->Complete(request);
+}
+
+void ResourceManager::Decode(const RequestPtr& request)
+{
+    assert(request->state == ResourceRequestStates::Decoding);
+
+    // Decode the resource.
+    // Nested requests are decoded by loaders of their own.
+    ResourceRequest* previousRequest = DecodingRequest;
+    DecodingRequest = request.get();
+
+    double startTime = glfwGetTime();
+
+    bool success = request->resource->Decode(request->filename);
+
+    request->loadTime += glfwGetTime() - startTime;
+
+    DecodingRequest = previousRequest;
+
+    // Hand the request over for upload.
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        request->state = success ? ResourceRequestStates::Decoded : ResourceRequestStates::Failed;
+        m_decoded.push_back(request);
+    }
+
+    m_decodeCondition.notify_all();
+}
+
+void ResourceManager::Complete(const RequestPtr& request)
+{
+    if(request->completed)
+        return;
+
+    // Upload the resource after its dependencies.
+    if(request->state == ResourceRequestStates::Decoded)
+    {
+        for(const auto& dependency : request->dependencies)
+        {
+            this->Wait(dependency);
+        }
+
+        double startTime = glfwGetTime();
+
+        bool success = request->resource->Upload(request->filename);
+
+        request->loadTime += glfwGetTime() - startTime;
+
+        request->state = success ? ResourceRequestStates::Ready : ResourceRequestStates::Failed;
+    }
+
+    assert(request->state == ResourceRequestStates::Ready || request->state == ResourceRequestStates::Failed);
+
+    // Hand the resource over to its pool.
+    Utility::ClearContainer(request->dependencies);
+
+    request->completed = true;
+    request->pool->CompleteRequest(*request);
+}
+
+bool ResourceManager::IsUploadable(const ResourceRequest& request) const
+{
+    int state = request.state;
+
+    if(state == ResourceRequestStates::Failed)
+        return true;
+
+    if(state != ResourceRequestStates::Decoded)
+        return false;
+
+    // Check if dependencies have finished.
+    for(const auto& dependency : request.dependencies)
+    {
+        int dependencyState = dependency->state;
+
+        if(dependencyState != ResourceRequestStates::Ready && dependencyState != ResourceRequestStates::Failed)
+            return false;
+    }
+
+    return true;
+}
+
+void ResourceManager::LoaderThread()
+{
+    while(true)
+    {
+        RequestPtr request;
+
+        // Wait for a queued request.
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+
+            m_queueCondition.wait(lock, [this]()
+            {
+                return m_exit || !m_queue.empty();
+            });
+
+            if(m_exit)
+                break;
+
+            request = std::move(m_queue.front());
+            m_queue.pop();
+        }
+
+        // Claim the request, unless the main thread already did.
+        int expected = ResourceRequestStates::Queued;
+
+        if(request->state.compare_exchange_strong(expected, ResourceRequestStates::Decoding))
+        {
+            this->Decode(request);
+        }
+    }
+}
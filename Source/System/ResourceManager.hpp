@@ -6,221 +6,1504 @@
 //
 // Resource Manager
 //
+//  Resources are decoded on loader threads and uploaded on the main thread,
+//  which has the graphics context current. Uploads of decoded resources are
+//  spread over frames by calling Update() once per frame, which stops after
+//  its time budget is spent.
+//
+//  Requests for a resource that is already being loaded share the same
+//  request. Dependencies requested while a resource is decoding are loaded
+//  in parallel on other loader threads, and the resource is uploaded after
+//  all of them are.
+//
+//  Loading a resource asynchronously:
+//      auto future = resourceManager->LoadAsync<Graphics::Texture>("Data/Texture.png");
+//
+//      if(future.IsReady())
+//      {
+//          auto texture = future.Get();
+//      }
+//
+//  Synchronous loads and calls to Get() on futures that are not ready yet
+//  finish their requests on the calling thread, which has to be the main one.
+//
+//  Code that refers to a resource every frame should hold a handle instead
+//  of a shared pointer. Handles point to a slot in the resource pool and are
+//  resolved with a single array lookup. References are counted in the slot
+//  without atomic operations, so handles may only be copied and released on
+//  the main thread, or on jobs it waits for.
+//
+//  Acquiring a resource handle:
+//      auto texture = resourceManager->Acquire<Graphics::Texture>("Data/Texture.png");
+//      glBindTexture(GL_TEXTURE_2D, texture->GetHandle());
+//
+//  Code that acquires the same resource repeatedly can resolve its filename
+//  to an id once, which skips copying and hashing the filename afterwards.
+//
+//  Acquiring a resource handle by id:
+//      auto textureId = resourceManager->Resolve<Graphics::Texture>("Data/Texture.png");
+//      auto texture = resourceManager->Acquire<Graphics::Texture>(textureId);
+//
+//  Resources that are no longer referenced by handles or shared pointers
+//  are kept in a least recently used cache, so they can be reused when
+//  requested again. Every pool has a memory budget, and cached resources
+//  are only released when the pool goes over it.
+//
+//  Pools track estimated memory of their resources, along with load times
+//  and cache hits, to help with sizing budgets and finding leaks. Reports
+//  can be written to the log periodically, or queried with GetStatistics().
+//
+
+namespace System
+{
+    // Forward declarations.
+    class ResourceManager;
+    struct ResourceRequest;
+
+    template<typename Type>
+    class ResourcePool;
+
+    // Resource id.
+    //  Identifies a resolved filename within its resource pool.
+    typedef uint32_t ResourceId;
+
+    const ResourceId InvalidResourceId = 0xFFFFFFFF;
+
+    // Resource statistics.
+    struct ResourceStatistics
+    {
+        ResourceStatistics() :
+            cpuMemory(0),
+            gpuMemory(0),
+            loadTime(0.0),
+            lastUseFrame(0),
+            hits(0),
+            references(0),
+            cached(false)
+        {
+        }
+
+        std::string filename;
+        std::size_t cpuMemory;
+        std::size_t gpuMemory;
+        double      loadTime;
+        uint64_t    lastUseFrame;
+        uint32_t    hits;
+        uint32_t    references;
+        bool        cached;
+    };
+
+    // Resource pool statistics.
+    struct ResourcePoolStatistics
+    {
+        ResourcePoolStatistics() :
+            resourceCount(0),
+            cachedCount(0),
+            cpuMemory(0),
+            gpuMemory(0),
+            budget(0),
+            hits(0),
+            joins(0),
+            misses(0)
+        {
+        }
+
+        std::string type;
+        std::size_t resourceCount;
+        std::size_t cachedCount;
+        std::size_t cpuMemory;
+        std::size_t gpuMemory;
+        std::size_t budget;
+        uint64_t    hits;
+        uint64_t    joins;
+        uint64_t    misses;
+    };
+
+    typedef std::vector<ResourceStatistics> ResourceStatisticsList;
+
+    // Resource pool interface.
+    class ResourcePoolInterface
+    {
+    protected:
+        ResourcePoolInterface()
+        {
+        }
+
+    public:
+        virtual ~ResourcePoolInterface()
+        {
+        }
+
+        virtual void ReleaseUnused() = 0;
+
+        virtual void SetBudget(std::size_t budget) = 0;
+
+        virtual void ReleaseAll() = 0;
+
+        virtual ResourcePoolStatistics GetStatistics(ResourceStatisticsList* resources) = 0;
+
+        virtual void CompleteRequest(ResourceRequest& request) = 0;
+    };
+
+    // Resource request states.
+    struct ResourceRequestStates
+    {
+        enum Type
+        {
+            Queued,
+            Decoding,
+            Decoded,
+            Ready,
+            Failed,
+        };
+    };
+
+    // Resource request.
+    //  Dependencies are only added by the thread that decodes the request.
+    struct ResourceRequest : private NonCopyable
+    {
+        ResourceRequest(std::string filename, std::shared_ptr<Resource> resource, ResourcePoolInterface* pool) :
+            filename(filename),
+            resource(resource),
+            pool(pool),
+            state(ResourceRequestStates::Queued),
+            completed(false),
+            slot(0),
+            loadTime(0.0)
+        {
+        }
+
+        std::string                                   filename;
+        std::shared_ptr<Resource>                     resource;
+        ResourcePoolInterface*                        pool;
+        std::vector<std::shared_ptr<ResourceRequest>> dependencies;
+        std::atomic<int>                              state;
+        bool                                          completed;
+
+        // Slot of the resource in its pool, once completed.
+        uint32_t slot;
+
+        // Time spent decoding and uploading (in seconds).
+        double loadTime;
+    };
+
+    // Resource handle class.
+    template<typename Type>
+    class ResourceHandle
+    {
+    public:
+        ResourceHandle();
+        ResourceHandle(ResourcePool<Type>* pool, uint32_t slot);
+        ResourceHandle(const ResourceHandle<Type>& other);
+        ResourceHandle(ResourceHandle<Type>&& other);
+        ~ResourceHandle();
+
+        // Assignment operators.
+        ResourceHandle<Type>& operator=(const ResourceHandle<Type>& other);
+        ResourceHandle<Type>& operator=(ResourceHandle<Type>&& other);
+
+        // Gets the resource.
+        // Returns null if the handle is invalid or has outlived its resource.
+        const Type* Get() const;
+
+        // Access operators.
+        const Type* operator->() const;
+        const Type& operator*() const;
+
+        // Checks if the handle refers to a resource.
+        bool IsValid() const;
+
+        // Comparison operators.
+        bool operator==(const ResourceHandle<Type>& other) const;
+        bool operator!=(const ResourceHandle<Type>& other) const;
+
+    private:
+        // Releases the reference.
+        void Release();
+
+    private:
+        // Pool of the resource.
+        ResourcePool<Type>* m_pool;
+
+        // Slot of the resource and its generation at the time of acquiring.
+        uint32_t m_slot;
+        uint32_t m_generation;
+    };
+
+    // Resource future class.
+    template<typename Type>
+    class ResourceFuture
+    {
+    public:
+        ResourceFuture();
+        ResourceFuture(ResourcePool<Type>* pool, uint32_t slot, std::shared_ptr<const Type> resource);
+        ResourceFuture(ResourceManager* resourceManager, ResourcePool<Type>* pool, std::shared_ptr<ResourceRequest> request, std::shared_ptr<const Type> fallback);
+
+        // Gets the resource.
+        // Finishes loading on the calling thread if the resource isn't ready.
+        // Returns the default resource if loading has failed.
+        std::shared_ptr<const Type> Get() const;
+
+        // Gets a handle of the resource.
+        // Finishes loading the same way as Get().
+        ResourceHandle<Type> GetHandle() const;
+
+        // Checks if the resource has finished loading, successfully or not.
+        bool IsReady() const;
+
+        // Checks if the resource has failed to load.
+        bool IsFailed() const;
+
+        // Checks if the future refers to a resource.
+        bool IsValid() const;
+
+    private:
+        // Resource manager reference.
+        ResourceManager* m_resourceManager;
+
+        // Pool of the resource and slot of an already loaded one.
+        ResourcePool<Type>* m_pool;
+        uint32_t            m_slot;
+
+        // Request of the resource being loaded.
+        std::shared_ptr<ResourceRequest> m_request;
+
+        // Loaded resource, or the default one while a request is pending.
+        std::shared_ptr<const Type> m_resource;
+    };
+
+    // Resource pool class.
+    template<typename Type>
+    class ResourcePool : public ResourcePoolInterface
+    {
+    public:
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
+
+        // Type declarations.
+        typedef std::shared_ptr<const Type>               ResourcePtr;
+        typedef std::unordered_map<std::string, uint32_t> ResourceList;
+
+        typedef std::shared_ptr<ResourceRequest>            RequestPtr;
+        typedef std::unordered_map<std::string, RequestPtr> RequestList;
+
+        // Resource slot.
+        //  Slots are reused after a generation bump, which invalidates
+        //  handles that have outlived the released resource.
+        //  Unused slots are linked in the cache list.
+        struct Slot
+        {
+            Slot() :
+                memorySize(0),
+                loadTime(0.0),
+                lastUseFrame(0),
+                generation(0),
+                references(0),
+                hits(0),
+                id(InvalidResourceId),
+                previous(InvalidSlot),
+                next(InvalidSlot),
+                cached(false)
+            {
+            }
+
+            ResourcePtr               resource;
+            std::weak_ptr<const Type> shared;
+            std::string               filename;
+            std::size_t               memorySize;
+            double                    loadTime;
+            uint64_t                  lastUseFrame;
+            uint32_t                  generation;
+            uint32_t                  references;
+            uint32_t                  hits;
+            ResourceId                id;
+            uint32_t                  previous;
+            uint32_t                  next;
+            bool                      cached;
+        };
+
+        typedef std::vector<Slot>     SlotList;
+        typedef std::vector<uint32_t> FreeSlotList;
+
+        // Resolved filenames, and slots of resources loaded from them.
+        typedef std::vector<std::string>                    PathList;
+        typedef std::vector<uint32_t>                       PathSlotList;
+        typedef std::unordered_map<std::string, ResourceId> PathIdList;
+
+        // Queue of slots whose shared pointers have all been released.
+        //  Filled by deleters of shared pointers, which can run on any
+        //  thread and outlive the pool.
+        struct ReleaseQueue
+        {
+            typedef std::vector<std::pair<uint32_t, uint32_t>> SlotList;
+
+            std::mutex mutex;
+            SlotList   slots;
+        };
+
+        // Deleter of shared pointers handed out by the pool.
+        //  Shares ownership of the resource with its slot, so shared
+        //  pointers keep the resource alive when all are released.
+        struct SharedRelease
+        {
+            void operator()(const Type*);
+
+            ResourcePtr                 owner;
+            std::weak_ptr<ReleaseQueue> queue;
+            uint32_t                    slot;
+            uint32_t                    generation;
+        };
+
+        // Constant variables.
+        static const uint32_t DefaultSlot = 0;
+        static const uint32_t InvalidSlot = 0xFFFFFFFF;
+
+    public:
+        ResourcePool(ResourceManager& resourceManager);
+        ~ResourcePool();
+
+        // Sets the default resource.
+        void SetDefault(std::shared_ptr<const Type> resource);
+
+        // Gets the default resource.
+        std::shared_ptr<const Type> GetDefault() const;
+
+        // Loads a resource.
+        std::shared_ptr<const Type> Load(const std::string& filename);
+
+        // Loads a resource asynchronously.
+        ResourceFuture<Type> LoadAsync(const std::string& filename);
+
+        // Loads a resource and returns a handle to it.
+        ResourceHandle<Type> Acquire(const std::string& filename);
+        ResourceHandle<Type> Acquire(ResourceId id);
+
+        // Resolves a filename to an id.
+        // Ids stay valid for the lifetime of the pool.
+        ResourceId Resolve(const std::string& filename);
+
+        // Caches resources released since the last call,
+        // and releases least recently used ones over the budget.
+        void ReleaseUnused();
+
+        // Releases all resources.
+        // Handles become invalid, while resources held by
+        // shared pointers are destroyed with the last of them.
+        void ReleaseAll();
+
+        // Sets the memory budget (in bytes).
+        void SetBudget(std::size_t budget);
+
+        // Gets statistics of the pool, and optionally of its resources.
+        // Has to be called on the main thread.
+        ResourcePoolStatistics GetStatistics(ResourceStatisticsList* resources);
+
+        // Moves a finished request to the list of resources.
+        void CompleteRequest(ResourceRequest& request);
+
+    private:
+        // Counts handle references of a slot.
+        void AddReference(uint32_t slot, uint32_t generation);
+        void RemoveReference(uint32_t slot, uint32_t generation);
+
+        // Gets a shared pointer of a slot and takes it out of the cache.
+        // Has to be called with the pool locked.
+        std::shared_ptr<const Type> GetShared(uint32_t slot);
+
+        // Adds a slot to the cache if nothing refers to it.
+        // Has to be called with the pool locked.
+        void CacheUnused(uint32_t slot);
+
+        // Takes a slot out of the cache.
+        // Has to be called with the pool locked.
+        void Uncache(uint32_t slot);
+
+        // Resolves a handle.
+        const Type* Resolve(uint32_t slot, uint32_t generation) const;
+
+        // Allows handles to resolve and count references.
+        friend class ResourceHandle<Type>;
+
+    private:
+        // Resource manager reference.
+        ResourceManager& m_resourceManager;
+
+        // Guards lists of the pool, which are accessed by loader threads.
+        // Slots are only modified by the main thread, which resolves
+        // handles without locking.
+        mutable std::mutex m_mutex;
+
+        // Resource slots, with the default resource in the first one.
+        SlotList     m_slots;
+        FreeSlotList m_freeSlots;
+
+        // Slots of resources by filename.
+        ResourceList m_resources;
+
+        // Resolved filenames.
+        PathList     m_paths;
+        PathSlotList m_pathSlots;
+        PathIdList   m_pathIds;
+
+        // List of requests in flight.
+        RequestList m_requests;
+
+        // Cached slots, from the least recently used one.
+        uint32_t m_cacheFirst;
+        uint32_t m_cacheLast;
+
+        // Slots released by shared pointers.
+        std::shared_ptr<ReleaseQueue> m_releaseQueue;
+
+        // Memory size of resources and the budget for them (in bytes).
+        std::size_t m_memorySize;
+        std::size_t m_budget;
+
+        // Requests for loaded resources, for resources that are
+        // still loading, and for ones that had to be loaded.
+        uint64_t m_hits;
+        uint64_t m_joins;
+        uint64_t m_misses;
+    };
+
+    // Resource manager class.
+    class ResourceManager
+    {
+    public:
+        // Type declarations.
+        typedef std::unique_ptr<ResourcePoolInterface>               ResourcePoolPtr;
+        typedef std::unordered_map<std::type_index, ResourcePoolPtr> ResourcePoolList;
+        typedef ResourcePoolList::value_type                         ResourcePoolPair;
+
+        typedef std::shared_ptr<ResourceRequest> RequestPtr;
+        typedef std::queue<RequestPtr>           RequestQueue;
+        typedef std::vector<RequestPtr>          RequestList;
+
+    public:
+        ResourceManager();
+        ~ResourceManager();
+
+        // Restores instance to it's original state.
+        void Cleanup();
+
+        // Initializes the component system.
+        bool Initialize(Context& context);
+
+        // Uploads decoded resources within the time budget.
+        void Update();
+
+        // Caches resources released since the last call, and releases
+        // least recently used ones of pools that are over the budget.
+        void ReleaseUnused();
+
+        // Writes statistics of all pools and their resources to the log.
+        // Has to be called on the main thread.
+        void DumpStatistics();
+
+        // Gets statistics of all pools.
+        // Has to be called on the main thread.
+        std::vector<ResourcePoolStatistics> GetStatistics();
+
+        // Gets the number of updates since initialization.
+        uint64_t GetFrame() const;
+
+        // Gets the context the manager was initialized with.
+        // Resources use it to find systems they are uploaded with.
+        Context* GetContext() const;
+
+        // Loads a resource.
+        template<typename Type>
+        std::shared_ptr<const Type> Load(const std::string& filename);
+
+        // Loads a resource asynchronously.
+        template<typename Type>
+        ResourceFuture<Type> LoadAsync(const std::string& filename);
+
+        // Loads a resource and returns a handle to it.
+        // Handles to the default resource are returned on failure.
+        template<typename Type>
+        ResourceHandle<Type> Acquire(const std::string& filename);
+
+        template<typename Type>
+        ResourceHandle<Type> Acquire(ResourceId id);
+
+        // Resolves a filename to an id, for acquiring the resource
+        // repeatedly without looking up its filename.
+        template<typename Type>
+        ResourceId Resolve(const std::string& filename);
+
+        // Sets the default resource.
+        template<typename Type>
+        void SetDefault(std::shared_ptr<const Type> default);
+
+        // Gets the default resource.
+        template<typename Type>
+        std::shared_ptr<const Type> GetDefault() const;
+
+        // Sets the memory budget of a resource pool (in bytes).
+        template<typename Type>
+        void SetBudget(std::size_t budget);
+
+        // Gets statistics of a resource pool, and optionally of its resources.
+        // Has to be called on the main thread.
+        template<typename Type>
+        ResourcePoolStatistics GetStatistics(ResourceStatisticsList* resources = nullptr);
+
+        // Gets a resource pool.
+        template<typename Type>
+        ResourcePool<Type>* GetPool();
+
+    private:
+        // Creates a resource pool.
+        template<typename Type>
+        ResourcePool<Type>* CreatePool();
+
+        // Queues a new request for loader threads.
+        void QueueRequest(const RequestPtr& request);
+
+        // Adds a request as a dependency of the request decoded on this thread.
+        void AddDependency(const RequestPtr& request);
+
+        // Finishes a request on the calling thread.
+        void Wait(const RequestPtr& request);
+
+        // Decodes a claimed request.
+        void Decode(const RequestPtr& request);
+
+        // Uploads a decoded request and hands it over to its pool.
+        void Complete(const RequestPtr& request);
+
+        // Checks if a request and all of its dependencies are decoded.
+        bool IsUploadable(const ResourceRequest& request) const;
+
+        // Loader thread entry point.
+        void LoaderThread();
+
+        // Allows pools and futures to manage requests.
+        template<typename> friend class ResourcePool;
+        template<typename> friend class ResourceFuture;
+
+    private:
+        // Context reference.
+        Context* m_context;
+
+        // Resource pools.
+        ResourcePoolList m_pools;
+        std::mutex       m_poolMutex;
+
+        // Loader threads.
+        std::vector<std::thread> m_threads;
+
+        // Synchronization objects.
+        std::mutex              m_queueMutex;
+        std::condition_variable m_queueCondition;
+        std::condition_variable m_decodeCondition;
+
+        // Request queues.
+        //  Queued requests wait for decoding and decoded ones for upload.
+        //  Uploads are only accessed by the main thread.
+        RequestQueue m_queue;
+        RequestList  m_decoded;
+        RequestList  m_uploads;
+        bool         m_exit;
+
+        // Time budget for uploads per update (in seconds).
+        double m_uploadBudget;
+
+        // Memory budget of new resource pools (in bytes).
+        std::size_t m_poolBudget;
+
+        // Number of updates, used to tell when resources were last used.
+        std::atomic<uint64_t> m_frame;
+
+        // Interval of statistics written to the log (in seconds).
+        double m_statisticsInterval;
+        double m_statisticsTime;
+
+        // Initialization state.
+        bool m_initialized;
+    };
+
+    template<typename Type>
+    ResourceHandle<Type>::ResourceHandle() :
+        m_pool(nullptr),
+        m_slot(0),
+        m_generation(0)
+    {
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>::ResourceHandle(ResourcePool<Type>* pool, uint32_t slot) :
+        m_pool(pool),
+        m_slot(slot),
+        m_generation(0)
+    {
+        assert(m_pool != nullptr);
+        assert(m_slot < m_pool->m_slots.size());
+
+        m_generation = m_pool->m_slots[m_slot].generation;
+        m_pool->AddReference(m_slot, m_generation);
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>::ResourceHandle(const ResourceHandle<Type>& other) :
+        m_pool(other.m_pool),
+        m_slot(other.m_slot),
+        m_generation(other.m_generation)
+    {
+        if(m_pool != nullptr)
+        {
+            m_pool->AddReference(m_slot, m_generation);
+        }
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>::ResourceHandle(ResourceHandle<Type>&& other) :
+        m_pool(other.m_pool),
+        m_slot(other.m_slot),
+        m_generation(other.m_generation)
+    {
+        other.m_pool = nullptr;
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>::~ResourceHandle()
+    {
+        this->Release();
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>& ResourceHandle<Type>::operator=(const ResourceHandle<Type>& other)
+    {
+        if(other.m_pool != nullptr)
+        {
+            other.m_pool->AddReference(other.m_slot, other.m_generation);
+        }
+
+        this->Release();
+
+        m_pool = other.m_pool;
+        m_slot = other.m_slot;
+        m_generation = other.m_generation;
+
+        return *this;
+    }
+
+    template<typename Type>
+    ResourceHandle<Type>& ResourceHandle<Type>::operator=(ResourceHandle<Type>&& other)
+    {
+        if(this != &other)
+        {
+            this->Release();
+
+            m_pool = other.m_pool;
+            m_slot = other.m_slot;
+            m_generation = other.m_generation;
+
+            other.m_pool = nullptr;
+        }
+
+        return *this;
+    }
+
+    template<typename Type>
+    void ResourceHandle<Type>::Release()
+    {
+        if(m_pool != nullptr)
+        {
+            m_pool->RemoveReference(m_slot, m_generation);
+            m_pool = nullptr;
+        }
+    }
+
+    template<typename Type>
+    const Type* ResourceHandle<Type>::Get() const
+    {
+        if(m_pool == nullptr)
+            return nullptr;
+
+        return m_pool->Resolve(m_slot, m_generation);
+    }
+
+    template<typename Type>
+    const Type* ResourceHandle<Type>::operator->() const
+    {
+        const Type* resource = this->Get();
+        assert(resource != nullptr);
+        return resource;
+    }
+
+    template<typename Type>
+    const Type& ResourceHandle<Type>::operator*() const
+    {
+        const Type* resource = this->Get();
+        assert(resource != nullptr);
+        return *resource;
+    }
+
+    template<typename Type>
+    bool ResourceHandle<Type>::IsValid() const
+    {
+        return this->Get() != nullptr;
+    }
+
+    template<typename Type>
+    bool ResourceHandle<Type>::operator==(const ResourceHandle<Type>& other) const
+    {
+        if(m_pool == nullptr || other.m_pool == nullptr)
+            return m_pool == other.m_pool;
+
+        return m_pool == other.m_pool && m_slot == other.m_slot && m_generation == other.m_generation;
+    }
+
+    template<typename Type>
+    bool ResourceHandle<Type>::operator!=(const ResourceHandle<Type>& other) const
+    {
+        return !(*this == other);
+    }
+
+    template<typename Type>
+    ResourceFuture<Type>::ResourceFuture() :
+        m_resourceManager(nullptr),
+        m_pool(nullptr),
+        m_slot(0)
+    {
+    }
+
+    template<typename Type>
+    ResourceFuture<Type>::ResourceFuture(ResourcePool<Type>* pool, uint32_t slot, std::shared_ptr<const Type> resource) :
+        m_resourceManager(nullptr),
+        m_pool(pool),
+        m_slot(slot),
+        m_resource(resource)
+    {
+        assert(m_pool != nullptr);
+    }
+
+    template<typename Type>
+    ResourceFuture<Type>::ResourceFuture(ResourceManager* resourceManager, ResourcePool<Type>* pool, std::shared_ptr<ResourceRequest> request, std::shared_ptr<const Type> fallback) :
+        m_resourceManager(resourceManager),
+        m_pool(pool),
+        m_slot(ResourcePool<Type>::DefaultSlot),
+        m_request(request),
+        m_resource(fallback)
+    {
+        assert(m_resourceManager != nullptr);
+        assert(m_pool != nullptr);
+        assert(m_request != nullptr);
+    }
+
+    template<typename Type>
+    std::shared_ptr<const Type> ResourceFuture<Type>::Get() const
+    {
+        if(m_request != nullptr)
+        {
+            // Finish the request.
+            m_resourceManager->Wait(m_request);
+
+            if(m_request->state == ResourceRequestStates::Ready)
+                return std::static_pointer_cast<const Type>(m_request->resource);
+        }
+
+        return m_resource;
+    }
+
+    template<typename Type>
+    ResourceHandle<Type> ResourceFuture<Type>::GetHandle() const
+    {
+        if(m_pool == nullptr)
+            return ResourceHandle<Type>();
+
+        uint32_t slot = m_slot;
+
+        if(m_request != nullptr)
+        {
+            // Finish the request.
+            m_resourceManager->Wait(m_request);
+
+            if(m_request->state == ResourceRequestStates::Ready)
+            {
+                slot = m_request->slot;
+            }
+        }
+
+        return ResourceHandle<Type>(m_pool, slot);
+    }
+
+    template<typename Type>
+    bool ResourceFuture<Type>::IsReady() const
+    {
+        if(m_request == nullptr)
+            return m_resource != nullptr;
+
+        int state = m_request->state;
+        return state == ResourceRequestStates::Ready || state == ResourceRequestStates::Failed;
+    }
+
+    template<typename Type>
+    bool ResourceFuture<Type>::IsFailed() const
+    {
+        if(m_request == nullptr)
+            return false;
+
+        return m_request->state == ResourceRequestStates::Failed;
+    }
+
+    template<typename Type>
+    bool ResourceFuture<Type>::IsValid() const
+    {
+        return m_request != nullptr || m_resource != nullptr;
+    }
+
+    template<typename Type>
+    void ResourcePool<Type>::SharedRelease::operator()(const Type*)
+    {
+        // Queue the slot to be checked by the main thread.
+        std::shared_ptr<ReleaseQueue> releaseQueue = queue.lock();
+
+        if(releaseQueue != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(releaseQueue->mutex);
+            releaseQueue->slots.emplace_back(slot, generation);
+        }
+
+        // Drop the ownership right away, as the weak pointer
+        // of the slot keeps the deleter around until it's reused.
+        // Destroys the resource if the slot has already released it.
+        owner = nullptr;
+    }
+
+    template<typename Type>
+    ResourcePool<Type>::ResourcePool(ResourceManager& resourceManager) :
+        m_resourceManager(resourceManager),
+        m_cacheFirst(InvalidSlot),
+        m_cacheLast(InvalidSlot),
+        m_releaseQueue(std::make_shared<ReleaseQueue>()),
+        m_memorySize(0),
+        m_budget(std::numeric_limits<std::size_t>::max()),
+        m_hits(0),
+        m_joins(0),
+        m_misses(0)
+    {
+        // Create the default resource.
+        // Its slot is never released.
+        m_slots.emplace_back();
+        m_slots[DefaultSlot].resource = std::make_shared<Type>(&m_resourceManager);
+    }
+
+    template<typename Type>
+    ResourcePool<Type>::~ResourcePool()
+    {
+        // Release all resources.
+        this->ReleaseAll();
+    }
+
+    template<typename Type>
+    void ResourcePool<Type>::SetDefault(std::shared_ptr<const Type> resource)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_slots[DefaultSlot].resource = resource;
+    }
+
+    template<typename Type>
+    std::shared_ptr<const Type>  ResourcePool<Type>::GetDefault() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_slots[DefaultSlot].resource;
+    }
+
+    template<typename Type>
+    std::shared_ptr<const Type> ResourcePool<Type>::Load(const std::string& filename)
+    {
+        // Finish loading on the calling thread.
+        return this->LoadAsync(filename).Get();
+    }
+
+    template<typename Type>
+    ResourceFuture<Type> ResourcePool<Type>::LoadAsync(const std::string& filename)
+    {
+        RequestPtr request;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Find the resource.
+            auto it = m_resources.find(filename);
+
+            if(it != m_resources.end())
+            {
+                Slot& entry = m_slots[it->second];
+                entry.lastUseFrame = m_resourceManager.GetFrame();
+                entry.hits += 1;
+
+                m_hits += 1;
+
+                return ResourceFuture<Type>(this, it->second, this->GetShared(it->second));
+            }
+
+            // Find a request that is already in flight.
+            auto requestIt = m_requests.find(filename);
+
+            if(requestIt != m_requests.end())
+            {
+                request = requestIt->second;
+
+                m_joins += 1;
+            }
+            else
+            {
+                m_misses += 1;
+
+                // Create and queue a new request.
+                std::shared_ptr<Type> resource = std::make_shared<Type>(&m_resourceManager);
+                request = std::make_shared<ResourceRequest>(filename, std::move(resource), this);
+
+                m_requests.emplace(filename, request);
+                m_resourceManager.QueueRequest(request);
+            }
+        }
+
+        // Track the request as a dependency of a decoding resource.
+        m_resourceManager.AddDependency(request);
+
+        // Return a future of the resource.
+        return ResourceFuture<Type>(&m_resourceManager, this, request, this->GetDefault());
+    }
+
+    template<typename Type>
+    ResourceHandle<Type> ResourcePool<Type>::Acquire(const std::string& filename)
+    {
+        // Take a loaded resource without a shared pointer.
+        uint32_t slot = InvalidSlot;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_resources.find(filename);
+
+            if(it != m_resources.end())
+            {
+                slot = it->second;
+
+                Slot& entry = m_slots[slot];
+                entry.lastUseFrame = m_resourceManager.GetFrame();
+                entry.hits += 1;
+
+                m_hits += 1;
+            }
+        }
+
+        if(slot != InvalidSlot)
+            return ResourceHandle<Type>(this, slot);
+
+        // Finish loading on the calling thread.
+        return this->LoadAsync(filename).GetHandle();
+    }
+
+    template<typename Type>
+    ResourceHandle<Type> ResourcePool<Type>::Acquire(ResourceId id)
+    {
+        // Handles are created with the pool unlocked,
+        // as the first reference takes the slot out of the cache.
+        uint32_t slot = DefaultSlot;
+        std::string filename;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(id < (ResourceId)m_paths.size())
+            {
+                // Take a loaded resource without looking up the filename.
+                slot = m_pathSlots[id];
+
+                if(slot != InvalidSlot)
+                {
+                    Slot& entry = m_slots[slot];
+                    entry.lastUseFrame = m_resourceManager.GetFrame();
+                    entry.hits += 1;
+
+                    m_hits += 1;
+                }
+                else
+                {
+                    filename = m_paths[id];
+                }
+            }
+        }
+
+        if(slot != InvalidSlot)
+            return ResourceHandle<Type>(this, slot);
+
+        // Finish loading on the calling thread.
+        return this->LoadAsync(filename).GetHandle();
+    }
+
+    template<typename Type>
+    ResourceId ResourcePool<Type>::Resolve(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Find an already resolved filename.
+        auto result = m_pathIds.emplace(filename, (ResourceId)m_paths.size());
+
+        if(!result.second)
+            return result.first->second;
+
+        // Add a new id, with the slot of a loaded resource.
+        ResourceId id = result.first->second;
+        uint32_t slot = InvalidSlot;
+
+        auto it = m_resources.find(filename);
+
+        if(it != m_resources.end())
+        {
+            slot = it->second;
+            m_slots[slot].id = id;
+        }
+
+        m_paths.push_back(filename);
+        m_pathSlots.push_back(slot);
+
+        return id;
+    }
+
+    template<typename Type>
+    void ResourcePool<Type>::CompleteRequest(ResourceRequest& request)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Remove the request from the list.
+        auto it = m_requests.find(request.filename);
+
+        assert(it != m_requests.end());
+        assert(it->second.get() == &request);
+
+        m_requests.erase(it);
+
+        // Add resource to a free slot.
+        if(request.state == ResourceRequestStates::Ready)
+        {
+            uint32_t slot = 0;
+
+            if(!m_freeSlots.empty())
+            {
+                slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                slot = (uint32_t)m_slots.size();
+                m_slots.emplace_back();
+            }
+
+            Slot& entry = m_slots[slot];
+            entry.resource = std::static_pointer_cast<const Type>(request.resource);
+            entry.filename = request.filename;
+            entry.memorySize = entry.resource->GetMemorySize();
+            entry.loadTime = request.loadTime;
+            entry.lastUseFrame = m_resourceManager.GetFrame();
+            entry.references = 0;
+            entry.hits = 0;
+
+            m_memorySize += entry.memorySize;
+
+            auto result = m_resources.emplace(request.filename, slot);
+
+            assert(result.second == true);
+
+            // Link the slot to the id of its filename.
+            auto idIt = m_pathIds.find(request.filename);
+
+            if(idIt != m_pathIds.end())
+            {
+                entry.id = idIt->second;
+                m_pathSlots[entry.id] = slot;
+            }
+
+            // Futures of the request hand out the shared pointer of the slot,
+            // so the resource gets cached once all of them are released.
+            request.resource = std::const_pointer_cast<Type>(this->GetShared(slot));
+            request.slot = slot;
+        }
+    }
 
-namespace System
-{
-    // Resource pool interface.
-    class ResourcePoolInterface
+    template<typename Type>
+    void ResourcePool<Type>::ReleaseUnused()
     {
-    protected:
-        ResourcePoolInterface()
-        {
-        }
+        // Resources are destroyed after the pool is unlocked,
+        // as they can release handles of other pools.
+        std::vector<ResourcePtr> released;
 
-    public:
-        virtual ~ResourcePoolInterface()
         {
-        }
+            std::lock_guard<std::mutex> lock(m_mutex);
 
-        virtual void ReleaseUnused() = 0;
-    };
+            // Cache slots released by shared pointers.
+            typename ReleaseQueue::SlotList releasedSlots;
 
-    // Resource pool class.
-    template<typename Type>
-    class ResourcePool : public ResourcePoolInterface
-    {
-    public:
-        // Validate resource type.
-        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
+            {
+                std::lock_guard<std::mutex> queueLock(m_releaseQueue->mutex);
+                releasedSlots.swap(m_releaseQueue->slots);
+            }
 
-        // Type declarations.
-        typedef std::shared_ptr<Type>                        ResourcePtr;
-        typedef std::unordered_map<std::string, ResourcePtr> ResourceList;
-        typedef typename ResourceList::value_type            ResourceListPair;
-        
-    public:
-        ResourcePool(ResourceManager& resourceManager);
-        ~ResourcePool();
+            for(const auto& releasedSlot : releasedSlots)
+            {
+                if(m_slots[releasedSlot.first].generation == releasedSlot.second)
+                {
+                    this->CacheUnused(releasedSlot.first);
+                }
+            }
 
-        // Sets the default resource.
-        void SetDefault(std::shared_ptr<const Type> resource);
+            // Release least recently used resources over the budget.
+            while(m_memorySize > m_budget && m_cacheFirst != InvalidSlot)
+            {
+                uint32_t slot = m_cacheFirst;
+                Slot& entry = m_slots[slot];
 
-        // Gets the default resource.
-        std::shared_ptr<const Type> GetDefault() const;
+                this->Uncache(slot);
 
-        // Loads a resource.
-        std::shared_ptr<const Type> Load(std::string filename);
+                // Take out filename string to print it later.
+                std::string filename = std::move(entry.filename);
+                m_resources.erase(filename);
 
-        // Releases unused resources.
-        void ReleaseUnused();
+                if(entry.id != InvalidResourceId)
+                {
+                    m_pathSlots[entry.id] = InvalidSlot;
+                    entry.id = InvalidResourceId;
+                }
 
-        // Releases all resources.
-        void ReleaseAll();
+                // Release the resource and invalidate its slot.
+                released.push_back(std::move(entry.resource));
+                entry.resource = nullptr;
+                entry.shared.reset();
+                entry.generation += 1;
 
-    private:
-        // Resource manager reference.
-        ResourceManager& m_resourceManager;
+                m_memorySize -= entry.memorySize;
+                entry.memorySize = 0;
 
-        // List of resources.
-        ResourceList m_resources;
+                m_freeSlots.push_back(slot);
 
-        // Default resource.
-        std::shared_ptr<const Type> m_default;
-    };
+                // Print log message.
+                Log() << "Released a resource loaded from \"" << filename << "\" file.";
+            }
+        }
+    }
 
     template<typename Type>
-    ResourcePool<Type>::ResourcePool(ResourceManager& resourceManager) :
-        m_resourceManager(resourceManager),
-        m_default(std::make_shared<Type>(&m_resourceManager))
+    void ResourcePool<Type>::ReleaseAll()
     {
+        std::vector<ResourcePtr> released;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Drop requests in flight.
+            Utility::ClearContainer(m_requests);
+
+            // Release all resources.
+            // Handles that are still held become invalid.
+            for(uint32_t i = DefaultSlot + 1; i < (uint32_t)m_slots.size(); ++i)
+            {
+                Slot& entry = m_slots[i];
+
+                if(entry.resource == nullptr)
+                    continue;
+
+                // Take out filename string to print it later.
+                std::string filename = std::move(entry.filename);
+
+                // Release the resource and invalidate its slot.
+                released.push_back(std::move(entry.resource));
+                entry.resource = nullptr;
+                entry.shared.reset();
+                entry.memorySize = 0;
+                entry.generation += 1;
+                entry.references = 0;
+                entry.id = InvalidResourceId;
+                entry.previous = InvalidSlot;
+                entry.next = InvalidSlot;
+                entry.cached = false;
+
+                m_freeSlots.push_back(i);
+
+                // Print log message.
+                Log() << "Released a resource loaded from \"" << filename << "\" file.";
+            }
+
+            Utility::ClearContainer(m_resources);
+
+            // Keep resolved ids, which are loaded again on next use.
+            for(auto& pathSlot : m_pathSlots)
+            {
+                pathSlot = InvalidSlot;
+            }
+
+            m_cacheFirst = InvalidSlot;
+            m_cacheLast = InvalidSlot;
+            m_memorySize = 0;
+        }
     }
 
     template<typename Type>
-    ResourcePool<Type>::~ResourcePool()
+    void ResourcePool<Type>::SetBudget(std::size_t budget)
     {
-        // Release all resources.
-        this->ReleaseAll();
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_budget = budget;
     }
 
     template<typename Type>
-    void ResourcePool<Type>::SetDefault(std::shared_ptr<const Type> resource)
+    ResourcePoolStatistics ResourcePool<Type>::GetStatistics(ResourceStatisticsList* resources)
     {
-        m_default = resource;
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        ResourcePoolStatistics statistics;
+        statistics.type = typeid(Type).name();
+        statistics.budget = m_budget;
+        statistics.hits = m_hits;
+        statistics.joins = m_joins;
+        statistics.misses = m_misses;
+
+        uint64_t frame = m_resourceManager.GetFrame();
+
+        for(uint32_t i = DefaultSlot + 1; i < (uint32_t)m_slots.size(); ++i)
+        {
+            const Slot& entry = m_slots[i];
+
+            if(entry.resource == nullptr)
+                continue;
+
+            // Query current sizes, which change while uploads are pending.
+            std::size_t cpuMemory = entry.resource->GetCpuMemorySize();
+            std::size_t gpuMemory = entry.resource->GetGpuMemorySize();
+
+            statistics.resourceCount += 1;
+            statistics.cachedCount += entry.cached ? 1 : 0;
+            statistics.cpuMemory += cpuMemory;
+            statistics.gpuMemory += gpuMemory;
+
+            if(resources != nullptr)
+            {
+                ResourceStatistics resource;
+                resource.filename = entry.filename;
+                resource.cpuMemory = cpuMemory;
+                resource.gpuMemory = gpuMemory;
+                resource.loadTime = entry.loadTime;
+                resource.lastUseFrame = entry.cached ? entry.lastUseFrame : frame;
+                resource.hits = entry.hits;
+                resource.references = entry.references;
+                resource.cached = entry.cached;
+
+                resources->push_back(std::move(resource));
+            }
+        }
+
+        return statistics;
     }
 
     template<typename Type>
-    std::shared_ptr<const Type>  ResourcePool<Type>::GetDefault() const
+    std::shared_ptr<const Type> ResourcePool<Type>::GetShared(uint32_t slot)
     {
-        return m_default;
+        Slot& entry = m_slots[slot];
+        assert(entry.resource != nullptr);
+
+        // Share the pointer that is already handed out.
+        std::shared_ptr<const Type> shared = entry.shared.lock();
+
+        if(shared == nullptr)
+        {
+            SharedRelease release;
+            release.owner = entry.resource;
+            release.queue = m_releaseQueue;
+            release.slot = slot;
+            release.generation = entry.generation;
+
+            shared = std::shared_ptr<const Type>(entry.resource.get(), release);
+            entry.shared = shared;
+        }
+
+        this->Uncache(slot);
+
+        return shared;
     }
 
     template<typename Type>
-    std::shared_ptr<const Type> ResourcePool<Type>::Load(std::string filename)
+    void ResourcePool<Type>::CacheUnused(uint32_t slot)
     {
-        // Find the resource.
-        auto it = m_resources.find(filename);
+        Slot& entry = m_slots[slot];
 
-        if(it != m_resources.end())
-            return it->second;
+        if(slot == DefaultSlot || entry.resource == nullptr || entry.cached)
+            return;
+
+        if(entry.references != 0 || !entry.shared.expired())
+            return;
 
-        // Create and load the new resource instance.
-        std::shared_ptr<Type> resource = std::make_shared<Type>(&m_resourceManager);
+        // Update the memory size, as pending uploads have finished by now.
+        std::size_t memorySize = entry.resource->GetMemorySize();
 
-        if(!resource->Load(filename))
-            return m_default;
+        m_memorySize -= entry.memorySize;
+        m_memorySize += memorySize;
 
-        // Add resource to the list.
-        auto result = m_resources.emplace(filename, std::move(resource));
+        entry.memorySize = memorySize;
+        entry.lastUseFrame = m_resourceManager.GetFrame();
 
-        assert(result.second == true);
+        // Link as the most recently used slot.
+        entry.previous = m_cacheLast;
+        entry.next = InvalidSlot;
+        entry.cached = true;
+
+        if(m_cacheLast != InvalidSlot)
+        {
+            m_slots[m_cacheLast].next = slot;
+        }
+        else
+        {
+            m_cacheFirst = slot;
+        }
 
-        // Return resource pointer.
-        return result.first->second;
+        m_cacheLast = slot;
     }
 
     template<typename Type>
-    void ResourcePool<Type>::ReleaseUnused()
+    void ResourcePool<Type>::Uncache(uint32_t slot)
     {
-        // Release unused resources.
-        auto it = m_resources.begin();
+        Slot& entry = m_slots[slot];
 
-        while(it != m_resources.end())
-        {
-            if(it->second.unique())
-            {
-                // Take out filename string to print it later.
-                std::string filename = std::move(it->first);
+        if(!entry.cached)
+            return;
 
-                // Release the resource.
-                it = m_resources.erase(it);
+        // Unlink the slot.
+        if(entry.previous != InvalidSlot)
+        {
+            m_slots[entry.previous].next = entry.next;
+        }
+        else
+        {
+            m_cacheFirst = entry.next;
+        }
 
-                // Print log message.
-                Log() << "Released a resource loaded from \"" << filename << "\" file.";
-            }
-            else
-            {
-                ++it;
-            }
+        if(entry.next != InvalidSlot)
+        {
+            m_slots[entry.next].previous = entry.previous;
+        }
+        else
+        {
+            m_cacheLast = entry.previous;
         }
+
+        entry.previous = InvalidSlot;
+        entry.next = InvalidSlot;
+        entry.cached = false;
     }
 
     template<typename Type>
-    void ResourcePool<Type>::ReleaseAll()
+    void ResourcePool<Type>::AddReference(uint32_t slot, uint32_t generation)
     {
-        // Release all resources.
-        auto it = m_resources.begin();
+        assert(slot < m_slots.size());
 
-        while(it != m_resources.end())
+        Slot& entry = m_slots[slot];
+
+        if(entry.generation != generation)
+            return;
+
+        // Take the slot out of the cache on the first reference.
+        if(entry.references == 0)
         {
-            // Take out filename string to print it later.
-            std::string filename = std::move(it->first);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            this->Uncache(slot);
+        }
+
+        entry.references += 1;
+    }
+
+    template<typename Type>
+    void ResourcePool<Type>::RemoveReference(uint32_t slot, uint32_t generation)
+    {
+        assert(slot < m_slots.size());
+
+        Slot& entry = m_slots[slot];
+
+        // References of released slots have already been dropped.
+        if(entry.generation != generation)
+            return;
 
-            // Release the resource.
-            it = m_resources.erase(it);
+        assert(entry.references > 0);
+        entry.references -= 1;
 
-            // Print log message.
-            Log() << "Released a resource loaded from \"" << filename << "\" file.";
+        // Cache the slot after the last reference.
+        if(entry.references == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            this->CacheUnused(slot);
         }
+    }
+
+    template<typename Type>
+    const Type* ResourcePool<Type>::Resolve(uint32_t slot, uint32_t generation) const
+    {
+        assert(slot < m_slots.size());
 
-        assert(m_resources.empty());
+        const Slot& entry = m_slots[slot];
+        return entry.generation == generation ? entry.resource.get() : nullptr;
     }
 
-    // Resource manager class.
-    class ResourceManager
+    template<typename Type>
+    std::shared_ptr<const Type> ResourceManager::Load(const std::string& filename)
     {
-    public:
-        // Type declarations.
-        typedef std::unique_ptr<ResourcePoolInterface>               ResourcePoolPtr;
-        typedef std::unordered_map<std::type_index, ResourcePoolPtr> ResourcePoolList;
-        typedef ResourcePoolList::value_type                         ResourcePoolPair;
+        if(!m_initialized)
+            return nullptr;
 
-    public:
-        ResourceManager();
-        ~ResourceManager();
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
 
-        // Restores instance to it's original state.
-        void Cleanup();
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
 
-        // Initializes the component system.
-        bool Initialize(Context& context);
+        // Delegate to the resource pool.
+        return pool->Load(filename);
+    }
 
-        // Releases unused resources.
-        void ReleaseUnused();
+    template<typename Type>
+    ResourceFuture<Type> ResourceManager::LoadAsync(const std::string& filename)
+    {
+        if(!m_initialized)
+            return ResourceFuture<Type>();
 
-        // Loads a resource.
-        template<typename Type>
-        std::shared_ptr<const Type> Load(std::string filename);
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
 
-        // Sets the default resource.
-        template<typename Type>
-        void SetDefault(std::shared_ptr<const Type> default);
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
 
-        // Gets the default resource.
-        template<typename Type>
-        std::shared_ptr<const Type> GetDefault() const;
+        // Delegate to the resource pool.
+        return pool->LoadAsync(filename);
+    }
 
-        // Gets a resource pool.
-        template<typename Type>
-        ResourcePool<Type>* GetPool();
+    template<typename Type>
+    ResourceHandle<Type> ResourceManager::Acquire(const std::string& filename)
+    {
+        if(!m_initialized)
+            return ResourceHandle<Type>();
 
-    private:
-        // Creates a resource pool.
-        template<typename Type>
-        ResourcePool<Type>* CreatePool();
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
 
-    private:
-        // Resource pools.
-        ResourcePoolList m_pools;
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
 
-        // Initialization state.
-        bool m_initialized;
-    };
+        // Delegate to the resource pool.
+        return pool->Acquire(filename);
+    }
 
     template<typename Type>
-    std::shared_ptr<const Type> ResourceManager::Load(std::string filename)
+    ResourceHandle<Type> ResourceManager::Acquire(ResourceId id)
     {
         if(!m_initialized)
-            return nullptr;
+            return ResourceHandle<Type>();
 
         // Validate resource type.
         static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
@@ -230,7 +1513,24 @@ namespace System
         assert(pool != nullptr);
 
         // Delegate to the resource pool.
-        return pool->Load(filename);
+        return pool->Acquire(id);
+    }
+
+    template<typename Type>
+    ResourceId ResourceManager::Resolve(const std::string& filename)
+    {
+        if(!m_initialized)
+            return InvalidResourceId;
+
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
+
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
+
+        // Delegate to the resource pool.
+        return pool->Resolve(filename);
     }
 
     template<typename Type>
@@ -267,6 +1567,40 @@ namespace System
         return pool->GetDefault();
     }
 
+    template<typename Type>
+    void ResourceManager::SetBudget(std::size_t budget)
+    {
+        if(!m_initialized)
+            return;
+
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
+
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
+
+        // Set the memory budget.
+        pool->SetBudget(budget);
+    }
+
+    template<typename Type>
+    ResourcePoolStatistics ResourceManager::GetStatistics(ResourceStatisticsList* resources)
+    {
+        if(!m_initialized)
+            return ResourcePoolStatistics();
+
+        // Validate resource type.
+        static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
+
+        // Get the resource pool.
+        ResourcePool<Type>* pool = this->GetPool<Type>();
+        assert(pool != nullptr);
+
+        // Gather pool statistics.
+        return pool->GetStatistics(resources);
+    }
+
     template<typename Type>
     ResourcePool<Type>* ResourceManager::CreatePool()
     {
@@ -277,6 +1611,7 @@ namespace System
 
         // Create and add a pool to the collection.
         auto pool = std::make_unique<ResourcePool<Type>>(*this);
+        pool->SetBudget(m_poolBudget);
         auto pair = ResourcePoolPair(typeid(Type), std::move(pool));
         auto result = m_pools.insert(std::move(pair));
 
@@ -295,6 +1630,9 @@ namespace System
         // Validate resource type.
         static_assert(std::is_base_of<Resource, Type>::value, "Not a resource type.");
 
+        // Pools can be requested by loader threads.
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+
         // Find pool by resource type.
         auto it = m_pools.find(typeid(Type));
 
@@ -158,6 +158,7 @@ namespace
 Window::Window() :
     events(m_dispatchers),
     m_window(nullptr),
+    m_sharedWindow(nullptr),
     m_initialized(false)
 {
     // Increase instance count.
@@ -201,6 +202,13 @@ Window::~Window()
 
 void Window::Cleanup()
 {
+    // Destroy the shared context window.
+    if(m_sharedWindow != nullptr)
+    {
+        glfwDestroyWindow(m_sharedWindow);
+        m_sharedWindow = nullptr;
+    }
+
     // Destroy the window.
     if(m_window != nullptr)
     {
@@ -303,6 +311,32 @@ bool Window::Initialize(int width, int height)
     return m_initialized = true;
 }
 
+bool Window::CreateSharedContext()
+{
+    if(!m_initialized)
+        return false;
+
+    if(m_sharedWindow != nullptr)
+        return true;
+
+    // Create a hidden window that shares objects with the main one.
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+    m_sharedWindow = glfwCreateWindow(1, 1, "Shared", nullptr, m_window);
+
+    glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+
+    if(m_sharedWindow == nullptr)
+    {
+        Log() << "Couldn't create a shared context window!";
+        return false;
+    }
+
+    Log() << "Created a shared OpenGL context.";
+
+    return true;
+}
+
 void Window::MakeContextCurrent()
 {
     if(!m_initialized)
@@ -311,6 +345,25 @@ void Window::MakeContextCurrent()
     glfwMakeContextCurrent(m_window);
 }
 
+void Window::MakeSharedContextCurrent()
+{
+    if(!m_initialized)
+        return;
+
+    if(m_sharedWindow == nullptr)
+        return;
+
+    glfwMakeContextCurrent(m_sharedWindow);
+}
+
+void Window::ReleaseContextCurrent()
+{
+    if(!m_initialized)
+        return;
+
+    glfwMakeContextCurrent(nullptr);
+}
+
 void Window::ProcessEvents()
 {
     if(!m_initialized)
@@ -21,9 +21,20 @@ namespace System
         // Initializes the window instance.
         bool Initialize(int width, int height);
 
+        // Creates a hidden context that shares objects with the window's context.
+        // Allows resources to be created on one thread while the window's
+        // context is owned by a different one (e.g. a render thread).
+        bool CreateSharedContext();
+
         // Makes window's context current.
         void MakeContextCurrent();
 
+        // Makes the shared context current.
+        void MakeSharedContextCurrent();
+
+        // Detaches any context from the calling thread.
+        void ReleaseContextCurrent();
+
         // Processes window events.
         void ProcessEvents();
 
@@ -164,6 +175,9 @@ namespace System
         // Window implementation.
         GLFWwindow* m_window;
 
+        // Hidden window with a shared context.
+        GLFWwindow* m_sharedWindow;
+
         // Event dispatchers.
         EventDispatchers m_dispatchers;
 
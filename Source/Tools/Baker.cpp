@@ -0,0 +1,224 @@
+#include "Precompiled.hpp"
+#include "System/Config.hpp"
+#include "System/FileSystem.hpp"
+#include "System/Archive.hpp"
+#include "System/BakedFile.hpp"
+#include "Graphics/SpriteSheet.hpp"
+#include "Graphics/AnimationList.hpp"
+
+#include <sys/stat.h>
+
+#ifndef WIN32
+    #include <dirent.h>
+#endif
+
+//
+// Baker
+//
+//  Command line tool that bakes data files of a working directory, so the
+//  game doesn't have to interpret their Lua sources at runtime. Files are
+//  only baked again when the content hash of their source changes.
+//
+//  Optionally packs the whole working directory into an archive, which is
+//  mounted by the game over loose files.
+//
+//  Usage:
+//      Baker <working directory> [archive]
+//
+
+namespace
+{
+    // Bake results.
+    struct BakeResults
+    {
+        enum Type
+        {
+            Baked,
+            UpToDate,
+            Skipped,
+            Failed,
+        };
+    };
+
+    // Lists files in a directory and its subdirectories.
+    void ListFiles(std::string directory, std::string prefix, std::vector<std::string>& files)
+    {
+#ifdef WIN32
+        WIN32_FIND_DATAA data;
+        HANDLE handle = FindFirstFileA((directory + prefix + "*").c_str(), &data);
+
+        if(handle == INVALID_HANDLE_VALUE)
+            return;
+
+        do
+        {
+            std::string name = data.cFileName;
+
+            if(name == "." || name == "..")
+                continue;
+
+            if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                ListFiles(directory, prefix + name + "/", files);
+            }
+            else
+            {
+                files.push_back(prefix + name);
+            }
+        }
+        while(FindNextFileA(handle, &data));
+
+        FindClose(handle);
+#else
+        DIR* handle = opendir((directory + prefix).c_str());
+
+        if(handle == nullptr)
+            return;
+
+        while(dirent* entry = readdir(handle))
+        {
+            std::string name = entry->d_name;
+
+            if(name == "." || name == "..")
+                continue;
+
+            struct stat info;
+
+            if(stat((directory + prefix + name).c_str(), &info) != 0)
+                continue;
+
+            if(S_ISDIR(info.st_mode))
+            {
+                ListFiles(directory, prefix + name + "/", files);
+            }
+            else
+            {
+                files.push_back(prefix + name);
+            }
+        }
+
+        closedir(handle);
+#endif
+    }
+
+    // Bakes a single data file.
+    BakeResults::Type BakeFile(std::string directory, std::string filename)
+    {
+        std::string extension = Utility::GetFileExtension(filename);
+
+        if(extension != "sprites" && extension != "animations" && extension != "cfg")
+            return BakeResults::Skipped;
+
+        // Read the source.
+        System::FileView source;
+
+        if(!source.Open(directory + filename))
+        {
+            Log() << "Couldn't open \"" << filename << "\" file!";
+            return BakeResults::Failed;
+        }
+
+        uint64_t sourceHash = System::BakedFile::Hash(source.GetData(), source.GetSize());
+
+        // Skip files baked from the same content.
+        std::string bakedPath = directory + System::BakedFile::GetBakedName(filename);
+
+        {
+            System::FileView baked;
+            uint64_t bakedHash = 0;
+
+            if(baked.Open(bakedPath) && System::BakedFile::GetSourceHash(baked.GetData(), baked.GetSize(), bakedHash) && bakedHash == sourceHash)
+                return BakeResults::UpToDate;
+        }
+
+        // Run the loader on the source and write its baked form.
+        bool success = false;
+
+        if(extension == "sprites")
+        {
+            Graphics::SpriteSheet spriteSheet(nullptr);
+            success = spriteSheet.DecodeSource(filename, source) && spriteSheet.Bake(bakedPath, sourceHash);
+        }
+        else if(extension == "animations")
+        {
+            Graphics::AnimationList animationList(nullptr);
+            success = animationList.DecodeSource(filename, source) && animationList.Bake(bakedPath, sourceHash);
+        }
+        else if(extension == "cfg")
+        {
+            System::Config config;
+            success = config.Initialize() && config.DecodeSource(filename, source) && config.Bake(bakedPath, sourceHash);
+        }
+
+        if(!success)
+        {
+            Log() << "Couldn't bake \"" << filename << "\" file!";
+            return BakeResults::Failed;
+        }
+
+        Log() << "Baked \"" << filename << "\" file.";
+
+        return BakeResults::Baked;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // Initialize debug routines.
+    Debug::Initialize();
+
+    // Initialize the logger.
+    Logger::Initialize();
+
+    // Read arguments.
+    if(argc < 2)
+    {
+        Log() << "Usage: Baker <working directory> [archive]";
+        return -1;
+    }
+
+    std::string directory = argv[1];
+    std::replace(directory.begin(), directory.end(), '\\', '/');
+
+    if(!directory.empty() && directory.back() != '/')
+    {
+        directory += '/';
+    }
+
+    std::string archive = argc >= 3 ? argv[2] : "";
+
+    // Bake data files.
+    std::vector<std::string> files;
+    ListFiles(directory, "", files);
+
+    int results[4] = { 0 };
+
+    for(const std::string& filename : files)
+    {
+        results[BakeFile(directory, filename)] += 1;
+    }
+
+    Log() << "Baked " << results[BakeResults::Baked] << " files, "
+        << results[BakeResults::UpToDate] << " up to date, "
+        << results[BakeResults::Failed] << " failed.";
+
+    if(results[BakeResults::Failed] != 0)
+        return -1;
+
+    // Pack the working directory.
+    if(!archive.empty())
+    {
+        files.clear();
+        ListFiles(directory, "", files);
+
+        // Leave out the archive itself.
+        files.erase(std::remove(files.begin(), files.end(), archive), files.end());
+
+        if(!System::Archive::Write(directory + archive, directory, files))
+            return -1;
+
+        Log() << "Packed " << files.size() << " files into \"" << archive << "\" archive.";
+    }
+
+    return 0;
+}